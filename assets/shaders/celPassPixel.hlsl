@@ -35,12 +35,12 @@ float3 PosterizeColor(float3 color, int levels)
 float3 main(VSOutput input) : SV_TARGET
 {
     float2 uv = input.UV;
-    float2 texelSize = 1.0 / float2(1920, 1080);
+    float2 texelSize = _TargetSize.zw;
 
     // Sample original pixel
     float3 originalColor = colorTexture.Sample(inputSampler, uv).rgb;
     float originalDepth = depthTexture.Sample(inputSampler, uv).r;
-    float3 originalWorldPos = ReconstructWorldPosition(uv, originalDepth, _InverseProjectionView);
+    float3 originalWorldPos = ReconstructWorldPosition(uv / _RenderScale.xy, originalDepth, _InverseProjectionView);
     float3 originalNormal = normalTexture.Sample(inputSampler, uv).rgb;
 
     // Edge detection: world position and normal discontinuities
@@ -52,9 +52,9 @@ float3 main(VSOutput input) : SV_TARGET
             if (x == 0 && y == 0) continue;
 
             float2 offset = float2(x, y) * texelSize;
-            float2 sampleUV = uv + offset;
+            float2 sampleUV = min(uv + offset, _RenderScale.xy - 0.5 * _TargetSize.zw);
             float sampledDepth = depthTexture.Sample(inputSampler, sampleUV).r;
-            float3 sampledWorldPos = ReconstructWorldPosition(sampleUV, sampledDepth, _InverseProjectionView);
+            float3 sampledWorldPos = ReconstructWorldPosition(sampleUV / _RenderScale.xy, sampledDepth, _InverseProjectionView);
             float3 sampledNormal = normalTexture.Sample(inputSampler, sampleUV).rgb;
 
             // World position edge detection
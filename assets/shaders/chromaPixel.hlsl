@@ -30,16 +30,19 @@ float3 main(VSOutput input) : SV_TARGET
     float2 aberrationDir = normalize(centerUV + 0.0001f); // Add small value to avoid division by zero
     float aberrationDistance = length(centerUV);
 
+    // Offsets pointing out of a scaled target stop at its last rendered texel
+    float2 lastTexel = _RenderScale.xy - 0.5 * _TargetSize.zw;
+
     // Red channel - offset outward
-    float2 redUV = uv + aberrationDir * AberrationStrength * RedShift;
+    float2 redUV = min(uv + aberrationDir * AberrationStrength * RedShift, lastTexel);
     float3 redChannel = inputTexture.Sample(inputSampler, redUV).rgb;
 
     // Green channel - no offset (center)
-    float2 greenUV = uv + aberrationDir * AberrationStrength * GreenShift;
+    float2 greenUV = min(uv + aberrationDir * AberrationStrength * GreenShift, lastTexel);
     float3 greenChannel = inputTexture.Sample(inputSampler, greenUV).rgb;
 
     // Blue channel - offset inward
-    float2 blueUV = uv + aberrationDir * AberrationStrength * BlueShift;
+    float2 blueUV = min(uv + aberrationDir * AberrationStrength * BlueShift, lastTexel);
     float3 blueChannel = inputTexture.Sample(inputSampler, blueUV).rgb;
 
     // Combine the channels
@@ -13,9 +13,12 @@ struct PSInput {
     float2 UV : TEXCOORD0;
 };
 
+// Draws at window size and upscales the targets rendered at the render scale, the sampler filters linearly. UVs stop
+// half a texel inside the rendered part, so filtering never reaches what was not rendered this frame.
 float4 main(PSInput input) : SV_TARGET {
-    float depth = Depth.Sample(InputSampler, input.UV).r;
-    float3 lightmapColor = Lightmap.Sample(InputSampler, input.UV).rgb;
+    float2 uv = min(input.UV, _RenderScale.xy - 0.5 * _TargetSize.zw);
+    float depth = Depth.Sample(InputSampler, uv).r;
+    float3 lightmapColor = Lightmap.Sample(InputSampler, uv).rgb;
     
     float3 finalColor = _AmbientColor + lightmapColor;
     
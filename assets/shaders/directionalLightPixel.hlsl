@@ -19,7 +19,7 @@ float3 main(PSInput input) : SV_TARGET {
     float3 worldNormal = WorldNormalXYZ_UnusedA.Sample(InputSampler, input.UV).xyz;
     float4 specular_shininess = SpecularRGB_ShininessA.Sample(InputSampler, input.UV);
 
-    float3 worldPos = ReconstructWorldPosition(input.UV, depth, _InverseProjectionView);
+    float3 worldPos = ReconstructWorldPosition(input.UV / _RenderScale.xy, depth, _InverseProjectionView);
     float3 viewVec = _CameraPosition - worldPos;
     float3 lit = StandardLambertBlinnPhong(
         worldNormal,
@@ -23,9 +23,10 @@ float Luminance(float3 color)
     return dot(color, float3(0.299f, 0.587f, 0.114f));
 }
 
+// Neighbours past the rendered part of a scaled target are clamped to its last texel centre
 float3 SampleColor(float2 uv)
 {
-    return inputTexture.Sample(inputSampler, uv).rgb;
+    return inputTexture.Sample(inputSampler, min(uv, _RenderScale.xy - 0.5 * _TargetSize.zw)).rgb;
 }
 
 // Sobel edge detection on luminance
@@ -62,8 +63,7 @@ float SobelEdgeDetection(float2 uv, float texelSize)
 float3 main(VSOutput input) : SV_TARGET
 {
     float2 uv = input.UV;
-    float2 screenSize = float2(1920.0f, 1080.0f);
-    float texelSize = 1.0f / screenSize.x;  // Using width for texel size
+    float texelSize = _TargetSize.z;  // Using width for texel size
 
     // Sample original color
     float3 originalColor = SampleColor(uv);
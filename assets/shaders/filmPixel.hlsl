@@ -67,7 +67,7 @@ float BayerMatrix4x4(float2 pixelPos)
 float3 main(VSOutput input) : SV_TARGET
 {
     float2 uv = input.UV;
-    float2 pixelPos = uv * float2(1920.0f, 1080.0f); // Screen resolution
+    float2 pixelPos = uv * _TargetSize.xy; // Target resolution
 
     // Sample input color
     float3 color = inputTexture.Sample(inputSampler, uv).rgb;
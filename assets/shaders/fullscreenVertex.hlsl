@@ -1,4 +1,6 @@
 
+#include <BeUniformBuffer.hlsli>
+
 struct VSOutput {
     float4 Position : SV_POSITION;
     float2 UV : TEXCOORD0;
@@ -22,6 +24,7 @@ VSOutput main(uint vertexID : SV_VertexID) {
     };
 
     output.Position = float4(positions[vertexID], 0.0f, 1.0f);
-    output.UV = texCoords[vertexID];
+    // only the top left share of the targets holds this frame at a lower render scale
+    output.UV = texCoords[vertexID] * _RenderScale.xy;
     return output;
 }
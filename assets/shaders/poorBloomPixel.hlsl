@@ -22,14 +22,19 @@ float Luminance(float3 color)
     return dot(color, float3(0.299f, 0.587f, 0.114f));
 }
 
+// Taps past the rendered part of a scaled target would pull in stale pixels, clamp them to its last texel centre
+float3 SampleColor(float2 uv)
+{
+    return inputTexture.Sample(inputSampler, min(uv, _RenderScale.xy - 0.5 * _TargetSize.zw)).rgb;
+}
+
 float3 main(VSOutput input) : SV_TARGET
 {
     float2 uv = input.UV;
-    float2 screenSize = float2(1920.0f, 1080.0f);
-    float2 texelSize = 1.0f / screenSize;
+    float2 texelSize = _TargetSize.zw;
 
     // Sample original color
-    float3 originalColor = inputTexture.Sample(inputSampler, uv).rgb;
+    float3 originalColor = SampleColor(uv);
     float originalLum = Luminance(originalColor);
 
     // Threshold: only bloom bright pixels
@@ -41,17 +46,17 @@ float3 main(VSOutput input) : SV_TARGET
     float3 blurredColor = thresholdedColor;  // Start with center
 
     // Cardinal taps
-    blurredColor += inputTexture.Sample(inputSampler, uv + float2(BloomRadius, 0) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv - float2(BloomRadius, 0) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv + float2(0, BloomRadius) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv - float2(0, BloomRadius) * texelSize).rgb * threshold;
+    blurredColor += SampleColor(uv + float2(BloomRadius, 0) * texelSize) * threshold;
+    blurredColor += SampleColor(uv - float2(BloomRadius, 0) * texelSize) * threshold;
+    blurredColor += SampleColor(uv + float2(0, BloomRadius) * texelSize) * threshold;
+    blurredColor += SampleColor(uv - float2(0, BloomRadius) * texelSize) * threshold;
 
     // Diagonal taps
     float diagonalRadius = BloomRadius * 0.707f;  // 45 degrees
-    blurredColor += inputTexture.Sample(inputSampler, uv + float2(diagonalRadius, diagonalRadius) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv - float2(diagonalRadius, diagonalRadius) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv + float2(diagonalRadius, -diagonalRadius) * texelSize).rgb * threshold;
-    blurredColor += inputTexture.Sample(inputSampler, uv - float2(diagonalRadius, -diagonalRadius) * texelSize).rgb * threshold;
+    blurredColor += SampleColor(uv + float2(diagonalRadius, diagonalRadius) * texelSize) * threshold;
+    blurredColor += SampleColor(uv - float2(diagonalRadius, diagonalRadius) * texelSize) * threshold;
+    blurredColor += SampleColor(uv + float2(diagonalRadius, -diagonalRadius) * texelSize) * threshold;
+    blurredColor += SampleColor(uv - float2(diagonalRadius, -diagonalRadius) * texelSize) * threshold;
 
     // Average the samples (9 taps total: 1 center + 4 cardinal + 4 diagonal)
     blurredColor /= 9.0f;
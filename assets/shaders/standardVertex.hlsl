@@ -1,10 +1,17 @@
 #include <BeUniformBuffer.hlsli>
 #include <BeMaterialBuffer.hlsli>
+#include <BeFunctions.hlsli>
 
 struct VertexInput {
     float3 Position : POSITION;
-    float3 Normal : NORMAL;
-    float2 UV    : TEXCOORD0;
+    float2 Normal : NORMAL;      // octahedral, R16G16_SNORM
+    float2 UV    : TEXCOORD0;    // R16G16_FLOAT
+
+    // per instance world matrix, rows as they sit in memory
+    float4 Model0 : INSTANCE_MODEL0;
+    float4 Model1 : INSTANCE_MODEL1;
+    float4 Model2 : INSTANCE_MODEL2;
+    float4 Model3 : INSTANCE_MODEL3;
 };
 
 struct VertexOutput {
@@ -16,12 +23,13 @@ struct VertexOutput {
 };
 
 VertexOutput main(VertexInput input) {
-    float4 worldPosition = mul(float4(input.Position, 1.0), _Model);
+    float4x4 model = float4x4(input.Model0, input.Model1, input.Model2, input.Model3);
+    float4 worldPosition = mul(float4(input.Position, 1.0), model);
 
     VertexOutput output;
     output.Position = mul(worldPosition, _ProjectionView);
     output.ViewDirection = _CameraPosition - worldPosition.xyz;
-    output.Normal = normalize(mul(input.Normal, (float3x3)_Model));
+    output.Normal = normalize(mul(DecodeOctahedral(input.Normal), (float3x3)model));
     output.UV = input.UV;
 
     return output;
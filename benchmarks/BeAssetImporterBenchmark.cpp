@@ -0,0 +1,263 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeAssetImporter.h"
+#include "BeBenchmark.h"
+#include "BeBlockCompression.h"
+#include "BeLod.h"
+#include "BeMeshOptimizer.h"
+#include "BeMeshlets.h"
+#include "BeTextureCompressor.h"
+#include "BeThreadPool.h"
+
+namespace {
+    struct BeCullStatistics {
+        uint64_t Triangles = 0;
+        uint64_t FrustumCulledTriangles = 0;
+        uint64_t BackfaceCulledTriangles = 0;
+        uint64_t Ranges = 0;   // draw calls after merging adjacent visible meshlets
+    };
+
+    // MeasureCulling samples this many views on each of its camera paths
+    constexpr uint32_t StepsPerPath = 64;
+    constexpr uint32_t PathCount = 3;
+
+    // Culls the model along an orbit, a close orbit and a fly through of its bounds and sums what got removed.
+    auto MeasureCulling(const BeModel& model) -> BeCullStatistics {
+        BeCullStatistics statistics;
+        if (model.Meshlets.empty()) return statistics;
+
+        glm::vec3 minimum {std::numeric_limits<float>::max()};
+        glm::vec3 maximum {std::numeric_limits<float>::lowest()};
+        for (const auto& meshlet : model.Meshlets) {
+            minimum = glm::min(minimum, meshlet.Center - meshlet.Radius);
+            maximum = glm::max(maximum, meshlet.Center + meshlet.Radius);
+        }
+        const glm::vec3 center = (minimum + maximum) * 0.5f;
+        const float radius = std::max(glm::length(maximum - minimum) * 0.5f, 1e-3f);
+        const glm::mat4 projection = glm::perspectiveFovLH(glm::radians(90.0f), 1920.0f, 1080.0f, radius * 0.01f, radius * 10.0f);
+
+        // outside orbit, close orbit that only sees part of the model, and a straight line through it
+        std::vector<BeMeshlets::BeIndexRange> ranges;
+        auto measureFrom = [&](const glm::vec3& eye, const glm::vec3& target) {
+            const glm::mat4 viewMatrix = glm::lookAtLH(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+            const BeMeshlets::BeCullView view = BeMeshlets::MakeCullView(projection * viewMatrix, glm::mat4(1.0f), eye);
+            for (const auto& slice : model.DrawSlices) {
+                ranges.clear();
+                for (uint32_t m = slice.FirstMeshlet; m < slice.FirstMeshlet + slice.MeshletCount; ++m) {
+                    const BeMeshlet& meshlet = model.Meshlets[m];
+                    statistics.Triangles += meshlet.TriangleCount;
+                    switch (BeMeshlets::Classify(meshlet, view)) {
+                        case BeMeshlets::BeVisibility::OutsideFrustum: statistics.FrustumCulledTriangles += meshlet.TriangleCount; break;
+                        case BeMeshlets::BeVisibility::Backfacing: statistics.BackfaceCulledTriangles += meshlet.TriangleCount; break;
+                        case BeMeshlets::BeVisibility::Visible: break;
+                    }
+                }
+                BeMeshlets::Cull(std::span(model.Meshlets).subspan(slice.FirstMeshlet, slice.MeshletCount), view, ranges);
+                statistics.Ranges += ranges.size();
+            }
+        };
+        for (uint32_t step = 0; step < StepsPerPath; ++step) {
+            const float angle = glm::two_pi<float>() * float(step) / float(StepsPerPath);
+            const glm::vec3 around {std::cos(angle), 0.0f, std::sin(angle)};
+            measureFrom(center + around * radius * 2.5f + glm::vec3(0.0f, radius * 0.5f, 0.0f), center);
+            measureFrom(center + around * radius * 0.9f, center - around * radius);
+            const float t = float(step) / float(StepsPerPath - 1) * 2.0f - 1.0f;
+            measureFrom(center + glm::vec3(radius * 2.0f * t, 0.0f, 0.0f), center + glm::vec3(radius * 2.0f * t + 1.0f, 0.0f, 0.0f));
+        }
+        return statistics;
+    }
+
+    auto PrintMeshletReport(const std::string& name, const BeModel& model, const BeCullStatistics& statistics) -> void {
+        const double triangles = std::max<double>(double(statistics.Triangles), 1.0);
+        std::cout << std::format(
+            "Meshlets {}: {} meshlets for {} slices, culled {:.1f}% by frustum and {:.1f}% by cone, {:.1f} ranges per view\n",
+            name,
+            model.Meshlets.size(),
+            model.DrawSlices.size(),
+            100.0 * double(statistics.FrustumCulledTriangles) / triangles,
+            100.0 * double(statistics.BackfaceCulledTriangles) / triangles,
+            double(statistics.Ranges) / double(StepsPerPath * PathCount));
+    }
+
+    auto PrintLodReport(const std::string& name, const BeModel& model) -> void {
+        glm::vec3 minimum {std::numeric_limits<float>::max()};
+        glm::vec3 maximum {std::numeric_limits<float>::lowest()};
+        for (const auto& vertex : model.FullVertices) {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        const float radius = model.FullVertices.empty() ? 0.0f : glm::length(maximum - minimum) * 0.5f;
+        std::cout << std::format("LODs {}: radius {:.3f}\n", name, radius);
+        for (uint32_t level = 0; level <= model.Lods.size(); ++level) {
+            const float error = BeLod::GetError(model, level);
+            std::cout << std::format("  level {}: {} triangles, error {:.5f} ({:.3f}% of radius)\n",
+                level, BeLod::GetTriangleCount(model, level), error, radius > 0.0f ? 100.0f * error / radius : 0.0f);
+        }
+    }
+}
+
+// Compresses every image under assets single threaded and on the thread pool, prints throughput, memory and PSNR.
+BE_BENCHMARK(TextureCompression) {
+    using Clock = std::chrono::steady_clock;
+    const BeAssetImporter importer;
+
+    // copies the mip chain, Compress consumes the texture it is given
+    auto cloneTexture = [](const BeTexture& texture) {
+        auto clone = std::make_shared<BeTexture>();
+        clone->Width = texture.Width;
+        clone->Height = texture.Height;
+        clone->MipLevels = texture.MipLevels;
+        clone->Pixels = static_cast<uint8_t*>(malloc(texture.GetSizeInBytes()));
+        if (!clone->Pixels) throw std::runtime_error("Failed to allocate texture");
+        memcpy(clone->Pixels, texture.Pixels, texture.GetSizeInBytes());
+        return clone;
+    };
+
+    std::cout << std::format("---- Texture Compression Benchmark ({} threads) ----\n", BeThreadPool::Shared().GetThreadCount() + 1);
+    std::cout << std::format("{:<56} {:>6} {:>10} {:>10} {:>10} {:>10} {:>9} {:>9}\n",
+        "Texture", "Format", "RGBA (MB)", "BC (MB)", "1T (ms)", "Pool (ms)", "RGB dB", "A dB");
+    double totalRaw = 0.0, totalCompressed = 0.0, totalSingle = 0.0, totalPool = 0.0, totalMegapixels = 0.0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".png" && extension != ".jpg" && extension != ".jpeg" && extension != ".tga" && extension != ".bmp") continue;
+
+        const auto source = importer.DecodeTextureFromFile(entry.path());
+        source->GenerateMips();
+        if (source->Width % 4 != 0 || source->Height % 4 != 0) {
+            std::cout << std::format("{:<56} skipped, {}x{} is not a multiple of 4\n", entry.path().string(), source->Width, source->Height);
+            continue;
+        }
+
+        const auto singleThreaded = cloneTexture(*source);
+        auto startTime = Clock::now();
+        BeTextureCompressor::Compress(*singleThreaded, false);
+        const std::chrono::duration<double, std::milli> single = Clock::now() - startTime;
+
+        const auto pooled = cloneTexture(*source);
+        startTime = Clock::now();
+        const DXGI_FORMAT format = BeTextureCompressor::Compress(*pooled, true);
+        const std::chrono::duration<double, std::milli> pool = Clock::now() - startTime;
+
+        const auto quality = BeBlockCompression::MeasureQuality(
+            source->Pixels, source->Width, source->Height, pooled->Pixels, BeTextureCompressor::ToBlockFormat(format));
+        const double rawMegabytes = double(source->GetSizeInBytes()) / (1024.0 * 1024.0);
+        const double compressedMegabytes = double(pooled->GetSizeInBytes()) / (1024.0 * 1024.0);
+        totalRaw += rawMegabytes;
+        totalCompressed += compressedMegabytes;
+        totalSingle += single.count();
+        totalPool += pool.count();
+        totalMegapixels += double(source->GetSizeInBytes()) / 4.0 / 1e6;
+        std::cout << std::format("{:<56} {:>6} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>9.2f} {:>9.2f}\n",
+            entry.path().string(),
+            format == DXGI_FORMAT_BC1_UNORM ? "BC1" : "BC3",
+            rawMegabytes, compressedMegabytes, single.count(), pool.count(), quality.ColorPSNR, quality.AlphaPSNR);
+    }
+    if (totalPool == 0.0) return;
+    std::cout << std::format("Total: {:.2f} MB -> {:.2f} MB ({:.1f}x smaller), {:.1f} MPix/s single threaded, {:.1f} MPix/s on the pool\n",
+        totalRaw, totalCompressed, totalRaw / totalCompressed,
+        totalMegapixels / (totalSingle / 1000.0), totalMegapixels / (totalPool / 1000.0));
+}
+
+// Vertex cache, overdraw and fetch metrics of every model under assets before and after BeMeshOptimizer.
+BE_BENCHMARK(MeshOptimizer) {
+    using Clock = std::chrono::steady_clock;
+    BeAssetImporter importer;
+
+    std::cout << "---- Mesh Optimizer Benchmark ----\n";
+    BeMeshOptimizer::BeMetrics totalBefore, totalAfter;
+    double totalTime = 0.0;
+    auto accumulate = [](BeMeshOptimizer::BeMetrics& total, const BeMeshOptimizer::BeMetrics& metrics) {
+        const auto triangles = float(metrics.TriangleCount);
+        total.ACMR += metrics.ACMR * triangles;
+        total.ATVR += metrics.ATVR * triangles;
+        total.Overdraw += metrics.Overdraw * triangles;
+        total.Overfetch += metrics.Overfetch * triangles;
+        total.TriangleCount += metrics.TriangleCount;
+    };
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+
+        BeModel model = importer.ImportGeometry(entry.path());
+
+        const auto before = BeMeshOptimizer::Analyze(model, true);
+        const auto startTime = Clock::now();
+        BeMeshOptimizer::Optimize(model);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - startTime;
+        const auto after = BeMeshOptimizer::Analyze(model, true);
+
+        BeMeshOptimizer::PrintComparison(entry.path().string(), before, after, elapsed.count());
+        accumulate(totalBefore, before);
+        accumulate(totalAfter, after);
+        totalTime += elapsed.count();
+    }
+    if (totalAfter.TriangleCount == 0) return;
+
+    // triangle weighted averages over every model
+    for (auto* total : {&totalBefore, &totalAfter}) {
+        const auto triangles = float(total->TriangleCount);
+        total->ACMR /= triangles;
+        total->ATVR /= triangles;
+        total->Overdraw /= triangles;
+        total->Overfetch /= triangles;
+    }
+    BeMeshOptimizer::PrintComparison("total", totalBefore, totalAfter, totalTime);
+}
+
+// How much of every model under assets cluster culling removes along a few camera paths.
+BE_BENCHMARK(Meshlets) {
+    using Clock = std::chrono::steady_clock;
+    BeAssetImporter importer;
+
+    std::cout << "---- Meshlet Culling Benchmark ----\n";
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+
+        BeModel model = importer.ImportGeometry(entry.path());
+        BeMeshOptimizer::Optimize(model);
+        BeLod::Generate(model);
+
+        const auto startTime = Clock::now();
+        BeMeshlets::Build(model);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - startTime;
+        std::cout << std::format("Built meshlets of {} in {:.2f} ms\n", entry.path().string(), elapsed.count());
+        PrintMeshletReport(entry.path().string(), model, MeasureCulling(model));
+    }
+}
+
+// Triangle count and error per level of the LOD chain of every model under assets.
+BE_BENCHMARK(Lods) {
+    using Clock = std::chrono::steady_clock;
+    BeAssetImporter importer;
+
+    std::cout << "---- LOD Generation Benchmark ----\n";
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+
+        BeModel model = importer.ImportGeometry(entry.path());
+        BeMeshOptimizer::Optimize(model);
+
+        const auto startTime = Clock::now();
+        BeLod::Generate(model);
+        const std::chrono::duration<double, std::milli> elapsed = Clock::now() - startTime;
+        std::cout << std::format("Generated {} LODs of {} in {:.2f} ms\n", model.Lods.size(), entry.path().string(), elapsed.count());
+        PrintLodReport(entry.path().string(), model);
+    }
+}
@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <string_view>
+#include <vector>
+
+// Benchmarks register themselves through BE_BENCHMARK. The runner executes every benchmark whose name contains one of
+// its arguments, or all of them without arguments. Asset paths are relative to the repository root.
+struct BeBenchmark {
+    std::string_view Name;
+    auto (*Run)() -> void;
+
+    static auto GetRegistry() -> std::vector<BeBenchmark>& {
+        static std::vector<BeBenchmark> registry;
+        return registry;
+    }
+};
+
+struct BeBenchmarkRegistration {
+    BeBenchmarkRegistration(const std::string_view name, auto (*run)() -> void) {
+        BeBenchmark::GetRegistry().push_back({name, run});
+    }
+};
+
+#define BE_BENCHMARK(Name) \
+    static auto Name##Benchmark() -> void; \
+    static const BeBenchmarkRegistration Name##BenchmarkRegistration {#Name, &Name##Benchmark}; \
+    static auto Name##Benchmark() -> void
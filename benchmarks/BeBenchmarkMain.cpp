@@ -0,0 +1,20 @@
+﻿#include <algorithm>
+#include <string_view>
+#include <vector>
+
+#include "BeBenchmark.h"
+
+auto main(const int argc, char** argv) -> int {
+    const std::vector<std::string_view> filters(argv + 1, argv + argc);
+    auto& registry = BeBenchmark::GetRegistry();
+    std::ranges::sort(registry, {}, &BeBenchmark::Name);
+
+    for (const auto& benchmark : registry) {
+        const bool selected = filters.empty() || std::ranges::any_of(filters, [&](const std::string_view filter) {
+            return benchmark.Name.find(filter) != std::string_view::npos;
+        });
+        if (selected)
+            benchmark.Run();
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeBlockCompression.h"
+#include "BeMipChain.h"
+#include "BeThreadPool.h"
+
+namespace {
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Compresses the full mip chain of a size x size procedural texture to BC1 and, with a striped alpha, to BC3:
+    // single threaded against the shared pool, with the quality of level 0.
+    auto RunBlockCompressionBenchmark(const uint32_t size) -> void {
+        const auto levels = BeMipChain::Layout(size, size);
+        std::cout << std::format("---- Block Compression Benchmark ({0}x{0} chain, {1} threads) ----\n",
+            size, BeThreadPool::Shared().GetThreadCount() + 1);
+        std::cout << std::format("{:<6} {:>10} {:>10} {:>10} {:>10} {:>9} {:>9}\n",
+            "Format", "RGBA (MB)", "BC (MB)", "1T (ms)", "Pool (ms)", "RGB dB", "A dB");
+
+        for (const bool withAlpha : {false, true}) {
+            // gradients with some high frequency detail, the kind of block the principal axis fit has to work for
+            std::vector<uint8_t> chain(BeMipChain::GetSizeInBytes(levels));
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    uint8_t* pixel = chain.data() + (size_t(y) * size + x) * 4;
+                    pixel[0] = static_cast<uint8_t>(x * 255 / size);
+                    pixel[1] = static_cast<uint8_t>(y * 255 / size);
+                    pixel[2] = static_cast<uint8_t>((x ^ y) & 0xFF);
+                    pixel[3] = withAlpha ? static_cast<uint8_t>((3 * x + 5 * y) & 0xFF) : 255;
+                }
+            }
+            BeMipChain::Generate(chain.data(), levels);
+
+            const BeBlockFormat format = BeBlockCompression::ChooseFormat(chain.data(), size, size);
+            const auto blockLevels = BeBlockCompression::Layout(levels, format);
+            std::vector<uint8_t> blocks(BeBlockCompression::GetSizeInBytes(blockLevels, format));
+            const double singleMs = MeasureBestMs([&] {
+                BeBlockCompression::Encode(chain.data(), levels, format, blocks.data(), blockLevels, false);
+            });
+            const double poolMs = MeasureBestMs([&] {
+                BeBlockCompression::Encode(chain.data(), levels, format, blocks.data(), blockLevels, true);
+            });
+            const BeBlockQuality quality = BeBlockCompression::MeasureQuality(chain.data(), size, size, blocks.data(), format);
+            std::cout << std::format("{:<6} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f} {:>9.2f} {:>9.2f}\n",
+                format == BeBlockFormat::BC1 ? "BC1" : "BC3",
+                double(chain.size()) / (1024.0 * 1024.0), double(blocks.size()) / (1024.0 * 1024.0),
+                singleMs, poolMs, quality.ColorPSNR, quality.AlphaPSNR);
+        }
+    }
+}
+
+BE_BENCHMARK(BlockCompression) {
+    RunBlockCompressionBenchmark(1024);
+}
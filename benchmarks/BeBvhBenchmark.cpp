@@ -0,0 +1,99 @@
+﻿#include <chrono>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeBenchmark.h"
+#include "BeBvh.h"
+
+namespace {
+    auto MeasureMs(const std::function<void()>& run) -> double {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    // Builds, refits and queries objectCount random boxes, the frustum queries next to culling the flat box list.
+    auto RunBvhBenchmark(const uint32_t objectCount) -> void {
+        // a level of small to mid sized props, spread evenly
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const float side = 4.0f * std::cbrt(float(objectCount));
+        std::vector<BeBvh::BeBox> boxes(objectCount);
+        for (auto& box : boxes) {
+            const glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 extent = glm::vec3(0.1f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.9f;
+            box = {center - extent, center + extent};
+        }
+
+        BeBvh bvh;
+        const double serialBuildMs = MeasureMs([&] { bvh.Build(boxes, false); });
+        const double buildMs = MeasureMs([&] { bvh.Build(boxes); });
+        const float builtCost = bvh.ComputeCost();
+
+        // everything drifts by up to half a unit
+        for (auto& box : boxes) {
+            const glm::vec3 offset = (glm::vec3(unit(random), unit(random), unit(random)) - 0.5f);
+            box.Min += offset;
+            box.Max += offset;
+        }
+        const double refitMs = MeasureMs([&] { bvh.Refit(boxes); });
+        const float refitCost = bvh.ComputeCost();
+
+        std::cout << std::format("---- BVH benchmark ({} objects, {} nodes) ----\n", objectCount, bvh.GetNodeCount());
+        std::cout << std::format("build {:.2f} ms ({:.2f} ms on one thread), refit {:.2f} ms, SAH cost {:.1f} -> {:.1f} after refit\n",
+            buildMs, serialBuildMs, refitMs, builtCost, refitCost);
+
+        constexpr uint32_t QueryCount = 64;
+        std::vector<uint32_t> found;
+        BeCulling::BeBoxes flatBoxes;
+        for (const auto& box : boxes)
+            flatBoxes.Add((box.Min + box.Max) * 0.5f, (box.Max - box.Min) * 0.5f);
+        std::vector<uint8_t> flatVisible;
+        double frustumMs = 0.0, flatFrustumMs = 0.0;
+        uint64_t frustumHits = 0;
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 eye = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const auto planes = BeCulling::ExtractPlanes(
+                glm::perspectiveFovLH(glm::radians(60.0f), 16.0f, 9.0f, 0.1f, side * 0.25f) *
+                glm::lookAtLH(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            found.clear();
+            frustumMs += MeasureMs([&] { bvh.QueryFrustum(planes, found); });
+            flatFrustumMs += MeasureMs([&] { BeCulling::Cull(flatBoxes, planes, flatVisible); });
+            frustumHits += found.size();
+        }
+
+        double sphereMs = 0.0;
+        uint64_t sphereHits = 0;
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const float radius = side * 0.05f * unit(random);
+            found.clear();
+            sphereMs += MeasureMs([&] { bvh.QuerySphere(center, radius, found); });
+            sphereHits += found.size();
+        }
+
+        double rayMs = 0.0;
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 origin = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f);
+            rayMs += MeasureMs([&] { (void)bvh.Raycast(origin, direction); });
+        }
+
+        std::cout << std::format("frustum {:.3f} ms per query ({:.3f} ms flat SIMD), {} objects on average\n",
+            frustumMs / QueryCount, flatFrustumMs / QueryCount, frustumHits / QueryCount);
+        std::cout << std::format("sphere {:.4f} ms per query, {} objects on average; ray {:.4f} ms per query\n",
+            sphereMs / QueryCount, sphereHits / QueryCount, rayMs / QueryCount);
+    }
+}
+
+BE_BENCHMARK(Bvh) {
+    for (const uint32_t objectCount : {10000u, 100000u, 1000000u})
+        RunBvhBenchmark(objectCount);
+}
@@ -0,0 +1,124 @@
+﻿#include <algorithm>
+#include <array>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeCommandList.h"
+#include "BeNullDeviceContext.h"
+#include "BePipelineState.h"
+#include "BeRecordingContext.h"
+#include "BeStateTracker.h"
+#include "BeThreadPool.h"
+
+namespace {
+    // Draws per millisecond of a sorted frame draw list recorded through a tracker on one thread, against the list cut
+    // into chunks recorded by threadCount threads into their own command lists, and what replaying those costs.
+    auto RunCommandListBenchmark(const uint32_t drawCount, const uint32_t threadCount, const uint32_t frameCount) -> void {
+        // the geometry pass of a frame: sorted draws, each binding through the tracker what changed
+        struct BeDraw {
+            uint32_t Shader, TextureSet, Material, IndexFormat;
+        };
+        constexpr uint32_t DrawsPerList = 512;
+        std::mt19937 random(43);
+        auto pick = [&random](const uint32_t count) { return static_cast<uint32_t>(random() % count); };
+        std::vector<BeDraw> draws(drawCount);
+        for (auto& draw : draws) draw = {pick(8) == 0, pick(48), pick(64), pick(2)};
+        std::ranges::sort(draws, {}, [](const BeDraw& draw) { return std::tuple(draw.Shader, draw.TextureSet, draw.Material); });
+
+        uint32_t token = 1;
+        auto next = [&token] { return token++; };
+        ID3D11Buffer* uniformBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11Buffer* instanceBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11SamplerState* pointSampler = MakeToken<ID3D11SamplerState>(next());
+        std::array<ID3D11Buffer*, 2> vertexStreams = {MakeToken<ID3D11Buffer>(next()), MakeToken<ID3D11Buffer>(next())};
+        std::array<ID3D11Buffer*, 2> indexBuffers = {MakeToken<ID3D11Buffer>(next()), MakeToken<ID3D11Buffer>(next())};
+        std::vector<ID3D11Buffer*> materialBuffers(64);
+        for (auto& buffer : materialBuffers) buffer = MakeToken<ID3D11Buffer>(next());
+        std::vector<ID3D11ShaderResourceView*> textures(96);
+        for (auto& texture : textures) texture = MakeToken<ID3D11ShaderResourceView>(next());
+        std::array<ID3D11RenderTargetView*, 3> gbuffer {};
+        for (auto& target : gbuffer) target = MakeToken<ID3D11RenderTargetView>(next());
+        ID3D11DepthStencilView* depthTarget = MakeToken<ID3D11DepthStencilView>(next());
+        std::array<BePipelineState, 2> pipelines;
+        for (auto& pipeline : pipelines)
+            pipeline = {MakeToken<ID3D11InputLayout>(next()), MakeToken<ID3D11VertexShader>(next()), MakeToken<ID3D11PixelShader>(next()),
+                MakeToken<ID3D11BlendState>(next()), MakeToken<ID3D11DepthStencilState>(next()), MakeToken<ID3D11RasterizerState>(next()), 4};
+
+        auto recordDraws = [&](BeDeviceContext& context, BeStateTracker& tracker, const std::span<const BeDraw> range) {
+            context.SetViewport(1920, 1080);
+            tracker.SetVSConstantBuffer(0, uniformBuffer);
+            tracker.SetPSConstantBuffer(0, uniformBuffer);
+            tracker.SetRenderTargets(gbuffer, depthTarget);
+            tracker.SetPSSampler(0, pointSampler);
+            tracker.SetVertexBuffer(1, instanceBuffer, 64, 0);
+            for (uint32_t i = 0; i < range.size(); ++i) {
+                const BeDraw& draw = range[i];
+                tracker.SetPipeline(pipelines[draw.Shader]);
+                tracker.SetVertexBuffer(0, vertexStreams[draw.Shader], 32, 0);
+                tracker.SetIndexBuffer(indexBuffers[draw.IndexFormat], 42 + draw.IndexFormat * 15);
+                tracker.SetVSConstantBuffer(1, materialBuffers[draw.Material]);
+                tracker.SetPSConstantBuffer(1, materialBuffers[draw.Material]);
+                const std::array<ID3D11ShaderResourceView*, 2> set = {textures[2 * draw.TextureSet], textures[2 * draw.TextureSet + 1]};
+                tracker.SetPSShaderResources(0, set);
+                context.DrawIndexedInstanced(3 * (64 + draw.Material), 1, draw.TextureSet * 1024, 0, i);
+            }
+        };
+
+        using Clock = std::chrono::steady_clock;
+        BeNullDeviceContext context;
+        auto startTime = Clock::now();
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            BeStateTracker tracker(context);
+            recordDraws(context, tracker, draws);
+        }
+        const std::chrono::duration<double, std::milli> direct = Clock::now() - startTime;
+
+        // the calling thread records too, the pool brings the others
+        BeThreadPool pool(std::max(threadCount, 1u) - 1);
+        const uint32_t listCount = std::max(threadCount, (drawCount + DrawsPerList - 1) / DrawsPerList);
+        struct BeRecording {
+            BeCommandList Commands;
+            BeStateTracker Tracker {Commands};
+        };
+        std::vector<std::unique_ptr<BeRecording>> recordings;
+        for (uint32_t i = 0; i < listCount; ++i) recordings.push_back(std::make_unique<BeRecording>());
+        std::chrono::duration<double, std::milli> recorded {0}, replayed {0};
+        size_t recordedBytes = 0;
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            startTime = Clock::now();
+            pool.ParallelFor(listCount, [&](const uint32_t i) {
+                const uint32_t first = drawCount * i / listCount;
+                const uint32_t last = drawCount * (i + 1) / listCount;
+                BeRecording& recording = *recordings[i];
+                recording.Commands.Reset();
+                recording.Tracker.Reset();
+                recordDraws(recording.Commands, recording.Tracker, std::span(draws).subspan(first, last - first));
+            });
+            const auto replayStart = Clock::now();
+            for (const auto& recording : recordings) context.ExecuteCommandList(recording->Commands);
+            const auto end = Clock::now();
+            recorded += replayStart - startTime;
+            replayed += end - replayStart;
+            if (frame == 0)
+                for (const auto& recording : recordings) recordedBytes += recording->Commands.GetByteSize();
+        }
+
+        const double drawTotal = double(drawCount) * frameCount;
+        std::cout << std::format("---- Command list benchmark ({} draws, {} threads, {} frames) ----\n", drawCount, threadCount, frameCount);
+        std::cout << std::format("tracker straight to context  {:>9.0f} draws/ms\n", drawTotal / direct.count());
+        std::cout << std::format("{:>3} lists on {} threads       {:>9.0f} draws/ms, {:>7.0f} draws/ms per thread, {:.1f} KB recorded per frame\n",
+            listCount, threadCount, drawTotal / recorded.count(), drawTotal / recorded.count() / threadCount, double(recordedBytes) / 1024.0);
+        std::cout << std::format("replaying the lists          {:>9.0f} draws/ms\n", drawTotal / replayed.count());
+    }
+}
+
+BE_BENCHMARK(CommandList) {
+    RunCommandListBenchmark(20000, 4, 60);
+}
@@ -0,0 +1,69 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
+
+#include "BeBenchmark.h"
+#include "BeCulling.h"
+
+namespace {
+    using BeInstructionSet = BeCulling::BeInstructionSet;
+
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Builds and culls objectCount boxes from random transforms on every instruction set.
+    auto RunCullingBenchmark(const uint32_t objectCount) -> void {
+        // objects scattered around a camera at the origin looking down +z, about a sixth of them in view
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::mat4> transforms;
+        transforms.reserve(objectCount);
+        for (uint32_t i = 0; i < objectCount; ++i) {
+            const glm::vec3 position = glm::vec3(unit(random), unit(random), unit(random)) * 1000.0f - 500.0f;
+            const glm::quat rotation = glm::normalize(glm::quat(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f));
+            transforms.push_back(glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f + 2.5f * unit(random))));
+        }
+        const BeBounds bounds = {.Min = glm::vec3(-1.0f, 0.0f, -0.5f), .Max = glm::vec3(1.0f, 2.0f, 0.5f), .Center = glm::vec3(0.0f, 1.0f, 0.0f), .Radius = 1.5f};
+        const glm::mat4 projectionView =
+            glm::perspectiveFovLH(glm::radians(60.0f), 1920.0f, 1080.0f, 0.1f, 1000.0f) *
+            glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const BeCulling::BePlanes planes = BeCulling::ExtractPlanes(projectionView);
+
+        BeCulling::BeBoxes boxes;
+        const double transformMs = MeasureBestMs([&] {
+            boxes.Clear();
+            for (const auto& transform : transforms)
+                boxes.Add(bounds, transform);
+        });
+
+        std::cout << std::format("---- Frustum culling benchmark ({} objects, boxes built in {:.3f} ms) ----\n", objectCount, transformMs);
+        double scalarMs = 0.0;
+        for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+             instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+            std::vector<uint8_t> visible;
+            uint32_t visibleCount = 0;
+            const double ms = MeasureBestMs([&] { visibleCount = BeCulling::Cull(boxes, planes, visible, instructionSet); });
+            if (instructionSet == BeInstructionSet::Scalar) scalarMs = ms;
+            std::cout << std::format("{:<8} {:>8.3f} ms {:>7.2f}x  {} visible\n",
+                BePixelKernels::GetInstructionSetName(instructionSet), ms, scalarMs / ms, visibleCount);
+        }
+    }
+}
+
+BE_BENCHMARK(Culling) {
+    RunCullingBenchmark(100000);
+}
@@ -0,0 +1,77 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeDrawList.h"
+
+namespace {
+    using BeDraw = BeDrawList::BeDraw;
+    using BeStateChanges = BeDrawList::BeStateChanges;
+
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Sorts drawCount draws with random keys by radix and std::sort and compares the binds before and after.
+    auto RunDrawListBenchmark(const uint32_t drawCount) -> void {
+        // a scene's worth of slices: few shaders, a few hundred texture sets, each material mostly tied to its textures
+        constexpr uint32_t ShaderCount = 6;
+        constexpr uint32_t TextureSetCount = 300;
+        constexpr uint32_t MaterialCount = 900;
+        std::mt19937 random(23);
+        std::vector<BeDraw> unsorted(drawCount);
+        for (uint32_t i = 0; i < drawCount; ++i) {
+            const uint32_t material = random() % MaterialCount;
+            const uint32_t textureSet = material % TextureSetCount;
+            const uint32_t shader = textureSet % ShaderCount;
+            const float distance = std::uniform_real_distribution<float>(0.0f, 500.0f)(random);
+            unsorted[i] = {.Key = BeDrawList::MakeKey(shader, textureSet, material, BeDrawList::QuantizeDepth(distance, 1000.0f)), .Batch = i, .Slice = 0, .FirstRange = i, .RangeCount = 1};
+        }
+
+        std::vector<BeDraw> sorted;
+        std::vector<BeDraw> scratch;
+        const double radixMs = MeasureBestMs([&] {
+            sorted = unsorted;
+            BeDrawList::Sort(sorted, scratch);
+        });
+        std::vector<BeDraw> reference;
+        const double stableSortMs = MeasureBestMs([&] {
+            reference = unsorted;
+            std::ranges::stable_sort(reference, {}, &BeDraw::Key);
+        });
+        std::vector<BeDraw> unstable;
+        const double sortMs = MeasureBestMs([&] {
+            unstable = unsorted;
+            std::ranges::sort(unstable, {}, &BeDraw::Key);
+        });
+
+        const BeStateChanges before = BeDrawList::CountStateChanges(unsorted, false);
+        const BeStateChanges filtered = BeDrawList::CountStateChanges(unsorted, true);
+        const BeStateChanges after = BeDrawList::CountStateChanges(sorted, true);
+        std::cout << std::format("---- Draw list benchmark ({} draws) ----\n", drawCount);
+        std::cout << std::format("radix {:.3f} ms, std::stable_sort {:.3f} ms, std::sort {:.3f} ms\n", radixMs, stableSortMs, sortMs);
+        auto print = [](const char* label, const BeStateChanges& changes) {
+            std::cout << std::format("{:<36} {:>7} shaders {:>7} texture sets {:>7} materials {:>7} binds\n",
+                label, changes.Shaders, changes.TextureSets, changes.Materials, changes.GetBindCount());
+        };
+        print("insertion order, binding per draw", before);
+        print("insertion order, skipping redundant", filtered);
+        print("sorted, skipping redundant", after);
+    }
+}
+
+BE_BENCHMARK(DrawList) {
+    RunDrawListBenchmark(100000);
+}
@@ -0,0 +1,26 @@
+﻿#include <format>
+#include <iostream>
+
+#include "BeBenchmark.h"
+#include "BeFrameGovernor.h"
+#include "BeFrameTraces.h"
+
+namespace {
+    // Frames over budget and quality changes of the synthetic traces with a fixed full quality against governed.
+    auto RunFrameGovernorBenchmark(const uint32_t frameCount) -> void {
+        const BeFrameGovernor::BeSettings settings = GetTraceSettings();
+        std::cout << std::format("---- Frame governor benchmark ({} frames, {:.1f} ms budget, {} quality levels) ----\n",
+            frameCount, settings.TargetMilliseconds, settings.QualityLevels);
+        for (const BeTrace& trace : GetTraces()) {
+            const BeTraceResult fixed = RunTrace(trace, settings, frameCount, false);
+            const BeTraceResult governed = RunTrace(trace, settings, frameCount, true);
+            std::cout << std::format("{:<18} fixed {:>5} frames over budget, governed {:>5}, mean scale {:.2f}, {:>3} changes, ends at {:.2f} level {}\n",
+                trace.Name, fixed.FramesOverBudget, governed.FramesOverBudget, governed.MeanRenderScale, governed.Changes,
+                governed.FinalQuality.RenderScale, governed.FinalQuality.Level);
+        }
+    }
+}
+
+BE_BENCHMARK(FrameGovernor) {
+    RunFrameGovernorBenchmark(3000);
+}
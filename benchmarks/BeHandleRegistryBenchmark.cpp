@@ -0,0 +1,64 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeHandleRegistry.h"
+
+namespace {
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Time per lookup of the targets a frame's passes read, by string in an unordered_map against by handle.
+    auto RunHandleRegistryBenchmark(const uint32_t resourceCount, const uint32_t lookupCount) -> void {
+        std::vector<std::string> names(resourceCount);
+        std::unordered_map<std::string, uint64_t> byString;
+        BeHandleRegistry<uint64_t> byHandle;
+        std::vector<BeHandle> handles(resourceCount);
+        for (uint32_t r = 0; r < resourceCount; ++r) {
+            names[r] = std::format("RenderTarget{}", r);
+            byString.emplace(names[r], r);
+            handles[r] = byHandle.Add(names[r], r);
+        }
+
+        // the same order of lookups for both, passes reading their inputs in turn
+        std::mt19937 random(41);
+        std::vector<uint32_t> order(lookupCount);
+        for (auto& r : order) r = random() % resourceCount;
+
+        uint64_t stringSum = 0, handleSum = 0;
+        const double stringMs = MeasureBestMs([&] {
+            stringSum = 0;
+            for (const uint32_t r : order) stringSum += byString.at(names[r]);
+        });
+        const double handleMs = MeasureBestMs([&] {
+            handleSum = 0;
+            for (const uint32_t r : order) handleSum += *byHandle.Get(handles[r]);
+        });
+
+        const double stringNs = stringMs * 1e6 / lookupCount;
+        const double handleNs = handleMs * 1e6 / lookupCount;
+        std::cout << std::format("---- Handle registry benchmark ({} resources, {} lookups) ----\n", resourceCount, lookupCount);
+        std::cout << std::format("by string name  {:>8.2f} ns per lookup\n", stringNs);
+        std::cout << std::format("by handle       {:>8.2f} ns per lookup, {:.1f}x\n", handleNs, stringNs / handleNs);
+        std::cout << std::format("lookups {}\n", stringSum == handleSum ? "agree" : "DISAGREE");
+    }
+}
+
+BE_BENCHMARK(HandleRegistry) {
+    RunHandleRegistryBenchmark(12, 4000000);
+}
@@ -0,0 +1,55 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeInstancing.h"
+
+// Times Build on 10k copies of a handful of generated models and compares the draw counts with and without
+// instancing.
+BE_BENCHMARK(Instancing) {
+    // a few models with different slice counts, scattered over a field with an LOD level by distance
+    constexpr uint32_t copyCount = 10000;
+    constexpr uint32_t SliceCounts[] = {1, 3, 5, 12};
+    constexpr uint32_t LodLevels = 4;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-200.0f, 200.0f);
+
+    std::vector<BeInstancing::BeInstance> instances;
+    instances.reserve(copyCount);
+    uint64_t separateDraws = 0;   // one per slice of every object
+    for (uint32_t i = 0; i < copyCount; ++i) {
+        const auto model = static_cast<uint32_t>(random() % std::size(SliceCounts));
+        const glm::vec3 position {coordinate(random), 0.0f, coordinate(random)};
+        const auto lodLevel = std::min(static_cast<uint32_t>(glm::length(position) / 75.0f), LodLevels - 1);
+        glm::mat4 world {1.0f};
+        world[3] = glm::vec4(position, 1.0f);
+        instances.push_back({.Key = BeInstancing::MakeKey(model, lodLevel), .Object = i, .World = world});
+        separateDraws += SliceCounts[model];
+    }
+
+    std::vector<glm::mat4> instanceData;
+    std::vector<uint32_t> instanceObjects;
+    std::vector<BeInstancing::BeBatch> batches;
+    double best = 1e30;
+    for (int run = 0; run < 10; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        BeInstancing::Build(instances, instanceData, instanceObjects, batches);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    uint64_t instancedDraws = 0;  // one per slice of every batch
+    for (const auto& batch : batches)
+        instancedDraws += SliceCounts[batch.Key >> 32];
+
+    std::cout << std::format("Instancing: {} objects in {} batches, {} draws instead of {} ({:.1f}x fewer), build {:.3f} ms\n",
+        copyCount,
+        batches.size(),
+        instancedDraws,
+        separateDraws,
+        double(separateDraws) / double(std::max<uint64_t>(instancedDraws, 1)),
+        best);
+}
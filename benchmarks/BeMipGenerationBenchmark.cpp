@@ -0,0 +1,64 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeMipChain.h"
+#include "BePixelKernels.h"
+
+// Mip generation of a 4096 x 4096 texture on every instruction set, with and without the thread pool.
+BE_BENCHMARK(MipGeneration) {
+    constexpr uint32_t size = 4096;
+
+    // gradients with a hard edged alpha mask, so both the filter and the coverage search have work to do
+    const auto levels = BeMipChain::Layout(size, size);
+    std::vector<uint8_t> source(BeMipChain::GetSizeInBytes(levels));
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint8_t* pixel = source.data() + (size_t(y) * size + x) * 4;
+            pixel[0] = static_cast<uint8_t>(x * 255 / size);
+            pixel[1] = static_cast<uint8_t>(y * 255 / size);
+            pixel[2] = static_cast<uint8_t>((x ^ y) & 0xFF);
+            pixel[3] = ((x / 7 + y / 5) % 3 == 0) ? 0 : 255;
+        }
+    }
+
+    auto run = [&](const BeMipSettings& settings) -> double {
+        double best = 1e30;
+        std::vector<uint8_t> chain;
+        for (int i = 0; i < 3; ++i) {
+            chain = source;
+            const auto start = std::chrono::steady_clock::now();
+            BeMipChain::Generate(chain.data(), levels, settings);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    };
+
+    constexpr BeMipSettings settings {.SRGB = true, .AlphaCutoff = 0.5f};
+    const double chainMegabytes = double(source.size()) / (1024.0 * 1024.0);
+    std::cout << std::format("---- Mip Generation Benchmark ({0}x{0} RGBA8, sRGB, alpha coverage) ----\n", size);
+
+    const auto previous = BePixelKernels::GetInstructionSet();
+    BePixelKernels::SetInstructionSet(BePixelKernels::BeInstructionSet::Scalar);
+    const double referenceMs = run({.SRGB = settings.SRGB, .AlphaCutoff = settings.AlphaCutoff, .Parallel = false});
+
+    for (auto instructionSet = BePixelKernels::BeInstructionSet::Scalar;
+         instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+         instructionSet = static_cast<BePixelKernels::BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+        BePixelKernels::SetInstructionSet(instructionSet);
+        for (const bool parallel : {false, true}) {
+            const double ms = run({.SRGB = settings.SRGB, .AlphaCutoff = settings.AlphaCutoff, .Parallel = parallel});
+            std::cout << std::format("{:<6} {:<14} {:>9.2f} ms {:>8.1f} MB/s {:>7.2f}x\n",
+                BePixelKernels::GetInstructionSetName(instructionSet),
+                parallel ? "thread pool" : "single thread",
+                ms,
+                chainMegabytes / (ms / 1000.0),
+                referenceMs / ms);
+        }
+    }
+    BePixelKernels::SetInstructionSet(previous);
+}
@@ -0,0 +1,43 @@
+﻿#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+
+#include "BeAssetImporter.h"
+#include "BeBenchmark.h"
+
+// Imports every model under assets once through Assimp and once from the cooked cache.
+BE_BENCHMARK(ModelCache) {
+    using Clock = std::chrono::steady_clock;
+    BeAssetImporter importer;
+
+    std::cout << "---- Model Cache Benchmark ----\n";
+    std::cout << std::format("{:<48} {:>12} {:>12} {:>9}\n", "Model", "Cold (ms)", "Warm (ms)", "Speedup");
+    double totalCold = 0.0;
+    double totalWarm = 0.0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+
+        // cold: full Assimp import, which also refreshes the cooked entry for the warm run
+        importer.UseModelCache = false;
+        auto startTime = Clock::now();
+        auto model = importer.ImportModel(entry.path());
+        const std::chrono::duration<double, std::milli> cold = Clock::now() - startTime;
+        model.reset();
+
+        importer.UseModelCache = true;
+        startTime = Clock::now();
+        model = importer.ImportModel(entry.path());
+        const std::chrono::duration<double, std::milli> warm = Clock::now() - startTime;
+        model.reset();
+
+        totalCold += cold.count();
+        totalWarm += warm.count();
+        std::cout << std::format("{:<48} {:>12.2f} {:>12.2f} {:>8.1f}x\n",
+            entry.path().string(), cold.count(), warm.count(), cold.count() / warm.count());
+    }
+    std::cout << std::format("{:<48} {:>12.2f} {:>12.2f} {:>8.1f}x\n",
+        "Total", totalCold, totalWarm, totalCold / totalWarm);
+}
@@ -0,0 +1,115 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeBenchmark.h"
+#include "BeOcclusionBuffer.h"
+
+namespace {
+    using BeInstructionSet = BeOcclusionBuffer::BeInstructionSet;
+    constexpr uint32_t Width = BeOcclusionBuffer::Width;
+    constexpr uint32_t Height = BeOcclusionBuffer::Height;
+
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // A ground plane and walls in front of a field of small boxes: times rasterization on every instruction set
+    // against the pixel by pixel reference, then the tiled box tests against the reference ones.
+    auto RunOcclusionBufferBenchmark(const uint32_t occluderCount, const uint32_t objectCount) -> void {
+        // a unit cube occluder and a ground quad, scaled into walls and a floor in front of a camera looking down +z
+        const std::vector<glm::vec3> cubeVertices = {
+            {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1},
+        };
+        const std::vector<uint32_t> cubeIndices = {
+            0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 7, 6, 3, 6, 2, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+        };
+        const std::vector<glm::vec3> quadVertices = {{-1, 0, -1}, {1, 0, -1}, {1, 0, 1}, {-1, 0, 1}};
+        const std::vector<uint32_t> quadIndices = {0, 2, 1, 0, 3, 2};
+
+        std::mt19937 random(17);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::mat4> walls;
+        for (uint32_t i = 0; i < occluderCount; ++i) {
+            const glm::vec3 position = {unit(random) * 160.0f - 80.0f, 0.0f, 10.0f + unit(random) * 90.0f};
+            const glm::vec3 scale = {2.0f + unit(random) * 6.0f, 1.0f + unit(random) * 5.0f, 0.5f};
+            walls.push_back(glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f, scale.y, 0.0f)) *
+                glm::rotate(glm::mat4(1.0f), (unit(random) - 0.5f) * 1.0f, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                glm::scale(glm::mat4(1.0f), scale));
+        }
+        const glm::mat4 ground = glm::scale(glm::mat4(1.0f), glm::vec3(400.0f, 1.0f, 400.0f));
+
+        std::vector<std::pair<glm::vec3, glm::vec3>> boxes;
+        for (uint32_t i = 0; i < objectCount; ++i) {
+            const glm::vec3 extent = glm::vec3(0.2f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.8f;
+            const glm::vec3 center = {unit(random) * 240.0f - 120.0f, extent.y + unit(random) * 2.0f, 2.0f + unit(random) * 200.0f};
+            boxes.emplace_back(center, extent);
+        }
+
+        const glm::mat4 projectionView =
+            glm::perspectiveFovLH(glm::radians(60.0f), float(Width), float(Height), 0.1f, 1000.0f) *
+            glm::lookAtLH(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.5f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        BeOcclusionBuffer buffer;
+        auto addOccluders = [&] {
+            buffer.Begin(projectionView);
+            buffer.AddOccluder(quadVertices, quadIndices, ground);
+            for (const auto& wall : walls)
+                buffer.AddOccluder(cubeVertices, cubeIndices, wall);
+        };
+
+        addOccluders();
+        const double referenceMs = MeasureBestMs([&] {
+            addOccluders();
+            buffer.RasterizeReference();
+        });
+
+        std::cout << std::format("---- Occlusion buffer benchmark ({}x{}, {} occluders, {} boxes) ----\n", Width, Height, occluderCount + 1, objectCount);
+        std::cout << std::format("reference  {:>8.3f} ms\n", referenceMs);
+        for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+             instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+            for (const bool parallel : {false, true}) {
+                const double ms = MeasureBestMs([&] {
+                    addOccluders();
+                    buffer.Rasterize(parallel, instructionSet);
+                });
+                std::cout << std::format("{:<8} {:<10} {:>8.3f} ms {:>7.2f}x\n",
+                    BePixelKernels::GetInstructionSetName(instructionSet), parallel ? "parallel" : "one thread", ms, referenceMs / ms);
+            }
+        }
+
+        uint32_t occluded = 0;
+        const double testMs = MeasureBestMs([&] {
+            occluded = 0;
+            for (const auto& [center, extent] : boxes)
+                occluded += !buffer.IsVisible(center, extent);
+        });
+        uint32_t referenceOccluded = 0;
+        const double referenceTestMs = MeasureBestMs([&] {
+            referenceOccluded = 0;
+            for (const auto& [center, extent] : boxes)
+                referenceOccluded += !buffer.IsVisibleReference(center, extent);
+        });
+        const auto& statistics = buffer.GetStatistics();
+        std::cout << std::format("{} triangles rasterized of {}; {} of {} boxes occluded ({:.1f}%)\n",
+            statistics.RasterizedTriangles, statistics.OccluderTriangles, occluded, objectCount,
+            100.0 * double(occluded) / double(std::max(objectCount, 1u)));
+        std::cout << std::format("box tests {:.3f} ms with tiles, {:.3f} ms pixel by pixel\n", testMs, referenceTestMs);
+    }
+}
+
+BE_BENCHMARK(OcclusionBuffer) {
+    RunOcclusionBufferBenchmark(64, 20000);
+}
@@ -0,0 +1,131 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BePixelKernels.h"
+
+namespace {
+    using BeInstructionSet = BePixelKernels::BeInstructionSet;
+
+    // the passes LoadTextureFromMemoryDecoded and BeTexture::FlipVertically used to run
+    auto LegacyFlip(uint8_t* pixels, const uint32_t width, const uint32_t height) -> void {
+        const uint32_t rowSize = width * 4;
+        const auto tempRow = new uint8_t[rowSize];
+        for (uint32_t y = 0; y < height / 2; ++y) {
+            uint8_t* topRow = pixels + size_t(y) * rowSize;
+            uint8_t* bottomRow = pixels + size_t(height - 1 - y) * rowSize;
+            memcpy(tempRow, topRow, rowSize);
+            memcpy(topRow, bottomRow, rowSize);
+            memcpy(bottomRow, tempRow, rowSize);
+        }
+        delete[] tempRow;
+    }
+
+    auto MeasureBestMs(const std::function<void()>& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    }
+
+    // Times every kernel on a size x size image against the scalar passes the importer used to run.
+    auto RunPixelKernelsBenchmark(const uint32_t size) -> void {
+        const size_t pixelCount = size_t(size) * size;
+        std::vector<uint8_t> source(pixelCount * 4);
+        for (size_t i = 0; i < source.size(); ++i)
+            source[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+        std::vector<uint8_t> sourceRGB(pixelCount * 3);
+        for (size_t i = 0; i < sourceRGB.size(); ++i)
+            sourceRGB[i] = static_cast<uint8_t>((i * 40503u) >> 7);
+        std::vector<uint8_t> target(pixelCount * 4);
+        const double megabytes = double(pixelCount * 4) / (1024.0 * 1024.0);
+
+        auto printRow = [&](const std::string& name, const double ms, const double baselineMs) {
+            std::cout << std::format("{:<44} {:>9.2f} ms {:>8.2f} GB/s {:>7.2f}x\n",
+                name, ms, megabytes / 1024.0 / (ms / 1000.0), baselineMs / ms);
+        };
+
+        std::cout << std::format("---- Pixel Kernel Benchmark ({0}x{0} RGBA8) ----\n", size);
+
+        // what the importer did before: separate swizzle, copy and flip passes through a temporary row
+        const double legacyDecodedMs = MeasureBestMs([&] {
+            const auto pixels = static_cast<uint8_t*>(malloc(pixelCount * 4));
+            for (size_t i = 0; i < pixelCount; ++i) {
+                pixels[4 * i + 0] = source[4 * i + 2];
+                pixels[4 * i + 1] = source[4 * i + 1];
+                pixels[4 * i + 2] = source[4 * i + 0];
+                pixels[4 * i + 3] = source[4 * i + 3];
+            }
+            LegacyFlip(pixels, size, size);
+            free(pixels);
+        });
+        const double legacyAdoptMs = MeasureBestMs([&] {
+            const auto pixels = static_cast<uint8_t*>(malloc(pixelCount * 4));
+            memcpy(pixels, source.data(), pixelCount * 4);
+            LegacyFlip(pixels, size, size);
+            free(pixels);
+        });
+        const double legacyRGBMs = MeasureBestMs([&] {
+            for (size_t i = 0; i < pixelCount; ++i) {
+                target[4 * i + 0] = sourceRGB[3 * i + 0];
+                target[4 * i + 1] = sourceRGB[3 * i + 1];
+                target[4 * i + 2] = sourceRGB[3 * i + 2];
+                target[4 * i + 3] = 255;
+            }
+            const auto pixels = static_cast<uint8_t*>(malloc(pixelCount * 4));
+            memcpy(pixels, target.data(), pixelCount * 4);
+            LegacyFlip(pixels, size, size);
+            free(pixels);
+        });
+        const BeInstructionSet previous = BePixelKernels::GetInstructionSet();
+        BePixelKernels::SetInstructionSet(BeInstructionSet::Scalar);
+        const double scalarPremultiplyMs = MeasureBestMs([&] {
+            memcpy(target.data(), source.data(), pixelCount * 4);
+            BePixelKernels::Premultiply(target.data(), pixelCount);
+        });
+        printRow("legacy BGRA swizzle + flip", legacyDecodedMs, legacyDecodedMs);
+        printRow("legacy RGBA copy + flip", legacyAdoptMs, legacyAdoptMs);
+        printRow("legacy RGB expand + copy + flip", legacyRGBMs, legacyRGBMs);
+        printRow("scalar copy + premultiply", scalarPremultiplyMs, scalarPremultiplyMs);
+
+        for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+             instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+            BePixelKernels::SetInstructionSet(instructionSet);
+            const std::string name = BePixelKernels::GetInstructionSetName(instructionSet);
+
+            printRow(name + " fused BGRA swizzle + flip", MeasureBestMs([&] {
+                const auto pixels = static_cast<uint8_t*>(malloc(pixelCount * 4));
+                BePixelKernels::SwizzleBGRAToRGBA(source.data(), pixels, size, size, true);
+                free(pixels);
+            }), legacyDecodedMs);
+            printRow(name + " adopted RGBA in-place flip", MeasureBestMs([&] {
+                BePixelKernels::FlipVertically(target.data(), size, size);
+            }), legacyAdoptMs);
+            printRow(name + " fused RGB expand + flip", MeasureBestMs([&] {
+                const auto pixels = static_cast<uint8_t*>(malloc(pixelCount * 4));
+                BePixelKernels::ExpandToRGBA(sourceRGB.data(), 3, pixels, size, size, true);
+                free(pixels);
+            }), legacyRGBMs);
+            printRow(name + " copy + premultiply", MeasureBestMs([&] {
+                memcpy(target.data(), source.data(), pixelCount * 4);
+                BePixelKernels::Premultiply(target.data(), pixelCount);
+            }), scalarPremultiplyMs);
+        }
+        BePixelKernels::SetInstructionSet(previous);
+    }
+}
+
+BE_BENCHMARK(PixelKernels) {
+    RunPixelKernelsBenchmark(4096);
+}
@@ -0,0 +1,26 @@
+﻿#include <format>
+#include <iostream>
+
+#include "BeBenchmark.h"
+#include "BeRenderGraph.h"
+#include "BeRenderGraphScenes.h"
+
+namespace {
+    // Peak render target memory of the renderer's graph and of longer post processing chains, with every target
+    // allocated up front against aliased transient targets.
+    auto RunRenderGraphBenchmark(const uint32_t width, const uint32_t height) -> void {
+        std::cout << std::format("---- Render graph benchmark ({}x{}) ----\n", width, height);
+        for (const uint32_t effectCount : {1u, 3u, 6u}) {
+            BeRenderGraph graph;
+            AddRendererGraph(graph, width, height, effectCount, nullptr);
+            graph.Compile();
+            std::cout << std::format("{} post effects: {:>2} targets up front {:>7.1f} MB, aliased into {:>2} textures {:>7.1f} MB\n",
+                effectCount, graph.GetResources().size() - 1, double(graph.GetTransientBytes()) / (1024.0 * 1024.0),
+                graph.GetPhysicalResources().size(), double(graph.GetPhysicalBytes()) / (1024.0 * 1024.0));
+        }
+    }
+}
+
+BE_BENCHMARK(RenderGraph) {
+    RunRenderGraphBenchmark(1920, 1080);
+}
@@ -0,0 +1,86 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeSceneGraph.h"
+
+namespace {
+    // Builds a forest of nodeCount nodes and moves movingShare of them each frame: times Update against recomputing
+    // every world matrix and checks both agree.
+    auto RunSceneGraphBenchmark(const uint32_t nodeCount, const float movingShare) -> void {
+        using Clock = std::chrono::steady_clock;
+        constexpr uint32_t FrameCount = 100;
+
+        // small trees of up to 16 nodes, each node below a random earlier node of its tree, like imported models
+        // placed around a level
+        std::mt19937 random(19);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        auto randomPosition = [&] { return glm::vec3(unit(random), unit(random), unit(random)) * 20.0f - 10.0f; };
+        auto randomRotation = [&] { return glm::quat(glm::vec3(unit(random), unit(random), unit(random)) * 6.28f); };
+        BeSceneGraph graph;
+        std::vector<glm::vec3> positions, scales;
+        std::vector<glm::quat> rotations;
+        uint32_t treeRoot = 0;
+        uint32_t maxDepth = 0;
+        std::vector<uint32_t> depths;
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            if (i - treeRoot >= 1 + random() % 16) treeRoot = i;
+            const uint32_t parent = i == treeRoot ? BeSceneGraph::NoParent : treeRoot + random() % (i - treeRoot);
+            positions.push_back(randomPosition());
+            rotations.push_back(randomRotation());
+            scales.push_back(glm::vec3(0.5f + unit(random)));
+            graph.AddNode(parent, positions.back(), rotations.back(), scales.back());
+            depths.push_back(parent == BeSceneGraph::NoParent ? 0 : depths[parent] + 1);
+            maxDepth = std::max(maxDepth, depths.back());
+        }
+        graph.Update();
+
+        const auto movingCount = static_cast<uint32_t>(float(nodeCount) * movingShare);
+        std::vector<std::vector<uint32_t>> moving(FrameCount);
+        for (auto& frame : moving)
+            for (uint32_t i = 0; i < movingCount; ++i)
+                frame.push_back(random() % nodeCount);
+
+        // what a frame costs when every transform is composed and multiplied again, moved or not
+        auto startTime = Clock::now();
+        for (const auto& frame : moving) {
+            for (const uint32_t node : frame)
+                positions[node] += glm::vec3(0.01f);
+            for (uint32_t i = 0; i < nodeCount; ++i)
+                graph.SetLocal(i, positions[i], rotations[i], scales[i]);
+            graph.UpdateAll();
+        }
+        const std::chrono::duration<double, std::milli> everything = (Clock::now() - startTime) / FrameCount;
+
+        startTime = Clock::now();
+        uint64_t changed = 0;
+        for (const auto& frame : moving) {
+            for (const uint32_t node : frame) {
+                positions[node] += glm::vec3(0.01f);
+                graph.SetLocal(node, positions[node], rotations[node], scales[node]);
+            }
+            graph.Update();
+            changed += graph.GetChangedNodes().size();
+        }
+        const std::chrono::duration<double, std::milli> dirty = (Clock::now() - startTime) / FrameCount;
+
+        // the same arithmetic either way, so the matrices have to match exactly
+        BeSceneGraph reference = graph;
+        reference.UpdateAll();
+        const bool same = std::ranges::equal(graph.GetWorlds(), reference.GetWorlds());
+
+        std::cout << std::format("---- Scene graph benchmark ({} nodes, depth up to {}, {} moving per frame) ----\n", nodeCount, maxDepth, movingCount);
+        std::cout << std::format("every node every frame {:>8.3f} ms\n", everything.count());
+        std::cout << std::format("dirty nodes only       {:>8.3f} ms, {:.0f} world matrices per frame, {:.1f}x faster, {}\n",
+            dirty.count(), double(changed) / FrameCount, everything.count() / dirty.count(),
+            same ? "matches full update" : "WORLD MATRIX MISMATCH");
+    }
+}
+
+BE_BENCHMARK(SceneGraph) {
+    RunSceneGraphBenchmark(100000, 0.01f);
+}
@@ -0,0 +1,237 @@
+﻿#include <algorithm>
+#include <array>
+#include <format>
+#include <iostream>
+#include <random>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BePipelineState.h"
+#include "BeRecordingContext.h"
+#include "BeStateTracker.h"
+
+namespace {
+    // Context calls per frame of the renderer's passes binding everything and unbinding behind themselves, against
+    // the same frame through pipelines and the tracker. Counted with a recording context, no device needed.
+    auto RunStateTrackerBenchmark(const uint32_t drawCount, const uint32_t pointLightCount, const uint32_t frameCount) -> void {
+        // the passes Program sets up: geometry, lighting, one fullscreen effect, composer
+        struct BeDraw {
+            uint32_t Shader, TextureSet, Material, VertexStream, IndexFormat;
+        };
+        std::mt19937 random(41);
+        auto pick = [&random](const uint32_t count) { return static_cast<uint32_t>(random() % count); };
+        std::vector<BeDraw> draws(drawCount);
+
+        uint32_t token = 1;
+        auto next = [&token] { return token++; };
+        ID3D11Buffer* uniformBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11Buffer* instanceBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11Buffer* directionalLightBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11Buffer* pointLightBuffer = MakeToken<ID3D11Buffer>(next());
+        ID3D11SamplerState* pointSampler = MakeToken<ID3D11SamplerState>(next());
+        ID3D11VertexShader* fullscreenShader = MakeToken<ID3D11VertexShader>(next());
+        std::array<ID3D11InputLayout*, 2> geometryLayouts = {MakeToken<ID3D11InputLayout>(next()), MakeToken<ID3D11InputLayout>(next())};
+        std::array<ID3D11VertexShader*, 2> geometryVertexShaders = {MakeToken<ID3D11VertexShader>(next()), MakeToken<ID3D11VertexShader>(next())};
+        std::array<ID3D11PixelShader*, 2> geometryPixelShaders = {MakeToken<ID3D11PixelShader>(next()), MakeToken<ID3D11PixelShader>(next())};
+        std::array<ID3D11Buffer*, 2> vertexStreams = {MakeToken<ID3D11Buffer>(next()), MakeToken<ID3D11Buffer>(next())};
+        std::array<ID3D11Buffer*, 2> indexBuffers = {MakeToken<ID3D11Buffer>(next()), MakeToken<ID3D11Buffer>(next())};
+        std::vector<ID3D11Buffer*> materialBuffers(64);
+        for (auto& buffer : materialBuffers) buffer = MakeToken<ID3D11Buffer>(next());
+        std::vector<ID3D11ShaderResourceView*> textures(96);
+        for (auto& texture : textures) texture = MakeToken<ID3D11ShaderResourceView>(next());
+        ID3D11PixelShader* directionalLightShader = MakeToken<ID3D11PixelShader>(next());
+        ID3D11PixelShader* pointLightShader = MakeToken<ID3D11PixelShader>(next());
+        ID3D11PixelShader* effectShader = MakeToken<ID3D11PixelShader>(next());
+        ID3D11PixelShader* composerShader = MakeToken<ID3D11PixelShader>(next());
+        ID3D11BlendState* additiveBlend = MakeToken<ID3D11BlendState>(next());
+        ID3D11BlendState* opaqueBlend = MakeToken<ID3D11BlendState>(next());
+        ID3D11DepthStencilState* depthTest = MakeToken<ID3D11DepthStencilState>(next());
+        ID3D11DepthStencilState* noDepth = MakeToken<ID3D11DepthStencilState>(next());
+        ID3D11RasterizerState* rasterizer = MakeToken<ID3D11RasterizerState>(next());
+        // depth, gbuffer 0-2, lighting, effect output, each as target and resource
+        std::array<ID3D11RenderTargetView*, 6> targetViews {};
+        std::array<ID3D11ShaderResourceView*, 6> resourceViews {};
+        for (auto& view : targetViews) view = MakeToken<ID3D11RenderTargetView>(next());
+        for (auto& view : resourceViews) view = MakeToken<ID3D11ShaderResourceView>(next());
+        ID3D11DepthStencilView* depthTarget = MakeToken<ID3D11DepthStencilView>(next());
+        ID3D11RenderTargetView* backbuffer = MakeToken<ID3D11RenderTargetView>(next());
+
+        constexpr uint32_t TriangleList = 4, TriangleStrip = 5;
+        std::array<BePipelineState, 2> geometryPipelines;
+        for (uint32_t s = 0; s < 2; ++s)
+            geometryPipelines[s] = {geometryLayouts[s], geometryVertexShaders[s], geometryPixelShaders[s], opaqueBlend, depthTest, rasterizer, TriangleList};
+        const BePipelineState directionalLightPipeline = {nullptr, fullscreenShader, directionalLightShader, additiveBlend, noDepth, rasterizer, TriangleStrip};
+        const BePipelineState pointLightPipeline = {nullptr, fullscreenShader, pointLightShader, additiveBlend, noDepth, rasterizer, TriangleStrip};
+        const BePipelineState effectPipeline = {nullptr, fullscreenShader, effectShader, opaqueBlend, noDepth, rasterizer, TriangleStrip};
+        const BePipelineState composerPipeline = {nullptr, fullscreenShader, composerShader, opaqueBlend, noDepth, rasterizer, TriangleStrip};
+
+        BeRecordingContext before;
+        BeRecordingContext after;
+        BeStateTracker tracker(after);
+        std::vector<ID3D11ShaderResourceView*> nullViews(BeStateTracker::ShaderResourceSlots, nullptr);
+        std::vector<ID3D11RenderTargetView*> nullTargets(BeStateTracker::RenderTargetSlots, nullptr);
+        ID3D11Buffer* nullBuffer = nullptr;
+        ID3D11SamplerState* nullSampler = nullptr;
+        constexpr uint32_t zero = 0;
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            // the sorted draw list of a frame, shader first, then texture set and material
+            for (auto& draw : draws) {
+                draw.Shader = pick(8) == 0;
+                draw.TextureSet = pick(48);
+                draw.Material = pick(64);
+                draw.VertexStream = draw.Shader;
+                draw.IndexFormat = pick(2);
+            }
+            std::ranges::sort(draws, {}, [](const BeDraw& draw) { return std::tuple(draw.Shader, draw.TextureSet, draw.Material); });
+            const uint32_t instanceOffset = 64 * (frame % 3);
+
+            // every pass binds what it uses and unbinds it behind itself
+            {
+                BeRecordingContext& context = before;
+                context.SetVSConstantBuffers(0, 1, &uniformBuffer);
+                context.SetPSConstantBuffers(0, 1, &uniformBuffer);
+
+                const std::array<ID3D11RenderTargetView*, 3> gbuffer = {targetViews[1], targetViews[2], targetViews[3]};
+                context.SetRenderTargets(3, gbuffer.data(), depthTarget);
+                context.SetPrimitiveTopology(TriangleList);
+                context.SetPSSamplers(0, 1, &pointSampler);
+                const uint32_t instanceStride = 64;
+                context.SetVertexBuffers(1, 1, &instanceBuffer, &instanceStride, &instanceOffset);
+                const BeDraw* previous = nullptr;
+                for (const auto& draw : draws) {
+                    if (!previous || previous->Shader != draw.Shader) {
+                        context.SetInputLayout(geometryLayouts[draw.Shader]);
+                        context.SetVertexShader(geometryVertexShaders[draw.Shader]);
+                        context.SetPixelShader(geometryPixelShaders[draw.Shader]);
+                    }
+                    if (!previous || previous->VertexStream != draw.VertexStream) {
+                        const uint32_t stride = 32;
+                        context.SetVertexBuffers(0, 1, &vertexStreams[draw.VertexStream], &stride, &zero);
+                    }
+                    if (!previous || previous->IndexFormat != draw.IndexFormat)
+                        context.SetIndexBuffer(indexBuffers[draw.IndexFormat], 56 + draw.IndexFormat * 15, 0);
+                    if (!previous || previous->Material != draw.Material) {
+                        context.SetVSConstantBuffers(1, 1, &materialBuffers[draw.Material]);
+                        context.SetPSConstantBuffers(1, 1, &materialBuffers[draw.Material]);
+                    }
+                    if (!previous || previous->TextureSet != draw.TextureSet) {
+                        const std::array<ID3D11ShaderResourceView*, 2> set = {textures[2 * draw.TextureSet], textures[2 * draw.TextureSet + 1]};
+                        context.SetPSShaderResources(0, 2, set.data());
+                    }
+                    previous = &draw;
+                }
+                context.SetPSShaderResources(0, 2, nullViews.data());
+                context.SetVSConstantBuffers(1, 1, &nullBuffer);
+                context.SetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+                context.SetPSSamplers(0, 1, &nullSampler);
+                context.SetRenderTargets(3, nullTargets.data(), nullptr);
+
+                context.SetRenderTargets(1, &targetViews[4], nullptr);
+                context.SetBlendState(additiveBlend);
+                context.SetVertexShader(fullscreenShader);
+                for (uint32_t i = 0; i < 4; ++i) context.SetPSShaderResources(i, 1, &resourceViews[i]);
+                context.SetPSSamplers(0, 1, &pointSampler);
+                context.SetPSConstantBuffers(1, 1, &directionalLightBuffer);
+                context.SetPixelShader(directionalLightShader);
+                context.SetInputLayout(nullptr);
+                context.SetPrimitiveTopology(TriangleStrip);
+                context.SetPixelShader(pointLightShader);
+                for (uint32_t i = 0; i < pointLightCount; ++i) {
+                    context.SetPSConstantBuffers(1, 1, &pointLightBuffer);
+                    context.SetInputLayout(nullptr);
+                    context.SetPrimitiveTopology(TriangleStrip);
+                }
+                context.SetPSShaderResources(0, 4, nullViews.data());
+                context.SetPSConstantBuffers(1, 1, &nullBuffer);
+                context.SetPSSamplers(0, 1, &nullSampler);
+                context.SetRenderTargets(1, nullTargets.data(), nullptr);
+                context.SetBlendState(nullptr);
+
+                context.SetPSShaderResources(0, 1, &resourceViews[4]);
+                context.SetRenderTargets(1, &targetViews[5], nullptr);
+                context.SetPSSamplers(0, 1, &pointSampler);
+                context.SetVertexShader(fullscreenShader);
+                context.SetPixelShader(effectShader);
+                context.SetInputLayout(nullptr);
+                context.SetPrimitiveTopology(TriangleStrip);
+                context.SetPSShaderResources(0, 1, nullViews.data());
+                context.SetRenderTargets(1, nullTargets.data(), nullptr);
+                context.SetPSSamplers(0, 1, &nullSampler);
+
+                context.SetRenderTargets(1, &backbuffer, nullptr);
+                for (uint32_t i = 0; i < 4; ++i) context.SetPSShaderResources(i, 1, &resourceViews[i]);
+                context.SetPSShaderResources(4, 1, &resourceViews[5]);
+                context.SetPSSamplers(0, 1, &pointSampler);
+                context.SetVertexShader(fullscreenShader);
+                context.SetPixelShader(composerShader);
+                context.SetInputLayout(nullptr);
+                context.SetPrimitiveTopology(TriangleStrip);
+                context.SetPSShaderResources(0, 4, nullViews.data());
+                context.SetPSSamplers(0, 1, &nullSampler);
+                context.SetRenderTargets(1, nullTargets.data(), nullptr);
+
+                context.SetVSConstantBuffers(1, 1, &nullBuffer);
+                context.SetPSConstantBuffers(1, 1, &nullBuffer);
+            }
+
+            // pipelines through the tracker, nothing unbound
+            {
+                tracker.SetVSConstantBuffer(0, uniformBuffer);
+                tracker.SetPSConstantBuffer(0, uniformBuffer);
+
+                const std::array<ID3D11RenderTargetView*, 3> gbuffer = {targetViews[1], targetViews[2], targetViews[3]};
+                tracker.SetRenderTargets(gbuffer, depthTarget);
+                tracker.SetPSSampler(0, pointSampler);
+                tracker.SetVertexBuffer(1, instanceBuffer, 64, instanceOffset);
+                const BeDraw* previous = nullptr;
+                for (const auto& draw : draws) {
+                    if (!previous || previous->Shader != draw.Shader)
+                        tracker.SetPipeline(geometryPipelines[draw.Shader]);
+                    tracker.SetVertexBuffer(0, vertexStreams[draw.VertexStream], 32, 0);
+                    tracker.SetIndexBuffer(indexBuffers[draw.IndexFormat], 56 + draw.IndexFormat * 15);
+                    if (!previous || previous->Material != draw.Material) {
+                        tracker.SetVSConstantBuffer(1, materialBuffers[draw.Material]);
+                        tracker.SetPSConstantBuffer(1, materialBuffers[draw.Material]);
+                    }
+                    if (!previous || previous->TextureSet != draw.TextureSet) {
+                        const std::array<ID3D11ShaderResourceView*, 2> set = {textures[2 * draw.TextureSet], textures[2 * draw.TextureSet + 1]};
+                        tracker.SetPSShaderResources(0, set);
+                    }
+                    previous = &draw;
+                }
+
+                tracker.SetRenderTargets(std::span(&targetViews[4], 1), nullptr);
+                tracker.SetPSShaderResources(0, std::span(resourceViews).first(4));
+                tracker.SetPSSampler(0, pointSampler);
+                tracker.SetPSConstantBuffer(1, directionalLightBuffer);
+                tracker.SetPipeline(directionalLightPipeline);
+                tracker.SetPipeline(pointLightPipeline);
+                for (uint32_t i = 0; i < pointLightCount; ++i)
+                    tracker.SetPSConstantBuffer(1, pointLightBuffer);
+
+                tracker.SetRenderTargets(std::span(&targetViews[5], 1), nullptr);
+                tracker.SetPSShaderResources(0, std::span(&resourceViews[4], 1));
+                tracker.SetPSSampler(0, pointSampler);
+                tracker.SetPipeline(effectPipeline);
+
+                tracker.SetRenderTargets(std::span(&backbuffer, 1), nullptr);
+                const std::array<ID3D11ShaderResourceView*, 5> composerInputs = {resourceViews[0], resourceViews[1], resourceViews[2], resourceViews[3], resourceViews[5]};
+                tracker.SetPSShaderResources(0, composerInputs);
+                tracker.SetPSSampler(0, pointSampler);
+                tracker.SetPipeline(composerPipeline);
+            }
+        }
+
+        std::cout << std::format("---- State tracker benchmark ({} draws, {} point lights, {} frames) ----\n", drawCount, pointLightCount, frameCount);
+        std::cout << std::format("bind and unbind per pass  {:>8.1f} calls per frame, {:>7.1f} changing nothing\n",
+            double(before.Calls) / frameCount, double(before.UnchangedCalls) / frameCount);
+        std::cout << std::format("pipelines and tracker     {:>8.1f} calls per frame, {:>7.1f} changing nothing, {:.1f} requested\n",
+            double(after.Calls) / frameCount, double(after.UnchangedCalls) / frameCount, double(tracker.GetStatistics().Requested) / frameCount);
+    }
+}
+
+BE_BENCHMARK(StateTracker) {
+    RunStateTrackerBenchmark(2000, 16, 300);
+}
@@ -0,0 +1,93 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeTextureResidency.h"
+
+namespace {
+    // mip chain sizes of a texture with 4 bytes per texel, or 8 or 16 bytes per 4x4 block when block compressed
+    auto MakeLevels(uint32_t width, uint32_t height, const uint32_t blockBytes) -> std::vector<BeTextureResidency::BeLevel> {
+        std::vector<BeTextureResidency::BeLevel> levels;
+        while (true) {
+            const size_t bytes = blockBytes == 0
+                ? size_t(width) * height * 4
+                : size_t((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+            levels.push_back({width, height, bytes, blockBytes == 0 || (width % 4 == 0 && height % 4 == 0)});
+            if (width == 1 && height == 1) break;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        return levels;
+    }
+}
+
+// Thousands of synthetic textures under a small budget with a wandering working set: textures sit along a line of 2x
+// the texture count units, the camera goes back and forth over it and sees the ones within 64 units, asking for finer
+// levels the closer they are. Prints the update cost next to the CPU copy of the chains the streamer keeps as its
+// source, and checks the accounting after every frame.
+BE_BENCHMARK(TextureStreamer) {
+    constexpr uint32_t textureCount = 4096;
+    constexpr size_t budgetBytes = 64ull << 20;
+    constexpr uint32_t frameCount = 1000;
+
+    std::mt19937 random(7);
+    std::vector<std::shared_ptr<int>> textures;
+    std::vector<std::vector<BeTextureResidency::BeLevel>> textureLevels;
+    std::vector<float> positions;
+    constexpr uint32_t blockBytes[] = {0, 8, 16};
+    BeTextureResidency residency(budgetBytes);
+    for (uint32_t i = 0; i < textureCount; ++i) {
+        const uint32_t size = 256u << (random() % 4);
+        textures.push_back(std::make_shared<int>());
+        textureLevels.push_back(MakeLevels(size, size >> (random() % 2), blockBytes[random() % std::size(blockBytes)]));
+        positions.push_back(float(random() % (2 * textureCount)));
+        residency.Register(textures.back(), textureLevels.back());
+    }
+    const size_t startBytes = residency.GetStatistics().ResidentBytes;
+
+    constexpr float ViewDistance = 64.0f;
+    constexpr float PixelsPerUnitAtOne = 2048.0f;
+    uint32_t failures = 0;
+    double updateMilliseconds = 0.0;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        const float phase = float(frame) / float(frameCount);
+        const float camera = float(2 * textureCount) * (phase < 0.5f ? 2.0f * phase : 2.0f - 2.0f * phase);
+        for (uint32_t i = 0; i < textureCount; ++i) {
+            if (!textures[i]) continue;
+            const float distance = std::abs(positions[i] - camera);
+            if (distance > ViewDistance) continue;
+            const float pixelsPerUnit = PixelsPerUnitAtOne / std::max(distance, 1.0f);
+            const auto& levels = textureLevels[i];
+            const uint32_t size = std::max(levels[0].Width, levels[0].Height);
+            residency.Request(textures[i].get(),
+                BeTextureResidency::ComputeRequiredMip(size, static_cast<uint32_t>(levels.size()), 1.0f, pixelsPerUnit));
+        }
+        // a texture dropped by its owner mid run
+        if (frame == frameCount / 3) textures[0].reset();
+
+        const auto start = std::chrono::steady_clock::now();
+        residency.Update();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        updateMilliseconds += elapsed.count();
+
+        const size_t resident = residency.GetStatistics().ResidentBytes;
+        if (!residency.ValidateAccounting() || resident > std::max(budgetBytes, startBytes)) ++failures;
+    }
+
+    const auto statistics = residency.GetStatistics();
+    std::cout << std::format("Texture streaming stress: {} textures, {:.1f} MB budget, {:.1f} MB start levels, {} frames, {:.3f} ms per update, {} failed checks\n",
+        textureCount, double(budgetBytes) / (1024.0 * 1024.0), double(startBytes) / (1024.0 * 1024.0), frameCount, updateMilliseconds / frameCount, failures);
+    std::cout << std::format("Peak {:.1f} MB resident, {:.1f} MB of CPU chains, {:.1f} MB in, {:.1f} MB out, {} evictions, {:.1f}% of requests resident\n",
+        double(statistics.PeakResidentBytes) / (1024.0 * 1024.0),
+        double(statistics.ChainBytes) / (1024.0 * 1024.0),
+        double(statistics.StreamedInBytes) / (1024.0 * 1024.0),
+        double(statistics.StreamedOutBytes) / (1024.0 * 1024.0),
+        statistics.Evictions,
+        statistics.Requests > 0 ? 100.0 * double(statistics.SatisfiedRequests) / double(statistics.Requests) : 100.0);
+}
@@ -0,0 +1,57 @@
+﻿#include <cmath>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BeBenchmark.h"
+#include "BeBuffers.h"
+#include "BeUploadRing.h"
+#include "BeVertexLayout.h"
+
+namespace {
+    // Map calls and bytes a frame of the geometry pass uploads with a material Map per draw and the instance buffer
+    // discarded every frame, against immutable material buffers and instances in a ring.
+    auto RunUploadRingBenchmark(const uint32_t objectCount, const uint32_t frameCount) -> void {
+        // a camera turning around a level: a varying share of the objects in view, each drawing a few of its slices
+        constexpr uint32_t RingFrames = 3;
+        std::mt19937 random(31);
+        std::vector<uint32_t> sliceCounts(objectCount);
+        for (auto& sliceCount : sliceCounts) sliceCount = 1 + random() % 8;
+        constexpr uint32_t MaterialCount = 900;
+
+        BeUploadRing ring(objectCount * InstanceStride * RingFrames);
+        uint64_t beforeMaps = 0, beforeBytes = 0;
+        uint64_t afterMaps = 0, afterDiscards = 0, afterBytes = 0;
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            const float inView = 0.5f + 0.5f * std::abs(std::sin(float(frame) * 0.05f));
+            uint32_t instances = 0, draws = 0;
+            for (uint32_t object = 0; object < objectCount; ++object) {
+                if (float(random() % 1000) >= inView * 1000.0f) continue;
+                ++instances;
+                draws += 1 + random() % sliceCounts[object];
+            }
+            if (instances == 0) continue;
+
+            // one WRITE_DISCARD of the instance buffer, then a WRITE_DISCARD of the material buffer for every draw
+            beforeMaps += 1 + draws;
+            beforeBytes += uint64_t(instances) * InstanceStride + uint64_t(draws) * sizeof(MaterialBufferGPU);
+
+            const BeUploadRing::BeAllocation allocation = ring.Allocate(instances * InstanceStride, InstanceStride);
+            ++afterMaps;
+            afterDiscards += allocation.Wrapped;
+            afterBytes += uint64_t(instances) * InstanceStride;
+        }
+
+        std::cout << std::format("---- Upload ring benchmark ({} objects, {} frames, ring of {} frames) ----\n", objectCount, frameCount, RingFrames);
+        std::cout << std::format("material Map per draw    {:>9.1f} maps {:>10.1f} KB per frame\n",
+            double(beforeMaps) / frameCount, double(beforeBytes) / 1024.0 / frameCount);
+        std::cout << std::format("immutable materials, ring {:>8.1f} maps {:>10.1f} KB per frame, {:.2f} discards per frame, {:.1f} KB of materials once\n",
+            double(afterMaps) / frameCount, double(afterBytes) / 1024.0 / frameCount, double(afterDiscards) / frameCount,
+            double(MaterialCount * sizeof(MaterialBufferGPU)) / 1024.0);
+    }
+}
+
+BE_BENCHMARK(UploadRing) {
+    RunUploadRingBenchmark(10000, 300);
+}
@@ -0,0 +1,32 @@
+﻿#include <filesystem>
+#include <format>
+#include <iostream>
+
+#include "BeAssetImporter.h"
+#include "BeBenchmark.h"
+#include "BeVertexPacking.h"
+
+// Bytes per vertex of every model under assets in the layout the standard shader reads, and what the quantisation
+// costs.
+BE_BENCHMARK(VertexPacking) {
+    BeAssetImporter importer;
+    std::cout << "---- Vertex Packing ----\n";
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+
+        const auto model = importer.ImportModel(entry.path());
+        const auto statistics = BeVertexPacking::Measure(model->FullVertices, StandardVertexLayout);
+        std::cout << std::format(
+            "Vertices {}: {} x {} B -> {} B ({:.1f} KB -> {:.1f} KB), max normal error {:.3f} deg, max UV error {:.6f}\n",
+            entry.path().string(),
+            statistics.VertexCount,
+            sizeof(BeFullVertex),
+            statistics.PackedStride,
+            double(statistics.VertexCount) * sizeof(BeFullVertex) / 1024.0,
+            double(statistics.VertexCount) * statistics.PackedStride / 1024.0,
+            statistics.MaxNormalErrorDegrees,
+            statistics.MaxTexCoordError);
+    }
+}
@@ -18,16 +18,8 @@ if _ACTION == "vs2022" or _ACTION == "vs2019" then
 end
 
 
--- workspace and project definitions
-workspace "Be"
-    configurations { "Debug", "Release" }
-    system "windows"
-    architecture "x86_64"  
-    location "."
-    startproject "Engine"
-
-project "Engine"
-    kind "ConsoleApp"
+-- settings shared by every project built from the engine sources
+local function engineProject()
     language "C++"
     cppdialect "C++20"
 
@@ -39,12 +31,7 @@ project "Engine"
         "src/**.c", 
         "src/**.h", 
         "src/**.hpp",
-        "src/**.hlsl",
-        "src/**.hlsli",
-        "assets/**.hlsl", 
-        "assets/**.hlsli", 
     }
-    
 
     includedirs { "src", "src/shaders", "vendor/glfw/include", "vendor/glm", "vendor/Assimp/include", "vendor/stb_image" }
     libdirs { "vendor/glfw/lib-vc2022", "vendor/Assimp/lib/x64" }
@@ -71,11 +58,52 @@ project "Engine"
         buildoptions { "/Zc:__cplusplus" }
 
     filter {}
+end
+
+-- workspace and project definitions
+workspace "Be"
+    configurations { "Debug", "Release" }
+    system "windows"
+    architecture "x86_64"  
+    location "."
+    startproject "Engine"
+
+project "Engine"
+    kind "ConsoleApp"
+    engineProject()
+
+    files {
+        "src/**.hlsl",
+        "src/**.hlsli",
+        "assets/**.hlsl", 
+        "assets/**.hlsli", 
+    }
+
+-- the engine without its entry point plus the benchmarks, runs from the repository root
+project "Benchmarks"
+    kind "ConsoleApp"
+    engineProject()
+
+    files { "benchmarks/**.cpp", "benchmarks/**.h" }
+    removefiles { "src/main.cpp", "src/Program.cpp", "src/Program.h" }
+    includedirs { "benchmarks", "tests" }
+    debugdir "%{wks.location}"
+
+-- the engine without its entry point plus the tests, exits non zero when a check fails
+project "Tests"
+    kind "ConsoleApp"
+    engineProject()
+
+    files { "tests/**.cpp", "tests/**.h" }
+    removefiles { "src/main.cpp", "src/Program.cpp", "src/Program.h" }
+    includedirs { "tests" }
+    debugdir "%{wks.location}"
 
 project "MiscConfiguration"
     kind "Utility"
     files {
         "premake5.lua",
+        "CMakeLists.txt",
         ".gitignore",
         ".guidelines",
         "README.md",
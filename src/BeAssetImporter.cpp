@@ -3,32 +3,97 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/type_ptr.hpp>
+
+#include "BeLod.h"
+#include "BeMeshOptimizer.h"
+#include "BeMeshlets.h"
+#include "BeOcclusionBuffer.h"
+#include "BePixelKernels.h"
+#include "BeTextureCompressor.h"
+#include "BeThreadPool.h"
 #include "Utils.h"
 
-BeAssetImporter::BeAssetImporter(const ComPtr<ID3D11Device>& device) {
+BeAssetImporter::BeAssetImporter(const ComPtr<ID3D11Device>& device, std::shared_ptr<BeTextureCache> textureCache) {
     _device = device;
+    _textureCache = textureCache ? std::move(textureCache) : std::make_shared<BeTextureCache>();
+}
+
+auto BeAssetImporter::UploadModel(const ComPtr<ID3D11Device>& device, const BeModel& model) -> void {
+    for (const auto& slice : model.DrawSlices) {
+        if (slice.Material.DiffuseTexture && !slice.Material.DiffuseTexture->SRV)
+            slice.Material.DiffuseTexture->CreateSRV(device);
+        if (slice.Material.SpecularTexture && !slice.Material.SpecularTexture->SRV)
+            slice.Material.SpecularTexture->CreateSRV(device);
+    }
 }
 
 auto BeAssetImporter::LoadModel(const std::filesystem::path& modelPath) -> std::shared_ptr<BeModel> {
-    constexpr auto flags = (
-        aiProcess_Triangulate |
-        aiProcess_GenNormals |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_CalcTangentSpace |
-        aiProcess_ValidateDataStructure |
-        aiProcess_OptimizeMeshes |
-        aiProcess_OptimizeGraph);
-
-    const aiScene* scene = _importer.ReadFile(modelPath.string().c_str(), flags);
+    auto model = ImportModel(modelPath);
+    UploadModel(_device, *model);
+    return model;
+}
+
+auto BeAssetImporter::ImportModel(const std::filesystem::path& modelPath) -> std::shared_ptr<BeModel> {
+    const auto startTime = std::chrono::steady_clock::now();
+    _textureCache->EvictExpired(); // textures of models released since the last import
+    auto model = std::make_shared<BeModel>();
+    std::vector<BeTextureReference> textures;
+
+    const uint64_t cacheKey = _modelCache.ComputeKey(modelPath, ImportFlags);
+    if (UseModelCache) {
+        // the cooked file has to stay mapped until the embedded textures are decoded
+        if (const auto cooked = _modelCache.TryLoad(modelPath, cacheKey, *model, textures)) {
+            model->ComputeBounds();
+            ResolveTextures(*model, textures);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+            std::cout << std::format("Loaded cooked {} in {:.2f} ms\n", modelPath.string(), elapsed.count());
+            return model;
+        }
+    }
+
+    ImportScene(modelPath, *model, textures);
+    // replaces Assimp's ImproveCacheLocality, so the cooked entry already holds the optimised order
+    BeMeshOptimizer::Optimize(*model);
+    BeLod::Generate(*model);
+    BeMeshlets::Build(*model);
+    model->ComputeBounds();
+    BeOcclusionBuffer::GenerateOccluder(*model);
+    _modelCache.Store(modelPath, cacheKey, *model, textures);
+    ResolveTextures(*model, textures);
+    _importer.FreeScene();
+
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+    std::cout << std::format("Imported {} in {:.2f} ms\n", modelPath.string(), elapsed.count());
+    return model;
+}
+
+auto BeAssetImporter::ImportGeometry(const std::filesystem::path& modelPath) -> BeModel {
+    BeModel model;
+    std::vector<BeTextureReference> textures;
+    ImportScene(modelPath, model, textures);
+    _importer.FreeScene();
+    return model;
+}
+
+auto BeAssetImporter::ImportScene(
+    const std::filesystem::path& modelPath,
+    BeModel& model,
+    std::vector<BeTextureReference>& textures)
+-> void {
+
+    const aiScene* scene = _importer.ReadFile(modelPath.string().c_str(), ImportFlags);
     if (!scene || !scene->mRootNode)
         throw std::runtime_error("Failed to load model: " + modelPath.string());
     
     Utils::PrintSceneInfo(scene);
 
 
-    auto model = std::make_shared<BeModel>();
-    model->DrawSlices.reserve(scene->mNumMeshes);
+    model.DrawSlices.reserve(scene->mNumMeshes);
 
     size_t numVertices = 0;
     size_t numIndices = 0;
@@ -38,8 +103,8 @@ auto BeAssetImporter::LoadModel(const std::filesystem::path& modelPath) -> std::
         numIndices += 3 * mesh->mNumFaces;
     }
 
-    model->FullVertices.reserve(numVertices); 
-    model->Indices.reserve(numIndices);
+    model.FullVertices.reserve(numVertices); 
+    model.Indices.reserve(numIndices);
     
     int32_t vertexOffset = 0; // indexing in each mesh starts from 0
     uint32_t indexOffset = 0;
@@ -60,27 +125,36 @@ auto BeAssetImporter::LoadModel(const std::filesystem::path& modelPath) -> std::
             vertex.UV0 = {texCoord0.x, texCoord0.y};
             vertex.UV1 = {texCoord1.x, texCoord1.y};
             vertex.UV2 = {texCoord2.x, texCoord2.y};
-            model->FullVertices.push_back(vertex);
+            model.FullVertices.push_back(vertex);
         }
         
         for (size_t f = 0; f < mesh->mNumFaces; ++f) {
             const aiFace& face = mesh->mFaces[f];
             if (face.mNumIndices != 3) continue;
-            model->Indices.push_back(face.mIndices[0]);
-            model->Indices.push_back(face.mIndices[2]);
-            model->Indices.push_back(face.mIndices[1]);
+            model.Indices.push_back(face.mIndices[0]);
+            model.Indices.push_back(face.mIndices[2]);
+            model.Indices.push_back(face.mIndices[1]);
         }
 
+        const auto sliceIndex = static_cast<uint32_t>(model.DrawSlices.size());
         auto meshMaterial = scene->mMaterials[mesh->mMaterialIndex];
         BeMaterial material;
         aiString texPath;
         constexpr int diffuseTexIndex = 0;
         if (meshMaterial->GetTexture(aiTextureType_DIFFUSE, diffuseTexIndex, &texPath) == AI_SUCCESS) {
-            material.DiffuseTexture = LoadTextureFromAssimpPath(texPath, scene, modelPath.parent_path());
+            textures.push_back({
+                .SliceIndex = sliceIndex,
+                .Slot = BeTextureReference::BeSlot::Diffuse,
+                .Source = ResolveTextureSource(texPath, scene, modelPath.parent_path())
+            });
         }
         constexpr int specularTexIndex = 0;
         if (meshMaterial->GetTexture(aiTextureType_SPECULAR, specularTexIndex, &texPath) == AI_SUCCESS) {
-            material.SpecularTexture = LoadTextureFromAssimpPath(texPath, scene, modelPath.parent_path());
+            textures.push_back({
+                .SliceIndex = sliceIndex,
+                .Slot = BeTextureReference::BeSlot::Specular,
+                .Source = ResolveTextureSource(texPath, scene, modelPath.parent_path())
+            });
         }
 
         aiColor4D color{};
@@ -96,7 +170,7 @@ auto BeAssetImporter::LoadModel(const std::filesystem::path& modelPath) -> std::
         }
         
         
-        model->DrawSlices.push_back({
+        model.DrawSlices.push_back({
             .IndexCount = mesh->mNumFaces * 3,
             .StartIndexLocation = indexOffset,
             .BaseVertexLocation = vertexOffset,
@@ -106,51 +180,90 @@ auto BeAssetImporter::LoadModel(const std::filesystem::path& modelPath) -> std::
         vertexOffset += mesh->mNumVertices;
         indexOffset += mesh->mNumFaces * 3;
     }
-    
-    return model;
+
+    // Nodes depth first, so parents come before their children; slice i is mesh i. Transforms get the same mirrored
+    // x axis as the vertices.
+    const glm::mat4 mirror = glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, 1.0f));
+    std::vector<std::pair<const aiNode*, uint32_t>> pending = {{scene->mRootNode, BeModel::NoParent}};
+    while (!pending.empty()) {
+        const auto [node, parent] = pending.back();
+        pending.pop_back();
+        const auto nodeIndex = static_cast<uint32_t>(model.Nodes.size());
+        model.Nodes.push_back({
+            .Transform = mirror * glm::transpose(glm::make_mat4(&node->mTransformation.a1)) * mirror,
+            .Parent = parent,
+            .FirstMesh = static_cast<uint32_t>(model.NodeMeshes.size()),
+            .MeshCount = node->mNumMeshes,
+        });
+        model.NodeMeshes.insert(model.NodeMeshes.end(), node->mMeshes, node->mMeshes + node->mNumMeshes);
+        for (uint32_t c = node->mNumChildren; c > 0; --c)
+            pending.emplace_back(node->mChildren[c - 1], nodeIndex);
+    }
 }
 
-auto BeAssetImporter::LoadTextureFromFile(const std::filesystem::path& texturePath) const -> std::shared_ptr<BeTexture> {
-    int w = 0, h = 0, channelsInFile = 0;
-    // Force 4 channels to standardize output layout as RGBA8.
-    uint8_t* decoded = stbi_load(texturePath.string().c_str(), &w, &h, &channelsInFile, 4);
-    if (!decoded) throw std::runtime_error("Failed to load texture from file: " + texturePath.string());
+auto BeAssetImporter::ResolveTextures(BeModel& model, const std::vector<BeTextureReference>& textures) const -> void {
+    // decode everything in parallel first, the slices are only touched afterwards on this thread.
+    // Repeated sources resolve to the texture already in the cache, or wait for the thread decoding it.
+    std::vector<std::shared_ptr<BeTexture>> decoded(textures.size());
+    // The mip chain depends on the slot and the compression, so both are part of the key.
+    BeThreadPool::Shared().ParallelFor(static_cast<uint32_t>(textures.size()), [&](const uint32_t i) {
+        const auto& source = textures[i].Source;
+        const bool diffuse = textures[i].Slot == BeTextureReference::BeSlot::Diffuse;
+        const auto key = BeTextureCache::MakeKey(source) + (diffuse ? "|diffuse" : "|specular") + (CompressTextures ? "|bc" : "");
+        decoded[i] = _textureCache->Acquire(key, [&] {
+            auto texture = DecodeTexture(source);
+            texture->GenerateMips(diffuse ? DiffuseMipSettings : SpecularMipSettings);
+            if (CompressTextures)
+                BeTextureCompressor::Compress(*texture);
+            return texture;
+        });
+    });
 
-    const size_t imageSize = static_cast<size_t>(w) * static_cast<size_t>(h) * 4; // RGBA8
-    const auto pixels = static_cast<uint8_t*>(malloc(imageSize));
-    if (!pixels) {
-        stbi_image_free(decoded);
-        throw std::runtime_error("Failed to allocate texture");
+    for (size_t i = 0; i < textures.size(); ++i) {
+        const auto& reference = textures[i];
+        auto& material = model.DrawSlices[reference.SliceIndex].Material;
+        auto texture = std::move(decoded[i]);
+        if (reference.Slot == BeTextureReference::BeSlot::Diffuse)
+            material.DiffuseTexture = std::move(texture);
+        else
+            material.SpecularTexture = std::move(texture);
     }
-    memcpy(pixels, decoded, imageSize);
-    stbi_image_free(decoded);
+}
 
-    auto texture = std::make_shared<BeTexture>();
-    texture->Pixels = pixels; // free with free()
-    texture->Width = w;
-    texture->Height = h;
-    texture->FlipVertically();
+auto BeAssetImporter::LoadTextureFromFile(const std::filesystem::path& texturePath) const -> std::shared_ptr<BeTexture> {
+    auto texture = DecodeTextureFromFile(texturePath);
+    texture->GenerateMips();
+    if (CompressTextures)
+        BeTextureCompressor::Compress(*texture);
     texture->CreateSRV(_device);
     return texture;
 }
 
-auto BeAssetImporter::LoadTextureFromAssimpPath(
+auto BeAssetImporter::DecodeTextureFromFile(const std::filesystem::path& texturePath) const -> std::shared_ptr<BeTexture> {
+    int w = 0, h = 0, channelsInFile = 0;
+    // Keep the native channel count, the expansion to RGBA8 is fused with the flip in AdoptDecodedPixels.
+    uint8_t* decoded = stbi_load(texturePath.string().c_str(), &w, &h, &channelsInFile, 0);
+    if (!decoded) throw std::runtime_error("Failed to load texture from file: " + texturePath.string());
+    return AdoptDecodedPixels(decoded, w, h, channelsInFile);
+}
+
+auto BeAssetImporter::ResolveTextureSource(
     const aiString& texPath,
     const aiScene* scene,
     const std::filesystem::path& parentPath)
-const -> std::shared_ptr<BeTexture> {
+const -> BeTextureSource {
     
     if (texPath.C_Str()[0] != '*') {
         const auto filename = std::filesystem::path (texPath.C_Str()).filename();
         std::filesystem::path path = parentPath / filename;
         if (std::filesystem::exists(path)) 
-            return LoadTextureFromFile(path);
+            return {.Kind = BeTextureSource::BeKind::File, .Path = path};
         path = parentPath / "textures" / filename;
         if (std::filesystem::exists(path)) 
-            return LoadTextureFromFile(path);
+            return {.Kind = BeTextureSource::BeKind::File, .Path = path};
         path = parentPath / "images" / filename;
         if (std::filesystem::exists(path)) 
-            return LoadTextureFromFile(path);
+            return {.Kind = BeTextureSource::BeKind::File, .Path = path};
         throw std::runtime_error("Texture file not found: " + filename.string());
         
     } // use stb_image
@@ -161,61 +274,76 @@ const -> std::shared_ptr<BeTexture> {
 
     // handle compressed texture
     if (aiTex->mHeight == 0) {
-        return LoadTextureFromMemoryEncoded(reinterpret_cast<const uint8_t*>(aiTex->pcData), aiTex->mWidth);
+        return {
+            .Kind = BeTextureSource::BeKind::EncodedMemory,
+            .Data = reinterpret_cast<const uint8_t*>(aiTex->pcData),
+            .Size = aiTex->mWidth,
+        };
     }
 
-    return LoadTextureFromMemoryDecoded(reinterpret_cast<const uint8_t*>(aiTex->pcData), aiTex->mWidth, aiTex->mHeight);
+    return {
+        .Kind = BeTextureSource::BeKind::DecodedMemory,
+        .Data = reinterpret_cast<const uint8_t*>(aiTex->pcData),
+        .Width = aiTex->mWidth,
+        .Height = aiTex->mHeight,
+    };
 }
 
-auto BeAssetImporter::LoadTextureFromMemoryEncoded(const uint8_t* data, uint32_t length) const -> std::shared_ptr<BeTexture> {
-    int w = 0, h = 0, channelsInFile = 0;
-
-    // Force 4 channels to standardize output layout as RGBA8.
-    uint8_t* decoded = stbi_load_from_memory(data, length, &w, &h, &channelsInFile, 4);
-    if (!decoded) throw std::runtime_error("Failed to decode texture");
-
-    // Allocate new space for the decoded image using your own allocator (malloc here)
-    const size_t imageSize = static_cast<size_t>(w) * static_cast<size_t>(h) * 4; // RGBA8
-    const auto pixels = static_cast<uint8_t*>(malloc(imageSize));
-    if (!pixels) {
-        stbi_image_free(decoded);
-        throw std::runtime_error("Failed to allocate texture");
+auto BeAssetImporter::DecodeTexture(const BeTextureSource& source) const -> std::shared_ptr<BeTexture> {
+    switch (source.Kind) {
+        case BeTextureSource::BeKind::File:
+            return DecodeTextureFromFile(source.Path);
+        case BeTextureSource::BeKind::EncodedMemory:
+            return DecodeTextureFromMemoryEncoded(source.Data, source.Size);
+        case BeTextureSource::BeKind::DecodedMemory:
+            return DecodeTextureFromMemoryDecoded(source.Data, source.Width, source.Height);
     }
-    memcpy(pixels, decoded, imageSize);
-    stbi_image_free(decoded);
+    throw std::runtime_error("Unknown texture source");
+}
 
-    auto texture = std::make_shared<BeTexture>();
-    texture->Pixels = pixels; // free with free()
-    texture->Width = w;
-    texture->Height = h;
-    texture->FlipVertically();
-    texture->CreateSRV(_device);
-    return texture;
+auto BeAssetImporter::DecodeTextureFromMemoryEncoded(const uint8_t* data, uint32_t length) const -> std::shared_ptr<BeTexture> {
+    int w = 0, h = 0, channelsInFile = 0;
+    // native channel count, as for files
+    uint8_t* decoded = stbi_load_from_memory(data, length, &w, &h, &channelsInFile, 0);
+    if (!decoded) throw std::runtime_error("Failed to decode texture");
+    return AdoptDecodedPixels(decoded, w, h, channelsInFile);
 }
 
-auto BeAssetImporter::LoadTextureFromMemoryDecoded(const uint8_t* data, uint32_t width, uint32_t height) const -> std::shared_ptr<BeTexture> {
+auto BeAssetImporter::DecodeTextureFromMemoryDecoded(const uint8_t* data, uint32_t width, uint32_t height) const -> std::shared_ptr<BeTexture> {
     const size_t count = width * height;
     if (count == 0) throw std::runtime_error("Failed to decode texture");
 
     const auto pixels = static_cast<uint8_t*>(malloc(count * 4));
     if (!pixels) throw std::runtime_error("Failed to allocate texture");
 
-    const uint8_t* src = data;
-    for (size_t i = 0; i < count; ++i) {
-        pixels[4 * i + 0] = src[4 * i + 2]; //r
-        pixels[4 * i + 1] = src[4 * i + 1]; //g
-        pixels[4 * i + 2] = src[4 * i + 0]; //b
-        pixels[4 * i + 3] = src[4 * i + 3]; //a
-    }
+    // BGRA -> RGBA and the vertical flip in one pass
+    BePixelKernels::SwizzleBGRAToRGBA(data, pixels, width, height, true);
 
     auto texture = std::make_shared<BeTexture>();
     texture->Pixels = pixels; // free with free()
     texture->Width = width;
     texture->Height = height;
-    texture->FlipVertically();
-    texture->CreateSRV(_device);
     return texture;
 }
 
+auto BeAssetImporter::AdoptDecodedPixels(uint8_t* decoded, const int width, const int height, const int channels) -> std::shared_ptr<BeTexture> {
+    uint8_t* pixels = decoded;
+    if (channels == 4) {
+        // stb allocates with malloc, so its buffer becomes the texture's without a copy
+        BePixelKernels::FlipVertically(pixels, width, height);
+    } else {
+        pixels = static_cast<uint8_t*>(malloc(static_cast<size_t>(width) * static_cast<size_t>(height) * 4));
+        if (!pixels) {
+            stbi_image_free(decoded);
+            throw std::runtime_error("Failed to allocate texture");
+        }
+        BePixelKernels::ExpandToRGBA(decoded, channels, pixels, width, height, true);
+        stbi_image_free(decoded);
+    }
 
-
+    auto texture = std::make_shared<BeTexture>();
+    texture->Pixels = pixels; // free with free()
+    texture->Width = width;
+    texture->Height = height;
+    return texture;
+}
@@ -1,8 +1,11 @@
 ﻿#pragma once
 #include <filesystem>
 #include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
 
 #include "BeModel.h"
+#include "BeModelCache.h"
+#include "BeTextureCache.h"
 #include "BeTexture.h"
 
 class BeAssetImporter {
@@ -12,21 +15,62 @@ private:
         uint32_t Width = 0;
         uint32_t Height = 0;
     };
-    
+
 public:
-    explicit BeAssetImporter(const ComPtr<ID3D11Device>& device);
+    // no OptimizeGraph or OptimizeMeshes: node transforms are kept and meshes several nodes use stay shared
+    static constexpr uint32_t ImportFlags = (
+        aiProcess_Triangulate |
+        aiProcess_GenNormals |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_CalcTangentSpace |
+        aiProcess_ValidateDataStructure);
+
+    // diffuse textures hold sRGB colour and feed the alpha test of the standard pixel shader (discard below 0.5),
+    // specular textures are plain data
+    static constexpr BeMipSettings DiffuseMipSettings {.SRGB = true, .AlphaCutoff = 0.5f};
+    static constexpr BeMipSettings SpecularMipSettings {.SRGB = false};
+
+public:
+    // Without a device the importer can still ImportModel, e.g. on a worker thread before the device exists.
+    // Importers that are handed the same texture cache share decoded textures, otherwise each gets its own.
+    explicit BeAssetImporter(const ComPtr<ID3D11Device>& device = nullptr, std::shared_ptr<BeTextureCache> textureCache = nullptr);
     ~BeAssetImporter() = default;
-    
+
+public:
+    // when off, models always go through Assimp; the cooked entry is still refreshed
+    bool UseModelCache = true;
+    // block compresses imported textures (BC1, or BC3 when alpha is used) after their mips are generated
+    bool CompressTextures = true;
+
 private:
     ComPtr<ID3D11Device> _device;
     Assimp::Importer _importer;
+    BeModelCache _modelCache {"cache/models"};
+    std::shared_ptr<BeTextureCache> _textureCache;
 
 public:
+    // Creates the GPU objects of an imported model. Must run on the thread that owns GPU object creation.
+    static auto UploadModel (const ComPtr<ID3D11Device>& device, const BeModel& model) -> void;
+
     [[nodiscard]] auto LoadModel (const std::filesystem::path& modelPath) -> std::shared_ptr<BeModel>;
+    // CPU side of LoadModel: geometry plus decoded textures, no GPU objects yet.
+    [[nodiscard]] auto ImportModel (const std::filesystem::path& modelPath) -> std::shared_ptr<BeModel>;
     [[nodiscard]] auto LoadTextureFromFile (const std::filesystem::path& texturePath) const -> std::shared_ptr<BeTexture>;
-    
+    [[nodiscard]] auto GetTextureCache() const -> const std::shared_ptr<BeTextureCache>& { return _textureCache; }
+
+    // Geometry and nodes as Assimp hands them over, before optimisation, LODs and meshlets, and without textures.
+    [[nodiscard]] auto ImportGeometry (const std::filesystem::path& modelPath) -> BeModel;
+    // RGBA8 top row first, no mips, not compressed.
+    [[nodiscard]] auto DecodeTextureFromFile (const std::filesystem::path& texturePath) const -> std::shared_ptr<BeTexture>;
+
 private:
-    auto LoadTextureFromAssimpPath (const aiString& texPath, const aiScene* scene, const std::filesystem::path& parentPath) const -> std::shared_ptr<BeTexture>;
-    auto LoadTextureFromMemoryEncoded (const uint8_t* data, uint32_t length) const -> std::shared_ptr<BeTexture>;
-    auto LoadTextureFromMemoryDecoded (const uint8_t* data, uint32_t width, uint32_t height) const -> std::shared_ptr<BeTexture>;
+    auto ImportScene (const std::filesystem::path& modelPath, BeModel& model, std::vector<BeTextureReference>& textures) -> void;
+    // Decodes the collected texture references across the thread pool, then patches them into the slice materials.
+    auto ResolveTextures (BeModel& model, const std::vector<BeTextureReference>& textures) const -> void;
+    auto ResolveTextureSource (const aiString& texPath, const aiScene* scene, const std::filesystem::path& parentPath) const -> BeTextureSource;
+    auto DecodeTexture (const BeTextureSource& source) const -> std::shared_ptr<BeTexture>;
+    auto DecodeTextureFromMemoryEncoded (const uint8_t* data, uint32_t length) const -> std::shared_ptr<BeTexture>;
+    auto DecodeTextureFromMemoryDecoded (const uint8_t* data, uint32_t width, uint32_t height) const -> std::shared_ptr<BeTexture>;
+    // Takes ownership of an stb_image result in its native channel count and turns it into a flipped RGBA8 texture.
+    static auto AdoptDecodedPixels (uint8_t* decoded, int width, int height, int channels) -> std::shared_ptr<BeTexture>;
 };
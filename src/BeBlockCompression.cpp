@@ -0,0 +1,360 @@
+﻿#include "BeBlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <glm.hpp>
+
+#include "BeThreadPool.h"
+
+namespace {
+    // weight of endpoint 0 for each index of the four colour palette
+    constexpr float ColorWeights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    auto Pack565(const glm::vec3& color) -> uint16_t {
+        const glm::vec3 clamped = glm::clamp(color, 0.0f, 255.0f);
+        const auto r = static_cast<uint32_t>(clamped.r * 31.0f / 255.0f + 0.5f);
+        const auto g = static_cast<uint32_t>(clamped.g * 63.0f / 255.0f + 0.5f);
+        const auto b = static_cast<uint32_t>(clamped.b * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    auto Unpack565(const uint16_t color) -> glm::vec3 {
+        const uint32_t r = (color >> 11) & 31;
+        const uint32_t g = (color >> 5) & 63;
+        const uint32_t b = color & 31;
+        return {float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2))};
+    }
+
+    // indices against the four colour palette of the endpoints, returns the squared error
+    auto FitColorIndices(const glm::vec3* colors, uint16_t& color0, uint16_t& color1, uint8_t* indices) -> float {
+        // color0 > color1 selects the four colour mode in BC1, BC3 always uses it
+        if (color0 < color1) std::swap(color0, color1);
+
+        const glm::vec3 endpoint0 = Unpack565(color0);
+        const glm::vec3 endpoint1 = Unpack565(color1);
+        if (color0 == color1) {
+            float error = 0.0f;
+            for (int i = 0; i < 16; ++i) {
+                const glm::vec3 difference = colors[i] - endpoint0;
+                error += glm::dot(difference, difference);
+                indices[i] = 0;
+            }
+            return error;
+        }
+
+        glm::vec3 palette[4];
+        for (int p = 0; p < 4; ++p)
+            palette[p] = endpoint0 * ColorWeights[p] + endpoint1 * (1.0f - ColorWeights[p]);
+
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            float bestDistance = std::numeric_limits<float>::max();
+            for (uint8_t p = 0; p < 4; ++p) {
+                const glm::vec3 difference = colors[i] - palette[p];
+                const float distance = glm::dot(difference, difference);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    indices[i] = p;
+                }
+            }
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    auto PrincipalAxis(const glm::vec3* colors, const glm::vec3& mean) -> glm::vec3 {
+        float xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+        for (int i = 0; i < 16; ++i) {
+            const glm::vec3 d = colors[i] - mean;
+            xx += d.x * d.x; xy += d.x * d.y; xz += d.x * d.z;
+            yy += d.y * d.y; yz += d.y * d.z; zz += d.z * d.z;
+        }
+
+        // power iteration, starting from the covariance row with the largest variance
+        glm::vec3 axis = xx >= yy && xx >= zz ? glm::vec3(xx, xy, xz) : yy >= zz ? glm::vec3(xy, yy, yz) : glm::vec3(xz, yz, zz);
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            const glm::vec3 next = {
+                xx * axis.x + xy * axis.y + xz * axis.z,
+                xy * axis.x + yy * axis.y + yz * axis.z,
+                xz * axis.x + yz * axis.y + zz * axis.z,
+            };
+            const float length = glm::length(next);
+            if (length < 1e-6f) break;
+            axis = next / length;
+        }
+        const float length = glm::length(axis);
+        return length < 1e-6f ? glm::vec3(0.57735f) : axis / length;
+    }
+
+    auto EncodeColorBlock(const uint8_t* texels, uint8_t* block) -> void {
+        glm::vec3 colors[16];
+        glm::vec3 mean(0.0f);
+        for (int i = 0; i < 16; ++i) {
+            colors[i] = {float(texels[4 * i + 0]), float(texels[4 * i + 1]), float(texels[4 * i + 2])};
+            mean += colors[i];
+        }
+        mean /= 16.0f;
+
+        // endpoints at the extremes of the colours projected on the principal axis
+        const glm::vec3 axis = PrincipalAxis(colors, mean);
+        float minProjection = std::numeric_limits<float>::max();
+        float maxProjection = std::numeric_limits<float>::lowest();
+        for (int i = 0; i < 16; ++i) {
+            const float projection = glm::dot(colors[i] - mean, axis);
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+        uint16_t color0 = Pack565(mean + axis * maxProjection);
+        uint16_t color1 = Pack565(mean + axis * minProjection);
+        uint8_t indices[16];
+        float error = FitColorIndices(colors, color0, color1, indices);
+
+        // least squares endpoints for the chosen indices, kept if they lower the error
+        float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+        glm::vec3 ax(0.0f), bx(0.0f);
+        for (int i = 0; i < 16; ++i) {
+            const float weight = ColorWeights[indices[i]];
+            aa += weight * weight;
+            bb += (1.0f - weight) * (1.0f - weight);
+            ab += weight * (1.0f - weight);
+            ax += colors[i] * weight;
+            bx += colors[i] * (1.0f - weight);
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) > 1e-6f) {
+            uint16_t refined0 = Pack565((ax * bb - bx * ab) / determinant);
+            uint16_t refined1 = Pack565((bx * aa - ax * ab) / determinant);
+            uint8_t refinedIndices[16];
+            const float refinedError = FitColorIndices(colors, refined0, refined1, refinedIndices);
+            if (refinedError < error) {
+                color0 = refined0;
+                color1 = refined1;
+                memcpy(indices, refinedIndices, sizeof(indices));
+            }
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; ++i)
+            bits |= uint32_t(indices[i]) << (2 * i);
+        memcpy(block + 0, &color0, 2);
+        memcpy(block + 2, &color1, 2);
+        memcpy(block + 4, &bits, 4);
+    }
+
+    auto EncodeAlphaBlock(const uint8_t* texels, uint8_t* block) -> void {
+        uint8_t alpha0 = 0;
+        uint8_t alpha1 = 255;
+        for (int i = 0; i < 16; ++i) {
+            alpha0 = std::max(alpha0, texels[4 * i + 3]);
+            alpha1 = std::min(alpha1, texels[4 * i + 3]);
+        }
+
+        // alpha0 > alpha1 selects the eight value mode, equal endpoints leave every index at 0
+        uint64_t bits = 0;
+        if (alpha0 > alpha1) {
+            int palette[8] = {alpha0, alpha1};
+            for (int k = 2; k < 8; ++k)
+                palette[k] = ((8 - k) * alpha0 + (k - 1) * alpha1 + 3) / 7;
+            for (int i = 0; i < 16; ++i) {
+                uint64_t bestIndex = 0;
+                int bestDistance = 256;
+                for (int p = 0; p < 8; ++p) {
+                    const int distance = std::abs(palette[p] - texels[4 * i + 3]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        bestIndex = p;
+                    }
+                }
+                bits |= bestIndex << (3 * i);
+            }
+        }
+
+        block[0] = alpha0;
+        block[1] = alpha1;
+        for (int byte = 0; byte < 6; ++byte)
+            block[2 + byte] = static_cast<uint8_t>(bits >> (8 * byte));
+    }
+
+    auto DecodeColorBlock(const uint8_t* block, uint8_t* texels, const bool forceFourColors) -> void {
+        uint16_t color0, color1;
+        uint32_t bits;
+        memcpy(&color0, block + 0, 2);
+        memcpy(&color1, block + 2, 2);
+        memcpy(&bits, block + 4, 4);
+
+        const glm::vec3 endpoint0 = Unpack565(color0);
+        const glm::vec3 endpoint1 = Unpack565(color1);
+        glm::vec4 palette[4] = {glm::vec4(endpoint0, 255.0f), glm::vec4(endpoint1, 255.0f)};
+        if (forceFourColors || color0 > color1) {
+            palette[2] = glm::vec4((2.0f * endpoint0 + endpoint1) / 3.0f, 255.0f);
+            palette[3] = glm::vec4((endpoint0 + 2.0f * endpoint1) / 3.0f, 255.0f);
+        } else {
+            palette[2] = glm::vec4((endpoint0 + endpoint1) / 2.0f, 255.0f);
+            palette[3] = glm::vec4(0.0f);
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            const glm::vec4& color = palette[(bits >> (2 * i)) & 3];
+            for (int c = 0; c < 4; ++c)
+                texels[4 * i + c] = static_cast<uint8_t>(color[c] + 0.5f);
+        }
+    }
+}
+
+auto BeBlockCompression::ChooseFormat(const uint8_t* pixels, const uint32_t width, const uint32_t height) -> BeBlockFormat {
+    if (width % 4 != 0 || height % 4 != 0) return BeBlockFormat::None;
+    const size_t pixelCount = size_t(width) * height;
+    for (size_t i = 0; i < pixelCount; ++i)
+        if (pixels[4 * i + 3] != 255) return BeBlockFormat::BC3;
+    return BeBlockFormat::BC1;
+}
+
+auto BeBlockCompression::GetBlockSize(const BeBlockFormat format) -> uint32_t {
+    switch (format) {
+        case BeBlockFormat::BC1: return 8;
+        case BeBlockFormat::BC3: return 16;
+        default: return 0;
+    }
+}
+
+auto BeBlockCompression::Layout(const std::vector<BeMipLevel>& levels, const BeBlockFormat format) -> std::vector<BeMipLevel> {
+    const uint32_t blockSize = GetBlockSize(format);
+    std::vector<BeMipLevel> blockLevels;
+    blockLevels.reserve(levels.size());
+    size_t offset = 0;
+    for (const auto& level : levels) {
+        blockLevels.push_back({.Width = level.Width, .Height = level.Height, .Offset = offset});
+        offset += size_t((level.Width + 3) / 4) * ((level.Height + 3) / 4) * blockSize;
+    }
+    return blockLevels;
+}
+
+auto BeBlockCompression::GetSizeInBytes(const std::vector<BeMipLevel>& blockLevels, const BeBlockFormat format) -> size_t {
+    if (blockLevels.empty()) return 0;
+    const BeMipLevel& last = blockLevels.back();
+    return last.Offset + size_t((last.Width + 3) / 4) * ((last.Height + 3) / 4) * GetBlockSize(format);
+}
+
+auto BeBlockCompression::Encode(
+    const uint8_t* pixels,
+    const std::vector<BeMipLevel>& levels,
+    const BeBlockFormat format,
+    uint8_t* blocks,
+    const std::vector<BeMipLevel>& blockLevels,
+    const bool parallel)
+-> void {
+    const uint32_t blockSize = GetBlockSize(format);
+    if (blockSize == 0) throw std::runtime_error("Not a block compressed format");
+    const auto encodeBlock = format == BeBlockFormat::BC1 ? EncodeBC1Block : EncodeBC3Block;
+
+    for (size_t level = 0; level < levels.size(); ++level) {
+        const auto& source = levels[level];
+        const uint8_t* sourcePixels = pixels + source.Offset;
+        uint8_t* targetBlocks = blocks + blockLevels[level].Offset;
+        const uint32_t blocksX = (source.Width + 3) / 4;
+        const uint32_t blocksY = (source.Height + 3) / 4;
+
+        auto encodeBlockRow = [&](const uint32_t blockY) {
+            uint8_t texels[64];
+            for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+                for (uint32_t ty = 0; ty < 4; ++ty) {
+                    const uint32_t y = std::min(blockY * 4 + ty, source.Height - 1);
+                    for (uint32_t tx = 0; tx < 4; ++tx) {
+                        const uint32_t x = std::min(blockX * 4 + tx, source.Width - 1);
+                        memcpy(texels + 4 * (4 * ty + tx), sourcePixels + 4 * (size_t(y) * source.Width + x), 4);
+                    }
+                }
+                encodeBlock(texels, targetBlocks + (size_t(blockY) * blocksX + blockX) * blockSize);
+            }
+        };
+        if (parallel)
+            BeThreadPool::Shared().ParallelFor(blocksY, encodeBlockRow);
+        else
+            for (uint32_t blockY = 0; blockY < blocksY; ++blockY) encodeBlockRow(blockY);
+    }
+}
+
+auto BeBlockCompression::EncodeBC1Block(const uint8_t* texels, uint8_t* block) -> void {
+    EncodeColorBlock(texels, block);
+}
+
+auto BeBlockCompression::EncodeBC3Block(const uint8_t* texels, uint8_t* block) -> void {
+    EncodeAlphaBlock(texels, block);
+    EncodeColorBlock(texels, block + 8);
+}
+
+auto BeBlockCompression::DecodeBC1Block(const uint8_t* block, uint8_t* texels) -> void {
+    DecodeColorBlock(block, texels, false);
+}
+
+auto BeBlockCompression::DecodeBC3Block(const uint8_t* block, uint8_t* texels) -> void {
+    DecodeColorBlock(block + 8, texels, true);
+
+    const int alpha0 = block[0];
+    const int alpha1 = block[1];
+    int palette[8] = {alpha0, alpha1};
+    if (alpha0 > alpha1) {
+        for (int k = 2; k < 8; ++k)
+            palette[k] = ((8 - k) * alpha0 + (k - 1) * alpha1 + 3) / 7;
+    } else {
+        for (int k = 2; k < 6; ++k)
+            palette[k] = ((6 - k) * alpha0 + (k - 1) * alpha1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t bits = 0;
+    for (int byte = 0; byte < 6; ++byte)
+        bits |= uint64_t(block[2 + byte]) << (8 * byte);
+    for (int i = 0; i < 16; ++i)
+        texels[4 * i + 3] = static_cast<uint8_t>(palette[(bits >> (3 * i)) & 7]);
+}
+
+auto BeBlockCompression::MeasureQuality(
+    const uint8_t* source,
+    const uint32_t width,
+    const uint32_t height,
+    const uint8_t* blocks,
+    const BeBlockFormat format)
+-> BeBlockQuality {
+    const uint32_t blockSize = GetBlockSize(format);
+    if (blockSize == 0) throw std::runtime_error("Not a block compressed format");
+    const auto decodeBlock = format == BeBlockFormat::BC1 ? DecodeBC1Block : DecodeBC3Block;
+
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    double colorError = 0.0;
+    double alphaError = 0.0;
+    uint8_t texels[64];
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY) {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX) {
+            decodeBlock(blocks + (size_t(blockY) * blocksX + blockX) * blockSize, texels);
+            for (uint32_t ty = 0; ty < 4 && blockY * 4 + ty < height; ++ty) {
+                for (uint32_t tx = 0; tx < 4 && blockX * 4 + tx < width; ++tx) {
+                    const uint8_t* original = source + 4 * (size_t(blockY * 4 + ty) * width + blockX * 4 + tx);
+                    const uint8_t* decoded = texels + 4 * (4 * ty + tx);
+                    for (int c = 0; c < 3; ++c) {
+                        const double difference = double(original[c]) - double(decoded[c]);
+                        colorError += difference * difference;
+                    }
+                    const double difference = double(original[3]) - double(decoded[3]);
+                    alphaError += difference * difference;
+                }
+            }
+        }
+    }
+
+    const double pixelCount = double(width) * double(height);
+    auto toPSNR = [](const double meanSquaredError) {
+        return meanSquaredError == 0.0
+            ? std::numeric_limits<double>::infinity()
+            : 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+    };
+    return {
+        .ColorPSNR = toPSNR(colorError / (pixelCount * 3.0)),
+        .AlphaPSNR = toPSNR(alphaError / pixelCount),
+    };
+}
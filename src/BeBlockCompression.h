@@ -0,0 +1,52 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "BeMipChain.h"
+
+enum class BeBlockFormat : uint8_t {
+    None,   // stays RGBA8
+    BC1,    // 8 bytes per 4x4 block, opaque
+    BC3,    // 16 bytes per 4x4 block, separate interpolated alpha
+};
+
+struct BeBlockQuality {
+    double ColorPSNR = 0.0;   // dB over RGB, infinite when lossless
+    double AlphaPSNR = 0.0;   // dB over A
+};
+
+// CPU block compression of RGBA8 mip chains. Endpoints come from the principal axis of the block colours, refined by
+// one least squares pass over the chosen indices. BeTextureCompressor owns the allocation and the D3D format, this
+// only lays the blocks out and fills them.
+namespace BeBlockCompression {
+
+    // None when the size is not a multiple of 4, as D3D11 requires it for BC formats. Otherwise BC1 when alpha is 255
+    // everywhere in level 0, BC3 when it is not.
+    [[nodiscard]] auto ChooseFormat(const uint8_t* pixels, uint32_t width, uint32_t height) -> BeBlockFormat;
+    [[nodiscard]] auto GetBlockSize(BeBlockFormat format) -> uint32_t;
+
+    // The levels of an RGBA8 chain with their offsets recomputed for blocks, packed one after the other.
+    [[nodiscard]] auto Layout(const std::vector<BeMipLevel>& levels, BeBlockFormat format) -> std::vector<BeMipLevel>;
+    [[nodiscard]] auto GetSizeInBytes(const std::vector<BeMipLevel>& blockLevels, BeBlockFormat format) -> size_t;
+
+    // Encodes every level of pixels into blocks laid out by Layout, block rows spread across the shared thread pool.
+    // Levels below 4x4 repeat their last row and column to fill the block.
+    auto Encode(
+        const uint8_t* pixels,
+        const std::vector<BeMipLevel>& levels,
+        BeBlockFormat format,
+        uint8_t* blocks,
+        const std::vector<BeMipLevel>& blockLevels,
+        bool parallel = true
+    ) -> void;
+
+    // A block is 16 RGBA8 texels in row order.
+    auto EncodeBC1Block(const uint8_t* texels, uint8_t* block) -> void;
+    auto EncodeBC3Block(const uint8_t* texels, uint8_t* block) -> void;
+    auto DecodeBC1Block(const uint8_t* block, uint8_t* texels) -> void;
+    auto DecodeBC3Block(const uint8_t* block, uint8_t* texels) -> void;
+
+    // Decodes the blocks of a width x height image and compares them with the source texels.
+    [[nodiscard]] auto MeasureQuality(const uint8_t* source, uint32_t width, uint32_t height, const uint8_t* blocks, BeBlockFormat format) -> BeBlockQuality;
+}
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include <cstddef>
 #include <glm.hpp>
 #include "BeModel.h"
 
@@ -8,6 +9,13 @@ struct UniformData {
     glm::vec3 CameraPosition {0.0f, 0.0f, 0.0f};
     
     glm::vec3 AmbientColor {0.0f, 0.0f, 0.0f};
+
+    // CPU only, turns model space error into pixels for LOD selection
+    float VerticalFov {glm::radians(90.0f)};
+    float ViewportHeight {1080.0f};
+    // filled in by the renderer every frame: target size in pixels and the share of it rendered at the render scale
+    glm::vec2 TargetSize {1920.0f, 1080.0f};
+    glm::vec2 RenderScale {1.0f, 1.0f};
     //glm::vec3 DirectionalLightColor {1.0f, 1.0f, 1.0f};
     //glm::vec3 DirectionalLightVector = glm::normalize(glm::vec3(-1.0f, -1.0f, 0.0f));
     //float DirectionalLightPower = 1.0f;
@@ -19,8 +27,10 @@ struct alignas(16) UniformBufferGPU {
     glm::vec4 NearFarPlane;             // 8  reg:  x = near, y = far, z = 1/near, w = 1/far
     glm::vec4 CameraPosition;           // 9  reg:  xyz = position, w unused
     glm::vec4 AmbientColor;             // 10 reg:  xyz = color, w unused
-    //glm::vec4 DirectionalLightVector;   // 11 reg:  xyz = direction, w unused
-    //glm::vec3 DirectionalLightColor;    // 12 reg:  xyz = color
+    glm::vec4 TargetSize;               // 11 reg:  xy = render target size in pixels, zw = 1 / xy
+    glm::vec4 RenderScale;              // 12 reg:  xy = share of the targets rendered, zw unused
+    //glm::vec4 DirectionalLightVector;   // 13 reg:  xyz = direction, w unused
+    //glm::vec3 DirectionalLightColor;    // 14 reg:  xyz = color
     //float DirectionalLightPower;        //          w = power
     
     explicit UniformBufferGPU(const UniformData& data) {
@@ -29,6 +39,8 @@ struct alignas(16) UniformBufferGPU {
         NearFarPlane = glm::vec4(data.NearFarPlane, 1.0f / data.NearFarPlane.x, 1.0f / data.NearFarPlane.y);
         CameraPosition = glm::vec4(data.CameraPosition, 0.0f);
         AmbientColor = glm::vec4(data.AmbientColor, 1.f);
+        TargetSize = glm::vec4(data.TargetSize, 1.0f / data.TargetSize.x, 1.0f / data.TargetSize.y);
+        RenderScale = glm::vec4(data.RenderScale, 0.0f, 0.0f);
         //DirectionalLightVector = glm::vec4(data.DirectionalLightVector, 0.0f);
         //DirectionalLightColor = data.DirectionalLightColor;
         //DirectionalLightPower = data.DirectionalLightPower;
@@ -37,16 +49,13 @@ struct alignas(16) UniformBufferGPU {
 
 
 struct alignas(16) MaterialBufferGPU {
-    glm::mat4x4 Model;
-
     glm::vec4 DiffuseColor  {1, 1, 1, 1};
     glm::vec3 SpecularColor {1, 1, 1};
     float Shininess = 32.f / 2048.f; // Scale down to [0, 1] range
     glm::vec3 SuperSpecularColor {1, 1, 1};
     float SuperSpecularPower = -1.f;
 
-    explicit MaterialBufferGPU(const glm::mat4x4& model, const BeMaterial& material) {
-        Model = model;
+    explicit MaterialBufferGPU(const BeMaterial& material) {
         DiffuseColor = glm::vec4(material.DiffuseColor, 1.f);
         SpecularColor = material.SpecularColor;
         Shininess = material.Shininess / 2048.f;
@@ -54,6 +63,10 @@ struct alignas(16) MaterialBufferGPU {
         SuperSpecularPower = material.SuperShininess;
     }
 };
+// cbuffer MaterialBuffer in BeMaterialBuffer.hlsli packs a float3 into each register and the floats into their w
+static_assert(sizeof(MaterialBufferGPU) == 48);
+static_assert(offsetof(MaterialBufferGPU, SpecularColor) == 16 && offsetof(MaterialBufferGPU, Shininess) == 28);
+static_assert(offsetof(MaterialBufferGPU, SuperSpecularColor) == 32 && offsetof(MaterialBufferGPU, SuperSpecularPower) == 44);
 
 struct DirectionalLightData {
     glm::vec3 Direction;
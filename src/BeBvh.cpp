@@ -0,0 +1,379 @@
+﻿#include "BeBvh.h"
+
+#include <algorithm>
+#include <array>
+
+#include "BeThreadPool.h"
+
+namespace {
+    using BeBox = BeBvh::BeBox;
+    using BeNode = BeBvh::BeNode;
+
+    // subtrees and binning passes at least this large are split across the pool
+    constexpr uint32_t ParallelSubtreeItems = 8192;
+    constexpr uint32_t ParallelBinningItems = 65536;
+    constexpr uint32_t BinningChunkItems = 16384;
+    constexpr uint32_t StackReserve = 64;
+
+    enum class BeOverlap : uint8_t { Outside, Intersecting, Inside };
+
+    auto MakeEmptyBox() -> BeBox {
+        return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+    }
+
+    auto Grow(BeBox& box, const BeBox& other) -> void {
+        box.Min = glm::min(box.Min, other.Min);
+        box.Max = glm::max(box.Max, other.Max);
+    }
+
+    auto Grow(BeBox& box, const glm::vec3& point) -> void {
+        box.Min = glm::min(box.Min, point);
+        box.Max = glm::max(box.Max, point);
+    }
+
+    auto GetHalfArea(const glm::vec3& min, const glm::vec3& max) -> float {
+        const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    auto Classify(const glm::vec3& min, const glm::vec3& max, const BeCulling::BePlanes& planes) -> BeOverlap {
+        const glm::vec3 center = (min + max) * 0.5f;
+        const glm::vec3 extent = (max - min) * 0.5f;
+        bool inside = true;
+        for (const auto& plane : planes) {
+            const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            const float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+            if (distance + radius < 0.0f) return BeOverlap::Outside;
+            if (distance - radius < 0.0f) inside = false;
+        }
+        return inside ? BeOverlap::Inside : BeOverlap::Intersecting;
+    }
+
+    auto TouchesSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, const float radius) -> bool {
+        const glm::vec3 offset = glm::clamp(center, min, max) - center;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // slab test, the entry distance or a negative value on a miss
+    auto IntersectRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, const float maxDistance) -> float {
+        const glm::vec3 t0 = (min - origin) * inverseDirection;
+        const glm::vec3 t1 = (max - origin) * inverseDirection;
+        const glm::vec3 near = glm::min(t0, t1);
+        const glm::vec3 far = glm::max(t0, t1);
+        const float enter = std::max({near.x, near.y, near.z, 0.0f});
+        const float exit = std::min({far.x, far.y, far.z, maxDistance});
+        return enter <= exit ? enter : -1.0f;
+    }
+
+    struct BeBin {
+        BeBox Bounds = MakeEmptyBox();
+        uint32_t Count = 0;
+    };
+
+    struct BeBinning {
+        std::array<std::array<BeBin, BeBvh::BinCount>, 3> Bins;
+
+        auto Merge(const BeBinning& other) -> void {
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                for (uint32_t bin = 0; bin < BeBvh::BinCount; ++bin) {
+                    Grow(Bins[axis][bin].Bounds, other.Bins[axis][bin].Bounds);
+                    Bins[axis][bin].Count += other.Bins[axis][bin].Count;
+                }
+            }
+        }
+    };
+
+    auto GetBin(const float centroid, const float minimum, const float scale) -> uint32_t {
+        return std::min(BeBvh::BinCount - 1, static_cast<uint32_t>(std::max(0.0f, (centroid - minimum) * scale)));
+    }
+
+    auto GetChunkCount(const uint32_t count, const bool parallel) -> uint32_t {
+        return parallel && count >= ParallelBinningItems ? (count + BinningChunkItems - 1) / BinningChunkItems : 1;
+    }
+
+    // body(chunk, begin, end) over the chunks of a range, on the pool when there is more than one
+    template <typename Body>
+    auto ForEachChunk(const uint32_t begin, const uint32_t end, const uint32_t chunkCount, const Body& body) -> void {
+        if (chunkCount == 1) {
+            body(0u, begin, end);
+            return;
+        }
+        BeThreadPool::Shared().ParallelFor(chunkCount, [&](const uint32_t chunk) {
+            body(chunk, begin + chunk * BinningChunkItems, std::min(end, begin + (chunk + 1) * BinningChunkItems));
+        });
+    }
+}
+
+auto BeBvh::Build(const std::span<const BeBox> boxes, const bool parallel) -> void {
+    const auto objectCount = static_cast<uint32_t>(boxes.size());
+    _nodes.assign(std::max(1u, 2 * objectCount), BeNode {});
+    _nodeCount = 1;
+
+    std::vector<BeBuildItem> buildItems(objectCount);
+    for (uint32_t i = 0; i < objectCount; ++i)
+        buildItems[i] = {.Box = boxes[i], .Centroid = (boxes[i].Min + boxes[i].Max) * 0.5f, .Object = i};
+
+    if (objectCount == 0) {
+        _nodes[0] = {.Min = glm::vec3(0.0f), .First = 0, .Max = glm::vec3(0.0f), .ItemCount = 0};
+    } else {
+        BuildNode(0, 0, objectCount, buildItems, parallel);
+    }
+    _nodes.resize(_nodeCount);
+
+    _items.resize(objectCount);
+    _itemBoxes.resize(objectCount);
+    _itemOfObject.resize(objectCount);
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        _items[i] = buildItems[i].Object;
+        _itemBoxes[i] = buildItems[i].Box;
+        _itemOfObject[_items[i]] = i;
+    }
+    _builtCost = ComputeCost();
+}
+
+auto BeBvh::BuildNode(
+    const uint32_t nodeIndex,
+    const uint32_t begin,
+    const uint32_t end,
+    const std::span<BeBuildItem> buildItems,
+    const bool parallel)
+-> void {
+    const uint32_t count = end - begin;
+
+    // node bounds and the centroid range the bins span
+    const uint32_t chunkCount = GetChunkCount(count, parallel);
+    std::vector<std::pair<BeBox, BeBox>> partialBounds(chunkCount, {MakeEmptyBox(), MakeEmptyBox()});
+    ForEachChunk(begin, end, chunkCount, [&](const uint32_t chunk, const uint32_t chunkBegin, const uint32_t chunkEnd) {
+        auto& [bounds, centroidBounds] = partialBounds[chunk];
+        for (uint32_t i = chunkBegin; i < chunkEnd; ++i) {
+            Grow(bounds, buildItems[i].Box);
+            Grow(centroidBounds, buildItems[i].Centroid);
+        }
+    });
+    BeBox bounds = MakeEmptyBox();
+    BeBox centroidBounds = MakeEmptyBox();
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+        Grow(bounds, partialBounds[chunk].first);
+        Grow(centroidBounds, partialBounds[chunk].second);
+    }
+
+    BeNode& node = _nodes[nodeIndex];
+    node.Min = bounds.Min;
+    node.Max = bounds.Max;
+    auto makeLeaf = [&] {
+        node.First = begin;
+        node.ItemCount = count;
+    };
+    if (count <= MaxLeafSize) {
+        makeLeaf();
+        return;
+    }
+
+    // bin centroids along all three axes
+    const glm::vec3 centroidExtent = centroidBounds.Max - centroidBounds.Min;
+    glm::vec3 binScale;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+        binScale[axis] = centroidExtent[axis] > 1e-12f ? float(BinCount) / centroidExtent[axis] : 0.0f;
+    std::vector<BeBinning> partialBins(chunkCount);
+    ForEachChunk(begin, end, chunkCount, [&](const uint32_t chunk, const uint32_t chunkBegin, const uint32_t chunkEnd) {
+        auto& binning = partialBins[chunk];
+        for (uint32_t i = chunkBegin; i < chunkEnd; ++i) {
+            const BeBuildItem& item = buildItems[i];
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                auto& bin = binning.Bins[axis][GetBin(item.Centroid[axis], centroidBounds.Min[axis], binScale[axis])];
+                Grow(bin.Bounds, item.Box);
+                ++bin.Count;
+            }
+        }
+    });
+    for (uint32_t chunk = 1; chunk < chunkCount; ++chunk)
+        partialBins[0].Merge(partialBins[chunk]);
+    const auto& bins = partialBins[0].Bins;
+
+    // cheapest plane between bins, a traversal step and an object test both cost 1
+    float bestCost = std::numeric_limits<float>::max();
+    uint32_t bestAxis = 0;
+    uint32_t bestSplit = 0;
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (binScale[axis] == 0.0f) continue;
+        std::array<float, BinCount> rightCost {};
+        BeBox right = MakeEmptyBox();
+        uint32_t rightCount = 0;
+        for (uint32_t bin = BinCount - 1; bin > 0; --bin) {
+            Grow(right, bins[axis][bin].Bounds);
+            rightCount += bins[axis][bin].Count;
+            rightCost[bin] = rightCount > 0 ? GetHalfArea(right.Min, right.Max) * float(rightCount) : 0.0f;
+        }
+        BeBox left = MakeEmptyBox();
+        uint32_t leftCount = 0;
+        for (uint32_t split = 1; split < BinCount; ++split) {
+            Grow(left, bins[axis][split - 1].Bounds);
+            leftCount += bins[axis][split - 1].Count;
+            if (leftCount == 0 || leftCount == count) continue;
+            const float cost = GetHalfArea(left.Min, left.Max) * float(leftCount) + rightCost[split];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = split;
+            }
+        }
+    }
+
+    uint32_t middle = begin;
+    if (bestSplit > 0) {
+        const float area = GetHalfArea(bounds.Min, bounds.Max);
+        const float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+        if (splitCost >= float(count) && count <= 4 * MaxLeafSize) {
+            makeLeaf();
+            return;
+        }
+        const auto items = buildItems.subspan(begin, count);
+        middle = begin + static_cast<uint32_t>(std::partition(items.begin(), items.end(), [&](const BeBuildItem& item) {
+            return GetBin(item.Centroid[bestAxis], centroidBounds.Min[bestAxis], binScale[bestAxis]) < bestSplit;
+        }) - items.begin());
+    }
+    // every centroid in one spot, any split is as good as another
+    if (middle == begin || middle == end)
+        middle = begin + count / 2;
+
+    const uint32_t children = _nodeCount.fetch_add(2, std::memory_order_relaxed);
+    node.First = children;
+    node.ItemCount = 0;
+    if (parallel && count >= ParallelSubtreeItems) {
+        BeThreadPool::Shared().ParallelFor(2, [&](const uint32_t child) {
+            if (child == 0) BuildNode(children, begin, middle, buildItems, parallel);
+            else BuildNode(children + 1, middle, end, buildItems, parallel);
+        });
+    } else {
+        BuildNode(children, begin, middle, buildItems, parallel);
+        BuildNode(children + 1, middle, end, buildItems, parallel);
+    }
+}
+
+auto BeBvh::Refit(const std::span<const BeBox> boxes) -> void {
+    for (uint32_t i = 0; i < _items.size(); ++i)
+        _itemBoxes[i] = boxes[_items[i]];
+    // children always come after their parent
+    for (uint32_t n = GetNodeCount(); n-- > 0;) {
+        BeNode& node = _nodes[n];
+        BeBox bounds = MakeEmptyBox();
+        if (node.ItemCount > 0) {
+            for (uint32_t i = node.First; i < node.First + node.ItemCount; ++i)
+                Grow(bounds, _itemBoxes[i]);
+        } else if (!_items.empty()) {
+            Grow(bounds, {_nodes[node.First].Min, _nodes[node.First].Max});
+            Grow(bounds, {_nodes[node.First + 1].Min, _nodes[node.First + 1].Max});
+        } else {
+            continue;
+        }
+        node.Min = bounds.Min;
+        node.Max = bounds.Max;
+    }
+}
+
+auto BeBvh::Update(const std::span<const BeBox> boxes) -> bool {
+    if (boxes.size() != _items.size() || _nodes.empty()) {
+        Build(boxes);
+        return true;
+    }
+    Refit(boxes);
+    if (ComputeCost() > _builtCost * MaxCostGrowth) {
+        Build(boxes);
+        return true;
+    }
+    return false;
+}
+
+auto BeBvh::QueryFrustum(const BeCulling::BePlanes& planes, std::vector<uint32_t>& objects) const -> void {
+    if (_items.empty()) return;
+    // nodes fully inside skip the plane tests for everything below them
+    std::vector<std::pair<uint32_t, bool>> stack;
+    stack.reserve(StackReserve);
+    stack.emplace_back(0, false);
+    while (!stack.empty()) {
+        const auto [nodeIndex, inside] = stack.back();
+        stack.pop_back();
+        const BeNode& node = _nodes[nodeIndex];
+        BeOverlap overlap = BeOverlap::Inside;
+        if (!inside) {
+            overlap = Classify(node.Min, node.Max, planes);
+            if (overlap == BeOverlap::Outside) continue;
+        }
+        const bool contained = overlap == BeOverlap::Inside;
+        if (node.ItemCount == 0) {
+            stack.emplace_back(node.First + 1, contained);
+            stack.emplace_back(node.First, contained);
+            continue;
+        }
+        for (uint32_t i = node.First; i < node.First + node.ItemCount; ++i)
+            if (contained || Classify(_itemBoxes[i].Min, _itemBoxes[i].Max, planes) != BeOverlap::Outside)
+                objects.push_back(_items[i]);
+    }
+}
+
+auto BeBvh::QuerySphere(const glm::vec3& center, const float radius, std::vector<uint32_t>& objects) const -> void {
+    if (_items.empty()) return;
+    std::vector<uint32_t> stack;
+    stack.reserve(StackReserve);
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const BeNode& node = _nodes[stack.back()];
+        stack.pop_back();
+        if (!TouchesSphere(node.Min, node.Max, center, radius)) continue;
+        if (node.ItemCount == 0) {
+            stack.push_back(node.First + 1);
+            stack.push_back(node.First);
+            continue;
+        }
+        for (uint32_t i = node.First; i < node.First + node.ItemCount; ++i)
+            if (TouchesSphere(_itemBoxes[i].Min, _itemBoxes[i].Max, center, radius))
+                objects.push_back(_items[i]);
+    }
+}
+
+auto BeBvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, const float maxDistance) const -> BeRayHit {
+    BeRayHit hit;
+    if (_items.empty()) return hit;
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    std::vector<uint32_t> stack;
+    stack.reserve(StackReserve);
+    if (IntersectRay(_nodes[0].Min, _nodes[0].Max, origin, inverseDirection, maxDistance) >= 0.0f)
+        stack.push_back(0);
+    while (!stack.empty()) {
+        const BeNode& node = _nodes[stack.back()];
+        stack.pop_back();
+        if (node.ItemCount > 0) {
+            for (uint32_t i = node.First; i < node.First + node.ItemCount; ++i) {
+                const float distance = IntersectRay(_itemBoxes[i].Min, _itemBoxes[i].Max, origin, inverseDirection, std::min(maxDistance, hit.Distance));
+                if (distance >= 0.0f && (distance < hit.Distance || (distance == hit.Distance && _items[i] < hit.Object)))
+                    hit = {_items[i], distance};
+            }
+            continue;
+        }
+        // the nearer child goes on top, the farther one is often skipped once something was hit
+        const float limit = std::min(maxDistance, hit.Distance);
+        const float left = IntersectRay(_nodes[node.First].Min, _nodes[node.First].Max, origin, inverseDirection, limit);
+        const float right = IntersectRay(_nodes[node.First + 1].Min, _nodes[node.First + 1].Max, origin, inverseDirection, limit);
+        if (left >= 0.0f && right >= 0.0f) {
+            stack.push_back(left <= right ? node.First + 1 : node.First);
+            stack.push_back(left <= right ? node.First : node.First + 1);
+        } else if (left >= 0.0f) {
+            stack.push_back(node.First);
+        } else if (right >= 0.0f) {
+            stack.push_back(node.First + 1);
+        }
+    }
+    return hit;
+}
+
+auto BeBvh::ComputeCost() const -> float {
+    if (_nodes.empty()) return 0.0f;
+    const float rootArea = GetHalfArea(_nodes[0].Min, _nodes[0].Max);
+    if (rootArea <= 0.0f) return 0.0f;
+    float cost = 0.0f;
+    for (uint32_t n = 0; n < GetNodeCount(); ++n) {
+        const BeNode& node = _nodes[n];
+        cost += GetHalfArea(node.Min, node.Max) * (node.ItemCount == 0 ? 1.0f : float(node.ItemCount));
+    }
+    return cost / rootArea;
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include <glm.hpp>
+
+#include "BeCulling.h"
+
+// Bounding volume hierarchy over world space object boxes. Built top down with binned SAH, subtrees in parallel on
+// the shared thread pool, into one flat array where the two children of a node sit next to each other. Moving
+// objects are refitted, the tree is rebuilt once refitting has made it too much worse.
+class BeBvh {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t BinCount = 16;
+    static constexpr uint32_t MaxLeafSize = 4;
+    // SAH cost a refitted tree may reach, relative to the cost right after its build, before Update rebuilds it
+    static constexpr float MaxCostGrowth = 1.5f;
+
+    struct BeBox {
+        glm::vec3 Min;
+        glm::vec3 Max;
+    };
+
+    // 32 bytes, two to a cache line
+    struct BeNode {
+        glm::vec3 Min;
+        uint32_t First;       // inner nodes: left child, the right one follows; leaves: first entry of _items
+        glm::vec3 Max;
+        uint32_t ItemCount;   // 0 for inner nodes
+    };
+
+    struct BeRayHit {
+        uint32_t Object = UINT32_MAX;
+        float Distance = std::numeric_limits<float>::max();   // where the ray enters the object's box
+    };
+
+private:
+    // an object while building, kept together so every pass reads contiguous memory and partitions in place
+    struct BeBuildItem {
+        BeBox Box;
+        glm::vec3 Centroid;
+        uint32_t Object;
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<BeNode> _nodes;
+    std::atomic<uint32_t> _nodeCount = 0;
+    std::vector<uint32_t> _items;     // object indices in leaf order
+    std::vector<BeBox> _itemBoxes;    // their boxes in the same order, so leaves read contiguous memory
+    std::vector<uint32_t> _itemOfObject;
+    float _builtCost = 0.0f;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeBvh() = default;
+    ~BeBvh() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    auto Build(std::span<const BeBox> boxes, bool parallel = true) -> void;
+    // Same objects, new boxes: node bounds are recomputed bottom up, the topology stays.
+    auto Refit(std::span<const BeBox> boxes) -> void;
+    // Refits, or rebuilds when the object count changed or refitting pushed the cost past MaxCostGrowth. Returns
+    // true when it rebuilt.
+    auto Update(std::span<const BeBox> boxes) -> bool;
+
+    // Appends every object whose box touches the frustum, the sphere.
+    auto QueryFrustum(const BeCulling::BePlanes& planes, std::vector<uint32_t>& objects) const -> void;
+    auto QuerySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& objects) const -> void;
+    // Closest object box along a normalised direction.
+    [[nodiscard]] auto Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance = std::numeric_limits<float>::max()) const -> BeRayHit;
+
+    [[nodiscard]] auto GetNodeCount() const -> uint32_t { return _nodeCount.load(std::memory_order_relaxed); }
+    [[nodiscard]] auto GetObjectCount() const -> uint32_t { return static_cast<uint32_t>(_items.size()); }
+    // SAH cost with unit costs per traversal step and per object test, relative to the root area.
+    [[nodiscard]] auto ComputeCost() const -> float;
+    // The tree as built: node 0 is the root, leaves cover GetLeafObjects()[First, First + ItemCount).
+    [[nodiscard]] auto GetNodes() const -> std::span<const BeNode> { return {_nodes.data(), GetNodeCount()}; }
+    [[nodiscard]] auto GetLeafObjects() const -> std::span<const uint32_t> { return _items; }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto BuildNode(
+        uint32_t nodeIndex,
+        uint32_t begin,
+        uint32_t end,
+        std::span<BeBuildItem> buildItems,
+        bool parallel
+    ) -> void;
+};
@@ -0,0 +1,236 @@
+﻿#include "BeCommandList.h"
+
+#include <bit>
+#include <cstring>
+
+namespace {
+    constexpr auto WordCount(const size_t bytes) -> size_t {
+        return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    }
+
+    auto ToWord(const void* object) -> uint64_t {
+        return reinterpret_cast<uintptr_t>(object);
+    }
+
+    template <typename T>
+    auto FromWord(const uint64_t word) -> T* {
+        return reinterpret_cast<T*>(static_cast<uintptr_t>(word));
+    }
+
+    // an array recorded inline, starting on the given word
+    template <typename T>
+    auto BlockAt(const uint64_t* word) -> const T* {
+        return reinterpret_cast<const T*>(word);
+    }
+
+    template <typename T>
+    auto AsBlock(const T* values, const uint32_t count) -> std::span<const std::byte> {
+        return std::as_bytes(std::span(values, count));
+    }
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeCommandList::SetInputLayout(ID3D11InputLayout* layout) -> void {
+    Record(BeOpcode::SetInputLayout, {ToWord(layout)});
+}
+
+auto BeCommandList::SetPrimitiveTopology(const uint32_t topology) -> void {
+    Record(BeOpcode::SetPrimitiveTopology, {topology});
+}
+
+auto BeCommandList::SetVertexBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void {
+    Record(BeOpcode::SetVertexBuffers, {startSlot, count}, {AsBlock(buffers, count), AsBlock(strides, count), AsBlock(offsets, count)});
+}
+
+auto BeCommandList::SetIndexBuffer(ID3D11Buffer* buffer, const uint32_t format, const uint32_t offset) -> void {
+    Record(BeOpcode::SetIndexBuffer, {ToWord(buffer), format, offset});
+}
+
+auto BeCommandList::SetVertexShader(ID3D11VertexShader* shader) -> void {
+    Record(BeOpcode::SetVertexShader, {ToWord(shader)});
+}
+
+auto BeCommandList::SetPixelShader(ID3D11PixelShader* shader) -> void {
+    Record(BeOpcode::SetPixelShader, {ToWord(shader)});
+}
+
+auto BeCommandList::SetVSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    Record(BeOpcode::SetVSConstantBuffers, {startSlot, count}, {AsBlock(buffers, count)});
+}
+
+auto BeCommandList::SetPSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    Record(BeOpcode::SetPSConstantBuffers, {startSlot, count}, {AsBlock(buffers, count)});
+}
+
+auto BeCommandList::SetPSShaderResources(const uint32_t startSlot, const uint32_t count, ID3D11ShaderResourceView* const* views) -> void {
+    Record(BeOpcode::SetPSShaderResources, {startSlot, count}, {AsBlock(views, count)});
+}
+
+auto BeCommandList::SetPSSamplers(const uint32_t startSlot, const uint32_t count, ID3D11SamplerState* const* samplers) -> void {
+    Record(BeOpcode::SetPSSamplers, {startSlot, count}, {AsBlock(samplers, count)});
+}
+
+auto BeCommandList::SetRasterizerState(ID3D11RasterizerState* state) -> void {
+    Record(BeOpcode::SetRasterizerState, {ToWord(state)});
+}
+
+auto BeCommandList::SetBlendState(ID3D11BlendState* state) -> void {
+    Record(BeOpcode::SetBlendState, {ToWord(state)});
+}
+
+auto BeCommandList::SetDepthStencilState(ID3D11DepthStencilState* state, const uint32_t stencilReference) -> void {
+    Record(BeOpcode::SetDepthStencilState, {ToWord(state), stencilReference});
+}
+
+auto BeCommandList::SetRenderTargets(const uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void {
+    Record(BeOpcode::SetRenderTargets, {count, ToWord(depthTarget)}, {AsBlock(targets, count)});
+}
+
+auto BeCommandList::SetViewport(const uint32_t width, const uint32_t height) -> void {
+    Record(BeOpcode::SetViewport, {width, height});
+}
+
+auto BeCommandList::ClearState() -> void {
+    Record(BeOpcode::ClearState, {});
+}
+
+auto BeCommandList::ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void {
+    Record(BeOpcode::ClearRenderTargetView, {ToWord(target)}, {AsBlock(color, 4)});
+}
+
+auto BeCommandList::ClearDepthStencilView(ID3D11DepthStencilView* target, const uint32_t flags, const float depth, const uint8_t stencil) -> void {
+    Record(BeOpcode::ClearDepthStencilView, {ToWord(target), flags, std::bit_cast<uint32_t>(depth), stencil});
+}
+
+auto BeCommandList::UpdateBuffer(ID3D11Buffer* buffer, const uint32_t offset, const void* data, const uint32_t size, const bool discard) -> void {
+    Record(BeOpcode::UpdateBuffer, {ToWord(buffer), offset, size, discard}, {AsBlock(static_cast<const std::byte*>(data), size)});
+}
+
+auto BeCommandList::CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, const uint32_t width, const uint32_t height) -> void {
+    Record(BeOpcode::CopyTextureRegion, {ToWord(destination), ToWord(source), width, height});
+}
+
+auto BeCommandList::Draw(const uint32_t vertexCount, const uint32_t startVertex) -> void {
+    Record(BeOpcode::Draw, {vertexCount, startVertex});
+}
+
+auto BeCommandList::DrawIndexedInstanced(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t startIndex, const int32_t baseVertex, const uint32_t startInstance) -> void {
+    Record(BeOpcode::DrawIndexedInstanced, {indexCount, instanceCount, startIndex, static_cast<uint32_t>(baseVertex), startInstance});
+}
+
+auto BeCommandList::ExecuteCommandList(const BeCommandList& commands) -> void {
+    Record(BeOpcode::ExecuteCommandList, {ToWord(&commands)});
+}
+
+auto BeCommandList::Replay(BeDeviceContext& context) const -> void {
+    context.ClearState();
+    const uint64_t* word = _words.data();
+    const uint64_t* const end = word + _words.size();
+    while (word < end) {
+        const auto opcode = static_cast<BeOpcode>(*word & 0xffffffffu);
+        const uint64_t* arguments = word + 1;
+        word += *word >> 32;
+        auto argument = [arguments](const uint32_t i) { return static_cast<uint32_t>(arguments[i]); };
+
+        switch (opcode) {
+        case BeOpcode::SetInputLayout:
+            context.SetInputLayout(FromWord<ID3D11InputLayout>(arguments[0]));
+            break;
+        case BeOpcode::SetPrimitiveTopology:
+            context.SetPrimitiveTopology(argument(0));
+            break;
+        case BeOpcode::SetVertexBuffers: {
+            const uint32_t count = argument(1);
+            const uint64_t* strides = arguments + 2 + WordCount(count * sizeof(ID3D11Buffer*));
+            const uint64_t* offsets = strides + WordCount(count * sizeof(uint32_t));
+            context.SetVertexBuffers(argument(0), count, BlockAt<ID3D11Buffer*>(arguments + 2), BlockAt<uint32_t>(strides), BlockAt<uint32_t>(offsets));
+            break;
+        }
+        case BeOpcode::SetIndexBuffer:
+            context.SetIndexBuffer(FromWord<ID3D11Buffer>(arguments[0]), argument(1), argument(2));
+            break;
+        case BeOpcode::SetVertexShader:
+            context.SetVertexShader(FromWord<ID3D11VertexShader>(arguments[0]));
+            break;
+        case BeOpcode::SetPixelShader:
+            context.SetPixelShader(FromWord<ID3D11PixelShader>(arguments[0]));
+            break;
+        case BeOpcode::SetVSConstantBuffers:
+            context.SetVSConstantBuffers(argument(0), argument(1), BlockAt<ID3D11Buffer*>(arguments + 2));
+            break;
+        case BeOpcode::SetPSConstantBuffers:
+            context.SetPSConstantBuffers(argument(0), argument(1), BlockAt<ID3D11Buffer*>(arguments + 2));
+            break;
+        case BeOpcode::SetPSShaderResources:
+            context.SetPSShaderResources(argument(0), argument(1), BlockAt<ID3D11ShaderResourceView*>(arguments + 2));
+            break;
+        case BeOpcode::SetPSSamplers:
+            context.SetPSSamplers(argument(0), argument(1), BlockAt<ID3D11SamplerState*>(arguments + 2));
+            break;
+        case BeOpcode::SetRasterizerState:
+            context.SetRasterizerState(FromWord<ID3D11RasterizerState>(arguments[0]));
+            break;
+        case BeOpcode::SetBlendState:
+            context.SetBlendState(FromWord<ID3D11BlendState>(arguments[0]));
+            break;
+        case BeOpcode::SetDepthStencilState:
+            context.SetDepthStencilState(FromWord<ID3D11DepthStencilState>(arguments[0]), argument(1));
+            break;
+        case BeOpcode::SetRenderTargets:
+            context.SetRenderTargets(argument(0), BlockAt<ID3D11RenderTargetView*>(arguments + 2), FromWord<ID3D11DepthStencilView>(arguments[1]));
+            break;
+        case BeOpcode::SetViewport:
+            context.SetViewport(argument(0), argument(1));
+            break;
+        case BeOpcode::ClearState:
+            context.ClearState();
+            break;
+        case BeOpcode::ClearRenderTargetView:
+            context.ClearRenderTargetView(FromWord<ID3D11RenderTargetView>(arguments[0]), BlockAt<float>(arguments + 1));
+            break;
+        case BeOpcode::ClearDepthStencilView:
+            context.ClearDepthStencilView(FromWord<ID3D11DepthStencilView>(arguments[0]), argument(1), std::bit_cast<float>(argument(2)), uint8_t(argument(3)));
+            break;
+        case BeOpcode::UpdateBuffer:
+            context.UpdateBuffer(FromWord<ID3D11Buffer>(arguments[0]), argument(1), arguments + 4, argument(2), argument(3) != 0);
+            break;
+        case BeOpcode::CopyTextureRegion:
+            context.CopyTextureRegion(FromWord<ID3D11Texture2D>(arguments[0]), FromWord<ID3D11Texture2D>(arguments[1]), argument(2), argument(3));
+            break;
+        case BeOpcode::Draw:
+            context.Draw(argument(0), argument(1));
+            break;
+        case BeOpcode::DrawIndexedInstanced:
+            context.DrawIndexedInstanced(argument(0), argument(1), argument(2), static_cast<int32_t>(argument(3)), argument(4));
+            break;
+        case BeOpcode::ExecuteCommandList:
+            context.ExecuteCommandList(*FromWord<const BeCommandList>(arguments[0]));
+            break;
+        }
+    }
+    context.ClearState();
+}
+
+auto BeCommandList::Reset() -> void {
+    _words.clear();
+    _commandCount = 0;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeCommandList::Record(const BeOpcode opcode, const std::initializer_list<uint64_t> arguments, const std::initializer_list<std::span<const std::byte>> blocks) -> void {
+    size_t wordCount = 1 + arguments.size();
+    for (const auto& block : blocks) wordCount += WordCount(block.size());
+    const size_t start = _words.size();
+    _words.resize(start + wordCount);
+
+    uint64_t* word = _words.data() + start;
+    *word++ = static_cast<uint64_t>(opcode) | static_cast<uint64_t>(wordCount) << 32;
+    for (const uint64_t argument : arguments) *word++ = argument;
+    for (const auto& block : blocks) {
+        if (!block.empty()) std::memcpy(word, block.data(), block.size());
+        word += WordCount(block.size());
+    }
+    ++_commandCount;
+}
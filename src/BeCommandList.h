@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "BeDeviceContext.h"
+
+// Records device context calls into one growing block of 8 byte words, to be replayed on another context later. Every
+// call is a header word with its opcode and length, one word per argument, then its arrays and uploaded bytes copied
+// inline, so recording never points back into the caller's memory. Recording touches no device, lists of different
+// passes or of different parts of a draw list are recorded on as many threads at once.
+// A list is recorded as if nothing was bound and replays between two ClearState calls: it can neither depend on nor
+// leak bindings of the list before it, which is what makes a BeStateTracker per list safe.
+class BeCommandList final : public BeDeviceContext {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+private:
+    enum class BeOpcode : uint32_t {
+        SetInputLayout,
+        SetPrimitiveTopology,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetVertexShader,
+        SetPixelShader,
+        SetVSConstantBuffers,
+        SetPSConstantBuffers,
+        SetPSShaderResources,
+        SetPSSamplers,
+        SetRasterizerState,
+        SetBlendState,
+        SetDepthStencilState,
+        SetRenderTargets,
+        SetViewport,
+        ClearState,
+        ClearRenderTargetView,
+        ClearDepthStencilView,
+        UpdateBuffer,
+        CopyTextureRegion,
+        Draw,
+        DrawIndexedInstanced,
+        ExecuteCommandList,
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<uint64_t> _words;
+    uint32_t _commandCount = 0;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeCommandList() = default;
+    ~BeCommandList() override = default;
+    BeCommandList(const BeCommandList&) = delete;
+    BeCommandList& operator=(const BeCommandList&) = delete;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    auto SetInputLayout(ID3D11InputLayout* layout) -> void override;
+    auto SetPrimitiveTopology(uint32_t topology) -> void override;
+    auto SetVertexBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void override;
+    auto SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) -> void override;
+    auto SetVertexShader(ID3D11VertexShader* shader) -> void override;
+    auto SetPixelShader(ID3D11PixelShader* shader) -> void override;
+    auto SetVSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSShaderResources(uint32_t startSlot, uint32_t count, ID3D11ShaderResourceView* const* views) -> void override;
+    auto SetPSSamplers(uint32_t startSlot, uint32_t count, ID3D11SamplerState* const* samplers) -> void override;
+    auto SetRasterizerState(ID3D11RasterizerState* state) -> void override;
+    auto SetBlendState(ID3D11BlendState* state) -> void override;
+    auto SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilReference) -> void override;
+    auto SetRenderTargets(uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void override;
+    auto SetViewport(uint32_t width, uint32_t height) -> void override;
+    auto ClearState() -> void override;
+    auto ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void override;
+    auto ClearDepthStencilView(ID3D11DepthStencilView* target, uint32_t flags, float depth, uint8_t stencil) -> void override;
+    // copies the data, it may change as soon as this returns
+    auto UpdateBuffer(ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size, bool discard) -> void override;
+    auto CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, uint32_t width, uint32_t height) -> void override;
+    auto Draw(uint32_t vertexCount, uint32_t startVertex) -> void override;
+    auto DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) -> void override;
+    // Only records where the list is, it has to stay as it is until this one is replayed.
+    auto ExecuteCommandList(const BeCommandList& commands) -> void override;
+
+    // Issues the recorded calls on context, cleared before and after.
+    auto Replay(BeDeviceContext& context) const -> void;
+    // Drops every command and keeps the memory for the next recording.
+    auto Reset() -> void;
+
+    [[nodiscard]] auto GetCommandCount() const -> uint32_t { return _commandCount; }
+    [[nodiscard]] auto GetByteSize() const -> size_t { return _words.size() * sizeof(uint64_t); }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Appends a command: its header, one word per argument, then every block padded to whole words.
+    auto Record(BeOpcode opcode, std::initializer_list<uint64_t> arguments, std::initializer_list<std::span<const std::byte>> blocks = {}) -> void;
+};
@@ -1,5 +1,6 @@
 ﻿#include "BeComposerPass.h"
 
+#include "BePipelineCache.h"
 #include "BeRenderer.h"
 #include "BeRenderResource.h"
 #include "BeShader.h"
@@ -7,52 +8,60 @@
 BeComposerPass::BeComposerPass() = default;
 BeComposerPass::~BeComposerPass() = default;
 
+auto BeComposerPass::GetResources() const -> BeRenderGraph::BePassResources {
+    return {
+        .Reads = {InputDepthTextureName, InputTexture0Name, InputTexture1Name, InputTexture2Name, InputLightTextureName},
+        .Writes = {BeRenderer::BackbufferName},
+    };
+}
+
 auto BeComposerPass::Initialise() -> void {
     const auto device = _renderer->GetDevice();
+    _inputDepthTexture = _renderer->FindRenderResource(InputDepthTextureName);
+    _inputTexture0 = _renderer->FindRenderResource(InputTexture0Name);
+    _inputTexture1 = _renderer->FindRenderResource(InputTexture1Name);
+    _inputTexture2 = _renderer->FindRenderResource(InputTexture2Name);
+    _inputLightTexture = _renderer->FindRenderResource(InputLightTextureName);
 
     _composerShader = std::make_unique<BeShader>(
         device.Get(),
         "assets/shaders/composer",
         BeShaderType::Pixel,
-        std::vector<BeVertexElementDescriptor>{}
+        BeVertexLayout{}
     );
-}
 
-auto BeComposerPass::Render() -> void {
-    const auto context = _renderer->GetContext();
+    _composerPipeline = _renderer->GetPipelineCache().Get({
+        .VertexShader = _renderer->GetFullscreenShader(),
+        .PixelShader = _composerShader.get(),
+        .DepthStencil = BePipelineCache::DisabledDepthStencil,
+        .Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+    });
+}
 
-    BeRenderResource* depthResource    = _renderer->GetRenderResource(InputDepthTextureName);
-    BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(InputTexture0Name);
-    BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(InputTexture1Name);
-    BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(InputTexture2Name);
-    BeRenderResource* lightingResource = _renderer->GetRenderResource(InputLightTextureName);
+auto BeComposerPass::Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void {
+    BeRenderResource* depthResource    = _renderer->GetRenderResource(_inputDepthTexture);
+    BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(_inputTexture0);
+    BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(_inputTexture1);
+    BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(_inputTexture2);
+    BeRenderResource* lightingResource = _renderer->GetRenderResource(_inputLightTexture);
 
     auto backbufferTarget = _renderer->GetBackbufferTarget();
     auto fullClearColor = glm::vec4(ClearColor, 1.0f);
-    context->ClearRenderTargetView(backbufferTarget.Get(), reinterpret_cast<FLOAT*>(&fullClearColor));
-    context->OMSetRenderTargets(1, backbufferTarget.GetAddressOf(), nullptr);
-        
-    context->PSSetShaderResources(0, 1, depthResource->SRV.GetAddressOf());
-    context->PSSetShaderResources(1, 1, gbufferResource0->SRV.GetAddressOf());
-    context->PSSetShaderResources(2, 1, gbufferResource1->SRV.GetAddressOf());
-    context->PSSetShaderResources(3, 1, gbufferResource2->SRV.GetAddressOf());
-    context->PSSetShaderResources(4, 1, lightingResource->SRV.GetAddressOf());
-    
-    context->PSSetSamplers(0, 1, _renderer->GetPointSampler().GetAddressOf());
+    context.ClearRenderTargetView(backbufferTarget.Get(), reinterpret_cast<FLOAT*>(&fullClearColor));
+    stateTracker.SetRenderTargets(std::span(backbufferTarget.GetAddressOf(), 1), nullptr);
+
+    ID3D11ShaderResourceView* inputResources[5] = {
+        depthResource->SRV.Get(),
+        gbufferResource0->SRV.Get(),
+        gbufferResource1->SRV.Get(),
+        gbufferResource2->SRV.Get(),
+        lightingResource->SRV.Get(),
+    };
+    stateTracker.SetPSShaderResources(0, inputResources);
     
-    context->VSSetShader(_renderer->GetFullscreenVertexShader().Get(), nullptr, 0);
-    context->PSSetShader(_composerShader->PixelShader.Get(), nullptr, 0);
-
-    context->IASetInputLayout(nullptr);
-    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-    context->Draw(4, 0);
-    { 
-        ID3D11ShaderResourceView* emptyResources[] = { nullptr, nullptr, nullptr, nullptr };
-        context->PSSetShaderResources(0, 4, emptyResources);
-        ID3D11SamplerState* emptySamplers[] = { nullptr };
-        context->PSSetSamplers(0, 1, emptySamplers);
-        ID3D11RenderTargetView* emptyTargets[] = { nullptr };
-        context->OMSetRenderTargets(1, emptyTargets, nullptr);
-    }
+    // upscales what was rendered at the render scale
+    stateTracker.SetPSSampler(0, _renderer->GetLinearSampler().Get());
+    stateTracker.SetPipeline(*_composerPipeline);
+    context.Draw(4, 0);
 }
 
@@ -6,6 +6,7 @@
 #include "BeRenderPass.h"
 
 class BeShader;
+struct BePipelineState;
 
 class BeComposerPass final : public BeRenderPass {
 
@@ -20,11 +21,19 @@ public:
     
 private:
     std::unique_ptr<BeShader> _composerShader = nullptr;
+    const BePipelineState* _composerPipeline = nullptr;
+
+    BeHandle _inputDepthTexture;
+    BeHandle _inputTexture0;
+    BeHandle _inputTexture1;
+    BeHandle _inputTexture2;
+    BeHandle _inputLightTexture;
     
 public:
     explicit BeComposerPass();
     ~BeComposerPass() override;
 
+    auto GetResources() const -> BeRenderGraph::BePassResources override;
     auto Initialise() -> void override;
-    auto Render() -> void override;
+    auto Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void override;
 };
@@ -0,0 +1,123 @@
+﻿#include "BeCulling.h"
+
+#include <algorithm>
+#include <bit>
+#include <immintrin.h>
+
+#include "BeMeshlets.h"
+
+namespace {
+    using BeInstructionSet = BeCulling::BeInstructionSet;
+
+    // Box against plane with centre c and half extent e: fully outside once dot(n, c) + w + dot(|n|, e) < 0.
+    auto CullRangeScalar(const BeCulling::BeBoxes& boxes, const BeCulling::BePlanes& planes, uint8_t* visible, const uint32_t begin, const uint32_t end) -> uint32_t {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            bool outside = false;
+            for (const auto& plane : planes) {
+                const float distance = plane.x * boxes.CenterX[i] + plane.y * boxes.CenterY[i] + plane.z * boxes.CenterZ[i] + plane.w;
+                const float radius = std::abs(plane.x) * boxes.ExtentX[i] + std::abs(plane.y) * boxes.ExtentY[i] + std::abs(plane.z) * boxes.ExtentZ[i];
+                outside |= distance + radius < 0.0f;
+            }
+            visible[i] = outside ? 0 : 1;
+            count += visible[i];
+        }
+        return count;
+    }
+
+    auto CullSSE2(const BeCulling::BeBoxes& boxes, const BeCulling::BePlanes& planes, uint8_t* visible) -> uint32_t {
+        const uint32_t wideEnd = boxes.Count & ~3u;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < wideEnd; i += 4) {
+            const __m128 centerX = _mm_loadu_ps(boxes.CenterX.data() + i);
+            const __m128 centerY = _mm_loadu_ps(boxes.CenterY.data() + i);
+            const __m128 centerZ = _mm_loadu_ps(boxes.CenterZ.data() + i);
+            const __m128 extentX = _mm_loadu_ps(boxes.ExtentX.data() + i);
+            const __m128 extentY = _mm_loadu_ps(boxes.ExtentY.data() + i);
+            const __m128 extentZ = _mm_loadu_ps(boxes.ExtentZ.data() + i);
+            __m128 outside = _mm_setzero_ps();
+            for (const auto& plane : planes) {
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                const __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(extentX, _mm_set1_ps(std::abs(plane.x))), _mm_mul_ps(extentY, _mm_set1_ps(std::abs(plane.y)))),
+                    _mm_mul_ps(extentZ, _mm_set1_ps(std::abs(plane.z))));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            const uint32_t visibleMask = ~static_cast<uint32_t>(_mm_movemask_ps(outside)) & 0xF;
+            for (uint32_t lane = 0; lane < 4; ++lane)
+                visible[i + lane] = (visibleMask >> lane) & 1;
+            count += std::popcount(visibleMask);
+        }
+        return count + CullRangeScalar(boxes, planes, visible, wideEnd, boxes.Count);
+    }
+
+    BE_TARGET_AVX2 auto CullAVX2(const BeCulling::BeBoxes& boxes, const BeCulling::BePlanes& planes, uint8_t* visible) -> uint32_t {
+        const uint32_t wideEnd = boxes.Count & ~7u;
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < wideEnd; i += 8) {
+            const __m256 centerX = _mm256_loadu_ps(boxes.CenterX.data() + i);
+            const __m256 centerY = _mm256_loadu_ps(boxes.CenterY.data() + i);
+            const __m256 centerZ = _mm256_loadu_ps(boxes.CenterZ.data() + i);
+            const __m256 extentX = _mm256_loadu_ps(boxes.ExtentX.data() + i);
+            const __m256 extentY = _mm256_loadu_ps(boxes.ExtentY.data() + i);
+            const __m256 extentZ = _mm256_loadu_ps(boxes.ExtentZ.data() + i);
+            __m256 outside = _mm256_setzero_ps();
+            for (const auto& plane : planes) {
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(centerX, _mm256_set1_ps(plane.x)), _mm256_mul_ps(centerY, _mm256_set1_ps(plane.y))),
+                    _mm256_add_ps(_mm256_mul_ps(centerZ, _mm256_set1_ps(plane.z)), _mm256_set1_ps(plane.w)));
+                const __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(extentX, _mm256_set1_ps(std::abs(plane.x))), _mm256_mul_ps(extentY, _mm256_set1_ps(std::abs(plane.y)))),
+                    _mm256_mul_ps(extentZ, _mm256_set1_ps(std::abs(plane.z))));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+            const uint32_t visibleMask = ~static_cast<uint32_t>(_mm256_movemask_ps(outside)) & 0xFF;
+            for (uint32_t lane = 0; lane < 8; ++lane)
+                visible[i + lane] = (visibleMask >> lane) & 1;
+            count += std::popcount(visibleMask);
+        }
+        return count + CullRangeScalar(boxes, planes, visible, wideEnd, boxes.Count);
+    }
+}
+
+auto BeCulling::BeBoxes::Clear() -> void {
+    CenterX.clear(); CenterY.clear(); CenterZ.clear();
+    ExtentX.clear(); ExtentY.clear(); ExtentZ.clear();
+    Count = 0;
+}
+
+auto BeCulling::BeBoxes::Add(const glm::vec3& center, const glm::vec3& extent) -> void {
+    CenterX.push_back(center.x); CenterY.push_back(center.y); CenterZ.push_back(center.z);
+    ExtentX.push_back(extent.x); ExtentY.push_back(extent.y); ExtentZ.push_back(extent.z);
+    ++Count;
+}
+
+auto BeCulling::BeBoxes::Add(const BeBounds& bounds, const glm::mat4& transform) -> void {
+    const glm::vec3 extent = bounds.GetExtent();
+    const glm::vec3 center = glm::vec3(transform * glm::vec4((bounds.Min + bounds.Max) * 0.5f, 1.0f));
+    const glm::vec3 worldExtent =
+        glm::abs(glm::vec3(transform[0])) * extent.x +
+        glm::abs(glm::vec3(transform[1])) * extent.y +
+        glm::abs(glm::vec3(transform[2])) * extent.z;
+    Add(center, worldExtent);
+}
+
+auto BeCulling::ExtractPlanes(const glm::mat4& projectionView) -> BePlanes {
+    return BeMeshlets::MakeCullView(projectionView, glm::mat4(1.0f), glm::vec3(0.0f)).Planes;
+}
+
+auto BeCulling::Cull(const BeBoxes& boxes, const BePlanes& planes, std::vector<uint8_t>& visible) -> uint32_t {
+    return Cull(boxes, planes, visible, BePixelKernels::GetInstructionSet());
+}
+
+auto BeCulling::Cull(const BeBoxes& boxes, const BePlanes& planes, std::vector<uint8_t>& visible, const BeInstructionSet instructionSet) -> uint32_t {
+    visible.resize(boxes.Count);
+    switch (std::min(instructionSet, BePixelKernels::GetSupportedInstructionSet())) {
+        case BeInstructionSet::AVX2: return CullAVX2(boxes, planes, visible.data());
+        case BeInstructionSet::SSE2: return CullSSE2(boxes, planes, visible.data());
+        case BeInstructionSet::Scalar: break;
+    }
+    return CullRangeScalar(boxes, planes, visible.data(), 0, boxes.Count);
+}
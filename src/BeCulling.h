@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+
+#include "BeModel.h"
+#include "BePixelKernels.h"
+
+// Frustum tests for many boxes at once. Boxes are kept as structure of arrays, so the SSE2 and AVX2 kernels test
+// 4 and 8 boxes against a plane per instruction. The path follows BePixelKernels' instruction set.
+namespace BeCulling {
+
+    using BeInstructionSet = BePixelKernels::BeInstructionSet;
+
+    // World space centres and half extents, the tail that does not fill a register goes through the scalar path.
+    struct BeBoxes {
+        std::vector<float> CenterX, CenterY, CenterZ;
+        std::vector<float> ExtentX, ExtentY, ExtentZ;
+        uint32_t Count = 0;
+
+        auto Clear() -> void;
+        auto Add(const glm::vec3& center, const glm::vec3& extent) -> void;
+        // World space box around a model space one, (center, extent) of the transformed corners.
+        auto Add(const BeBounds& bounds, const glm::mat4& transform) -> void;
+    };
+
+    struct BeStatistics {
+        uint32_t Objects = 0;
+        uint32_t CulledObjects = 0;
+        uint32_t Slices = 0;          // of visible objects only
+        uint32_t CulledSlices = 0;
+    };
+
+    // Normalised planes, inside where dot(xyz, p) + w >= 0.
+    using BePlanes = std::array<glm::vec4, 6>;
+    [[nodiscard]] auto ExtractPlanes(const glm::mat4& projectionView) -> BePlanes;
+
+    // visible[i] is 1 when box i touches the frustum. Returns how many do.
+    auto Cull(const BeBoxes& boxes, const BePlanes& planes, std::vector<uint8_t>& visible) -> uint32_t;
+    auto Cull(const BeBoxes& boxes, const BePlanes& planes, std::vector<uint8_t>& visible, BeInstructionSet instructionSet) -> uint32_t;
+}
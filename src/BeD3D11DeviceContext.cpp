@@ -0,0 +1,113 @@
+﻿#include "BeD3D11DeviceContext.h"
+
+#include <cstring>
+#include <utility>
+
+#include "BeCommandList.h"
+#include "Utils.h"
+
+BeD3D11DeviceContext::BeD3D11DeviceContext(ComPtr<ID3D11DeviceContext> context) : _context(std::move(context)) {}
+
+auto BeD3D11DeviceContext::SetInputLayout(ID3D11InputLayout* layout) -> void {
+    _context->IASetInputLayout(layout);
+}
+
+auto BeD3D11DeviceContext::SetPrimitiveTopology(const uint32_t topology) -> void {
+    _context->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+auto BeD3D11DeviceContext::SetVertexBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void {
+    _context->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+}
+
+auto BeD3D11DeviceContext::SetIndexBuffer(ID3D11Buffer* buffer, const uint32_t format, const uint32_t offset) -> void {
+    _context->IASetIndexBuffer(buffer, static_cast<DXGI_FORMAT>(format), offset);
+}
+
+auto BeD3D11DeviceContext::SetVertexShader(ID3D11VertexShader* shader) -> void {
+    _context->VSSetShader(shader, nullptr, 0);
+}
+
+auto BeD3D11DeviceContext::SetPixelShader(ID3D11PixelShader* shader) -> void {
+    _context->PSSetShader(shader, nullptr, 0);
+}
+
+auto BeD3D11DeviceContext::SetVSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    _context->VSSetConstantBuffers(startSlot, count, buffers);
+}
+
+auto BeD3D11DeviceContext::SetPSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    _context->PSSetConstantBuffers(startSlot, count, buffers);
+}
+
+auto BeD3D11DeviceContext::SetPSShaderResources(const uint32_t startSlot, const uint32_t count, ID3D11ShaderResourceView* const* views) -> void {
+    _context->PSSetShaderResources(startSlot, count, views);
+}
+
+auto BeD3D11DeviceContext::SetPSSamplers(const uint32_t startSlot, const uint32_t count, ID3D11SamplerState* const* samplers) -> void {
+    _context->PSSetSamplers(startSlot, count, samplers);
+}
+
+auto BeD3D11DeviceContext::SetRasterizerState(ID3D11RasterizerState* state) -> void {
+    _context->RSSetState(state);
+}
+
+auto BeD3D11DeviceContext::SetBlendState(ID3D11BlendState* state) -> void {
+    _context->OMSetBlendState(state, nullptr, 0xFFFFFFFF);
+}
+
+auto BeD3D11DeviceContext::SetDepthStencilState(ID3D11DepthStencilState* state, const uint32_t stencilReference) -> void {
+    _context->OMSetDepthStencilState(state, stencilReference);
+}
+
+auto BeD3D11DeviceContext::SetRenderTargets(const uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void {
+    _context->OMSetRenderTargets(count, targets, depthTarget);
+}
+
+auto BeD3D11DeviceContext::SetViewport(const uint32_t width, const uint32_t height) -> void {
+    const D3D11_VIEWPORT viewport = {
+        .TopLeftX = 0.0f,
+        .TopLeftY = 0.0f,
+        .Width = static_cast<FLOAT>(width),
+        .Height = static_cast<FLOAT>(height),
+        .MinDepth = 0.0f,
+        .MaxDepth = 1.0f,
+    };
+    _context->RSSetViewports(1, &viewport);
+}
+
+auto BeD3D11DeviceContext::ClearState() -> void {
+    _context->ClearState();
+}
+
+auto BeD3D11DeviceContext::ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void {
+    _context->ClearRenderTargetView(target, color);
+}
+
+auto BeD3D11DeviceContext::ClearDepthStencilView(ID3D11DepthStencilView* target, const uint32_t flags, const float depth, const uint8_t stencil) -> void {
+    _context->ClearDepthStencilView(target, flags, depth, stencil);
+}
+
+auto BeD3D11DeviceContext::UpdateBuffer(ID3D11Buffer* buffer, const uint32_t offset, const void* data, const uint32_t size, const bool discard) -> void {
+    D3D11_MAPPED_SUBRESOURCE mappedResource;
+    Utils::Check << _context->Map(buffer, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedResource);
+    std::memcpy(static_cast<uint8_t*>(mappedResource.pData) + offset, data, size);
+    _context->Unmap(buffer, 0);
+}
+
+auto BeD3D11DeviceContext::CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, const uint32_t width, const uint32_t height) -> void {
+    const D3D11_BOX box = {.left = 0, .top = 0, .front = 0, .right = width, .bottom = height, .back = 1};
+    _context->CopySubresourceRegion(destination, 0, 0, 0, 0, source, 0, &box);
+}
+
+auto BeD3D11DeviceContext::Draw(const uint32_t vertexCount, const uint32_t startVertex) -> void {
+    _context->Draw(vertexCount, startVertex);
+}
+
+auto BeD3D11DeviceContext::DrawIndexedInstanced(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t startIndex, const int32_t baseVertex, const uint32_t startInstance) -> void {
+    _context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+auto BeD3D11DeviceContext::ExecuteCommandList(const BeCommandList& commands) -> void {
+    commands.Replay(*this);
+}
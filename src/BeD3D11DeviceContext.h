@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "BeDeviceContext.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Forwards every call to a D3D11 immediate or deferred context as it comes.
+class BeD3D11DeviceContext final : public BeDeviceContext {
+private:
+    ComPtr<ID3D11DeviceContext> _context;
+
+public:
+    explicit BeD3D11DeviceContext(ComPtr<ID3D11DeviceContext> context);
+    ~BeD3D11DeviceContext() override = default;
+
+    auto SetInputLayout(ID3D11InputLayout* layout) -> void override;
+    auto SetPrimitiveTopology(uint32_t topology) -> void override;
+    auto SetVertexBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void override;
+    auto SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) -> void override;
+    auto SetVertexShader(ID3D11VertexShader* shader) -> void override;
+    auto SetPixelShader(ID3D11PixelShader* shader) -> void override;
+    auto SetVSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSShaderResources(uint32_t startSlot, uint32_t count, ID3D11ShaderResourceView* const* views) -> void override;
+    auto SetPSSamplers(uint32_t startSlot, uint32_t count, ID3D11SamplerState* const* samplers) -> void override;
+    auto SetRasterizerState(ID3D11RasterizerState* state) -> void override;
+    auto SetBlendState(ID3D11BlendState* state) -> void override;
+    auto SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilReference) -> void override;
+    auto SetRenderTargets(uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void override;
+    auto SetViewport(uint32_t width, uint32_t height) -> void override;
+    auto ClearState() -> void override;
+    auto ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void override;
+    auto ClearDepthStencilView(ID3D11DepthStencilView* target, uint32_t flags, float depth, uint8_t stencil) -> void override;
+    auto UpdateBuffer(ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size, bool discard) -> void override;
+    auto CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, uint32_t width, uint32_t height) -> void override;
+    auto Draw(uint32_t vertexCount, uint32_t startVertex) -> void override;
+    auto DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) -> void override;
+    // Replays the list here. Command lists could also map onto deferred contexts and their ID3D11CommandList; a
+    // replay costs about what recording into a deferred context does, without depending on driver support for them.
+    auto ExecuteCommandList(const BeCommandList& commands) -> void override;
+};
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <cstdint>
+
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11RasterizerState;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+struct ID3D11Texture2D;
+
+class BeCommandList;
+
+// The calls passes make on a device context, and nothing that needs d3d11.h: objects are only passed around, topology
+// and index format travel as their enum values. BeStateTracker filters the binding calls, BeD3D11DeviceContext
+// forwards to the real context, BeCommandList records for a later replay and BeNullDeviceContext only counts.
+class BeDeviceContext {
+public:
+    virtual ~BeDeviceContext() = default;
+
+    virtual auto SetInputLayout(ID3D11InputLayout* layout) -> void = 0;
+    virtual auto SetPrimitiveTopology(uint32_t topology) -> void = 0;
+    virtual auto SetVertexBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void = 0;
+    virtual auto SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) -> void = 0;
+    virtual auto SetVertexShader(ID3D11VertexShader* shader) -> void = 0;
+    virtual auto SetPixelShader(ID3D11PixelShader* shader) -> void = 0;
+    virtual auto SetVSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void = 0;
+    virtual auto SetPSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void = 0;
+    virtual auto SetPSShaderResources(uint32_t startSlot, uint32_t count, ID3D11ShaderResourceView* const* views) -> void = 0;
+    virtual auto SetPSSamplers(uint32_t startSlot, uint32_t count, ID3D11SamplerState* const* samplers) -> void = 0;
+    virtual auto SetRasterizerState(ID3D11RasterizerState* state) -> void = 0;
+    // blend factor 1 and every sample, as every pass uses it
+    virtual auto SetBlendState(ID3D11BlendState* state) -> void = 0;
+    virtual auto SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilReference) -> void = 0;
+    virtual auto SetRenderTargets(uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void = 0;
+    virtual auto SetViewport(uint32_t width, uint32_t height) -> void = 0;
+    // unbinds everything, viewports included
+    virtual auto ClearState() -> void = 0;
+
+    virtual auto ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void = 0;
+    virtual auto ClearDepthStencilView(ID3D11DepthStencilView* target, uint32_t flags, float depth, uint8_t stencil) -> void = 0;
+    // Maps a dynamic buffer with WRITE_DISCARD, or WRITE_NO_OVERWRITE without discard, and copies size bytes to offset.
+    virtual auto UpdateBuffer(ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size, bool discard) -> void = 0;
+    // the top left width by height texels of the first level
+    virtual auto CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, uint32_t width, uint32_t height) -> void = 0;
+    virtual auto Draw(uint32_t vertexCount, uint32_t startVertex) -> void = 0;
+    virtual auto DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) -> void = 0;
+    // Replays a recorded list, which leaves nothing bound behind it.
+    virtual auto ExecuteCommandList(const BeCommandList& commands) -> void = 0;
+};
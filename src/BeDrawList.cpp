@@ -0,0 +1,51 @@
+﻿#include "BeDrawList.h"
+
+#include <algorithm>
+#include <array>
+
+auto BeDrawList::QuantizeDepth(const float distance, const float farPlane) -> uint32_t {
+    constexpr uint32_t MaxDepth = (1u << DepthBits) - 1;
+    const float fraction = std::clamp(distance / farPlane, 0.0f, 1.0f);
+    return static_cast<uint32_t>(fraction * float(MaxDepth));
+}
+
+auto BeDrawList::Sort(std::vector<BeDraw>& draws, std::vector<BeDraw>& scratch) -> void {
+    const size_t count = draws.size();
+    if (count < 2) return;
+
+    // every byte's histogram in one read of the keys
+    std::array<std::array<uint32_t, 256>, 8> histograms {};
+    for (const auto& draw : draws)
+        for (uint32_t digit = 0; digit < 8; ++digit)
+            ++histograms[digit][(draw.Key >> (digit * 8)) & 0xFF];
+
+    scratch.resize(count);
+    for (uint32_t digit = 0; digit < 8; ++digit) {
+        auto& histogram = histograms[digit];
+        if (std::ranges::find(histogram, static_cast<uint32_t>(count)) != histogram.end()) continue;
+        uint32_t offset = 0;
+        for (auto& bucket : histogram) {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for (const auto& draw : draws)
+            scratch[histogram[(draw.Key >> (digit * 8)) & 0xFF]++] = draw;
+        draws.swap(scratch);
+    }
+}
+
+auto BeDrawList::CountStateChanges(const std::span<const BeDraw> draws, const bool skipRedundant) -> BeStateChanges {
+    BeStateChanges changes;
+    const BeDraw* previous = nullptr;
+    for (const auto& draw : draws) {
+        changes.Shaders += !previous || GetShader(previous->Key) != GetShader(draw.Key);
+        const bool sameTextures = previous && GetTextureSet(previous->Key) == GetTextureSet(draw.Key);
+        const bool sameMaterial = previous && GetMaterial(previous->Key) == GetMaterial(draw.Key);
+        changes.TextureSets += !(skipRedundant && sameTextures);
+        changes.Materials += !(skipRedundant && sameMaterial);
+        changes.Draws += draw.RangeCount;
+        previous = &draw;
+    }
+    return changes;
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Orders a frame's draws by 64 bit keys so that draws sharing state end up next to each other: shader first, then
+// texture set, then material constants, then front to back. A submission walking the sorted list only rebinds the
+// parts of the key that changed since the previous draw.
+namespace BeDrawList {
+
+    constexpr uint32_t DepthBits = 24;
+    constexpr uint32_t MaterialBits = 16;
+    constexpr uint32_t TextureSetBits = 16;
+    constexpr uint32_t ShaderBits = 8;
+    static_assert(DepthBits + MaterialBits + TextureSetBits + ShaderBits == 64);
+
+    struct BeDraw {
+        uint64_t Key;
+        uint32_t Batch;        // caller's index of what is drawn, with Slice
+        uint32_t Slice;
+        uint32_t FirstRange;   // into the caller's index ranges
+        uint32_t RangeCount;
+    };
+
+    // Binds a submission issues, draws are the DrawIndexed calls behind them.
+    struct BeStateChanges {
+        uint32_t Shaders = 0;
+        uint32_t TextureSets = 0;
+        uint32_t Materials = 0;
+        uint32_t Draws = 0;
+
+        [[nodiscard]] auto GetBindCount() const -> uint32_t { return Shaders + TextureSets + Materials; }
+    };
+
+    // Ids have to fit their fields, draws compare them to tell whether state changed.
+    [[nodiscard]] constexpr auto MakeKey(const uint32_t shader, const uint32_t textureSet, const uint32_t material, const uint32_t depth) -> uint64_t {
+        return
+            uint64_t(shader & ((1u << ShaderBits) - 1)) << (DepthBits + MaterialBits + TextureSetBits) |
+            uint64_t(textureSet & ((1u << TextureSetBits) - 1)) << (DepthBits + MaterialBits) |
+            uint64_t(material & ((1u << MaterialBits) - 1)) << DepthBits |
+            uint64_t(depth & ((1u << DepthBits) - 1));
+    }
+    [[nodiscard]] constexpr auto GetShader(const uint64_t key) -> uint32_t { return uint32_t(key >> (DepthBits + MaterialBits + TextureSetBits)); }
+    [[nodiscard]] constexpr auto GetTextureSet(const uint64_t key) -> uint32_t { return uint32_t(key >> (DepthBits + MaterialBits)) & ((1u << TextureSetBits) - 1); }
+    [[nodiscard]] constexpr auto GetMaterial(const uint64_t key) -> uint32_t { return uint32_t(key >> DepthBits) & ((1u << MaterialBits) - 1); }
+
+    // View distance as a DepthBits wide fraction of the far plane, nearer is smaller.
+    [[nodiscard]] auto QuantizeDepth(float distance, float farPlane) -> uint32_t;
+
+    // Stable least significant digit radix sort on Key, a byte per pass, skipping the bytes every key shares.
+    auto Sort(std::vector<BeDraw>& draws, std::vector<BeDraw>& scratch) -> void;
+
+    // What submitting draws in this order costs when only changed state is bound, or when every draw binds its
+    // material and textures and only the shader is kept while it stays the same, as the geometry pass used to.
+    [[nodiscard]] auto CountStateChanges(std::span<const BeDraw> draws, bool skipRedundant) -> BeStateChanges;
+}
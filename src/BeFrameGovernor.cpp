@@ -0,0 +1,97 @@
+﻿#include "BeFrameGovernor.h"
+
+#include <algorithm>
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeFrameGovernor::BeFrameGovernor() : BeFrameGovernor(BeSettings{}) {}
+
+BeFrameGovernor::BeFrameGovernor(const BeSettings& settings) : _settings(settings) {
+    Reset();
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeFrameGovernor::Update(const float frameMilliseconds) -> bool {
+    if (_framesSinceRaise != UINT32_MAX) ++_framesSinceRaise;
+    if (_settleFrames > 0) {
+        --_settleFrames;
+        return false;
+    }
+
+    _smoothedMilliseconds = _smoothedMilliseconds == 0.0f
+        ? frameMilliseconds
+        : _smoothedMilliseconds + (frameMilliseconds - _smoothedMilliseconds) * _settings.Smoothing;
+    if (_smoothedMilliseconds > _settings.TargetMilliseconds * _settings.SlowThreshold) {
+        ++_slowFrames;
+        _fastFrames = 0;
+    } else if (_smoothedMilliseconds < _settings.TargetMilliseconds * _settings.FastThreshold) {
+        ++_fastFrames;
+        _slowFrames = 0;
+    } else {
+        _slowFrames = 0;
+        _fastFrames = 0;
+    }
+
+    bool changed = false;
+    if (_slowFrames >= _settings.SlowFrames)
+        changed = StepDown();
+    else if (_fastFrames >= _raiseFrames)
+        changed = StepUp();
+    if (!changed) return false;
+
+    // frames rendered before the change say nothing about the ones after it
+    ++_changes;
+    _slowFrames = 0;
+    _fastFrames = 0;
+    _settleFrames = _settings.SettleFrames;
+    _smoothedMilliseconds = 0.0f;
+    return true;
+}
+
+auto BeFrameGovernor::Reset() -> void {
+    _quality = {.RenderScale = _settings.MaxRenderScale, .Level = 0};
+    _smoothedMilliseconds = 0.0f;
+    _slowFrames = 0;
+    _fastFrames = 0;
+    _settleFrames = 0;
+    _raiseFrames = _settings.FastFrames;
+    _framesSinceRaise = UINT32_MAX;
+    _changes = 0;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeFrameGovernor::StepDown() -> bool {
+    constexpr float Epsilon = 1e-4f;
+    if (_quality.RenderScale > _settings.MinRenderScale + Epsilon)
+        _quality.RenderScale = std::max(_quality.RenderScale - _settings.RenderScaleStep, _settings.MinRenderScale);
+    else if (_quality.Level < _settings.QualityLevels)
+        ++_quality.Level;
+    else
+        return false;
+
+    // the last step up did not hold, or the load grew and the next one may come as soon as usual
+    _raiseFrames = _framesSinceRaise < _raiseFrames
+        ? std::min(_raiseFrames * 2, _settings.FastFrames * 16)
+        : _settings.FastFrames;
+    _framesSinceRaise = UINT32_MAX;
+    return true;
+}
+
+auto BeFrameGovernor::StepUp() -> bool {
+    constexpr float Epsilon = 1e-4f;
+    if (_quality.Level > 0) {
+        --_quality.Level;
+    } else if (_quality.RenderScale < _settings.MaxRenderScale - Epsilon) {
+        // as if all of the frame scaled with the pixel count, so the step is never taken too early
+        const float next = std::min(_quality.RenderScale + _settings.RenderScaleStep, _settings.MaxRenderScale);
+        const float growth = (next * next) / (_quality.RenderScale * _quality.RenderScale);
+        if (_smoothedMilliseconds * growth > _settings.TargetMilliseconds * _settings.SlowThreshold) return false;
+        _quality.RenderScale = next;
+    } else {
+        return false;
+    }
+    _framesSinceRaise = 0;
+    return true;
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+#include <cstdint>
+
+// Keeps frame times under a budget by trading quality for time. Frame times are smoothed, and a run of slow frames
+// lowers the render scale one step. At the lowest scale a run of slow frames drops a quality level instead; what a
+// level turns off is up to the caller. Frames with headroom give quality back in the reverse order, after a much
+// longer run and only when the next scale step is predicted to stay in budget. The gap between the two thresholds,
+// the two run lengths and a step up that has to wait longer every time it did not hold keep the governor from
+// oscillating around the budget or reacting to single spikes.
+// Frame times come from whoever measures them, GPU timestamps or the CPU frame clock.
+class BeFrameGovernor {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    struct BeSettings {
+        float TargetMilliseconds = 1000.0f / 60.0f;
+        float MinRenderScale = 0.5f;
+        float MaxRenderScale = 1.0f;
+        float RenderScaleStep = 0.1f;
+        // levels below full quality the caller can drop to, 0 leaves only the render scale to the governor
+        uint32_t QualityLevels = 0;
+        // shares of the target above which a smoothed frame is slow and below which it has headroom
+        float SlowThreshold = 0.95f;
+        float FastThreshold = 0.75f;
+        // consecutive slow or fast frames before a step down or up
+        uint32_t SlowFrames = 4;
+        uint32_t FastFrames = 90;
+        // frames ignored after a change, they were still in flight at the old quality when their time was measured
+        uint32_t SettleFrames = 3;
+        // weight of the newest frame in the smoothed frame time
+        float Smoothing = 0.25f;
+    };
+
+    struct BeQuality {
+        float RenderScale = 1.0f;
+        uint32_t Level = 0;   // 0 is full quality, QualityLevels the lowest
+
+        auto operator==(const BeQuality&) const -> bool = default;
+    };
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeSettings _settings;
+    BeQuality _quality;
+    float _smoothedMilliseconds = 0.0f;
+    uint32_t _slowFrames = 0;
+    uint32_t _fastFrames = 0;
+    uint32_t _settleFrames = 0;
+    // a step down soon after a step up doubles the fast frames the next step up needs, up to 16 times FastFrames
+    uint32_t _raiseFrames = 0;
+    uint32_t _framesSinceRaise = UINT32_MAX;
+    uint32_t _changes = 0;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeFrameGovernor();
+    explicit BeFrameGovernor(const BeSettings& settings);
+    ~BeFrameGovernor() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Feeds the time of a finished frame, true when the quality to render the next frame at changed.
+    auto Update(float frameMilliseconds) -> bool;
+    // Back to full quality, forgetting every frame seen.
+    auto Reset() -> void;
+
+    [[nodiscard]] auto GetQuality() const -> const BeQuality& { return _quality; }
+    [[nodiscard]] auto GetSettings() const -> const BeSettings& { return _settings; }
+    [[nodiscard]] auto GetSmoothedMilliseconds() const -> float { return _smoothedMilliseconds; }
+    [[nodiscard]] auto GetChangeCount() const -> uint32_t { return _changes; }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto StepDown() -> bool;
+    auto StepUp() -> bool;
+};
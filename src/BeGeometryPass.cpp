@@ -1,150 +1,526 @@
 ﻿#include "BeGeometryPass.h"
 
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <unordered_map>
 #include <gtc/type_ptr.inl>
 
+#include "BeCulling.h"
+#include "BeIndexPacking.h"
+#include "BeInstancing.h"
+#include "BeLod.h"
 #include "BeRenderer.h"
+#include "BeShader.h"
+#include "BeTextureStreamer.h"
+#include "BeThreadPool.h"
+#include "BeVertexPacking.h"
 #include "Utils.h"
 
 BeGeometryPass::BeGeometryPass() = default;
 BeGeometryPass::~BeGeometryPass() = default;
 
-auto BeGeometryPass::Initialise() -> void {
-    //material buffer
-    D3D11_BUFFER_DESC materialBufferDescriptor = {};
-    materialBufferDescriptor.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    materialBufferDescriptor.Usage = D3D11_USAGE_DYNAMIC;
-    materialBufferDescriptor.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    materialBufferDescriptor.ByteWidth = sizeof(MaterialBufferGPU);
-    Utils::Check << _renderer->GetDevice()->CreateBuffer(&materialBufferDescriptor, nullptr, &_materialBuffer);
-
-    //depth stencil state
-    constexpr D3D11_DEPTH_STENCIL_DESC depthStencilStateDescriptor = {
-        .DepthEnable = true,
-        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL,
-        .DepthFunc = D3D11_COMPARISON_LESS,
-        .StencilEnable = false,
-    };
-    Utils::Check << _renderer->GetDevice()->CreateDepthStencilState(&depthStencilStateDescriptor, _depthStencilState.GetAddressOf());
-    _renderer->GetContext()->OMSetDepthStencilState(_depthStencilState.Get(), 1);
+auto BeGeometryPass::GetResources() const -> BeRenderGraph::BePassResources {
+    return {.Writes = {OutputDepthTextureName, OutputTexture0Name, OutputTexture1Name, OutputTexture2Name}};
+}
 
-    //
+auto BeGeometryPass::Initialise() -> void {
     _whiteFallbackTexture.CreateSRV(_renderer->GetDevice());
+    _outputTexture0 = _renderer->FindRenderResource(OutputTexture0Name);
+    _outputTexture1 = _renderer->FindRenderResource(OutputTexture1Name);
+    _outputTexture2 = _renderer->FindRenderResource(OutputTexture2Name);
+    _outputDepthTexture = _renderer->FindRenderResource(OutputDepthTextureName);
     
     //vbo + ibo
-    size_t totalVerticesNumber = 0;
-    size_t totalIndicesNumber = 0;
-    size_t totalDrawSlices = 0;
-    for (const auto& object : _objects) {
-        totalVerticesNumber += object.Model->FullVertices.size();
-        totalIndicesNumber += object.Model->Indices.size();
-        totalDrawSlices += object.Model->DrawSlices.size();
-    }
-    
-    std::vector<BeFullVertex> fullVertices;
-    std::vector<uint32_t> indices;
-    fullVertices.reserve(totalVerticesNumber);
-    indices.reserve(totalIndicesNumber);
+    MemoryStatistics = {};
+    // Every model is packed once per layout that draws it and its indices are uploaded once,
+    // however many objects share it.
+    struct BeVertexUpload {
+        const BeModel* Model;
+        uint32_t StreamIndex;
+        int32_t BaseVertex;
+    };
+    std::vector<std::vector<uint8_t>> streamData;
+    std::vector<BeVertexUpload> vertexUploads;
+    struct BeIndexUpload {
+        uint32_t FirstIndex;
+        DXGI_FORMAT Format;
+    };
+    std::unordered_map<const BeModel*, BeIndexUpload> indexUploads;
+    BeIndexPacking::BeIndexBuffers indices;
+    // objects sharing model and shader get a block of instance groups, one per model node
+    std::vector<std::pair<const BeModel*, const BeShader*>> instanceGroups;
+    std::vector<uint32_t> instanceGroupBases;
+    uint32_t instanceGroupCount = 0;
+    uint32_t instanceCount = 0;
+    // draw sort key ids, slices of a model get theirs once however many objects show it
+    std::vector<const BeShader*> shaders;
+    std::vector<std::pair<const BeTexture*, const BeTexture*>> textureSets;
+    std::vector<const BeMaterial*> materials;
+    std::unordered_map<const BeModel*, std::pair<std::vector<uint32_t>, std::vector<uint32_t>>> sliceIds;
+    auto findOrAdd = [](auto& values, const auto& value, auto&& equal) -> uint32_t {
+        auto found = std::ranges::find_if(values, [&](const auto& candidate) { return equal(candidate, value); });
+        if (found == values.end())
+            found = values.insert(values.end(), value);
+        return static_cast<uint32_t>(found - values.begin());
+    };
+    auto sameConstants = [](const BeMaterial* a, const BeMaterial* b) {
+        return a->DiffuseColor == b->DiffuseColor && a->SpecularColor == b->SpecularColor && a->Shininess == b->Shininess &&
+            a->SuperSpecularColor == b->SuperSpecularColor && a->SuperShininess == b->SuperShininess;
+    };
+    _sceneGraph.Clear();
     for (auto& object : _objects) {
-        fullVertices.insert(fullVertices.end(), object.Model->FullVertices.begin(), object.Model->FullVertices.end());
-        indices.insert(indices.end(), object.Model->Indices.begin(), object.Model->Indices.end());
+        const std::pair<const BeModel*, const BeShader*> instanceGroup = {object.Model, object.Shader};
+        auto group = std::ranges::find(instanceGroups, instanceGroup);
+        if (group == instanceGroups.end()) {
+            group = instanceGroups.insert(instanceGroups.end(), instanceGroup);
+            instanceGroupBases.push_back(instanceGroupCount);
+            instanceGroupCount += static_cast<uint32_t>(object.Model->Nodes.size());
+        }
+        object.InstanceGroup = instanceGroupBases[group - instanceGroups.begin()];
+
+        // the object's node, then the model's nodes below it in their own order
+        object.SceneNode = _sceneGraph.AddNode(BeSceneGraph::NoParent, object.Position, object.Rotation, object.Scale);
+        for (const auto& node : object.Model->Nodes) {
+            _sceneGraph.AddNode(node.Parent == BeModel::NoParent ? object.SceneNode : object.SceneNode + 1 + node.Parent, node.Transform);
+            instanceCount += node.MeshCount > 0;
+        }
+
+        object.ShaderId = findOrAdd(shaders, object.Shader, std::equal_to {});
+        auto [ids, newModel] = sliceIds.try_emplace(object.Model);
+        if (newModel) {
+            for (const auto& slice : object.Model->DrawSlices) {
+                const std::pair<const BeTexture*, const BeTexture*> textureSet = {slice.Material.DiffuseTexture.get(), slice.Material.SpecularTexture.get()};
+                ids->second.first.push_back(findOrAdd(materials, &slice.Material, sameConstants));
+                ids->second.second.push_back(findOrAdd(textureSets, textureSet, std::equal_to {}));
+            }
+        }
+        object.MaterialIds = ids->second.first;
+        object.TextureSetIds = ids->second.second;
+
+        const BeVertexLayout& layout = object.Shader->VertexLayout;
+        auto stream = std::ranges::find(_vertexStreams, layout, &BeVertexStream::Layout);
+        if (stream == _vertexStreams.end()) {
+            _vertexStreams.push_back({.Layout = layout});
+            streamData.emplace_back();
+            stream = std::prev(_vertexStreams.end());
+        }
+        object.VertexStreamIndex = static_cast<uint32_t>(stream - _vertexStreams.begin());
+
+        auto vertexUpload = std::ranges::find_if(vertexUploads, [&](const BeVertexUpload& upload) {
+            return upload.Model == object.Model && upload.StreamIndex == object.VertexStreamIndex;
+        });
+        if (vertexUpload == vertexUploads.end()) {
+            auto& data = streamData[object.VertexStreamIndex];
+            const size_t start = data.size();
+            data.resize(start + object.Model->FullVertices.size() * layout.Stride);
+            BeVertexPacking::PackVertices(object.Model->FullVertices, layout, data.data() + start);
+            MemoryStatistics.VertexBytes += object.Model->FullVertices.size() * layout.Stride;
+            MemoryStatistics.FullVertexBytes += object.Model->FullVertices.size() * sizeof(BeFullVertex);
+            vertexUploads.push_back({
+                .Model = object.Model,
+                .StreamIndex = object.VertexStreamIndex,
+                .BaseVertex = static_cast<int32_t>(start / layout.Stride),
+            });
+            vertexUpload = std::prev(vertexUploads.end());
+        }
+
+        auto [indexUpload, inserted] = indexUploads.try_emplace(object.Model);
+        if (inserted) {
+            const auto placement = BeIndexPacking::Append(object.Model->Indices, indices);
+            indexUpload->second = {placement.FirstIndex, placement.IsShort ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT};
+        }
+        object.IndexFormat = indexUpload->second.Format;
+        object.FirstIndex = indexUpload->second.FirstIndex;
+
         for (BeModel::BeDrawSlice slice : object.Model->DrawSlices) {
-            slice.BaseVertexLocation += static_cast<int32_t>(fullVertices.size() - object.Model->FullVertices.size());
-            slice.StartIndexLocation += static_cast<uint32_t>(indices.size() - object.Model->Indices.size());
+            object.UVDensities.push_back(BeTextureStreamer::ComputeUVDensity(*object.Model, slice));
+            slice.BaseVertexLocation += vertexUpload->BaseVertex;
+            slice.StartIndexLocation += indexUpload->second.FirstIndex;
             object.DrawSlices.push_back(slice);
         }
+        // LOD slices draw with the vertices and material of their full detail slice
+        for (const auto& level : object.Model->Lods) {
+            for (size_t s = 0; s < level.Slices.size(); ++s) {
+                BeModel::BeDrawSlice slice = object.DrawSlices[s];
+                slice.IndexCount = level.Slices[s].IndexCount;
+                slice.StartIndexLocation = level.Slices[s].StartIndexLocation + indexUpload->second.FirstIndex;
+                slice.FirstMeshlet = level.Slices[s].FirstMeshlet;
+                slice.MeshletCount = level.Slices[s].MeshletCount;
+                object.LodDrawSlices.push_back(slice);
+            }
+        }
     }
     
-    D3D11_BUFFER_DESC vertexBufferDescriptor = {};
-    vertexBufferDescriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    vertexBufferDescriptor.Usage = D3D11_USAGE_DEFAULT;
-    vertexBufferDescriptor.ByteWidth = static_cast<UINT>(fullVertices.size() * sizeof(BeFullVertex));
-    D3D11_SUBRESOURCE_DATA vertexData = {};
-    vertexData.pSysMem = fullVertices.data();
-    Utils::Check << _renderer->GetDevice()->CreateBuffer(&vertexBufferDescriptor, &vertexData, &_sharedVertexBuffer);
+    for (size_t i = 0; i < _vertexStreams.size(); ++i) {
+        D3D11_BUFFER_DESC vertexBufferDescriptor = {};
+        vertexBufferDescriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        vertexBufferDescriptor.Usage = D3D11_USAGE_DEFAULT;
+        vertexBufferDescriptor.ByteWidth = static_cast<UINT>(streamData[i].size());
+        D3D11_SUBRESOURCE_DATA vertexData = {};
+        vertexData.pSysMem = streamData[i].data();
+        Utils::Check << _renderer->GetDevice()->CreateBuffer(&vertexBufferDescriptor, &vertexData, &_vertexStreams[i].Buffer);
+    }
     
-    D3D11_BUFFER_DESC indexBufferDescriptor = {};
-    indexBufferDescriptor.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    indexBufferDescriptor.Usage = D3D11_USAGE_DEFAULT;
-    indexBufferDescriptor.ByteWidth = static_cast<UINT>(indices.size() * sizeof(uint32_t));
-    D3D11_SUBRESOURCE_DATA indexData = {};
-    indexData.pSysMem = indices.data();
-    Utils::Check << _renderer->GetDevice()->CreateBuffer(&indexBufferDescriptor, &indexData, &_sharedIndexBuffer);
-}
+    auto createIndexBuffer = [this](const void* data, const size_t size, ComPtr<ID3D11Buffer>& buffer) {
+        if (size == 0) return;
+        D3D11_BUFFER_DESC indexBufferDescriptor = {};
+        indexBufferDescriptor.BindFlags = D3D11_BIND_INDEX_BUFFER;
+        indexBufferDescriptor.Usage = D3D11_USAGE_DEFAULT;
+        indexBufferDescriptor.ByteWidth = static_cast<UINT>(size);
+        D3D11_SUBRESOURCE_DATA indexData = {};
+        indexData.pSysMem = data;
+        Utils::Check << _renderer->GetDevice()->CreateBuffer(&indexBufferDescriptor, &indexData, &buffer);
+    };
+    createIndexBuffer(indices.Short.data(), indices.Short.size() * sizeof(uint16_t), _shortIndexBuffer);
+    createIndexBuffer(indices.Wide.data(), indices.Wide.size() * sizeof(uint32_t), _wideIndexBuffer);
+    MemoryStatistics.ShortIndices = indices.Short.size();
+    MemoryStatistics.WideIndices = indices.Wide.size();
 
-auto BeGeometryPass::Render() -> void {
-    const auto context = _renderer->GetContext();
+    //material buffers, one immutable constant buffer per distinct set of material constants
+    _materialBuffers.resize(materials.size());
+    for (size_t i = 0; i < materials.size(); ++i) {
+        const MaterialBufferGPU materialData(*materials[i]);
+        D3D11_BUFFER_DESC materialBufferDescriptor = {};
+        materialBufferDescriptor.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        materialBufferDescriptor.Usage = D3D11_USAGE_IMMUTABLE;
+        materialBufferDescriptor.ByteWidth = sizeof(MaterialBufferGPU);
+        D3D11_SUBRESOURCE_DATA materialInitialData = {};
+        materialInitialData.pSysMem = &materialData;
+        Utils::Check << _renderer->GetDevice()->CreateBuffer(&materialBufferDescriptor, &materialInitialData, &_materialBuffers[i]);
+    }
+
+    //instance stream, a ring every frame appends the world matrices of every model node that places meshes to
+    const uint32_t instanceRingSize = std::max(instanceCount, 1u) * InstanceStride * InstanceRingFrames;
+    D3D11_BUFFER_DESC instanceBufferDescriptor = {};
+    instanceBufferDescriptor.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    instanceBufferDescriptor.Usage = D3D11_USAGE_DYNAMIC;
+    instanceBufferDescriptor.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    instanceBufferDescriptor.ByteWidth = instanceRingSize;
+    Utils::Check << _renderer->GetDevice()->CreateBuffer(&instanceBufferDescriptor, nullptr, &_instanceBuffer);
+    _instanceRing.Reset(instanceRingSize);
+    std::cout << std::format("Instancing: {} objects placing {} mesh nodes in {} instance groups, {} scene graph nodes\n",
+        _objects.size(), instanceCount, instanceGroupCount, _sceneGraph.GetNodeCount());
+    // the submission skips binds by comparing ids, so two states must never share one
+    if (shaders.size() > 1u << BeDrawList::ShaderBits ||
+        textureSets.size() > 1u << BeDrawList::TextureSetBits ||
+        materials.size() > 1u << BeDrawList::MaterialBits)
+        throw std::runtime_error(std::format("Too many draw states for the sort key: {} shaders, {} texture sets, {} materials",
+            shaders.size(), textureSets.size(), materials.size()));
+
+    //pipelines, one per shader id: depth tested, opaque, back faces culled
+    _pipelines.clear();
+    for (const BeShader* shader : shaders)
+        _pipelines.push_back(_renderer->GetPipelineCache().Get({.VertexShader = shader, .PixelShader = shader, .StencilReference = 1}));
+}
 
-    const BeRenderResource* depthResource = _renderer->GetRenderResource(OutputDepthTextureName);
-    const BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(OutputTexture0Name);
-    const BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(OutputTexture1Name);
-    const BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(OutputTexture2Name);
+auto BeGeometryPass::Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void {
+    const BeRenderResource* depthResource = _renderer->GetRenderResource(_outputDepthTexture);
+    const BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(_outputTexture0);
+    const BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(_outputTexture1);
+    const BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(_outputTexture2);
     
-    // Clear and set render targets
-    context->ClearDepthStencilView(depthResource->DSV.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
-    context->ClearRenderTargetView(gbufferResource0->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
-    context->ClearRenderTargetView(gbufferResource1->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
-    context->ClearRenderTargetView(gbufferResource2->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
+    // Clear render targets, they are bound with the rest of the pass state before the draws
+    context.ClearDepthStencilView(depthResource->DSV.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+    context.ClearRenderTargetView(gbufferResource0->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
+    context.ClearRenderTargetView(gbufferResource1->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
+    context.ClearRenderTargetView(gbufferResource2->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
 
+    // World matrices of what moved since the last frame, then frustum test every object's box and the slice boxes
+    // of the survivors
+    _sceneGraph.Update();
+    CullingStatistics = {};
+    const BeCulling::BePlanes planes = BeCulling::ExtractPlanes(_renderer->UniformData.ProjectionView);
+    _objectBoxes.Clear();
+    for (const auto& object : _objects)
+        _objectBoxes.Add(object.Model->Bounds, _sceneGraph.GetWorld(object.SceneNode));
+    CullingStatistics.Objects = _objectBoxes.Count;
+    if (FrustumCulling && _objectBoxes.Count >= BvhObjectThreshold) {
+        _objectBvhBoxes.resize(_objectBoxes.Count);
+        for (uint32_t i = 0; i < _objectBoxes.Count; ++i) {
+            const glm::vec3 center = {_objectBoxes.CenterX[i], _objectBoxes.CenterY[i], _objectBoxes.CenterZ[i]};
+            const glm::vec3 extent = {_objectBoxes.ExtentX[i], _objectBoxes.ExtentY[i], _objectBoxes.ExtentZ[i]};
+            _objectBvhBoxes[i] = {center - extent, center + extent};
+        }
+        _objectBvh.Update(_objectBvhBoxes);
+        _visibleObjects.clear();
+        _objectBvh.QueryFrustum(planes, _visibleObjects);
+        _objectVisibility.assign(_objectBoxes.Count, 0);
+        for (const uint32_t object : _visibleObjects)
+            _objectVisibility[object] = 1;
+        CullingStatistics.CulledObjects = _objectBoxes.Count - static_cast<uint32_t>(_visibleObjects.size());
+    } else if (FrustumCulling) {
+        CullingStatistics.CulledObjects = _objectBoxes.Count - BeCulling::Cull(_objectBoxes, planes, _objectVisibility);
+    } else {
+        _objectVisibility.assign(_objectBoxes.Count, 1);
+    }
+
+    // Large objects in view draw their occluder meshes into the CPU depth buffer, the rest are tested against it.
+    // Occluders themselves always stay, their simplified mesh may poke out of their own box.
+    if (OcclusionCulling) {
+        _occlusionBuffer.Begin(_renderer->UniformData.ProjectionView);
+        _objectIsOccluder.assign(_objects.size(), 0);
+        for (uint32_t i = 0; i < _objects.size(); ++i) {
+            const auto& object = _objects[i];
+            if (!_objectVisibility[i] || object.Model->OccluderIndices.empty()) continue;
+            const BeBounds& bounds = object.Model->Bounds;
+            const float maxScale = std::max({std::abs(object.Scale.x), std::abs(object.Scale.y), std::abs(object.Scale.z)});
+            const float radius = bounds.Radius * maxScale;
+            const glm::mat4& world = _sceneGraph.GetWorld(object.SceneNode);
+            const float distance = glm::length(glm::vec3(world * glm::vec4(bounds.Center, 1.0f)) - _renderer->UniformData.CameraPosition);
+            if (distance > radius && 2.0f * std::asin(radius / distance) < OccluderMinAngularSize) continue;
+            _occlusionBuffer.AddOccluder(object.Model->OccluderVertices, object.Model->OccluderIndices, world);
+            _objectIsOccluder[i] = 1;
+        }
+        CullingStatistics.Occluders = _occlusionBuffer.GetStatistics().Occluders;
+        if (CullingStatistics.Occluders > 0) {
+            _occlusionBuffer.Rasterize();
+            for (uint32_t i = 0; i < _objects.size(); ++i) {
+                if (!_objectVisibility[i] || _objectIsOccluder[i]) continue;
+                const glm::vec3 center = {_objectBoxes.CenterX[i], _objectBoxes.CenterY[i], _objectBoxes.CenterZ[i]};
+                const glm::vec3 extent = {_objectBoxes.ExtentX[i], _objectBoxes.ExtentY[i], _objectBoxes.ExtentZ[i]};
+                if (_occlusionBuffer.IsVisible(center, extent)) continue;
+                _objectVisibility[i] = 0;
+                ++CullingStatistics.OccludedObjects;
+            }
+        }
+    }
+
+    // one box per mesh a model node places, in NodeMeshes order
+    _sliceBoxes.Clear();
+    _firstSliceBox.assign(_objects.size(), 0);
+    for (uint32_t i = 0; i < _objects.size(); ++i) {
+        if (!_objectVisibility[i]) continue;
+        const auto& object = _objects[i];
+        _firstSliceBox[i] = _sliceBoxes.Count;
+        for (uint32_t n = 0; n < object.Model->Nodes.size(); ++n) {
+            const BeModel::BeNode& node = object.Model->Nodes[n];
+            for (const uint32_t s : std::span(object.Model->NodeMeshes).subspan(node.FirstMesh, node.MeshCount))
+                _sliceBoxes.Add(object.DrawSlices[s].Bounds, _sceneGraph.GetWorld(object.SceneNode + 1 + n));
+        }
+    }
+    CullingStatistics.Slices = _sliceBoxes.Count;
+    if (FrustumCulling) CullingStatistics.CulledSlices = _sliceBoxes.Count - BeCulling::Cull(_sliceBoxes, planes, _sliceVisibility);
+    else _sliceVisibility.assign(_sliceBoxes.Count, 1);
+
+    // Pick every visible object's LOD, then draw the model nodes of objects sharing model, shader and level as one
+    // instanced batch per node
+    _instances.clear();
+    for (uint32_t i = 0; i < _objects.size(); ++i) {
+        auto& object = _objects[i];
+        if (!_objectVisibility[i]) continue;
+        const glm::mat4x4& modelMatrix = _sceneGraph.GetWorld(object.SceneNode);
+
+        // LOD error is in model space, the largest scale axis bounds how much it grows in the world
+        const BeBounds& bounds = object.Model->Bounds;
+        const float maxScale = std::max({std::abs(object.Scale.x), std::abs(object.Scale.y), std::abs(object.Scale.z)});
+        const glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(bounds.Center, 1.0f));
+        const float distance = glm::length(worldCenter - _renderer->UniformData.CameraPosition) - bounds.Radius * maxScale;
+        const float pixelsPerUnit = BeLod::GetPixelsPerUnit(_renderer->UniformData.VerticalFov, _renderer->UniformData.ViewportHeight, distance) * maxScale;
+        object.LodLevel = LodErrorThreshold > 0.0f ? BeLod::SelectLevel(*object.Model, pixelsPerUnit, LodErrorThreshold, object.LodLevel) : 0;
+
+        // the closest point of the bounds decides, as for the LOD
+        if (TextureStreamer) {
+            for (uint32_t m = 0; m < object.Model->NodeMeshes.size(); ++m) {
+                if (!_sliceVisibility[_firstSliceBox[i] + m]) continue;
+                const uint32_t s = object.Model->NodeMeshes[m];
+                const auto& material = object.DrawSlices[s].Material;
+                for (const BeTexture* texture : {material.DiffuseTexture.get(), material.SpecularTexture.get()})
+                    if (texture)
+                        TextureStreamer->Request(texture, BeTextureStreamer::ComputeRequiredMip(*texture, object.UVDensities[s], pixelsPerUnit));
+            }
+        }
+
+        for (uint32_t n = 0; n < object.Model->Nodes.size(); ++n) {
+            if (object.Model->Nodes[n].MeshCount == 0) continue;
+            _instances.push_back({
+                .Key = BeInstancing::MakeKey(object.InstanceGroup + n, object.LodLevel),
+                .Object = i,
+                .World = _sceneGraph.GetWorld(object.SceneNode + 1 + n),
+            });
+        }
+    }
+    BeInstancing::Build(_instances, _instanceData, _instanceObjects, _batches);
+    UploadStatistics = {};
+    uint32_t instanceOffset = 0;
+    if (!_instanceData.empty()) {
+        // appended behind last frame's matrices without a rename, until the ring wraps
+        const auto instanceBytes = static_cast<uint32_t>(_instanceData.size() * sizeof(glm::mat4));
+        const BeUploadRing::BeAllocation allocation = _instanceRing.Allocate(instanceBytes, InstanceStride);
+        context.UpdateBuffer(_instanceBuffer.Get(), allocation.Offset, _instanceData.data(), instanceBytes, allocation.Wrapped);
+        UploadStatistics = {.MapCalls = 1, .Discards = allocation.Wrapped, .Bytes = instanceBytes};
+        instanceOffset = allocation.Offset;
+    }
+
+    // Record a draw per slice a batch shows, sort them by shader, textures, material and depth, then bind only what
+    // changed from one draw to the next; vertex streams and index buffers are left to the state tracker
+    auto getDrawSlices = [](const ObjectEntry& object) -> std::span<const BeModel::BeDrawSlice> {
+        return object.LodLevel == 0
+            ? std::span(object.DrawSlices)
+            : std::span(object.LodDrawSlices).subspan((object.LodLevel - 1) * object.DrawSlices.size(), object.DrawSlices.size());
+    };
+    _draws.clear();
+    _drawRanges.clear();
+    for (uint32_t b = 0; b < _batches.size(); ++b) {
+        const auto& batch = _batches[b];
+        const auto& object = _objects[batch.Object];
+        const BeModel::BeNode& node = object.Model->Nodes[static_cast<uint32_t>(batch.Key >> 32) - object.InstanceGroup];
+
+        // meshlet visibility belongs to one transform, so only single instances are culled per cluster
+        const bool clusterCulling = ClusterCulling && batch.InstanceCount == 1;
+        const auto cullView = clusterCulling
+            ? BeMeshlets::MakeCullView(_renderer->UniformData.ProjectionView, _instanceData[batch.FirstInstance], _renderer->UniformData.CameraPosition)
+            : BeMeshlets::BeCullView {};
+        const auto drawSlices = getDrawSlices(object);
+        const auto instanceObjects = std::span(_instanceObjects).subspan(batch.FirstInstance, batch.InstanceCount);
+        const float distance = glm::length(glm::vec3(_instanceData[batch.FirstInstance][3]) - _renderer->UniformData.CameraPosition);
+        const uint32_t depth = BeDrawList::QuantizeDepth(distance, _renderer->UniformData.NearFarPlane.y);
+
+        for (uint32_t m = node.FirstMesh; m < node.FirstMesh + node.MeshCount; ++m) {
+            // a batch draws the slice when it is in view for any of its instances
+            if (std::ranges::none_of(instanceObjects, [&](const uint32_t i) { return _sliceVisibility[_firstSliceBox[i] + m] != 0; }))
+                continue;
+
+            const uint32_t s = object.Model->NodeMeshes[m];
+
+            const auto& slice = drawSlices[s];
+            // meshlet ranges are relative to the model's own indices
+            const auto firstRange = static_cast<uint32_t>(_drawRanges.size());
+            if (clusterCulling && slice.MeshletCount > 0) {
+                const auto meshlets = std::span(object.Model->Meshlets).subspan(slice.FirstMeshlet, slice.MeshletCount);
+                CullingStatistics.CulledTriangles += BeMeshlets::Cull(meshlets, cullView, _drawRanges);
+            } else {
+                _drawRanges.push_back({slice.StartIndexLocation - object.FirstIndex, slice.IndexCount});
+            }
+            CullingStatistics.Triangles += slice.IndexCount / 3 * batch.InstanceCount;
+            const auto rangeCount = static_cast<uint32_t>(_drawRanges.size()) - firstRange;
+            if (rangeCount == 0) continue;
+
+            _draws.push_back({
+                .Key = BeDrawList::MakeKey(object.ShaderId, object.TextureSetIds[s], object.MaterialIds[s], depth),
+                .Batch = b,
+                .Slice = s,
+                .FirstRange = firstRange,
+                .RangeCount = rangeCount,
+            });
+        }
+    }
+    UnsortedStateChanges = BeDrawList::CountStateChanges(_draws, false);
+    BeDrawList::Sort(_draws, _drawScratch);
+
+    // what every draw expects bound, in the pass's own list and again in every chunk's
     ID3D11RenderTargetView* gbufferRTVs[3] = {
         gbufferResource0->RTV.Get(),
         gbufferResource1->RTV.Get(),
         gbufferResource2->RTV.Get()
     };
-    context->OMSetRenderTargets(3, gbufferRTVs, depthResource->DSV.Get());
+    auto bindPassState = [&](BeStateTracker& tracker) {
+        tracker.SetRenderTargets(gbufferRTVs, depthResource->DSV.Get());
+        // Set default sampler - temporary,  should be overridden by materials if needed
+        tracker.SetPSSampler(0, _renderer->GetPointSampler().Get());
+        if (!_instanceData.empty())
+            tracker.SetVertexBuffer(InstanceStreamSlot, _instanceBuffer.Get(), InstanceStride, instanceOffset);
+    };
 
-    // Set vertex and index buffers
-    uint32_t stride = sizeof(BeFullVertex);
-    uint32_t offset = 0;
-    context->IASetVertexBuffers(0, 1, _sharedVertexBuffer.GetAddressOf(), &stride, &offset);
-    context->IASetIndexBuffer(_sharedIndexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    // draws [first, last) of the sorted list, binding what changes from one to the next
+    auto recordDraws = [&](BeDeviceContext& drawContext, BeStateTracker& tracker, const uint32_t first, const uint32_t last, BeDrawList::BeStateChanges& changes) {
+        const BeDrawList::BeDraw* previous = nullptr;
+        for (const auto& draw : std::span(_draws).subspan(first, last - first)) {
+            const auto& batch = _batches[draw.Batch];
+            const auto& object = _objects[batch.Object];
+            const auto& slice = getDrawSlices(object)[draw.Slice];
 
-    // Set default sampler - temporary,  should be overridden by materials if needed
-    context->PSSetSamplers(0, 1, _renderer->GetPointSampler().GetAddressOf());
+            if (!previous || BeDrawList::GetShader(previous->Key) != BeDrawList::GetShader(draw.Key)) {
+                tracker.SetPipeline(*_pipelines[object.ShaderId]);
+                ++changes.Shaders;
+            }
+            const auto& stream = _vertexStreams[object.VertexStreamIndex];
+            tracker.SetVertexBuffer(0, stream.Buffer.Get(), stream.Layout.Stride, 0);
+            const auto& indexBuffer = object.IndexFormat == DXGI_FORMAT_R16_UINT ? _shortIndexBuffer : _wideIndexBuffer;
+            tracker.SetIndexBuffer(indexBuffer.Get(), object.IndexFormat);
+            if (!previous || BeDrawList::GetMaterial(previous->Key) != BeDrawList::GetMaterial(draw.Key)) {
+                const auto& materialBuffer = _materialBuffers[BeDrawList::GetMaterial(draw.Key)];
+                tracker.SetVSConstantBuffer(1, materialBuffer.Get());
+                tracker.SetPSConstantBuffer(1, materialBuffer.Get());
+                ++changes.Materials;
+            }
+            if (!previous || BeDrawList::GetTextureSet(previous->Key) != BeDrawList::GetTextureSet(draw.Key)) {
+                ID3D11ShaderResourceView* materialResources[2] = {
+                    slice.Material.DiffuseTexture && slice.Material.DiffuseTexture->SRV ? slice.Material.DiffuseTexture->SRV.Get() : _whiteFallbackTexture.SRV.Get(),
+                    slice.Material.SpecularTexture && slice.Material.SpecularTexture->SRV ? slice.Material.SpecularTexture->SRV.Get() : _whiteFallbackTexture.SRV.Get(),
+                };
+                tracker.SetPSShaderResources(0, materialResources);
+                ++changes.TextureSets;
+            }
+            previous = &draw;
 
-    // Draw all objects
-    for (const auto& object : _objects) {
-        object.Shader->Bind(context.Get());
-    
-        for (const auto& slice : object.DrawSlices) {
-        
-            glm::mat4x4 modelMatrix =
-                glm::translate(glm::mat4(1.0f), object.Position) *
-                glm::mat4_cast(object.Rotation) *
-                glm::scale(glm::mat4(1.0f), object.Scale);
-            MaterialBufferGPU materialData(modelMatrix, slice.Material);
-            D3D11_MAPPED_SUBRESOURCE materialMappedResource;
-            Utils::Check << context->Map(_materialBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &materialMappedResource);
-            memcpy(materialMappedResource.pData, &materialData, sizeof(MaterialBufferGPU));
-            context->Unmap(_materialBuffer.Get(), 0);
-            context->VSSetConstantBuffers(1, 1, _materialBuffer.GetAddressOf());
-            context->PSSetConstantBuffers(1, 1, _materialBuffer.GetAddressOf());
-        
-            ID3D11ShaderResourceView* materialResources[2] = {
-                slice.Material.DiffuseTexture ? slice.Material.DiffuseTexture->SRV.Get() : _whiteFallbackTexture.SRV.Get(),
-                slice.Material.SpecularTexture ? slice.Material.SpecularTexture->SRV.Get() : _whiteFallbackTexture.SRV.Get(),
-            };
-            context->PSSetShaderResources(0, 2, materialResources);
-
-            context->DrawIndexed(slice.IndexCount, slice.StartIndexLocation, slice.BaseVertexLocation);
-        
-            ID3D11ShaderResourceView* emptyResources[2] = { nullptr, nullptr };
-            context->PSSetShaderResources(0, 2, emptyResources);
+            for (const auto& range : std::span(_drawRanges).subspan(draw.FirstRange, draw.RangeCount))
+                drawContext.DrawIndexedInstanced(range.IndexCount, batch.InstanceCount, range.StartIndexLocation + object.FirstIndex, slice.BaseVertexLocation, batch.FirstInstance);
+            changes.Draws += draw.RangeCount;
+        }
+    };
+
+    StateChanges = {};
+    const auto drawCount = static_cast<uint32_t>(_draws.size());
+    if (drawCount <= DrawsPerCommandList) {
+        bindPassState(stateTracker);
+        recordDraws(context, stateTracker, 0, drawCount, StateChanges);
+    } else {
+        // chunks start from nothing bound, each binds the pass state again and is executed in draw order
+        const uint32_t chunkCount = (drawCount + DrawsPerCommandList - 1) / DrawsPerCommandList;
+        while (_drawChunks.size() < chunkCount) _drawChunks.push_back(std::make_unique<BeDrawChunk>());
+        BeThreadPool::Shared().ParallelFor(chunkCount, [&](const uint32_t c) {
+            BeDrawChunk& chunk = *_drawChunks[c];
+            chunk.Commands.Reset();
+            chunk.Tracker.Reset();
+            chunk.Tracker.ResetStatistics();
+            chunk.StateChanges = {};
+            chunk.Commands.SetViewport(_renderer->GetRenderWidth(), _renderer->GetRenderHeight());
+            chunk.Tracker.SetVSConstantBuffer(0, _renderer->GetUniformBuffer().Get());
+            chunk.Tracker.SetPSConstantBuffer(0, _renderer->GetUniformBuffer().Get());
+            bindPassState(chunk.Tracker);
+            recordDraws(chunk.Commands, chunk.Tracker, c * DrawsPerCommandList, std::min(drawCount, (c + 1) * DrawsPerCommandList), chunk.StateChanges);
+        });
+        for (uint32_t c = 0; c < chunkCount; ++c) {
+            const BeDrawChunk& chunk = *_drawChunks[c];
+            stateTracker.ExecuteCommandList(chunk.Commands);
+            stateTracker.AddStatistics(chunk.Tracker.GetStatistics());
+            StateChanges.Shaders += chunk.StateChanges.Shaders;
+            StateChanges.TextureSets += chunk.StateChanges.TextureSets;
+            StateChanges.Materials += chunk.StateChanges.Materials;
+            StateChanges.Draws += chunk.StateChanges.Draws;
         }
     }
-    { 
-        ID3D11ShaderResourceView* emptyResources[2] = { nullptr, nullptr };
-        context->PSSetShaderResources(0, 2, emptyResources); // clean material textures
-        ID3D11Buffer* emptyBuffers[1] = { nullptr };
-        context->VSSetConstantBuffers(1, 1, emptyBuffers); // clean material buffer
-        ID3D11SamplerState* emptySamplers[1] = { nullptr };
-        context->PSSetSamplers(0, 1, emptySamplers); // clean samplers
-        ID3D11RenderTargetView* emptyTargets[3] = { nullptr, nullptr, nullptr };
-        context->OMSetRenderTargets(3, emptyTargets, nullptr); // clean render targets
-    }
+    CullingStatistics.DrawCalls = StateChanges.Draws;
 }
 
 auto BeGeometryPass::SetObjects(const std::vector<ObjectEntry>& objects) -> void {
     _objects = objects;
 }
 
+auto BeGeometryPass::SetObjectTransform(const uint32_t object, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> void {
+    auto& entry = _objects[object];
+    entry.Position = position;
+    entry.Rotation = rotation;
+    entry.Scale = scale;
+    _sceneGraph.SetLocal(entry.SceneNode, position, rotation, scale);
+}
+
+auto BeGeometryPass::PrintFrameStatistics() const -> void {
+    std::cout << std::format("Geometry pass: {} of {} objects culled, {} occluded by {} occluders, {} draws\n",
+        CullingStatistics.CulledObjects, CullingStatistics.Objects, CullingStatistics.OccludedObjects, CullingStatistics.Occluders, CullingStatistics.DrawCalls);
+    std::cout << std::format("State changes: {} shaders, {} texture sets, {} materials sorted; {} shaders, {} texture sets, {} materials in object order\n",
+        StateChanges.Shaders, StateChanges.TextureSets, StateChanges.Materials,
+        UnsortedStateChanges.Shaders, UnsortedStateChanges.TextureSets, UnsortedStateChanges.Materials);
+    std::cout << std::format("Uploads: {} maps, {} discarding, {:.1f} KB; {} immutable material buffers\n",
+        UploadStatistics.MapCalls, UploadStatistics.Discards, double(UploadStatistics.Bytes) / 1024.0, _materialBuffers.size());
+    std::cout << std::format("Geometry memory: vertices {:.1f} KB packed, {:.1f} KB as BeFullVertex; indices {} as 16 bit, {} as 32 bit, {:.1f} KB instead of {:.1f} KB\n",
+        double(MemoryStatistics.VertexBytes) / 1024.0, double(MemoryStatistics.FullVertexBytes) / 1024.0,
+        MemoryStatistics.ShortIndices, MemoryStatistics.WideIndices,
+        double(MemoryStatistics.ShortIndices * sizeof(uint16_t) + MemoryStatistics.WideIndices * sizeof(uint32_t)) / 1024.0,
+        double((MemoryStatistics.ShortIndices + MemoryStatistics.WideIndices) * sizeof(uint32_t)) / 1024.0);
+}
+
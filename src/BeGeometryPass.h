@@ -4,10 +4,23 @@
 #include <gtc/quaternion.hpp>
 #include "BeModel.h"
 
+#include "BeBvh.h"
+#include "BeCommandList.h"
+#include "BeCulling.h"
+#include "BeDrawList.h"
+#include "BeInstancing.h"
+#include "BeMeshlets.h"
+#include "BeOcclusionBuffer.h"
+#include "BePipelineState.h"
 #include "BeRenderPass.h"
+#include "BeSceneGraph.h"
+#include "BeStateTracker.h"
 #include "BeTexture.h"
+#include "BeUploadRing.h"
+#include "BeVertexLayout.h"
 
 class BeShader;
+class BeTextureStreamer;
 
 class BeGeometryPass final : public BeRenderPass {
 public:
@@ -19,6 +32,50 @@ public:
         BeModel* Model;
         std::vector<BeModel::BeDrawSlice> DrawSlices;
         BeShader* Shader;
+        uint32_t VertexStreamIndex = 0;
+        DXGI_FORMAT IndexFormat = DXGI_FORMAT_R32_UINT;
+        uint32_t FirstIndex = 0; // where the model's indices start in its index buffer
+        std::vector<BeModel::BeDrawSlice> LodDrawSlices; // DrawSlices.size() per level of Model->Lods
+        uint32_t LodLevel = 0;
+        std::vector<float> UVDensities; // UV units per model space unit of each DrawSlices entry
+        uint32_t InstanceGroup = 0; // first of a block, one per model node, shared by objects with the same model and shader
+        uint32_t SceneNode = 0; // the object's own node, the model's nodes follow it in their order
+        uint32_t ShaderId = 0; // draw sort key ids, per DrawSlices entry for the material and texture set ones
+        std::vector<uint32_t> MaterialIds;
+        std::vector<uint32_t> TextureSetIds;
+    };
+
+    struct BeCullingStatistics {
+        uint32_t Objects = 0;
+        uint32_t CulledObjects = 0;
+        uint32_t Occluders = 0;
+        uint32_t OccludedObjects = 0;   // in the frustum but hidden behind occluders
+        uint32_t Slices = 0;          // of objects in view
+        uint32_t CulledSlices = 0;
+        uint32_t Triangles = 0;
+        uint32_t CulledTriangles = 0;
+        uint32_t DrawCalls = 0;
+    };
+
+    // what the pass wrote into GPU buffers in the last frame; materials are uploaded once in Initialise
+    struct BeUploadStatistics {
+        uint32_t MapCalls = 0;
+        uint32_t Discards = 0;   // maps that had to rename the instance ring
+        uint64_t Bytes = 0;
+    };
+
+    // what Initialise uploaded, next to what the unpacked data would take
+    struct BeMemoryStatistics {
+        uint64_t VertexBytes = 0;
+        uint64_t FullVertexBytes = 0;   // the same vertices as BeFullVertex
+        uint64_t ShortIndices = 0;
+        uint64_t WideIndices = 0;
+    };
+
+    // one vertex buffer per layout the object shaders read
+    struct BeVertexStream {
+        BeVertexLayout Layout;
+        ComPtr<ID3D11Buffer> Buffer;
     };
 
 public:
@@ -26,14 +83,72 @@ public:
     std::string OutputTexture1Name;
     std::string OutputTexture2Name;
     std::string OutputDepthTextureName;
+    // tests object and then slice boxes against the view frustum before anything is drawn
+    bool FrustumCulling = true;
+    // from this many objects on, object culling walks a BVH refitted every frame instead of testing every box
+    uint32_t BvhObjectThreshold = 256;
+    // rasterizes the occluder meshes of large objects on the CPU and drops objects hidden behind them
+    bool OcclusionCulling = true;
+    // objects whose bounding sphere spans at least this many radians seen from the camera occlude others
+    float OccluderMinAngularSize = 0.25f;
+    // culls slices meshlet by meshlet against the frustum and their backface cones, drawing what is left as ranges
+    bool ClusterCulling = true;
+    BeCullingStatistics CullingStatistics;
+    // binds the last frame issued from its sorted draw list, and what drawing in object order used to cost
+    BeDrawList::BeStateChanges StateChanges;
+    BeDrawList::BeStateChanges UnsortedStateChanges;
+    BeUploadStatistics UploadStatistics;
+    BeMemoryStatistics MemoryStatistics;
+    // largest on screen error in pixels an LOD may introduce, 0 keeps every object at full detail
+    float LodErrorThreshold = 1.0f;
+    // receives the mip level every drawn material texture needs, textures stay as they are without one
+    BeTextureStreamer* TextureStreamer = nullptr;
+    // sorted draws per command list; longer draw lists are cut into parts recorded on as many threads
+    uint32_t DrawsPerCommandList = 512;
     
 private:
-    ComPtr<ID3D11Buffer> _materialBuffer;
-    ComPtr<ID3D11Buffer> _sharedVertexBuffer;
-    ComPtr<ID3D11Buffer> _sharedIndexBuffer;
-    ComPtr<ID3D11DepthStencilState> _depthStencilState;
+    // a part of the sorted draw list, recorded with a tracker of its own
+    struct BeDrawChunk {
+        BeCommandList Commands;
+        BeStateTracker Tracker {Commands};
+        BeDrawList::BeStateChanges StateChanges;
+    };
+
+    // frames of instance data the ring holds before it wraps and discards
+    static constexpr uint32_t InstanceRingFrames = 3;
+
+    std::vector<ComPtr<ID3D11Buffer>> _materialBuffers;   // immutable, one per material id
+    std::vector<BeVertexStream> _vertexStreams;
+    ComPtr<ID3D11Buffer> _shortIndexBuffer;   // models whose indices all fit in 16 bit
+    ComPtr<ID3D11Buffer> _wideIndexBuffer;
+    std::vector<const BePipelineState*> _pipelines;   // per shader id
+    BeHandle _outputTexture0;
+    BeHandle _outputTexture1;
+    BeHandle _outputTexture2;
+    BeHandle _outputDepthTexture;
     
     std::vector<ObjectEntry> _objects;
+    BeSceneGraph _sceneGraph;
+    BeCulling::BeBoxes _objectBoxes;
+    BeCulling::BeBoxes _sliceBoxes;
+    std::vector<uint8_t> _objectVisibility;
+    BeBvh _objectBvh;
+    std::vector<BeBvh::BeBox> _objectBvhBoxes;
+    std::vector<uint32_t> _visibleObjects;
+    BeOcclusionBuffer _occlusionBuffer;
+    std::vector<uint8_t> _objectIsOccluder;
+    std::vector<uint8_t> _sliceVisibility;
+    std::vector<uint32_t> _firstSliceBox; // per object, where the boxes of its NodeMeshes start in _sliceBoxes
+    ComPtr<ID3D11Buffer> _instanceBuffer;
+    BeUploadRing _instanceRing;
+    std::vector<BeInstancing::BeInstance> _instances;
+    std::vector<glm::mat4> _instanceData;
+    std::vector<uint32_t> _instanceObjects;
+    std::vector<BeInstancing::BeBatch> _batches;
+    std::vector<BeDrawList::BeDraw> _draws;
+    std::vector<BeDrawList::BeDraw> _drawScratch;
+    std::vector<BeMeshlets::BeIndexRange> _drawRanges;
+    std::vector<std::unique_ptr<BeDrawChunk>> _drawChunks;
     
     BeTexture _whiteFallbackTexture {glm::vec4(1.0f)};
     
@@ -41,8 +156,12 @@ public:
     explicit BeGeometryPass();
     ~BeGeometryPass() override;
     
+    auto GetResources() const -> BeRenderGraph::BePassResources override;
     auto Initialise() -> void override;
-    auto Render() -> void override;
+    auto Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void override;
 
     auto SetObjects (const std::vector<ObjectEntry>& objects) -> void;
+    // Moves an object after Initialise, its world matrices are recomputed in the next Render.
+    auto SetObjectTransform(uint32_t object, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> void;
+    auto PrintFrameStatistics() const -> void;
 };
@@ -0,0 +1,120 @@
+﻿#pragma once
+#include <cstdint>
+#include <deque>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A name reduced to its 64 bit FNV-1a hash. String literals are hashed by the compiler, runtime strings once where
+// they are turned into a name; lookups compare integers and never touch the string again.
+struct BeName {
+    static constexpr uint64_t OffsetBasis = 0xcbf29ce484222325ull;
+    static constexpr uint64_t Prime = 0x100000001b3ull;
+
+    uint64_t Hash = 0;
+
+    [[nodiscard]] static constexpr auto HashString(const std::string_view text) -> uint64_t {
+        uint64_t hash = OffsetBasis;
+        for (const char c : text) {
+            hash ^= uint8_t(c);
+            hash *= Prime;
+        }
+        return hash;
+    }
+
+    constexpr BeName() = default;
+    template <size_t N>
+    consteval BeName(const char (&literal)[N]) : Hash(HashString(std::string_view(literal, N - 1))) {}
+    constexpr BeName(const std::string& name) : Hash(HashString(name)) {}
+    constexpr explicit BeName(const std::string_view name) : Hash(HashString(name)) {}
+
+    auto operator==(const BeName&) const -> bool = default;
+};
+
+// Index of a registry slot and the generation the slot had when it was filled. A default handle is never valid, a
+// handle to a removed entry stops resolving even after its slot is reused.
+struct BeHandle {
+    uint32_t Index = 0;
+    uint32_t Generation = 0;
+
+    [[nodiscard]] auto IsValid() const -> bool { return Generation != 0; }
+    auto operator==(const BeHandle&) const -> bool = default;
+};
+
+// Entries in slots that never move, found by name once and by handle from then on. Pointers from Get stay valid until
+// the entry is removed, adding more entries does not move the ones already there.
+template <typename T>
+class BeHandleRegistry {
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    struct BeSlot {
+        std::optional<T> Value;
+        uint32_t Generation = 1;
+        BeName Name;
+    };
+
+    std::deque<BeSlot> _slots;
+    std::vector<uint32_t> _freeSlots;
+    std::unordered_map<uint64_t, uint32_t> _slotsByName;
+
+public:
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructs the entry in place. Throws when the name, or another one with the same hash, is already taken.
+    template <typename... Args>
+    auto Add(const BeName name, Args&&... args) -> BeHandle {
+        if (_slotsByName.contains(name.Hash))
+            throw std::runtime_error(std::format("Registry already holds an entry named {:016x}", name.Hash));
+        uint32_t index;
+        if (!_freeSlots.empty()) {
+            index = _freeSlots.back();
+            _freeSlots.pop_back();
+        } else {
+            index = static_cast<uint32_t>(_slots.size());
+            _slots.emplace_back();
+        }
+        BeSlot& slot = _slots[index];
+        slot.Value.emplace(std::forward<Args>(args)...);
+        slot.Name = name;
+        _slotsByName.emplace(name.Hash, index);
+        return {.Index = index, .Generation = slot.Generation};
+    }
+
+    // Destroys the entry, every handle to it stops resolving. False for handles that already did not resolve.
+    auto Remove(const BeHandle handle) -> bool {
+        if (Get(handle) == nullptr) return false;
+        BeSlot& slot = _slots[handle.Index];
+        slot.Value.reset();
+        if (++slot.Generation == 0) slot.Generation = 1;
+        _slotsByName.erase(slot.Name.Hash);
+        _freeSlots.push_back(handle.Index);
+        return true;
+    }
+
+    auto Clear() -> void {
+        for (uint32_t i = 0; i < _slots.size(); ++i)
+            if (_slots[i].Value.has_value())
+                Remove({.Index = i, .Generation = _slots[i].Generation});
+    }
+
+    // The handle of a named entry, an invalid one when there is none.
+    [[nodiscard]] auto Find(const BeName name) const -> BeHandle {
+        const auto found = _slotsByName.find(name.Hash);
+        if (found == _slotsByName.end()) return {};
+        return {.Index = found->second, .Generation = _slots[found->second].Generation};
+    }
+
+    // nullptr for invalid handles and handles to removed entries
+    [[nodiscard]] auto Get(const BeHandle handle) -> T* {
+        if (handle.Index >= _slots.size()) return nullptr;
+        BeSlot& slot = _slots[handle.Index];
+        return slot.Generation == handle.Generation && slot.Value.has_value() ? &*slot.Value : nullptr;
+    }
+    [[nodiscard]] auto Get(const BeHandle handle) const -> const T* {
+        return const_cast<BeHandleRegistry*>(this)->Get(handle);
+    }
+
+    [[nodiscard]] auto GetCount() const -> uint32_t { return static_cast<uint32_t>(_slotsByName.size()); }
+};
@@ -0,0 +1,25 @@
+﻿#include "BeIndexPacking.h"
+
+#include <algorithm>
+
+auto BeIndexPacking::FitsInShort(const std::span<const uint32_t> indices) -> bool {
+    return std::ranges::all_of(indices, [](const uint32_t index) { return index <= UINT16_MAX; });
+}
+
+auto BeIndexPacking::Append(const std::span<const uint32_t> indices, BeIndexBuffers& buffers) -> BePlacement {
+    if (!FitsInShort(indices)) {
+        const BePlacement placement = {.IsShort = false, .FirstIndex = static_cast<uint32_t>(buffers.Wide.size())};
+        buffers.Wide.insert(buffers.Wide.end(), indices.begin(), indices.end());
+        return placement;
+    }
+    const BePlacement placement = {.IsShort = true, .FirstIndex = static_cast<uint32_t>(buffers.Short.size())};
+    buffers.Short.reserve(buffers.Short.size() + indices.size());
+    for (const uint32_t index : indices)
+        buffers.Short.push_back(static_cast<uint16_t>(index));
+    return placement;
+}
+
+auto BeIndexPacking::Read(const BeIndexBuffers& buffers, const BePlacement& placement, const uint32_t offset) -> uint32_t {
+    const size_t position = size_t(placement.FirstIndex) + offset;
+    return placement.IsShort ? buffers.Short.at(position) : buffers.Wide.at(position);
+}
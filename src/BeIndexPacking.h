@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Narrows model indices for upload. Slice indices are relative to BaseVertexLocation, so a model whose indices all fit
+// in 16 bit can share one 16 bit index buffer with the others, whatever the size of the scene.
+namespace BeIndexPacking {
+
+    struct BeIndexBuffers {
+        std::vector<uint16_t> Short;
+        std::vector<uint32_t> Wide;    // models with an index past UINT16_MAX
+    };
+
+    struct BePlacement {
+        bool IsShort = false;
+        uint32_t FirstIndex = 0;       // where the model's indices start in the buffer they went to
+    };
+
+    [[nodiscard]] auto FitsInShort(std::span<const uint32_t> indices) -> bool;
+    // Appends indices to the narrowest buffer that holds them unchanged.
+    auto Append(std::span<const uint32_t> indices, BeIndexBuffers& buffers) -> BePlacement;
+    // The index at position FirstIndex + offset of the buffer placement points into.
+    [[nodiscard]] auto Read(const BeIndexBuffers& buffers, const BePlacement& placement, uint32_t offset) -> uint32_t;
+}
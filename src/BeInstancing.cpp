@@ -0,0 +1,40 @@
+﻿#include "BeInstancing.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+auto BeInstancing::Build(
+    const std::span<const BeInstance> instances,
+    std::vector<glm::mat4>& instanceData,
+    std::vector<uint32_t>& instanceObjects,
+    std::vector<BeBatch>& batches)
+-> void {
+    // count per key, then place every instance at its batch's running offset
+    batches.clear();
+    std::unordered_map<uint64_t, uint32_t> batchOfKey;
+    batchOfKey.reserve(instances.size());
+    std::vector<uint32_t> instanceBatch(instances.size());
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const auto [found, inserted] = batchOfKey.try_emplace(instances[i].Key, static_cast<uint32_t>(batches.size()));
+        if (inserted)
+            batches.push_back({.Key = instances[i].Key, .Object = instances[i].Object, .FirstInstance = 0, .InstanceCount = 0});
+        instanceBatch[i] = found->second;
+        ++batches[found->second].InstanceCount;
+    }
+
+    uint32_t offset = 0;
+    for (auto& batch : batches) {
+        batch.FirstInstance = offset;
+        offset += batch.InstanceCount;
+    }
+
+    instanceData.resize(instances.size());
+    instanceObjects.resize(instances.size());
+    std::vector<uint32_t> written(batches.size(), 0);
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const uint32_t batch = instanceBatch[i];
+        const uint32_t place = batches[batch].FirstInstance + written[batch]++;
+        instanceData[place] = instances[i].World;
+        instanceObjects[place] = instances[i].Object;
+    }
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm.hpp>
+
+// Groups objects that draw the same thing into instanced batches and lays out their per instance data.
+namespace BeInstancing {
+
+    // One object wanting to be drawn this frame. Objects with equal keys draw the same slices with the same shader.
+    struct BeInstance {
+        uint64_t Key;
+        uint32_t Object;          // caller's index, the first object of a batch stands in for all of them
+        glm::mat4 World;
+    };
+
+    struct BeBatch {
+        uint64_t Key;
+        uint32_t Object;
+        uint32_t FirstInstance;   // into the instance data, the StartInstanceLocation of the draw
+        uint32_t InstanceCount;
+    };
+
+    // Group and shader in the high bits, LOD level in the low ones.
+    [[nodiscard]] constexpr auto MakeKey(const uint32_t group, const uint32_t lodLevel) -> uint64_t {
+        return uint64_t(group) << 32 | lodLevel;
+    }
+
+    // Batches in order of first appearance, instances keep their relative order within a batch. instanceData gets
+    // the world matrices batch after batch, glm columns being the rows the shader reads, instanceObjects the object
+    // each of them belongs to.
+    auto Build(
+        std::span<const BeInstance> instances,
+        std::vector<glm::mat4>& instanceData,
+        std::vector<uint32_t>& instanceObjects,
+        std::vector<BeBatch>& batches
+    ) -> void;
+}
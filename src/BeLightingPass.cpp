@@ -1,7 +1,10 @@
 ﻿#include "BeLightingPass.h"
 
+#include <algorithm>
+#include <span>
 #include <gtc/type_ptr.inl>
 
+#include "BePipelineCache.h"
 #include "BeRenderer.h"
 #include "BeShader.h"
 #include "Utils.h"
@@ -10,8 +13,20 @@
 BeLightingPass::BeLightingPass() = default;
 BeLightingPass::~BeLightingPass() = default;
 
+auto BeLightingPass::GetResources() const -> BeRenderGraph::BePassResources {
+    return {
+        .Reads = {InputDepthTextureName, InputTexture0Name, InputTexture1Name, InputTexture2Name},
+        .Writes = {OutputTextureName},
+    };
+}
+
 auto BeLightingPass::Initialise() -> void {
     const auto device = _renderer->GetDevice();
+    _inputTexture0 = _renderer->FindRenderResource(InputTexture0Name);
+    _inputTexture1 = _renderer->FindRenderResource(InputTexture1Name);
+    _inputTexture2 = _renderer->FindRenderResource(InputTexture2Name);
+    _inputDepthTexture = _renderer->FindRenderResource(InputDepthTextureName);
+    _outputTexture = _renderer->FindRenderResource(OutputTextureName);
 
     // Additive blending for lights
     D3D11_BLEND_DESC lightingBlendDesc = {};
@@ -24,8 +39,6 @@ auto BeLightingPass::Initialise() -> void {
     lightingBlendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
     lightingBlendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
 
-    Utils::Check << device->CreateBlendState(&lightingBlendDesc, _lightingBlendState.GetAddressOf());
-
     
     D3D11_BUFFER_DESC directionalLightBufferDescriptor = {};
     directionalLightBufferDescriptor.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
@@ -45,77 +58,68 @@ auto BeLightingPass::Initialise() -> void {
         device.Get(),
         "assets/shaders/directionalLight",
         BeShaderType::Pixel,
-        std::vector<BeVertexElementDescriptor>{}
+        BeVertexLayout{}
     );
 
     _pointLightShader = std::make_unique<BeShader>(
         device.Get(),
         "assets/shaders/pointLight",
         BeShaderType::Pixel,
-        std::vector<BeVertexElementDescriptor>{}
+        BeVertexLayout{}
     );
+
+    BePipelineCache& pipelineCache = _renderer->GetPipelineCache();
+    _directionalLightPipeline = pipelineCache.Get({
+        .VertexShader = _renderer->GetFullscreenShader(),
+        .PixelShader = _directionalLightShader.get(),
+        .Blend = lightingBlendDesc,
+        .DepthStencil = BePipelineCache::DisabledDepthStencil,
+        .Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+    });
+    _pointLightPipeline = pipelineCache.Get({
+        .VertexShader = _renderer->GetFullscreenShader(),
+        .PixelShader = _pointLightShader.get(),
+        .Blend = lightingBlendDesc,
+        .DepthStencil = BePipelineCache::DisabledDepthStencil,
+        .Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+    });
 }
 
-auto BeLightingPass::Render() -> void {
-    const auto context = _renderer->GetContext();
-    
-    BeRenderResource* depthResource    = _renderer->GetRenderResource(InputDepthTextureName);
-    BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(InputTexture0Name);
-    BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(InputTexture1Name);
-    BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(InputTexture2Name);
-    BeRenderResource* lightingResource = _renderer->GetRenderResource(OutputTextureName);
+auto BeLightingPass::Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void {
+    BeRenderResource* depthResource    = _renderer->GetRenderResource(_inputDepthTexture);
+    BeRenderResource* gbufferResource0 = _renderer->GetRenderResource(_inputTexture0);
+    BeRenderResource* gbufferResource1 = _renderer->GetRenderResource(_inputTexture1);
+    BeRenderResource* gbufferResource2 = _renderer->GetRenderResource(_inputTexture2);
+    BeRenderResource* lightingResource = _renderer->GetRenderResource(_outputTexture);
     
-    context->ClearRenderTargetView(lightingResource->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
-    context->OMSetRenderTargets(1, lightingResource->RTV.GetAddressOf(), nullptr);
-    context->OMSetBlendState(_lightingBlendState.Get(), nullptr, 0xFFFFFFFF);
-
-    context->VSSetShader(_renderer->GetFullscreenVertexShader().Get(), nullptr, 0);
+    context.ClearRenderTargetView(lightingResource->RTV.Get(), glm::value_ptr(glm::vec4(0.0f)));
+    stateTracker.SetRenderTargets(std::span(lightingResource->RTV.GetAddressOf(), 1), nullptr);
 
-    context->PSSetShaderResources(0, 1, depthResource->SRV.GetAddressOf());
-    context->PSSetShaderResources(1, 1, gbufferResource0->SRV.GetAddressOf());
-    context->PSSetShaderResources(2, 1, gbufferResource1->SRV.GetAddressOf());
-    context->PSSetShaderResources(3, 1, gbufferResource2->SRV.GetAddressOf());
+    ID3D11ShaderResourceView* inputResources[4] = {
+        depthResource->SRV.Get(),
+        gbufferResource0->SRV.Get(),
+        gbufferResource1->SRV.Get(),
+        gbufferResource2->SRV.Get(),
+    };
+    stateTracker.SetPSShaderResources(0, inputResources);
 
-    context->PSSetSamplers(0, 1, _renderer->GetPointSampler().GetAddressOf());
+    stateTracker.SetPSSampler(0, _renderer->GetPointSampler().Get());
 
     {
         DirectionalLightBufferGPU directionalLightBuffer(DirectionalLightData);
-        D3D11_MAPPED_SUBRESOURCE directionalLightMappedResource;
-        Utils::Check << context->Map(_directionalLightBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &directionalLightMappedResource);
-        memcpy(directionalLightMappedResource.pData, &directionalLightBuffer, sizeof(DirectionalLightBufferGPU));
-        context->Unmap(_directionalLightBuffer.Get(), 0);
-        context->PSSetConstantBuffers(1, 1, _directionalLightBuffer.GetAddressOf());
+        context.UpdateBuffer(_directionalLightBuffer.Get(), 0, &directionalLightBuffer, sizeof(DirectionalLightBufferGPU), true);
+        stateTracker.SetPSConstantBuffer(1, _directionalLightBuffer.Get());
 
-        context->PSSetShader(_directionalLightShader->PixelShader.Get(), nullptr, 0);
-
-        context->IASetInputLayout(nullptr);
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        context->Draw(4, 0);
+        stateTracker.SetPipeline(*_directionalLightPipeline);
+        context.Draw(4, 0);
     }
 
-    context->PSSetShader(_pointLightShader->PixelShader.Get(), nullptr, 0);
-    for (const auto& pointLightData : PointLights) {
+    stateTracker.SetPipeline(*_pointLightPipeline);
+    const size_t pointLightCount = std::min<size_t>(PointLights.size(), MaxPointLights);
+    for (const auto& pointLightData : std::span(PointLights).first(pointLightCount)) {
         PointLightBufferGPU pointLightBuffer(pointLightData);
-        D3D11_MAPPED_SUBRESOURCE pointLightMappedResource;
-        Utils::Check << context->Map(_pointLightBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &pointLightMappedResource);
-        memcpy(pointLightMappedResource.pData, &pointLightBuffer, sizeof(PointLightBufferGPU));
-        context->Unmap(_pointLightBuffer.Get(), 0);
-        context->PSSetConstantBuffers(1, 1, _pointLightBuffer.GetAddressOf());
-    
-        context->IASetInputLayout(nullptr);
-        context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        context->Draw(4, 0);
-    }
-
-    {
-        ID3D11ShaderResourceView* emptyResources[4] = { nullptr, nullptr, nullptr, nullptr };
-        context->PSSetShaderResources(0, 4, emptyResources);
-        ID3D11Buffer* emptyBuffers[1] = { nullptr };
-        context->PSSetConstantBuffers(1, 1, emptyBuffers);
-        ID3D11SamplerState* emptySamplers[1] = { nullptr };
-        context->PSSetSamplers(0, 1, emptySamplers);
-        ID3D11RenderTargetView* emptyTargets[1] = { nullptr };
-        context->OMSetRenderTargets(1, emptyTargets, nullptr);
-        context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
+        context.UpdateBuffer(_pointLightBuffer.Get(), 0, &pointLightBuffer, sizeof(PointLightBufferGPU), true);
+        stateTracker.SetPSConstantBuffer(1, _pointLightBuffer.Get());
+        context.Draw(4, 0);
     }
 }
@@ -6,11 +6,14 @@
 
 class BeShader;
 class BeRenderer;
+struct BePipelineState;
 
 class BeLightingPass final : public BeRenderPass {
 public:
     DirectionalLightData DirectionalLightData;
     std::vector<PointLightData> PointLights;
+    // only the first this many point lights are drawn, a quality knob
+    uint32_t MaxPointLights = UINT32_MAX;
 
     std::string InputTexture0Name;
     std::string InputTexture1Name;
@@ -19,20 +22,28 @@ public:
     std::string OutputTextureName;
     
 private:
-    ComPtr<ID3D11BlendState> _lightingBlendState;
-
     ComPtr<ID3D11Buffer> _directionalLightBuffer;
     ComPtr<ID3D11Buffer> _pointLightBuffer;
     //ComPtr<ID3D11Buffer> _spotLightBuffer;
 
     std::unique_ptr<BeShader> _directionalLightShader;
     std::unique_ptr<BeShader> _pointLightShader;
+
+    const BePipelineState* _directionalLightPipeline = nullptr;
+    const BePipelineState* _pointLightPipeline = nullptr;
+
+    BeHandle _inputTexture0;
+    BeHandle _inputTexture1;
+    BeHandle _inputTexture2;
+    BeHandle _inputDepthTexture;
+    BeHandle _outputTexture;
     
     
 public:
     explicit BeLightingPass();
     ~BeLightingPass() override;
 
+    auto GetResources() const -> BeRenderGraph::BePassResources override;
     auto Initialise() -> void override;
-    auto Render() -> void override;
+    auto Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void override;
 };
@@ -0,0 +1,337 @@
+﻿#include "BeLod.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#include "BeMeshOptimizer.h"
+
+namespace {
+    // a collapse may tilt a neighbouring triangle by up to about 75 degrees, more tends to leave folded slivers
+    constexpr float MinimumNormalCosine = 0.25f;
+
+    // Symmetric 4x4 plane quadric, area weighted, so Evaluate / Weight is a squared distance.
+    struct BeQuadric {
+        double A00 = 0, A01 = 0, A02 = 0, A11 = 0, A12 = 0, A22 = 0;
+        double B0 = 0, B1 = 0, B2 = 0;
+        double C = 0;
+        double Weight = 0;
+
+        static auto FromPlane(const glm::dvec3& normal, const double distance, const double weight) -> BeQuadric {
+            return {
+                .A00 = weight * normal.x * normal.x, .A01 = weight * normal.x * normal.y, .A02 = weight * normal.x * normal.z,
+                .A11 = weight * normal.y * normal.y, .A12 = weight * normal.y * normal.z, .A22 = weight * normal.z * normal.z,
+                .B0 = weight * normal.x * distance, .B1 = weight * normal.y * distance, .B2 = weight * normal.z * distance,
+                .C = weight * distance * distance,
+                .Weight = weight,
+            };
+        }
+
+        auto operator+=(const BeQuadric& other) -> BeQuadric& {
+            A00 += other.A00; A01 += other.A01; A02 += other.A02;
+            A11 += other.A11; A12 += other.A12; A22 += other.A22;
+            B0 += other.B0; B1 += other.B1; B2 += other.B2;
+            C += other.C;
+            Weight += other.Weight;
+            return *this;
+        }
+
+        [[nodiscard]] auto Evaluate(const glm::vec3& point) const -> double {
+            const double x = point.x, y = point.y, z = point.z;
+            const double result =
+                A00 * x * x + 2 * A01 * x * y + 2 * A02 * x * z +
+                A11 * y * y + 2 * A12 * y * z + A22 * z * z +
+                2 * (B0 * x + B1 * y + B2 * z) + C;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct BePositionKey {
+        std::array<uint32_t, 3> Bits;
+        auto operator==(const BePositionKey&) const -> bool = default;
+    };
+
+    struct BePositionHash {
+        auto operator()(const BePositionKey& key) const -> size_t {
+            return size_t(key.Bits[0]) * 73856093u ^ size_t(key.Bits[1]) * 19349663u ^ size_t(key.Bits[2]) * 83492791u;
+        }
+    };
+
+    struct BeCollapse {
+        uint32_t From;
+        uint32_t To;
+        float Error;
+    };
+
+    // Vertices that may not move: several attribute vertices sharing a position (UV and normal seams), and ends of
+    // welded edges without exactly two triangles (open borders such as a slice outline, non-manifold fins).
+    auto FindLockedVertices(const std::span<const uint32_t> indices, const std::span<const BeFullVertex> vertices) -> std::vector<bool> {
+        std::unordered_map<BePositionKey, uint32_t, BePositionHash> positionIds;
+        std::vector<uint32_t> welded(vertices.size(), std::numeric_limits<uint32_t>::max());
+        std::vector<uint32_t> firstVertex;   // per position id, the attribute vertex seen first
+        std::vector<bool> seam;              // per position id
+        for (const uint32_t index : indices) {
+            if (welded[index] != std::numeric_limits<uint32_t>::max()) continue;
+            const glm::vec3& p = vertices[index].Position;
+            const BePositionKey key {{std::bit_cast<uint32_t>(p.x), std::bit_cast<uint32_t>(p.y), std::bit_cast<uint32_t>(p.z)}};
+            const auto [entry, inserted] = positionIds.try_emplace(key, static_cast<uint32_t>(firstVertex.size()));
+            if (inserted) {
+                firstVertex.push_back(index);
+                seam.push_back(false);
+            } else if (firstVertex[entry->second] != index) {
+                seam[entry->second] = true;
+            }
+            welded[index] = entry->second;
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(indices.size());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                const uint32_t a = welded[indices[t + corner]];
+                const uint32_t b = welded[indices[t + (corner + 1) % 3]];
+                ++edgeUse[(uint64_t(std::min(a, b)) << 32) | std::max(a, b)];
+            }
+        }
+        std::vector<bool> lockedPosition(seam);
+        for (const auto& [edge, count] : edgeUse) {
+            if (count == 2) continue;
+            lockedPosition[uint32_t(edge >> 32)] = true;
+            lockedPosition[uint32_t(edge)] = true;
+        }
+
+        std::vector<bool> locked(vertices.size(), false);
+        for (size_t v = 0; v < vertices.size(); ++v)
+            if (welded[v] != std::numeric_limits<uint32_t>::max()) locked[v] = lockedPosition[welded[v]];
+        return locked;
+    }
+
+    auto ComputeError(const BeQuadric& quadric, const glm::vec3& point) -> float {
+        return quadric.Weight > 0.0 ? float(std::sqrt(quadric.Evaluate(point) / quadric.Weight)) : 0.0f;
+    }
+
+    // Moving `from` onto `to` must not turn any remaining triangle around `from` over, or close to it.
+    auto PreservesOrientation(
+        const uint32_t from,
+        const uint32_t to,
+        const std::span<const uint32_t> indices,
+        const std::span<const uint32_t> adjacency,
+        const std::span<const BeFullVertex> vertices)
+    -> bool {
+        const glm::vec3& target = vertices[to].Position;
+        for (const uint32_t triangle : adjacency) {
+            const uint32_t* corners = &indices[triangle * 3];
+            if (corners[0] == to || corners[1] == to || corners[2] == to) continue;
+            const uint32_t corner = corners[0] == from ? 0 : corners[1] == from ? 1 : 2;
+            const glm::vec3& b = vertices[corners[(corner + 1) % 3]].Position;
+            const glm::vec3& c = vertices[corners[(corner + 2) % 3]].Position;
+            const glm::vec3 before = glm::cross(b - vertices[from].Position, c - vertices[from].Position);
+            const glm::vec3 after = glm::cross(b - target, c - target);
+            if (glm::dot(before, after) < MinimumNormalCosine * glm::length(before) * glm::length(after)) return false;
+        }
+        return true;
+    }
+
+    auto GetModelRadius(const BeModel& model) -> float {
+        if (model.FullVertices.empty()) return 0.0f;
+        glm::vec3 minimum {std::numeric_limits<float>::max()};
+        glm::vec3 maximum {std::numeric_limits<float>::lowest()};
+        for (const auto& vertex : model.FullVertices) {
+            minimum = glm::min(minimum, vertex.Position);
+            maximum = glm::max(maximum, vertex.Position);
+        }
+        return glm::length(maximum - minimum) * 0.5f;
+    }
+}
+
+auto BeLod::Simplify(
+    const std::span<const uint32_t> indices,
+    const std::span<const BeFullVertex> vertices,
+    const uint32_t targetIndexCount,
+    const float maxError,
+    std::vector<uint32_t>& destination)
+-> float {
+    destination.assign(indices.begin(), indices.end());
+    if (destination.size() <= targetIndexCount) return 0.0f;
+
+    const std::vector<bool> locked = FindLockedVertices(indices, vertices);
+    std::vector<BeQuadric> quadrics(vertices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const glm::dvec3 p0 = vertices[indices[t + 0]].Position;
+        const glm::dvec3 p1 = vertices[indices[t + 1]].Position;
+        const glm::dvec3 p2 = vertices[indices[t + 2]].Position;
+        const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(normal);
+        if (length == 0.0) continue;
+        const glm::dvec3 unitNormal = normal / length;
+        const BeQuadric plane = BeQuadric::FromPlane(unitNormal, -glm::dot(unitNormal, p0), length * 0.5);
+        for (uint32_t corner = 0; corner < 3; ++corner)
+            quadrics[indices[t + corner]] += plane;
+    }
+
+    // Passes of independent collapses, cheapest first, until the target or the error limit is reached. Collapses
+    // in one pass never share a triangle, so their orientation checks stay valid.
+    float resultError = 0.0f;
+    std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<BeCollapse> bestCollapses(vertices.size());
+    std::vector<BeCollapse> collapses;
+    std::vector<uint32_t> remap(vertices.size());
+    std::vector<bool> touched(vertices.size());
+    while (destination.size() > targetIndexCount) {
+        std::ranges::fill(adjacencyOffsets, 0);
+        for (const uint32_t index : destination) ++adjacencyOffsets[index + 1];
+        std::inclusive_scan(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        adjacency.resize(destination.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < destination.size(); ++i)
+                adjacency[fill[destination[i]]++] = i / 3;
+        }
+        auto trianglesAround = [&](const uint32_t vertex) {
+            return std::span(adjacency).subspan(adjacencyOffsets[vertex], adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex]);
+        };
+
+        // cheapest edge out of every free vertex
+        std::ranges::fill(bestCollapses, BeCollapse {0, 0, std::numeric_limits<float>::max()});
+        for (size_t t = 0; t + 2 < destination.size(); t += 3) {
+            for (uint32_t corner = 0; corner < 3; ++corner) {
+                const uint32_t a = destination[t + corner];
+                const uint32_t b = destination[t + (corner + 1) % 3];
+                BeQuadric combined = quadrics[a];
+                combined += quadrics[b];
+                if (!locked[a]) {
+                    const float error = ComputeError(combined, vertices[b].Position);
+                    if (error < bestCollapses[a].Error) bestCollapses[a] = {a, b, error};
+                }
+                if (!locked[b]) {
+                    const float error = ComputeError(combined, vertices[a].Position);
+                    if (error < bestCollapses[b].Error) bestCollapses[b] = {b, a, error};
+                }
+            }
+        }
+        collapses.clear();
+        for (const auto& collapse : bestCollapses)
+            if (collapse.Error <= maxError) collapses.push_back(collapse);
+        std::ranges::sort(collapses, {}, &BeCollapse::Error);
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), false);
+        const size_t trianglesToRemove = (destination.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        for (const auto& collapse : collapses) {
+            if (collapse.Error > maxError || removed >= trianglesToRemove) break;
+            if (touched[collapse.From] || touched[collapse.To]) continue;
+            const auto around = trianglesAround(collapse.From);
+            if (!PreservesOrientation(collapse.From, collapse.To, destination, around, vertices)) continue;
+
+            for (const uint32_t triangle : around) {
+                bool sharesEdge = false;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    touched[destination[triangle * 3 + corner]] = true;
+                    sharesEdge |= destination[triangle * 3 + corner] == collapse.To;
+                }
+                removed += sharesEdge;
+            }
+            remap[collapse.From] = collapse.To;
+            quadrics[collapse.To] += quadrics[collapse.From];
+            resultError = std::max(resultError, collapse.Error);
+        }
+        if (removed == 0) break;
+
+        size_t write = 0;
+        for (size_t t = 0; t + 2 < destination.size(); t += 3) {
+            const uint32_t a = remap[destination[t + 0]];
+            const uint32_t b = remap[destination[t + 1]];
+            const uint32_t c = remap[destination[t + 2]];
+            if (a == b || b == c || c == a) continue;
+            destination[write++] = a;
+            destination[write++] = b;
+            destination[write++] = c;
+        }
+        destination.resize(write);
+    }
+    return resultError;
+}
+
+auto BeLod::Generate(BeModel& model) -> void {
+    model.Lods.clear();
+    const float maxError = GetModelRadius(model) * MaxRelativeError;
+
+    std::vector<BeModel::BeLodSlice> previous;
+    for (const auto& slice : model.DrawSlices)
+        previous.push_back({.IndexCount = slice.IndexCount, .StartIndexLocation = slice.StartIndexLocation});
+    float previousError = 0.0f;
+    uint32_t previousTriangles = GetTriangleCount(model, 0);
+
+    std::vector<uint32_t> simplified;
+    for (const float ratio : LevelRatios) {
+        const size_t indexCountBefore = model.Indices.size();
+        BeModel::BeLodLevel level {.Error = previousError, .Slices = {}};
+        uint32_t triangles = 0;
+        for (size_t s = 0; s < model.DrawSlices.size(); ++s) {
+            const auto& slice = model.DrawSlices[s];
+            BeModel::BeLodSlice lodSlice = previous[s];
+            const uint32_t target = std::max(uint32_t(float(slice.IndexCount / 3) * ratio), 1u) * 3;
+            if (lodSlice.IndexCount > target) {
+                const auto sliceIndices = std::span(model.Indices).subspan(slice.StartIndexLocation, slice.IndexCount);
+                const std::span<const BeFullVertex> vertices(model.FullVertices.data() + slice.BaseVertexLocation, *std::ranges::max_element(sliceIndices) + 1);
+                const float error = Simplify(
+                    std::span(model.Indices).subspan(lodSlice.StartIndexLocation, lodSlice.IndexCount),
+                    vertices, target, maxError - previousError, simplified);
+                if (simplified.size() < lodSlice.IndexCount) {
+                    lodSlice = {
+                        .IndexCount = static_cast<uint32_t>(simplified.size()),
+                        .StartIndexLocation = static_cast<uint32_t>(model.Indices.size()),
+                    };
+                    model.Indices.insert(model.Indices.end(), simplified.begin(), simplified.end());
+                    BeMeshOptimizer::OptimizeTriangleOrder(std::span(model.Indices).subspan(lodSlice.StartIndexLocation), vertices);
+                    level.Error = std::max(level.Error, previousError + error);
+                }
+            }
+            triangles += lodSlice.IndexCount / 3;
+            level.Slices.push_back(lodSlice);
+        }
+
+        if (float(triangles) > MinimumReduction * float(previousTriangles)) {
+            model.Indices.resize(indexCountBefore);
+            break;
+        }
+        previous = level.Slices;
+        previousError = level.Error;
+        previousTriangles = triangles;
+        model.Lods.push_back(std::move(level));
+    }
+}
+
+auto BeLod::GetTriangleCount(const BeModel& model, const uint32_t level) -> uint32_t {
+    uint32_t triangles = 0;
+    if (level == 0) {
+        for (const auto& slice : model.DrawSlices) triangles += slice.IndexCount / 3;
+    } else {
+        for (const auto& slice : model.Lods[level - 1].Slices) triangles += slice.IndexCount / 3;
+    }
+    return triangles;
+}
+
+auto BeLod::GetError(const BeModel& model, const uint32_t level) -> float {
+    return level == 0 ? 0.0f : model.Lods[level - 1].Error;
+}
+
+auto BeLod::GetPixelsPerUnit(const float verticalFov, const float viewportHeight, const float distance) -> float {
+    return viewportHeight / (2.0f * std::tan(verticalFov * 0.5f) * std::max(distance, 1e-4f));
+}
+
+auto BeLod::SelectLevel(const BeModel& model, const float pixelsPerUnit, const float thresholdPixels, const uint32_t currentLevel) -> uint32_t {
+    const auto levelCount = static_cast<uint32_t>(model.Lods.size()) + 1;
+    uint32_t level = std::min(currentLevel, levelCount - 1);
+    while (level + 1 < levelCount && GetError(model, level + 1) * pixelsPerUnit <= thresholdPixels * (1.0f - Hysteresis))
+        ++level;
+    while (level > 0 && GetError(model, level) * pixelsPerUnit > thresholdPixels * (1.0f + Hysteresis))
+        --level;
+    return level;
+}
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "BeModel.h"
+
+// Level of detail chains: quadric error simplification at import and projected error selection per frame.
+namespace BeLod {
+
+    // triangle count of each generated level relative to the full detail slices
+    constexpr float LevelRatios[] = {0.5f, 0.25f, 0.125f};
+    // simplification stops once its error would pass this fraction of the model's bounding radius
+    constexpr float MaxRelativeError = 0.05f;
+    // a level that keeps more than this share of the previous level's triangles is not worth switching to
+    constexpr float MinimumReduction = 0.85f;
+    // a level is only taken once its error is this much under the threshold, and only left this much over it
+    constexpr float Hysteresis = 0.25f;
+
+    // Edge collapse simplification with Garland-Heckbert quadrics, collapsing onto existing vertices so the vertex
+    // buffer is shared between levels. Vertices on UV or normal seams, open borders and non-manifold edges are
+    // locked, so seams and the outline of a material slice never move. Stops at targetIndexCount or before any
+    // collapse that would cost more than maxError. Returns the model space error of the result.
+    auto Simplify(
+        std::span<const uint32_t> indices,
+        std::span<const BeFullVertex> vertices,
+        uint32_t targetIndexCount,
+        float maxError,
+        std::vector<uint32_t>& destination
+    ) -> float;
+
+    // Appends up to std::size(LevelRatios) levels to model.Lods, each simplified from the one before and in vertex
+    // cache order. Slices that cannot shrink further share the previous level's range.
+    auto Generate(BeModel& model) -> void;
+
+    [[nodiscard]] auto GetTriangleCount(const BeModel& model, uint32_t level) -> uint32_t;
+    [[nodiscard]] auto GetError(const BeModel& model, uint32_t level) -> float;
+
+    // Screen pixels covered by one model space unit at the given distance.
+    [[nodiscard]] auto GetPixelsPerUnit(float verticalFov, float viewportHeight, float distance) -> float;
+    // Coarsest level whose error stays under thresholdPixels, moving away from currentLevel only past the hysteresis
+    // band. Level 0 is the full detail DrawSlices, level n is model.Lods[n - 1].
+    [[nodiscard]] auto SelectLevel(const BeModel& model, float pixelsPerUnit, float thresholdPixels, uint32_t currentLevel) -> uint32_t;
+}
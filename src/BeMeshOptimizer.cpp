@@ -0,0 +1,470 @@
+﻿#include "BeMeshOptimizer.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace {
+    constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+    // clusters whose running ACMR is within this factor of their whole cluster's ACMR may be split off
+    constexpr float SoftBoundaryThreshold = 1.05f;
+    constexpr uint32_t OverdrawGridSize = 256;
+    constexpr uint32_t FetchLineSize = 64;
+    constexpr uint32_t FetchCacheLines = 64;
+
+    // FIFO cache emulated with timestamps: a vertex is resident while fewer than `capacity` misses happened since
+    // it was loaded. Advancing the clock by capacity + 1 flushes everything.
+    struct BeFifoCache {
+        std::vector<uint32_t> LoadTime;
+        uint32_t Clock;
+        uint32_t Capacity;
+
+        BeFifoCache(const size_t entries, const uint32_t capacity) : LoadTime(entries, 0), Clock(capacity + 1), Capacity(capacity) {}
+
+        [[nodiscard]] auto Contains(const uint32_t entry) const -> bool { return Clock - LoadTime[entry] <= Capacity; }
+        // returns whether it was a miss
+        auto Touch(const uint32_t entry) -> bool {
+            if (Contains(entry)) return false;
+            LoadTime[entry] = Clock++;
+            return true;
+        }
+        auto Flush() -> void { Clock += Capacity + 1; }
+    };
+
+    struct BeCacheCounts {
+        uint64_t Misses = 0;
+        uint64_t ReferencedVertices = 0;
+    };
+
+    struct BeFetchCounts {
+        uint64_t FetchedBytes = 0;
+        uint64_t ReferencedBytes = 0;
+    };
+
+    struct BeSliceRange {
+        uint32_t VertexCount = 0;
+        bool Exclusive = false; // no other slice draws from these vertices, so they may be renumbered
+    };
+
+    auto SimulateVertexCache(const std::span<const uint32_t> indices, const uint32_t vertexCount) -> BeCacheCounts {
+        BeFifoCache cache(vertexCount, BeMeshOptimizer::CacheSize);
+        std::vector<bool> referenced(vertexCount, false);
+        BeCacheCounts counts;
+        for (const uint32_t index : indices) {
+            counts.Misses += cache.Touch(index);
+            if (!referenced[index]) {
+                referenced[index] = true;
+                ++counts.ReferencedVertices;
+            }
+        }
+        return counts;
+    }
+
+    auto SimulateVertexFetch(const std::span<const uint32_t> indices, const uint32_t vertexCount, const uint32_t vertexStride) -> BeFetchCounts {
+        const size_t lineCount = (size_t(vertexCount) * vertexStride + FetchLineSize - 1) / FetchLineSize;
+        BeFifoCache cache(lineCount, FetchCacheLines);
+        std::vector<bool> referenced(vertexCount, false);
+        BeFetchCounts counts;
+        for (const uint32_t index : indices) {
+            const size_t firstLine = size_t(index) * vertexStride / FetchLineSize;
+            const size_t lastLine = (size_t(index) * vertexStride + vertexStride - 1) / FetchLineSize;
+            for (size_t line = firstLine; line <= lastLine; ++line)
+                if (cache.Touch(static_cast<uint32_t>(line))) counts.FetchedBytes += FetchLineSize;
+            if (!referenced[index]) {
+                referenced[index] = true;
+                counts.ReferencedBytes += vertexStride;
+            }
+        }
+        return counts;
+    }
+
+    // Vertex counts follow from the slice bases: ImportScene and the model cache lay every mesh's vertices out
+    // contiguously, so a slice owns everything up to the next larger base. Indices reaching past that mean the
+    // slices overlap and the range is widened and marked shared.
+    auto GetSliceRanges(const BeModel& model) -> std::vector<BeSliceRange> {
+        const auto totalVertices = static_cast<uint32_t>(model.FullVertices.size());
+        std::vector<BeSliceRange> ranges(model.DrawSlices.size());
+        for (size_t i = 0; i < model.DrawSlices.size(); ++i) {
+            const auto& slice = model.DrawSlices[i];
+            const auto base = static_cast<uint32_t>(slice.BaseVertexLocation);
+            uint32_t end = totalVertices;
+            bool exclusive = true;
+            for (size_t j = 0; j < model.DrawSlices.size(); ++j) {
+                if (j == i) continue;
+                const auto otherBase = static_cast<uint32_t>(model.DrawSlices[j].BaseVertexLocation);
+                if (otherBase == base) exclusive = false;
+                else if (otherBase > base) end = std::min(end, otherBase);
+            }
+
+            uint32_t maxIndex = 0;
+            for (uint32_t k = 0; k < slice.IndexCount; ++k)
+                maxIndex = std::max(maxIndex, model.Indices[slice.StartIndexLocation + k]);
+            if (slice.IndexCount > 0 && base + maxIndex >= end) {
+                exclusive = false;
+                end = std::min(totalVertices, base + maxIndex + 1);
+            }
+            ranges[i] = {.VertexCount = end - base, .Exclusive = exclusive};
+        }
+        return ranges;
+    }
+
+    // Tipsify (Sander, Nehab, Barczak 2007). Fans out of the most recently used vertex that still has triangles left,
+    // preferring ones that will still be in the cache when reached. Writes the new triangle order and the triangle
+    // positions where it had to jump to a dead end, those start the hard clusters.
+    auto Tipsify(
+        const std::span<const uint32_t> indices,
+        const uint32_t vertexCount,
+        std::vector<uint32_t>& destination,
+        std::vector<uint32_t>& clusters)
+    -> void {
+        const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        // triangles around each vertex
+        std::vector<uint32_t> liveTriangles(vertexCount, 0);
+        for (const uint32_t index : indices) ++liveTriangles[index];
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < indices.size(); ++i)
+                adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        uint32_t clock = BeMeshOptimizer::CacheSize + 1;
+        uint32_t scanCursor = 0;
+
+        destination.clear();
+        destination.reserve(indices.size());
+        clusters.assign(1, 0);
+
+        uint32_t fanVertex = 0;
+        while (fanVertex != InvalidIndex) {
+            candidates.clear();
+            for (uint32_t a = adjacencyOffsets[fanVertex]; a < adjacencyOffsets[fanVertex + 1]; ++a) {
+                const uint32_t triangle = adjacency[a];
+                if (emitted[triangle]) continue;
+                emitted[triangle] = true;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    const uint32_t vertex = indices[triangle * 3 + corner];
+                    destination.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --liveTriangles[vertex];
+                    if (clock - cacheTime[vertex] > BeMeshOptimizer::CacheSize)
+                        cacheTime[vertex] = clock++;
+                }
+            }
+
+            // best candidate that is still in the cache after its remaining triangles were emitted, oldest first
+            uint32_t next = InvalidIndex;
+            int32_t bestPriority = -1;
+            for (const uint32_t vertex : candidates) {
+                if (liveTriangles[vertex] == 0) continue;
+                int32_t priority = 0;
+                if (clock - cacheTime[vertex] + 2 * liveTriangles[vertex] <= BeMeshOptimizer::CacheSize)
+                    priority = int32_t(clock - cacheTime[vertex]);
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    next = vertex;
+                }
+            }
+
+            if (next == InvalidIndex) {
+                while (!deadEnds.empty() && next == InvalidIndex) {
+                    const uint32_t vertex = deadEnds.back();
+                    deadEnds.pop_back();
+                    if (liveTriangles[vertex] > 0) next = vertex;
+                }
+                while (next == InvalidIndex && scanCursor < vertexCount) {
+                    if (liveTriangles[scanCursor] > 0) next = scanCursor;
+                    ++scanCursor;
+                }
+                if (next != InvalidIndex)
+                    clusters.push_back(static_cast<uint32_t>(destination.size() / 3));
+            }
+            fanVertex = next;
+        }
+    }
+
+    // Splits hard clusters further wherever the running ACMR is already about as good as the whole cluster's, so
+    // the overdraw sort has finer pieces to move without costing much vertex reuse.
+    auto SplitSoftBoundaries(const std::span<const uint32_t> indices, const uint32_t vertexCount, const std::vector<uint32_t>& hardClusters) -> std::vector<uint32_t> {
+        const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        BeFifoCache cache(vertexCount, BeMeshOptimizer::CacheSize);
+        std::vector<uint32_t> clusters;
+
+        for (size_t c = 0; c < hardClusters.size(); ++c) {
+            const uint32_t begin = hardClusters[c];
+            const uint32_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+            if (begin == end) continue;
+
+            cache.Flush();
+            uint32_t clusterMisses = 0;
+            for (uint32_t t = begin; t < end; ++t)
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    clusterMisses += cache.Touch(indices[t * 3 + corner]);
+            const float threshold = SoftBoundaryThreshold * float(clusterMisses) / float(end - begin);
+
+            cache.Flush();
+            clusters.push_back(begin);
+            uint32_t misses = 0;
+            uint32_t triangles = 0;
+            for (uint32_t t = begin; t < end; ++t) {
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    misses += cache.Touch(indices[t * 3 + corner]);
+                ++triangles;
+                if (t + 1 < end && float(misses) / float(triangles) <= threshold) {
+                    clusters.push_back(t + 1);
+                    cache.Flush();
+                    misses = 0;
+                    triangles = 0;
+                }
+            }
+        }
+        return clusters;
+    }
+
+    // View independent overdraw order after Sander et al: clusters facing away from the mesh centre are the likely
+    // occluders from any direction that sees them, so they are drawn first.
+    auto SortClustersForOverdraw(
+        const std::span<const uint32_t> indices,
+        const std::span<const BeFullVertex> vertices,
+        const std::vector<uint32_t>& clusters,
+        std::vector<uint32_t>& destination)
+    -> void {
+        const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        struct BeCluster {
+            uint32_t Begin;
+            uint32_t End;
+            glm::vec3 Centroid;
+            glm::vec3 Normal;
+            float Area;
+            float SortKey;
+        };
+        std::vector<BeCluster> sorted;
+        sorted.reserve(clusters.size());
+
+        glm::vec3 meshCentroid {0.0f};
+        float meshArea = 0.0f;
+        for (size_t c = 0; c < clusters.size(); ++c) {
+            BeCluster cluster {
+                .Begin = clusters[c],
+                .End = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount,
+                .Centroid = glm::vec3(0.0f),
+                .Normal = glm::vec3(0.0f),
+                .Area = 0.0f,
+                .SortKey = 0.0f,
+            };
+            for (uint32_t t = cluster.Begin; t < cluster.End; ++t) {
+                const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+                const float area = glm::length(normal);
+                cluster.Normal += normal;
+                cluster.Centroid += (p0 + p1 + p2) * (area / 3.0f);
+                cluster.Area += area;
+            }
+            meshCentroid += cluster.Centroid;
+            meshArea += cluster.Area;
+            if (cluster.Area > 0.0f) cluster.Centroid /= cluster.Area;
+            sorted.push_back(cluster);
+        }
+        if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+        for (auto& cluster : sorted) {
+            const float normalLength = glm::length(cluster.Normal);
+            if (normalLength > 0.0f)
+                cluster.SortKey = glm::dot(cluster.Centroid - meshCentroid, cluster.Normal / normalLength);
+        }
+        std::ranges::stable_sort(sorted, std::ranges::greater {}, &BeCluster::SortKey);
+
+        destination.clear();
+        destination.reserve(indices.size());
+        for (const auto& cluster : sorted)
+            destination.insert(destination.end(), indices.begin() + cluster.Begin * 3, indices.begin() + cluster.End * 3);
+    }
+
+    // Renumbers vertices in the order the index stream first touches them, unreferenced ones keep their relative
+    // order at the end.
+    auto RemapVertexFetch(const std::span<uint32_t> indices, const std::span<BeFullVertex> vertices) -> void {
+        std::vector<uint32_t> remap(vertices.size(), InvalidIndex);
+        uint32_t nextVertex = 0;
+        for (const uint32_t index : indices)
+            if (remap[index] == InvalidIndex) remap[index] = nextVertex++;
+        for (auto& target : remap)
+            if (target == InvalidIndex) target = nextVertex++;
+
+        const std::vector<BeFullVertex> source(vertices.begin(), vertices.end());
+        for (size_t v = 0; v < source.size(); ++v)
+            vertices[remap[v]] = source[v];
+        for (auto& index : indices)
+            index = remap[index];
+    }
+
+    auto OrderTriangles(const std::span<uint32_t> indices, const std::span<const BeFullVertex> vertices) -> void {
+        const auto vertexCount = static_cast<uint32_t>(vertices.size());
+        std::vector<uint32_t> cacheOrdered;
+        std::vector<uint32_t> hardClusters;
+        Tipsify(indices, vertexCount, cacheOrdered, hardClusters);
+        const auto clusters = SplitSoftBoundaries(cacheOrdered, vertexCount, hardClusters);
+
+        std::vector<uint32_t> overdrawOrdered;
+        SortClustersForOverdraw(cacheOrdered, vertices, clusters, overdrawOrdered);
+        std::ranges::copy(overdrawOrdered, indices.begin());
+    }
+}
+
+auto BeMeshOptimizer::Optimize(BeModel& model) -> void {
+    const auto ranges = GetSliceRanges(model);
+    for (size_t i = 0; i < model.DrawSlices.size(); ++i) {
+        const auto& slice = model.DrawSlices[i];
+        if (slice.IndexCount < 3) continue;
+        const std::span indices(model.Indices.data() + slice.StartIndexLocation, slice.IndexCount);
+        const std::span vertices(model.FullVertices.data() + slice.BaseVertexLocation, ranges[i].VertexCount);
+        if (ranges[i].Exclusive)
+            OptimizeSlice(indices, vertices);
+        else
+            OrderTriangles(indices, vertices);
+    }
+}
+
+auto BeMeshOptimizer::OptimizeSlice(const std::span<uint32_t> indices, const std::span<BeFullVertex> vertices) -> void {
+    if (indices.size() < 3) return;
+    OrderTriangles(indices, vertices);
+    RemapVertexFetch(indices, vertices);
+}
+
+auto BeMeshOptimizer::OptimizeTriangleOrder(const std::span<uint32_t> indices, const std::span<const BeFullVertex> vertices) -> void {
+    if (indices.size() < 3) return;
+    OrderTriangles(indices, vertices);
+}
+
+auto BeMeshOptimizer::AnalyzeVertexCache(const std::span<const uint32_t> indices, const uint32_t vertexCount) -> BeMetrics {
+    const auto counts = SimulateVertexCache(indices, vertexCount);
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    return {
+        .ACMR = triangleCount ? float(counts.Misses) / float(triangleCount) : 0.0f,
+        .ATVR = counts.ReferencedVertices ? float(counts.Misses) / float(counts.ReferencedVertices) : 0.0f,
+        .TriangleCount = triangleCount,
+    };
+}
+
+auto BeMeshOptimizer::AnalyzeOverdraw(const std::span<const uint32_t> indices, const std::span<const BeFullVertex> vertices) -> float {
+    if (indices.size() < 3) return 0.0f;
+    glm::vec3 minimum {std::numeric_limits<float>::max()};
+    glm::vec3 maximum {std::numeric_limits<float>::lowest()};
+    for (const uint32_t index : indices) {
+        minimum = glm::min(minimum, vertices[index].Position);
+        maximum = glm::max(maximum, vertices[index].Position);
+    }
+    const glm::vec3 extent = glm::max(maximum - minimum, glm::vec3(1e-6f));
+
+    // orthographic views down +-X, +-Y and +-Z, both faces rasterised with a less depth test
+    uint64_t shaded = 0;
+    uint64_t covered = 0;
+    std::vector<float> depthBuffer(OverdrawGridSize * OverdrawGridSize);
+    for (uint32_t view = 0; view < 6; ++view) {
+        const uint32_t axis = view / 2;
+        const float direction = view % 2 ? -1.0f : 1.0f;
+        const uint32_t axisU = (axis + 1) % 3;
+        const uint32_t axisV = (axis + 2) % 3;
+        std::ranges::fill(depthBuffer, std::numeric_limits<float>::max());
+
+        auto project = [&](const glm::vec3& position) {
+            const glm::vec3 normalized = (position - minimum) / extent;
+            return glm::vec3(normalized[axisU] * OverdrawGridSize, normalized[axisV] * OverdrawGridSize, normalized[axis] * direction);
+        };
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3 a = project(vertices[indices[t + 0]].Position);
+            glm::vec3 b = project(vertices[indices[t + 1]].Position);
+            glm::vec3 c = project(vertices[indices[t + 2]].Position);
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.0f) continue;
+            if (area < 0.0f) {
+                std::swap(b, c);
+                area = -area;
+            }
+
+            const auto minX = static_cast<uint32_t>(std::max(0.0f, std::floor(std::min({a.x, b.x, c.x}))));
+            const auto minY = static_cast<uint32_t>(std::max(0.0f, std::floor(std::min({a.y, b.y, c.y}))));
+            const auto maxX = std::min(OverdrawGridSize - 1, static_cast<uint32_t>(std::max({a.x, b.x, c.x})));
+            const auto maxY = std::min(OverdrawGridSize - 1, static_cast<uint32_t>(std::max({a.y, b.y, c.y})));
+            for (uint32_t y = minY; y <= maxY; ++y) {
+                for (uint32_t x = minX; x <= maxX; ++x) {
+                    const float px = float(x) + 0.5f;
+                    const float py = float(y) + 0.5f;
+                    const float w0 = (c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x);
+                    const float w1 = (a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x);
+                    const float w2 = (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                    const float depth = (w0 * a.z + w1 * b.z + w2 * c.z) / area;
+                    float& stored = depthBuffer[y * OverdrawGridSize + x];
+                    if (depth < stored) {
+                        covered += stored == std::numeric_limits<float>::max();
+                        stored = depth;
+                        ++shaded;
+                    }
+                }
+            }
+        }
+    }
+    return covered ? float(shaded) / float(covered) : 0.0f;
+}
+
+auto BeMeshOptimizer::AnalyzeVertexFetch(const std::span<const uint32_t> indices, const uint32_t vertexCount, const uint32_t vertexStride) -> float {
+    const auto counts = SimulateVertexFetch(indices, vertexCount, vertexStride);
+    return counts.ReferencedBytes ? float(counts.FetchedBytes) / float(counts.ReferencedBytes) : 0.0f;
+}
+
+auto BeMeshOptimizer::Analyze(const BeModel& model, const bool full, const uint32_t vertexStride) -> BeMetrics {
+    const auto ranges = GetSliceRanges(model);
+    BeCacheCounts cacheTotals;
+    BeFetchCounts fetchTotals;
+    double weightedOverdraw = 0.0;
+    uint64_t triangleCount = 0;
+
+    for (size_t i = 0; i < model.DrawSlices.size(); ++i) {
+        const auto& slice = model.DrawSlices[i];
+        const std::span indices(model.Indices.data() + slice.StartIndexLocation, slice.IndexCount);
+        const std::span vertices(model.FullVertices.data() + slice.BaseVertexLocation, ranges[i].VertexCount);
+        const uint32_t sliceTriangles = slice.IndexCount / 3;
+        triangleCount += sliceTriangles;
+
+        const auto cacheCounts = SimulateVertexCache(indices, ranges[i].VertexCount);
+        cacheTotals.Misses += cacheCounts.Misses;
+        cacheTotals.ReferencedVertices += cacheCounts.ReferencedVertices;
+        if (!full) continue;
+
+        const auto fetchCounts = SimulateVertexFetch(indices, ranges[i].VertexCount, vertexStride);
+        fetchTotals.FetchedBytes += fetchCounts.FetchedBytes;
+        fetchTotals.ReferencedBytes += fetchCounts.ReferencedBytes;
+        weightedOverdraw += double(AnalyzeOverdraw(indices, vertices)) * sliceTriangles;
+    }
+
+    BeMetrics metrics {.TriangleCount = static_cast<uint32_t>(triangleCount)};
+    if (triangleCount) metrics.ACMR = float(double(cacheTotals.Misses) / double(triangleCount));
+    if (cacheTotals.ReferencedVertices) metrics.ATVR = float(double(cacheTotals.Misses) / double(cacheTotals.ReferencedVertices));
+    if (full && triangleCount) metrics.Overdraw = float(weightedOverdraw / double(triangleCount));
+    if (fetchTotals.ReferencedBytes) metrics.Overfetch = float(double(fetchTotals.FetchedBytes) / double(fetchTotals.ReferencedBytes));
+    return metrics;
+}
+
+auto BeMeshOptimizer::PrintComparison(const std::string& name, const BeMetrics& before, const BeMetrics& after, const double milliseconds) -> void {
+    std::cout << std::format("Mesh optimizer {}: {} triangles in {:.2f} ms, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+        name, after.TriangleCount, milliseconds, before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+    if (before.Overdraw > 0.0f)
+        std::cout << std::format(", overdraw {:.3f} -> {:.3f}, overfetch {:.3f} -> {:.3f}",
+            before.Overdraw, after.Overdraw, before.Overfetch, after.Overfetch);
+    std::cout << "\n";
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "BeModel.h"
+
+// Index and vertex reordering for draw slices, plus the CPU simulations to measure it. Slice indices are relative to
+// the slice's BaseVertexLocation, every function here works on that local range.
+namespace BeMeshOptimizer {
+
+    // post transform cache size the optimisation targets and the simulator models
+    constexpr uint32_t CacheSize = 16;
+
+    struct BeMetrics {
+        float ACMR = 0.0f;        // cache misses per triangle, 0.5 is the ideal for a regular grid
+        float ATVR = 0.0f;        // cache misses per referenced vertex, 1.0 is ideal
+        float Overdraw = 0.0f;    // rasterised fragments per covered pixel, averaged over 6 axis views
+        float Overfetch = 0.0f;   // bytes pulled through a 64 byte line cache per referenced vertex byte
+        uint32_t TriangleCount = 0;
+    };
+
+    // Triangle order for the vertex cache (Tipsify), then cluster order against overdraw, then vertices renumbered
+    // in first use order so fetches stay sequential. Slices that share a vertex range keep their vertex order.
+    auto Optimize(BeModel& model) -> void;
+    // indices address vertices[0, vertices.size())
+    auto OptimizeSlice(std::span<uint32_t> indices, std::span<BeFullVertex> vertices) -> void;
+    // Only the triangle order, for index ranges that share their vertices with another range.
+    auto OptimizeTriangleOrder(std::span<uint32_t> indices, std::span<const BeFullVertex> vertices) -> void;
+
+    [[nodiscard]] auto AnalyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount) -> BeMetrics;
+    [[nodiscard]] auto AnalyzeOverdraw(std::span<const uint32_t> indices, std::span<const BeFullVertex> vertices) -> float;
+    [[nodiscard]] auto AnalyzeVertexFetch(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t vertexStride) -> float;
+    // Triangle weighted over all slices. Overdraw and overfetch are only filled in with full set.
+    [[nodiscard]] auto Analyze(const BeModel& model, bool full, uint32_t vertexStride = sizeof(BeFullVertex)) -> BeMetrics;
+
+    auto PrintComparison(const std::string& name, const BeMetrics& before, const BeMetrics& after, double milliseconds) -> void;
+}
@@ -0,0 +1,251 @@
+﻿#include "BeMeshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+#include <gtc/matrix_access.hpp>
+
+namespace {
+    constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+    // normals closer than this to perpendicular to the average leave a cone too wide to be worth testing
+    constexpr float MinimumConeDot = 0.1f;
+
+    // Ritter's sphere, good to within a few percent of the minimal one.
+    auto ComputeBoundingSphere(const std::vector<glm::vec3>& points) -> glm::vec4 {
+        auto farthestFrom = [&](const glm::vec3& origin) {
+            return *std::ranges::max_element(points, {}, [&](const glm::vec3& p) { return glm::dot(p - origin, p - origin); });
+        };
+        const glm::vec3 a = farthestFrom(points[0]);
+        const glm::vec3 b = farthestFrom(a);
+        glm::vec3 center = (a + b) * 0.5f;
+        float radius = glm::length(b - a) * 0.5f;
+        for (const auto& p : points) {
+            const float distance = glm::length(p - center);
+            if (distance <= radius) continue;
+            const float grownRadius = (radius + distance) * 0.5f;
+            center += (p - center) * ((grownRadius - radius) / distance);
+            radius = grownRadius;
+        }
+        return {center, radius};
+    }
+
+    auto ComputeBounds(
+        const std::span<const uint32_t> indices,
+        const std::span<const BeFullVertex> vertices,
+        std::vector<glm::vec3>& points,
+        BeMeshlet& meshlet)
+    -> void {
+        points.clear();
+        for (const uint32_t index : indices) points.push_back(vertices[index].Position);
+        const glm::vec4 sphere = ComputeBoundingSphere(points);
+        meshlet.Center = glm::vec3(sphere);
+        meshlet.Radius = sphere.w;
+
+        // average of the unit triangle normals as the axis, the widest normal gives the cutoff
+        glm::vec3 normalSum {0.0f};
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3& p0 = vertices[indices[t + 0]].Position;
+            const glm::vec3 normal = glm::cross(vertices[indices[t + 1]].Position - p0, vertices[indices[t + 2]].Position - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f) normalSum += normal / length;
+        }
+        meshlet.ConeApex = meshlet.Center;
+        meshlet.ConeAxis = {0.0f, 0.0f, 0.0f};
+        meshlet.ConeCutoff = 1.0f;
+        const float sumLength = glm::length(normalSum);
+        if (sumLength == 0.0f) return;
+        const glm::vec3 axis = normalSum / sumLength;
+
+        float minimumDot = 1.0f;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3& p0 = vertices[indices[t + 0]].Position;
+            const glm::vec3 normal = glm::cross(vertices[indices[t + 1]].Position - p0, vertices[indices[t + 2]].Position - p0);
+            const float length = glm::length(normal);
+            if (length > 0.0f) minimumDot = std::min(minimumDot, glm::dot(axis, normal / length));
+        }
+        if (minimumDot <= MinimumConeDot) return;
+
+        // pull the apex back along the axis until it sits behind every triangle plane
+        float apexDistance = 0.0f;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3& p0 = vertices[indices[t + 0]].Position;
+            const glm::vec3 normal = glm::cross(vertices[indices[t + 1]].Position - p0, vertices[indices[t + 2]].Position - p0);
+            const float length = glm::length(normal);
+            if (length == 0.0f) continue;
+            const glm::vec3 unitNormal = normal / length;
+            apexDistance = std::max(apexDistance, glm::dot(meshlet.Center - p0, unitNormal) / glm::dot(axis, unitNormal));
+        }
+        meshlet.ConeApex = meshlet.Center - axis * apexDistance;
+        meshlet.ConeAxis = axis;
+        meshlet.ConeCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+    }
+
+    // Greedy growth: a meshlet takes the adjacent triangle that adds the fewest new vertices, falling back to the
+    // next unused triangle in the incoming order when nothing adjacent fits. Returns the new slice index order and
+    // appends one meshlet per group, StartIndexLocation relative to the slice.
+    auto BuildSlice(
+        const std::span<const uint32_t> indices,
+        const std::span<const BeFullVertex> vertices,
+        std::vector<uint32_t>& destination,
+        std::vector<BeMeshlet>& meshlets)
+    -> void {
+        const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        const uint32_t vertexCount = indices.empty() ? 0 : *std::ranges::max_element(indices) + 1;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        for (const uint32_t index : indices) ++adjacencyOffsets[index + 1];
+        std::inclusive_scan(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < indices.size(); ++i)
+                adjacency[fill[indices[i]]++] = i / 3;
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> vertexMeshlet(vertexCount, InvalidIndex); // last meshlet that used the vertex
+        std::vector<uint32_t> candidates;
+        std::vector<glm::vec3> points;
+        uint32_t seedCursor = 0;
+
+        destination.clear();
+        destination.reserve(indices.size());
+        while (destination.size() < indices.size()) {
+            const auto meshletIndex = static_cast<uint32_t>(meshlets.size());
+            BeMeshlet meshlet {};
+            meshlet.StartIndexLocation = static_cast<uint32_t>(destination.size());
+            candidates.clear();
+
+            auto newVertices = [&](const uint32_t triangle) {
+                uint32_t count = 0;
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    count += vertexMeshlet[indices[triangle * 3 + corner]] != meshletIndex;
+                return count;
+            };
+            auto add = [&](const uint32_t triangle) {
+                emitted[triangle] = true;
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    const uint32_t vertex = indices[triangle * 3 + corner];
+                    destination.push_back(vertex);
+                    if (vertexMeshlet[vertex] != meshletIndex) {
+                        vertexMeshlet[vertex] = meshletIndex;
+                        ++meshlet.VertexCount;
+                        for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; ++a)
+                            if (!emitted[adjacency[a]]) candidates.push_back(adjacency[a]);
+                    }
+                }
+                ++meshlet.TriangleCount;
+            };
+
+            while (meshlet.TriangleCount < BeMeshlets::MaxTriangles) {
+                uint32_t best = InvalidIndex;
+                uint32_t bestNewVertices = 4;
+                std::erase_if(candidates, [&](const uint32_t triangle) { return emitted[triangle]; });
+                for (const uint32_t triangle : candidates) {
+                    const uint32_t count = newVertices(triangle);
+                    if (count < bestNewVertices || (count == bestNewVertices && triangle < best)) {
+                        best = triangle;
+                        bestNewVertices = count;
+                    }
+                }
+                if (best == InvalidIndex || meshlet.VertexCount + bestNewVertices > BeMeshlets::MaxVertices) {
+                    while (seedCursor < triangleCount && emitted[seedCursor]) ++seedCursor;
+                    if (seedCursor == triangleCount) break;
+                    best = seedCursor;
+                    if (meshlet.VertexCount + newVertices(best) > BeMeshlets::MaxVertices) break;
+                }
+                add(best);
+            }
+
+            ComputeBounds(std::span(destination).subspan(meshlet.StartIndexLocation), vertices, points, meshlet);
+            meshlets.push_back(meshlet);
+        }
+    }
+}
+
+auto BeMeshlets::Build(BeModel& model) -> void {
+    model.Meshlets.clear();
+    std::vector<uint32_t> reordered;
+    // LOD levels share the ranges of slices that could not be simplified further, those keep one set of meshlets
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> builtRanges;
+    auto buildRange = [&](const uint32_t startIndexLocation, const uint32_t indexCount, const int32_t baseVertexLocation) {
+        const auto [built, inserted] = builtRanges.try_emplace(startIndexLocation);
+        if (!inserted) return built->second;
+
+        const std::span indices(model.Indices.data() + startIndexLocation, indexCount);
+        const std::span<const BeFullVertex> vertices(model.FullVertices.data() + baseVertexLocation, model.FullVertices.size() - baseVertexLocation);
+        const auto firstMeshlet = static_cast<uint32_t>(model.Meshlets.size());
+        BuildSlice(indices, vertices, reordered, model.Meshlets);
+        std::ranges::copy(reordered, indices.begin());
+        for (uint32_t m = firstMeshlet; m < model.Meshlets.size(); ++m)
+            model.Meshlets[m].StartIndexLocation += startIndexLocation;
+        built->second = {firstMeshlet, static_cast<uint32_t>(model.Meshlets.size()) - firstMeshlet};
+        return built->second;
+    };
+
+    for (auto& slice : model.DrawSlices)
+        std::tie(slice.FirstMeshlet, slice.MeshletCount) = buildRange(slice.StartIndexLocation, slice.IndexCount, slice.BaseVertexLocation);
+    for (auto& level : model.Lods) {
+        for (size_t s = 0; s < level.Slices.size(); ++s) {
+            auto& slice = level.Slices[s];
+            std::tie(slice.FirstMeshlet, slice.MeshletCount) = buildRange(slice.StartIndexLocation, slice.IndexCount, model.DrawSlices[s].BaseVertexLocation);
+        }
+    }
+}
+
+auto BeMeshlets::MakeCullView(const glm::mat4& projectionView, const glm::mat4& modelMatrix, const glm::vec3& eye) -> BeCullView {
+    // Gribb/Hartmann planes of the combined matrix land in model space. The near plane uses w + z, which is right
+    // for -1..1 depth and slightly conservative for 0..1.
+    const glm::mat4 clip = projectionView * modelMatrix;
+    const glm::vec4 x = glm::row(clip, 0);
+    const glm::vec4 y = glm::row(clip, 1);
+    const glm::vec4 z = glm::row(clip, 2);
+    const glm::vec4 w = glm::row(clip, 3);
+
+    BeCullView view {
+        .Planes = {w + x, w - x, w + y, w - y, w + z, w - z},
+        .Eye = glm::vec3(glm::inverse(modelMatrix) * glm::vec4(eye, 1.0f)),
+    };
+    for (auto& plane : view.Planes)
+        plane /= glm::length(glm::vec3(plane));
+    return view;
+}
+
+auto BeMeshlets::Classify(const BeMeshlet& meshlet, const BeCullView& view) -> BeVisibility {
+    for (const auto& plane : view.Planes)
+        if (glm::dot(glm::vec3(plane), meshlet.Center) + plane.w < -meshlet.Radius)
+            return BeVisibility::OutsideFrustum;
+    // triangle normals follow D3D's clockwise front faces, all of them point away from the eye inside the cone
+    if (meshlet.ConeCutoff < 1.0f) {
+        const glm::vec3 toApex = meshlet.ConeApex - view.Eye;
+        const float distance = glm::length(toApex);
+        if (distance > 0.0f && glm::dot(toApex / distance, meshlet.ConeAxis) >= meshlet.ConeCutoff)
+            return BeVisibility::Backfacing;
+    }
+    return BeVisibility::Visible;
+}
+
+auto BeMeshlets::IsVisible(const BeMeshlet& meshlet, const BeCullView& view) -> bool {
+    return Classify(meshlet, view) == BeVisibility::Visible;
+}
+
+auto BeMeshlets::Cull(const std::span<const BeMeshlet> meshlets, const BeCullView& view, std::vector<BeIndexRange>& ranges) -> uint32_t {
+    uint32_t culledTriangles = 0;
+    bool extendLast = false;
+    for (const auto& meshlet : meshlets) {
+        if (!IsVisible(meshlet, view)) {
+            culledTriangles += meshlet.TriangleCount;
+            extendLast = false;
+            continue;
+        }
+        if (extendLast)
+            ranges.back().IndexCount += meshlet.TriangleCount * 3;
+        else
+            ranges.push_back({meshlet.StartIndexLocation, meshlet.TriangleCount * 3});
+        extendLast = true;
+    }
+    return culledTriangles;
+}
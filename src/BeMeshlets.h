@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm.hpp>
+
+#include "BeModel.h"
+
+// Splits draw slices into meshlets with culling bounds and culls them on the CPU into index ranges.
+namespace BeMeshlets {
+
+    constexpr uint32_t MaxVertices = 64;
+    constexpr uint32_t MaxTriangles = 124;
+
+    // Everything the per meshlet test needs, in the model space of one object.
+    struct BeCullView {
+        std::array<glm::vec4, 6> Planes;   // normalised, inside where dot(xyz, p) + w >= 0
+        glm::vec3 Eye;
+    };
+
+    struct BeIndexRange {
+        uint32_t StartIndexLocation;
+        uint32_t IndexCount;
+    };
+
+    enum class BeVisibility : uint8_t {
+        Visible,
+        OutsideFrustum,
+        Backfacing,
+    };
+
+    // Regroups the triangles of every slice and LOD slice into meshlets, rewriting their index ranges in meshlet
+    // order, and fills model.Meshlets plus the FirstMeshlet/MeshletCount of each. Run after BeMeshOptimizer and
+    // BeLod, meshlets are grown in the optimised triangle order.
+    auto Build(BeModel& model) -> void;
+
+    [[nodiscard]] auto MakeCullView(const glm::mat4& projectionView, const glm::mat4& modelMatrix, const glm::vec3& eye) -> BeCullView;
+    // Conservative: a meshlet is only outside when its sphere is, and only backfacing when every triangle is.
+    [[nodiscard]] auto Classify(const BeMeshlet& meshlet, const BeCullView& view) -> BeVisibility;
+    [[nodiscard]] auto IsVisible(const BeMeshlet& meshlet, const BeCullView& view) -> bool;
+    // Appends the index ranges of the visible meshlets, merged where they touch. Returns the culled triangle count.
+    auto Cull(std::span<const BeMeshlet> meshlets, const BeCullView& view, std::vector<BeIndexRange>& ranges) -> uint32_t;
+}
@@ -0,0 +1,129 @@
+﻿#include "BeMipChain.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "BePixelKernels.h"
+#include "BeThreadPool.h"
+
+namespace {
+    // splits the rows of a level into bands of about 64K pixels, coarse enough to be worth a pool job
+    auto ForEachBand(
+        const uint32_t width,
+        const uint32_t height,
+        const bool parallel,
+        const std::function<void(uint32_t rowBegin, uint32_t rowEnd)>& body)
+    -> void {
+        const uint32_t bandRows = std::max(1u, 65536u / std::max(1u, width));
+        const uint32_t bandCount = (height + bandRows - 1) / bandRows;
+        auto runBand = [&](const uint32_t band) {
+            body(band * bandRows, std::min(height, (band + 1) * bandRows));
+        };
+        if (parallel)
+            BeThreadPool::Shared().ParallelFor(bandCount, runBand);
+        else
+            for (uint32_t band = 0; band < bandCount; ++band) runBand(band);
+    }
+
+    auto BuildAlphaHistogram(const uint16_t* pixels, const size_t pixelCount, std::vector<uint32_t>& histogram) -> void {
+        histogram.assign(4096, 0);
+        for (size_t i = 0; i < pixelCount; ++i)
+            ++histogram[pixels[4 * i + 3]];
+    }
+
+    // fraction of pixels whose alpha, scaled and rounded like EncodeFromLinear12 does, reaches the threshold
+    auto ComputeCoverage(const std::vector<uint32_t>& histogram, const uint32_t threshold, const float scale, const size_t pixelCount) -> double {
+        uint64_t covered = 0;
+        for (uint32_t alpha = 0; alpha < 4096; ++alpha)
+            if (float(alpha) * scale + 0.5f >= float(threshold)) covered += histogram[alpha];
+        return double(covered) / double(pixelCount);
+    }
+
+    // coverage only grows with the scale, so a bisection brackets the target. Blurred levels often hold only a few
+    // distinct alpha values and coverage moves in steps, so the closer side of the step wins.
+    auto FindAlphaScale(const std::vector<uint32_t>& histogram, const uint32_t threshold, const double targetCoverage, const size_t pixelCount) -> float {
+        float low = 0.0f;
+        float high = 4.0f;
+        for (int i = 0; i < 16; ++i) {
+            const float middle = 0.5f * (low + high);
+            if (ComputeCoverage(histogram, threshold, middle, pixelCount) < targetCoverage)
+                low = middle;
+            else
+                high = middle;
+        }
+        const double lowError = targetCoverage - ComputeCoverage(histogram, threshold, low, pixelCount);
+        const double highError = ComputeCoverage(histogram, threshold, high, pixelCount) - targetCoverage;
+        return lowError < highError ? low : high;
+    }
+}
+
+auto BeMipChain::Layout(const uint32_t width, const uint32_t height) -> std::vector<BeMipLevel> {
+    std::vector<BeMipLevel> levels;
+    size_t offset = 0;
+    for (uint32_t w = std::max(1u, width), h = std::max(1u, height);; w = std::max(1u, w / 2), h = std::max(1u, h / 2)) {
+        levels.push_back({.Width = w, .Height = h, .Offset = offset});
+        offset += size_t(w) * h * 4;
+        if (w == 1 && h == 1) break;
+    }
+    return levels;
+}
+
+auto BeMipChain::GetSizeInBytes(const std::vector<BeMipLevel>& levels) -> size_t {
+    if (levels.empty()) return 0;
+    return levels.back().Offset + size_t(levels.back().Width) * levels.back().Height * 4;
+}
+
+auto BeMipChain::Generate(uint8_t* pixels, const std::vector<BeMipLevel>& levels, const BeMipSettings& settings) -> void {
+    if (levels.size() < 2) return;
+    const uint32_t width = levels[0].Width;
+    const uint32_t height = levels[0].Height;
+
+    // every level is filtered from the 12 bit linear version of the previous one, not from its 8 bit encoding
+    std::vector<uint16_t> current(size_t(width) * height * 4);
+    std::vector<uint16_t> next;
+    ForEachBand(width, height, settings.Parallel, [&](const uint32_t rowBegin, const uint32_t rowEnd) {
+        const size_t first = size_t(rowBegin) * width;
+        BePixelKernels::DecodeToLinear12(pixels + 4 * first, current.data() + 4 * first, size_t(rowEnd - rowBegin) * width, settings.SRGB);
+    });
+
+    const bool preserveCoverage = settings.AlphaCutoff >= 0.0f;
+    uint32_t threshold = 0;
+    double targetCoverage = 0.0;
+    std::vector<uint32_t> histogram;
+    if (preserveCoverage) {
+        while (threshold < 4096 && float(BePixelKernels::Linear12ToUnorm8(static_cast<uint16_t>(threshold))) / 255.0f < settings.AlphaCutoff)
+            ++threshold;
+        BuildAlphaHistogram(current.data(), size_t(width) * height, histogram);
+        targetCoverage = ComputeCoverage(histogram, threshold, 1.0f, size_t(width) * height);
+    }
+
+    for (size_t level = 1; level < levels.size(); ++level) {
+        const BeMipLevel& source = levels[level - 1];
+        const BeMipLevel& target = levels[level];
+        const size_t pixelCount = size_t(target.Width) * target.Height;
+        next.resize(pixelCount * 4);
+        ForEachBand(target.Width, target.Height, settings.Parallel, [&](const uint32_t rowBegin, const uint32_t rowEnd) {
+            BePixelKernels::Downsample2x2(current.data(), source.Width, source.Height, next.data(), rowBegin, rowEnd);
+        });
+
+        // averaging pulls alpha towards the cutoff, so alpha tested cutouts would thin out or grow with distance.
+        // Scale alpha so the same fraction of texels passes the test as in level 0.
+        float alphaScale = 1.0f;
+        if (preserveCoverage) {
+            BuildAlphaHistogram(next.data(), pixelCount, histogram);
+            alphaScale = FindAlphaScale(histogram, threshold, targetCoverage, pixelCount);
+        }
+
+        uint8_t* targetPixels = pixels + target.Offset;
+        ForEachBand(target.Width, target.Height, settings.Parallel, [&](const uint32_t rowBegin, const uint32_t rowEnd) {
+            const size_t first = size_t(rowBegin) * target.Width;
+            BePixelKernels::EncodeFromLinear12(
+                next.data() + 4 * first,
+                targetPixels + 4 * first,
+                size_t(rowEnd - rowBegin) * target.Width,
+                settings.SRGB,
+                alphaScale);
+        });
+        std::swap(current, next);
+    }
+}
@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct BeMipSettings {
+    bool SRGB = true;            // filter the colour channels in linear light
+    float AlphaCutoff = -1.0f;   // alpha test threshold whose coverage every level keeps, negative to disable
+    bool Parallel = true;        // split each level into row bands across the shared thread pool
+};
+
+struct BeMipLevel {
+    uint32_t Width;
+    uint32_t Height;
+    size_t Offset;   // bytes from the start of the chain
+};
+
+// CPU mip chain generation for RGBA8 pixels. BeTexture owns the allocation, this only lays it out and fills it.
+namespace BeMipChain {
+
+    // Every level of a width x height texture down to 1x1, level 0 included, packed one after the other.
+    [[nodiscard]] auto Layout(uint32_t width, uint32_t height) -> std::vector<BeMipLevel>;
+    [[nodiscard]] auto GetSizeInBytes(const std::vector<BeMipLevel>& levels) -> size_t;
+
+    // Box filters levels 1.. of a chain laid out by Layout from level 0 at the start of pixels.
+    auto Generate(uint8_t* pixels, const std::vector<BeMipLevel>& levels, const BeMipSettings& settings = {}) -> void;
+}
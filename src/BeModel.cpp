@@ -1 +1,63 @@
 #include "BeModel.h"
+
+#include <algorithm>
+#include <limits>
+#include <span>
+
+namespace {
+    auto MakeBounds(const glm::vec3& minimum, const glm::vec3& maximum) -> BeBounds {
+        return {.Min = minimum, .Max = maximum, .Center = (minimum + maximum) * 0.5f, .Radius = 0.0f};
+    }
+}
+
+auto BeModel::ComputeBounds() -> void {
+    for (auto& slice : DrawSlices) {
+        const auto indices = std::span(Indices).subspan(slice.StartIndexLocation, slice.IndexCount);
+        glm::vec3 minimum {std::numeric_limits<float>::max()};
+        glm::vec3 maximum {std::numeric_limits<float>::lowest()};
+        for (const uint32_t index : indices) {
+            const glm::vec3& position = FullVertices[slice.BaseVertexLocation + index].Position;
+            minimum = glm::min(minimum, position);
+            maximum = glm::max(maximum, position);
+        }
+        if (indices.empty()) continue;
+
+        slice.Bounds = MakeBounds(minimum, maximum);
+        for (const uint32_t index : indices)
+            slice.Bounds.Radius = std::max(slice.Bounds.Radius, glm::length(FullVertices[slice.BaseVertexLocation + index].Position - slice.Bounds.Center));
+    }
+
+    // a slice counts once for every node placing it
+    const std::vector<glm::mat4> nodeWorlds = GetNodeWorlds();
+    auto forEachPlacedPosition = [&](auto&& visit) {
+        for (size_t n = 0; n < Nodes.size(); ++n) {
+            for (const uint32_t s : std::span(NodeMeshes).subspan(Nodes[n].FirstMesh, Nodes[n].MeshCount)) {
+                const auto& slice = DrawSlices[s];
+                for (const uint32_t index : std::span(Indices).subspan(slice.StartIndexLocation, slice.IndexCount))
+                    visit(glm::vec3(nodeWorlds[n] * glm::vec4(FullVertices[slice.BaseVertexLocation + index].Position, 1.0f)));
+            }
+        }
+    };
+    glm::vec3 modelMinimum {std::numeric_limits<float>::max()};
+    glm::vec3 modelMaximum {std::numeric_limits<float>::lowest()};
+    forEachPlacedPosition([&](const glm::vec3& position) {
+        modelMinimum = glm::min(modelMinimum, position);
+        modelMaximum = glm::max(modelMaximum, position);
+    });
+    if (modelMinimum.x > modelMaximum.x) {
+        Bounds = {};
+        return;
+    }
+
+    Bounds = MakeBounds(modelMinimum, modelMaximum);
+    forEachPlacedPosition([&](const glm::vec3& position) {
+        Bounds.Radius = std::max(Bounds.Radius, glm::length(position - Bounds.Center));
+    });
+}
+
+auto BeModel::GetNodeWorlds() const -> std::vector<glm::mat4> {
+    std::vector<glm::mat4> worlds(Nodes.size());
+    for (size_t i = 0; i < Nodes.size(); ++i)
+        worlds[i] = Nodes[i].Parent == NoParent ? Nodes[i].Transform : worlds[Nodes[i].Parent] * Nodes[i].Transform;
+    return worlds;
+}
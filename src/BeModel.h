@@ -1,7 +1,8 @@
-#pragma once
-#include <filesystem>
+﻿#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
 #include <glm.hpp>
-#include <assimp/scene.h>
 
 class BeTexture;
 
@@ -25,6 +26,29 @@ struct BeMaterial {
     float SuperShininess = -1.f; 
 };
 
+// Up to 64 vertices and 124 triangles of one draw slice, stored contiguously in the model's index buffer so a
+// visible meshlet is a plain index range.
+struct BeMeshlet {
+    glm::vec3 Center;           // bounding sphere, model space
+    float Radius;
+    glm::vec3 ConeApex;         // every triangle faces away when dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff
+    float ConeCutoff;           // 1 when the normals spread too wide to ever cull
+    glm::vec3 ConeAxis;
+    uint32_t StartIndexLocation;
+    uint32_t TriangleCount;
+    uint32_t VertexCount;
+};
+
+// Axis aligned box plus a sphere around its centre, model space.
+struct BeBounds {
+    glm::vec3 Min {0.0f};
+    glm::vec3 Max {0.0f};
+    glm::vec3 Center {0.0f};
+    float Radius = 0.0f;   // farthest vertex from Center, tighter than half the diagonal
+
+    [[nodiscard]] auto GetExtent() const -> glm::vec3 { return (Max - Min) * 0.5f; }
+};
+
 struct BeModel {
     
     struct BeDrawSlice {
@@ -32,6 +56,32 @@ struct BeModel {
         uint32_t StartIndexLocation;
         int32_t BaseVertexLocation;
         BeMaterial Material;
+        uint32_t FirstMeshlet = 0;
+        uint32_t MeshletCount = 0;
+        BeBounds Bounds;   // of the full detail triangles, LOD slices never reach outside them
+    };
+
+    // Simplified index range of one draw slice, drawn with that slice's vertices and material.
+    struct BeLodSlice {
+        uint32_t IndexCount;
+        uint32_t StartIndexLocation;
+        uint32_t FirstMeshlet = 0;
+        uint32_t MeshletCount = 0;
+    };
+
+    struct BeLodLevel {
+        float Error;                        // model space, how far the simplified surface may stray from the full one
+        std::vector<BeLodSlice> Slices;     // parallel to DrawSlices
+    };
+
+    static constexpr uint32_t NoParent = UINT32_MAX;
+
+    // Where the slices sit in the model, as the file arranged them. Parents come before their children.
+    struct BeNode {
+        glm::mat4 Transform {1.0f};   // relative to the parent
+        uint32_t Parent = NoParent;
+        uint32_t FirstMesh = 0;       // into NodeMeshes
+        uint32_t MeshCount = 0;
     };
 
     BeModel() = default;
@@ -40,4 +90,19 @@ struct BeModel {
     std::vector<BeDrawSlice> DrawSlices;
     std::vector<BeFullVertex> FullVertices;
     std::vector<uint32_t> Indices;
+    std::vector<BeMeshlet> Meshlets;
+    std::vector<BeLodLevel> Lods;           // coarser levels after the full detail DrawSlices, finest first
+    std::vector<BeNode> Nodes;
+    // DrawSlices index of every mesh a node places; a slice several nodes place is still stored and drawn from once
+    std::vector<uint32_t> NodeMeshes;
+    BeBounds Bounds;                        // of every slice where its nodes place it
+    // welded and simplified stand-in for software occlusion, model space, empty when the model occludes nothing
+    std::vector<glm::vec3> OccluderVertices;
+    std::vector<uint32_t> OccluderIndices;
+
+    // Fills the Bounds of every draw slice from the vertices their indices reference, in the slice's own space, and
+    // Bounds from the same vertices placed by the nodes.
+    auto ComputeBounds() -> void;
+    // Transform of every node into model space, parallel to Nodes.
+    [[nodiscard]] auto GetNodeWorlds() const -> std::vector<glm::mat4>;
 };
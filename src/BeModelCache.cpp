@@ -0,0 +1,422 @@
+﻿#include "BeModelCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace {
+    constexpr char CookedMagic[4] = {'B', 'E', 'M', 'C'};
+    constexpr size_t CookedAlignment = 16;
+
+    struct BeCookedHeader {
+        char Magic[4];
+        uint32_t Version;
+        uint64_t Key;
+        uint64_t FileSize;
+        uint64_t SourceSize;
+        uint64_t SourceWriteTime;
+        uint64_t SourceHash;        // FNV-1a of the source file, only read when the write time changed
+        uint32_t VertexCount;
+        uint32_t IndexCount;
+        uint32_t SliceCount;
+        uint32_t TextureCount;
+        uint64_t VerticesOffset;
+        uint64_t IndicesOffset;
+        uint64_t SlicesOffset;
+        uint64_t TexturesOffset;
+        uint32_t MeshletCount;
+        uint32_t LodCount;
+        uint64_t MeshletsOffset;
+        uint64_t LodErrorsOffset;   // one float per level
+        uint64_t LodSlicesOffset;   // SliceCount slices per level
+        uint32_t OccluderVertexCount;
+        uint32_t OccluderIndexCount;
+        uint64_t OccluderVerticesOffset;
+        uint64_t OccluderIndicesOffset;
+        uint32_t NodeCount;
+        uint32_t NodeMeshCount;
+        uint64_t NodesOffset;
+        uint64_t NodeMeshesOffset;
+    };
+
+    struct BeCookedSlice {
+        uint32_t IndexCount;
+        uint32_t StartIndexLocation;
+        int32_t BaseVertexLocation;
+        float Shininess;
+        glm::vec3 DiffuseColor;
+        float SuperShininess;
+        glm::vec3 SpecularColor;
+        uint32_t FirstMeshlet;
+        glm::vec3 SuperSpecularColor;
+        uint32_t MeshletCount;
+    };
+
+    struct BeCookedTexture {
+        uint32_t SliceIndex;
+        uint8_t Slot;
+        uint8_t Kind;
+        uint16_t Padding;
+        uint32_t Width;
+        uint32_t Height;
+        uint32_t DataSize;
+        uint64_t DataOffset; // path bytes for files, texel/encoded bytes otherwise
+    };
+
+    static_assert(std::is_trivially_copyable_v<BeFullVertex>);
+    static_assert(std::is_trivially_copyable_v<BeCookedSlice>);
+    static_assert(std::is_trivially_copyable_v<BeMeshlet>);
+    static_assert(std::is_trivially_copyable_v<BeModel::BeLodSlice>);
+    static_assert(std::is_trivially_copyable_v<BeModel::BeNode>);
+
+    auto AppendAligned(std::vector<uint8_t>& blob, const void* data, const size_t size) -> uint64_t {
+        blob.resize((blob.size() + CookedAlignment - 1) & ~(CookedAlignment - 1));
+        const uint64_t offset = blob.size();
+        blob.insert(blob.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+        return offset;
+    }
+
+    struct BeSourceStamp {
+        uint64_t Size = 0;
+        uint64_t WriteTime = 0;
+    };
+
+    auto GetSourceStamp(const std::filesystem::path& sourcePath, BeSourceStamp& stamp) -> bool {
+        std::error_code error;
+        stamp.Size = std::filesystem::file_size(sourcePath, error);
+        if (error) return false;
+        const auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+        stamp.WriteTime = static_cast<uint64_t>(writeTime.time_since_epoch().count());
+        return !error;
+    }
+
+    auto HashSource(const std::filesystem::path& sourcePath) -> uint64_t {
+        const BeModelCache::BeMappedFile source(sourcePath);
+        if (!source.IsValid())
+            throw std::runtime_error("Failed to read model: " + sourcePath.string());
+        return BeModelCache::HashBytes(source.Data, source.Size);
+    }
+
+    auto IsRangeInside(const uint64_t offset, const uint64_t size, const uint64_t fileSize) -> bool {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+}
+
+//static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeModelCache::HashBytes(const uint8_t* data, const size_t size, uint64_t seed) -> uint64_t {
+    // FNV-1a, 64 bit
+    for (size_t i = 0; i < size; ++i) {
+        seed ^= data[i];
+        seed *= 0x100000001b3ull;
+    }
+    return seed;
+}
+
+BeModelCache::BeMappedFile::BeMappedFile(const std::filesystem::path& path) {
+    _file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0) return;
+
+    _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping) return;
+
+    Data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (Data) Size = static_cast<size_t>(fileSize.QuadPart);
+}
+
+BeModelCache::BeMappedFile::~BeMappedFile() {
+    if (Data) UnmapViewOfFile(Data);
+    if (_mapping) CloseHandle(_mapping);
+    if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+}
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeModelCache::BeModelCache(std::filesystem::path cacheDirectory)
+    : _cacheDirectory(std::move(cacheDirectory)) {
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeModelCache::ComputeKey(const std::filesystem::path& sourcePath, const uint32_t importFlags) const -> uint64_t {
+    const auto path = std::filesystem::absolute(sourcePath).lexically_normal().generic_u8string();
+    uint64_t key = HashBytes(reinterpret_cast<const uint8_t*>(path.data()), path.size());
+    key = HashBytes(reinterpret_cast<const uint8_t*>(&importFlags), sizeof(importFlags), key);
+    key = HashBytes(reinterpret_cast<const uint8_t*>(&FormatVersion), sizeof(FormatVersion), key);
+    return key;
+}
+
+auto BeModelCache::TryLoad(
+    const std::filesystem::path& sourcePath,
+    const uint64_t key,
+    BeModel& model,
+    std::vector<BeTextureReference>& textures)
+const -> std::unique_ptr<BeMappedFile> {
+
+    const auto cookedPath = GetCookedPath(sourcePath, key);
+    if (!std::filesystem::exists(cookedPath) || !IsSourceUnchanged(sourcePath, cookedPath)) return nullptr;
+
+    auto cooked = std::make_unique<BeMappedFile>(cookedPath);
+    if (!cooked->IsValid() || cooked->Size < sizeof(BeCookedHeader)) return nullptr;
+
+    const auto header = reinterpret_cast<const BeCookedHeader*>(cooked->Data);
+    const uint64_t fileSize = cooked->Size;
+    if (memcmp(header->Magic, CookedMagic, sizeof(CookedMagic)) != 0 ||
+        header->Version != FormatVersion ||
+        header->Key != key ||
+        header->FileSize != fileSize ||
+        !IsRangeInside(header->VerticesOffset, uint64_t(header->VertexCount) * sizeof(BeFullVertex), fileSize) ||
+        !IsRangeInside(header->IndicesOffset, uint64_t(header->IndexCount) * sizeof(uint32_t), fileSize) ||
+        !IsRangeInside(header->SlicesOffset, uint64_t(header->SliceCount) * sizeof(BeCookedSlice), fileSize) ||
+        !IsRangeInside(header->TexturesOffset, uint64_t(header->TextureCount) * sizeof(BeCookedTexture), fileSize) ||
+        !IsRangeInside(header->MeshletsOffset, uint64_t(header->MeshletCount) * sizeof(BeMeshlet), fileSize) ||
+        !IsRangeInside(header->LodErrorsOffset, uint64_t(header->LodCount) * sizeof(float), fileSize) ||
+        !IsRangeInside(header->LodSlicesOffset, uint64_t(header->LodCount) * header->SliceCount * sizeof(BeModel::BeLodSlice), fileSize) ||
+        !IsRangeInside(header->OccluderVerticesOffset, uint64_t(header->OccluderVertexCount) * sizeof(glm::vec3), fileSize) ||
+        !IsRangeInside(header->OccluderIndicesOffset, uint64_t(header->OccluderIndexCount) * sizeof(uint32_t), fileSize) ||
+        !IsRangeInside(header->NodesOffset, uint64_t(header->NodeCount) * sizeof(BeModel::BeNode), fileSize) ||
+        !IsRangeInside(header->NodeMeshesOffset, uint64_t(header->NodeMeshCount) * sizeof(uint32_t), fileSize)) {
+        std::cerr << "Discarding invalid cooked model: " << cookedPath.string() << "\n";
+        return nullptr;
+    }
+
+    const auto vertices = reinterpret_cast<const BeFullVertex*>(cooked->Data + header->VerticesOffset);
+    const auto indices = reinterpret_cast<const uint32_t*>(cooked->Data + header->IndicesOffset);
+    const auto slices = reinterpret_cast<const BeCookedSlice*>(cooked->Data + header->SlicesOffset);
+    const auto cookedTextures = reinterpret_cast<const BeCookedTexture*>(cooked->Data + header->TexturesOffset);
+    const auto meshlets = reinterpret_cast<const BeMeshlet*>(cooked->Data + header->MeshletsOffset);
+    const auto lodErrors = reinterpret_cast<const float*>(cooked->Data + header->LodErrorsOffset);
+    const auto lodSlices = reinterpret_cast<const BeModel::BeLodSlice*>(cooked->Data + header->LodSlicesOffset);
+    const auto occluderVertices = reinterpret_cast<const glm::vec3*>(cooked->Data + header->OccluderVerticesOffset);
+    const auto occluderIndices = reinterpret_cast<const uint32_t*>(cooked->Data + header->OccluderIndicesOffset);
+    const auto nodes = reinterpret_cast<const BeModel::BeNode*>(cooked->Data + header->NodesOffset);
+    const auto nodeMeshes = reinterpret_cast<const uint32_t*>(cooked->Data + header->NodeMeshesOffset);
+
+    model.FullVertices.assign(vertices, vertices + header->VertexCount);
+    model.Indices.assign(indices, indices + header->IndexCount);
+    model.Meshlets.assign(meshlets, meshlets + header->MeshletCount);
+    model.Lods.clear();
+    for (uint32_t i = 0; i < header->LodCount; ++i) {
+        const auto slices = lodSlices + size_t(i) * header->SliceCount;
+        model.Lods.push_back({.Error = lodErrors[i], .Slices = {slices, slices + header->SliceCount}});
+    }
+    model.OccluderVertices.assign(occluderVertices, occluderVertices + header->OccluderVertexCount);
+    model.OccluderIndices.assign(occluderIndices, occluderIndices + header->OccluderIndexCount);
+    model.Nodes.assign(nodes, nodes + header->NodeCount);
+    model.NodeMeshes.assign(nodeMeshes, nodeMeshes + header->NodeMeshCount);
+    for (uint32_t i = 0; i < header->NodeCount; ++i) {
+        const BeModel::BeNode& node = nodes[i];
+        if ((node.Parent != BeModel::NoParent && node.Parent >= i) ||
+            uint64_t(node.FirstMesh) + node.MeshCount > header->NodeMeshCount) {
+            std::cerr << "Discarding invalid cooked model: " << cookedPath.string() << "\n";
+            return nullptr;
+        }
+    }
+    if (std::ranges::any_of(model.NodeMeshes, [&](const uint32_t slice) { return slice >= header->SliceCount; })) {
+        std::cerr << "Discarding invalid cooked model: " << cookedPath.string() << "\n";
+        return nullptr;
+    }
+
+    model.DrawSlices.clear();
+    model.DrawSlices.reserve(header->SliceCount);
+    for (uint32_t i = 0; i < header->SliceCount; ++i) {
+        const BeCookedSlice& slice = slices[i];
+        if (uint64_t(slice.FirstMeshlet) + slice.MeshletCount > header->MeshletCount) {
+            std::cerr << "Discarding invalid cooked model: " << cookedPath.string() << "\n";
+            return nullptr;
+        }
+        BeMaterial material;
+        material.DiffuseColor = slice.DiffuseColor;
+        material.SpecularColor = slice.SpecularColor;
+        material.Shininess = slice.Shininess;
+        material.SuperSpecularColor = slice.SuperSpecularColor;
+        material.SuperShininess = slice.SuperShininess;
+        model.DrawSlices.push_back({
+            .IndexCount = slice.IndexCount,
+            .StartIndexLocation = slice.StartIndexLocation,
+            .BaseVertexLocation = slice.BaseVertexLocation,
+            .Material = material,
+            .FirstMeshlet = slice.FirstMeshlet,
+            .MeshletCount = slice.MeshletCount,
+        });
+    }
+
+    textures.clear();
+    textures.reserve(header->TextureCount);
+    for (uint32_t i = 0; i < header->TextureCount; ++i) {
+        const BeCookedTexture& cookedTexture = cookedTextures[i];
+        const auto kind = static_cast<BeTextureSource::BeKind>(cookedTexture.Kind);
+        if (!IsRangeInside(cookedTexture.DataOffset, cookedTexture.DataSize, fileSize) ||
+            cookedTexture.SliceIndex >= header->SliceCount ||
+            cookedTexture.Slot > uint8_t(BeTextureReference::BeSlot::Specular) ||
+            cookedTexture.Kind > uint8_t(BeTextureSource::BeKind::DecodedMemory) ||
+            (kind == BeTextureSource::BeKind::DecodedMemory &&
+             cookedTexture.DataSize != uint64_t(cookedTexture.Width) * cookedTexture.Height * 4)) {
+            std::cerr << "Discarding invalid cooked model: " << cookedPath.string() << "\n";
+            return nullptr;
+        }
+
+        BeTextureReference reference;
+        reference.SliceIndex = cookedTexture.SliceIndex;
+        reference.Slot = static_cast<BeTextureReference::BeSlot>(cookedTexture.Slot);
+        reference.Source.Kind = kind;
+        reference.Source.Width = cookedTexture.Width;
+        reference.Source.Height = cookedTexture.Height;
+        const auto data = cooked->Data + cookedTexture.DataOffset;
+        if (reference.Source.Kind == BeTextureSource::BeKind::File) {
+            reference.Source.Path = std::u8string(reinterpret_cast<const char8_t*>(data), cookedTexture.DataSize);
+        } else {
+            reference.Source.Data = data;
+            reference.Source.Size = cookedTexture.DataSize;
+        }
+        textures.push_back(std::move(reference));
+    }
+
+    return cooked;
+}
+
+auto BeModelCache::Store(
+    const std::filesystem::path& sourcePath,
+    const uint64_t key,
+    const BeModel& model,
+    const std::vector<BeTextureReference>& textures)
+const -> void {
+
+    std::vector<uint8_t> blob(sizeof(BeCookedHeader));
+
+    BeCookedHeader header = {};
+    memcpy(header.Magic, CookedMagic, sizeof(CookedMagic));
+    header.Version = FormatVersion;
+    header.Key = key;
+    BeSourceStamp stamp;
+    if (!GetSourceStamp(sourcePath, stamp)) {
+        std::cerr << "Failed to stamp cooked model: " << sourcePath.string() << "\n";
+        return;
+    }
+    header.SourceSize = stamp.Size;
+    header.SourceWriteTime = stamp.WriteTime;
+    header.SourceHash = HashSource(sourcePath);
+    header.VertexCount = static_cast<uint32_t>(model.FullVertices.size());
+    header.IndexCount = static_cast<uint32_t>(model.Indices.size());
+    header.SliceCount = static_cast<uint32_t>(model.DrawSlices.size());
+    header.TextureCount = static_cast<uint32_t>(textures.size());
+    header.MeshletCount = static_cast<uint32_t>(model.Meshlets.size());
+    header.LodCount = static_cast<uint32_t>(model.Lods.size());
+    header.OccluderVertexCount = static_cast<uint32_t>(model.OccluderVertices.size());
+    header.OccluderIndexCount = static_cast<uint32_t>(model.OccluderIndices.size());
+    header.NodeCount = static_cast<uint32_t>(model.Nodes.size());
+    header.NodeMeshCount = static_cast<uint32_t>(model.NodeMeshes.size());
+
+    header.VerticesOffset = AppendAligned(blob, model.FullVertices.data(), model.FullVertices.size() * sizeof(BeFullVertex));
+    header.IndicesOffset = AppendAligned(blob, model.Indices.data(), model.Indices.size() * sizeof(uint32_t));
+
+    std::vector<BeCookedSlice> slices;
+    slices.reserve(model.DrawSlices.size());
+    for (const auto& slice : model.DrawSlices) {
+        slices.push_back({
+            .IndexCount = slice.IndexCount,
+            .StartIndexLocation = slice.StartIndexLocation,
+            .BaseVertexLocation = slice.BaseVertexLocation,
+            .Shininess = slice.Material.Shininess,
+            .DiffuseColor = slice.Material.DiffuseColor,
+            .SuperShininess = slice.Material.SuperShininess,
+            .SpecularColor = slice.Material.SpecularColor,
+            .FirstMeshlet = slice.FirstMeshlet,
+            .SuperSpecularColor = slice.Material.SuperSpecularColor,
+            .MeshletCount = slice.MeshletCount,
+        });
+    }
+    header.SlicesOffset = AppendAligned(blob, slices.data(), slices.size() * sizeof(BeCookedSlice));
+    header.MeshletsOffset = AppendAligned(blob, model.Meshlets.data(), model.Meshlets.size() * sizeof(BeMeshlet));
+    std::vector<float> lodErrors;
+    std::vector<BeModel::BeLodSlice> lodSlices;
+    for (const auto& level : model.Lods) {
+        lodErrors.push_back(level.Error);
+        lodSlices.insert(lodSlices.end(), level.Slices.begin(), level.Slices.end());
+    }
+    header.LodErrorsOffset = AppendAligned(blob, lodErrors.data(), lodErrors.size() * sizeof(float));
+    header.LodSlicesOffset = AppendAligned(blob, lodSlices.data(), lodSlices.size() * sizeof(BeModel::BeLodSlice));
+    header.OccluderVerticesOffset = AppendAligned(blob, model.OccluderVertices.data(), model.OccluderVertices.size() * sizeof(glm::vec3));
+    header.OccluderIndicesOffset = AppendAligned(blob, model.OccluderIndices.data(), model.OccluderIndices.size() * sizeof(uint32_t));
+    header.NodesOffset = AppendAligned(blob, model.Nodes.data(), model.Nodes.size() * sizeof(BeModel::BeNode));
+    header.NodeMeshesOffset = AppendAligned(blob, model.NodeMeshes.data(), model.NodeMeshes.size() * sizeof(uint32_t));
+
+    // texture payloads first, so the table can point at them
+    std::vector<BeCookedTexture> cookedTextures;
+    cookedTextures.reserve(textures.size());
+    for (const auto& reference : textures) {
+        const auto& source = reference.Source;
+        BeCookedTexture cookedTexture = {
+            .SliceIndex = reference.SliceIndex,
+            .Slot = static_cast<uint8_t>(reference.Slot),
+            .Kind = static_cast<uint8_t>(source.Kind),
+            .Width = source.Width,
+            .Height = source.Height,
+        };
+        if (source.Kind == BeTextureSource::BeKind::File) {
+            const auto path = source.Path.u8string();
+            cookedTexture.DataSize = static_cast<uint32_t>(path.size());
+            cookedTexture.DataOffset = AppendAligned(blob, path.data(), path.size());
+        } else {
+            const uint32_t size = source.Kind == BeTextureSource::BeKind::EncodedMemory
+                ? source.Size
+                : source.Width * source.Height * 4;
+            cookedTexture.DataSize = size;
+            cookedTexture.DataOffset = AppendAligned(blob, source.Data, size);
+        }
+        cookedTextures.push_back(cookedTexture);
+    }
+    header.TexturesOffset = AppendAligned(blob, cookedTextures.data(), cookedTextures.size() * sizeof(BeCookedTexture));
+
+    header.FileSize = blob.size();
+    memcpy(blob.data(), &header, sizeof(BeCookedHeader));
+
+    // write next to the final name and swap, a torn file never looks like a valid entry
+    std::error_code error;
+    std::filesystem::create_directories(_cacheDirectory, error);
+    const auto cookedPath = GetCookedPath(sourcePath, key);
+    auto temporaryPath = cookedPath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to write cooked model: " << cookedPath.string() << "\n";
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+    }
+    std::filesystem::rename(temporaryPath, cookedPath, error);
+    if (error)
+        std::cerr << "Failed to write cooked model: " << cookedPath.string() << "\n";
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeModelCache::GetCookedPath(const std::filesystem::path& sourcePath, const uint64_t key) const -> std::filesystem::path {
+    return _cacheDirectory / std::format("{}-{:016x}.bemodel", sourcePath.stem().string(), key);
+}
+
+auto BeModelCache::IsSourceUnchanged(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath) -> bool {
+    BeSourceStamp stamp;
+    if (!GetSourceStamp(sourcePath, stamp)) return false;
+
+    std::fstream cookedFile(cookedPath, std::ios::binary | std::ios::in | std::ios::out);
+    BeCookedHeader header;
+    if (!cookedFile.read(reinterpret_cast<char*>(&header), sizeof(BeCookedHeader))) return false;
+    if (memcmp(header.Magic, CookedMagic, sizeof(CookedMagic)) != 0 || header.Version != FormatVersion) return false;
+    if (header.SourceSize != stamp.Size) return false;
+    if (header.SourceWriteTime == stamp.WriteTime) return true;
+
+    // touched, e.g. by a checkout, but maybe not edited
+    if (HashSource(sourcePath) != header.SourceHash) return false;
+    header.SourceWriteTime = stamp.WriteTime;
+    cookedFile.seekp(0);
+    cookedFile.write(reinterpret_cast<const char*>(&header), sizeof(BeCookedHeader));
+    return true;
+}
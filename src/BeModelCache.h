@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <windows.h>
+
+#include "BeModel.h"
+
+// Where the pixels of a material texture come from. Memory sources point either into the Assimp scene or into
+// a mapped cooked file, so they stay valid only while their owner is alive.
+struct BeTextureSource {
+    enum class BeKind : uint8_t {
+        File,
+        EncodedMemory,   // png/jpg/... bytes, Size is the byte count
+        DecodedMemory,   // BGRA8 texels, Width x Height
+    };
+
+    BeKind Kind = BeKind::File;
+    std::filesystem::path Path;
+    const uint8_t* Data = nullptr;
+    uint32_t Size = 0;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+};
+
+struct BeTextureReference {
+    enum class BeSlot : uint8_t {
+        Diffuse,
+        Specular,
+    };
+
+    uint32_t SliceIndex = 0;
+    BeSlot Slot = BeSlot::Diffuse;
+    BeTextureSource Source;
+};
+
+// Stores fully imported models in a versioned binary format, so a warm start maps one file instead of running
+// Assimp. Entries are keyed by the source path, the import flags and the format version. An entry is current while
+// its source keeps the size and write time it was cooked from; the content hash in the header is only read when the
+// write time alone changed.
+class BeModelCache {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t FormatVersion = 7;
+
+    static auto HashBytes(const uint8_t* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) -> uint64_t;
+
+    class BeMappedFile {
+    public:
+        explicit BeMappedFile(const std::filesystem::path& path);
+        ~BeMappedFile();
+        BeMappedFile(const BeMappedFile&) = delete;
+        BeMappedFile& operator=(const BeMappedFile&) = delete;
+
+        [[nodiscard]] auto IsValid() const -> bool { return Data != nullptr; }
+
+        const uint8_t* Data = nullptr;
+        size_t Size = 0;
+
+    private:
+        HANDLE _file = INVALID_HANDLE_VALUE;
+        HANDLE _mapping = nullptr;
+    };
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::filesystem::path _cacheDirectory;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeModelCache(std::filesystem::path cacheDirectory);
+    ~BeModelCache() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Cheap enough for every launch, the source itself is not read.
+    [[nodiscard]] auto ComputeKey(const std::filesystem::path& sourcePath, uint32_t importFlags) const -> uint64_t;
+
+    // On a hit fills the model and texture references and returns the mapping they point into, nullptr on a miss.
+    [[nodiscard]] auto TryLoad(
+        const std::filesystem::path& sourcePath,
+        uint64_t key,
+        BeModel& model,
+        std::vector<BeTextureReference>& textures
+    ) const -> std::unique_ptr<BeMappedFile>;
+
+    auto Store(
+        const std::filesystem::path& sourcePath,
+        uint64_t key,
+        const BeModel& model,
+        const std::vector<BeTextureReference>& textures
+    ) const -> void;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    [[nodiscard]] auto GetCookedPath(const std::filesystem::path& sourcePath, uint64_t key) const -> std::filesystem::path;
+    // Compares the source with the stamp in the cooked header. A source whose contents still hash the same is current
+    // too, its new write time goes back into the header so the next launch skips the hash.
+    [[nodiscard]] static auto IsSourceUnchanged(const std::filesystem::path& sourcePath, const std::filesystem::path& cookedPath) -> bool;
+};
@@ -0,0 +1,192 @@
+﻿#include "BeNullDeviceContext.h"
+
+#include <bit>
+
+#include "BeCommandList.h"
+#include "BeHandleRegistry.h"
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeNullDeviceContext::BeNullDeviceContext() {
+    Reset();
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeNullDeviceContext::SetInputLayout(ID3D11InputLayout* layout) -> void {
+    Call(0);
+    Mix(layout);
+}
+
+auto BeNullDeviceContext::SetPrimitiveTopology(const uint32_t topology) -> void {
+    Call(1);
+    Mix(topology);
+}
+
+auto BeNullDeviceContext::SetVertexBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void {
+    Call(2);
+    Mix(startSlot);
+    Mix(count);
+    MixArray(buffers, count);
+    MixArray(strides, count);
+    MixArray(offsets, count);
+}
+
+auto BeNullDeviceContext::SetIndexBuffer(ID3D11Buffer* buffer, const uint32_t format, const uint32_t offset) -> void {
+    Call(3);
+    Mix(buffer);
+    Mix(format);
+    Mix(offset);
+}
+
+auto BeNullDeviceContext::SetVertexShader(ID3D11VertexShader* shader) -> void {
+    Call(4);
+    Mix(shader);
+}
+
+auto BeNullDeviceContext::SetPixelShader(ID3D11PixelShader* shader) -> void {
+    Call(5);
+    Mix(shader);
+}
+
+auto BeNullDeviceContext::SetVSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    Call(6);
+    Mix(startSlot);
+    Mix(count);
+    MixArray(buffers, count);
+}
+
+auto BeNullDeviceContext::SetPSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void {
+    Call(7);
+    Mix(startSlot);
+    Mix(count);
+    MixArray(buffers, count);
+}
+
+auto BeNullDeviceContext::SetPSShaderResources(const uint32_t startSlot, const uint32_t count, ID3D11ShaderResourceView* const* views) -> void {
+    Call(8);
+    Mix(startSlot);
+    Mix(count);
+    MixArray(views, count);
+}
+
+auto BeNullDeviceContext::SetPSSamplers(const uint32_t startSlot, const uint32_t count, ID3D11SamplerState* const* samplers) -> void {
+    Call(9);
+    Mix(startSlot);
+    Mix(count);
+    MixArray(samplers, count);
+}
+
+auto BeNullDeviceContext::SetRasterizerState(ID3D11RasterizerState* state) -> void {
+    Call(10);
+    Mix(state);
+}
+
+auto BeNullDeviceContext::SetBlendState(ID3D11BlendState* state) -> void {
+    Call(11);
+    Mix(state);
+}
+
+auto BeNullDeviceContext::SetDepthStencilState(ID3D11DepthStencilState* state, const uint32_t stencilReference) -> void {
+    Call(12);
+    Mix(state);
+    Mix(stencilReference);
+}
+
+auto BeNullDeviceContext::SetRenderTargets(const uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void {
+    Call(13);
+    Mix(count);
+    MixArray(targets, count);
+    Mix(depthTarget);
+}
+
+auto BeNullDeviceContext::SetViewport(const uint32_t width, const uint32_t height) -> void {
+    Call(14);
+    Mix(width);
+    Mix(height);
+}
+
+auto BeNullDeviceContext::ClearState() -> void {
+    Call(15);
+}
+
+auto BeNullDeviceContext::ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void {
+    Call(16);
+    Mix(target);
+    for (uint32_t i = 0; i < 4; ++i) Mix(std::bit_cast<uint32_t>(color[i]));
+}
+
+auto BeNullDeviceContext::ClearDepthStencilView(ID3D11DepthStencilView* target, const uint32_t flags, const float depth, const uint8_t stencil) -> void {
+    Call(17);
+    Mix(target);
+    Mix(flags);
+    Mix(std::bit_cast<uint32_t>(depth));
+    Mix(stencil);
+}
+
+auto BeNullDeviceContext::UpdateBuffer(ID3D11Buffer* buffer, const uint32_t offset, const void* data, const uint32_t size, const bool discard) -> void {
+    Call(18);
+    Mix(buffer);
+    Mix(offset);
+    Mix(size);
+    Mix(discard);
+    MixBytes(data, size);
+    _statistics.UploadedBytes += size;
+}
+
+auto BeNullDeviceContext::CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, const uint32_t width, const uint32_t height) -> void {
+    Call(19);
+    Mix(destination);
+    Mix(source);
+    Mix(width);
+    Mix(height);
+}
+
+auto BeNullDeviceContext::Draw(const uint32_t vertexCount, const uint32_t startVertex) -> void {
+    Call(20);
+    Mix(vertexCount);
+    Mix(startVertex);
+    ++_statistics.Draws;
+}
+
+auto BeNullDeviceContext::DrawIndexedInstanced(const uint32_t indexCount, const uint32_t instanceCount, const uint32_t startIndex, const int32_t baseVertex, const uint32_t startInstance) -> void {
+    Call(21);
+    Mix(indexCount);
+    Mix(instanceCount);
+    Mix(startIndex);
+    Mix(static_cast<uint32_t>(baseVertex));
+    Mix(startInstance);
+    ++_statistics.Draws;
+}
+
+auto BeNullDeviceContext::ExecuteCommandList(const BeCommandList& commands) -> void {
+    commands.Replay(*this);
+}
+
+auto BeNullDeviceContext::Reset() -> void {
+    _hash = BeName::OffsetBasis;
+    _statistics = {};
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeNullDeviceContext::Call(const uint32_t id) -> void {
+    Mix(id);
+    ++_statistics.Calls;
+}
+
+auto BeNullDeviceContext::Mix(const uint64_t value) -> void {
+    // FNV-1a a byte at a time, like BeName
+    for (uint32_t i = 0; i < 8; ++i) {
+        _hash ^= (value >> (8 * i)) & 0xff;
+        _hash *= BeName::Prime;
+    }
+}
+
+auto BeNullDeviceContext::MixBytes(const void* data, const uint32_t size) -> void {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (uint32_t i = 0; i < size; ++i) {
+        _hash ^= bytes[i];
+        _hash *= BeName::Prime;
+    }
+}
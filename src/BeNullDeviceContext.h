@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <cstdint>
+
+#include "BeDeviceContext.h"
+
+// A backend without a device: every call only feeds a hash of itself and its arguments and a few counters. Two call
+// streams hash alike when they would have done the same to a real context, which is what command lists are checked
+// against. Executing a command list replays it here.
+class BeNullDeviceContext final : public BeDeviceContext {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    struct BeStatistics {
+        uint64_t Calls = 0;
+        uint64_t Draws = 0;
+        uint64_t UploadedBytes = 0;
+    };
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint64_t _hash = 0;
+    BeStatistics _statistics;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeNullDeviceContext();
+    ~BeNullDeviceContext() override = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    auto SetInputLayout(ID3D11InputLayout* layout) -> void override;
+    auto SetPrimitiveTopology(uint32_t topology) -> void override;
+    auto SetVertexBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void override;
+    auto SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset) -> void override;
+    auto SetVertexShader(ID3D11VertexShader* shader) -> void override;
+    auto SetPixelShader(ID3D11PixelShader* shader) -> void override;
+    auto SetVSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSConstantBuffers(uint32_t startSlot, uint32_t count, ID3D11Buffer* const* buffers) -> void override;
+    auto SetPSShaderResources(uint32_t startSlot, uint32_t count, ID3D11ShaderResourceView* const* views) -> void override;
+    auto SetPSSamplers(uint32_t startSlot, uint32_t count, ID3D11SamplerState* const* samplers) -> void override;
+    auto SetRasterizerState(ID3D11RasterizerState* state) -> void override;
+    auto SetBlendState(ID3D11BlendState* state) -> void override;
+    auto SetDepthStencilState(ID3D11DepthStencilState* state, uint32_t stencilReference) -> void override;
+    auto SetRenderTargets(uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void override;
+    auto SetViewport(uint32_t width, uint32_t height) -> void override;
+    auto ClearState() -> void override;
+    auto ClearRenderTargetView(ID3D11RenderTargetView* target, const float* color) -> void override;
+    auto ClearDepthStencilView(ID3D11DepthStencilView* target, uint32_t flags, float depth, uint8_t stencil) -> void override;
+    auto UpdateBuffer(ID3D11Buffer* buffer, uint32_t offset, const void* data, uint32_t size, bool discard) -> void override;
+    auto CopyTextureRegion(ID3D11Texture2D* destination, ID3D11Texture2D* source, uint32_t width, uint32_t height) -> void override;
+    auto Draw(uint32_t vertexCount, uint32_t startVertex) -> void override;
+    auto DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) -> void override;
+    auto ExecuteCommandList(const BeCommandList& commands) -> void override;
+
+    [[nodiscard]] auto GetHash() const -> uint64_t { return _hash; }
+    [[nodiscard]] auto GetStatistics() const -> const BeStatistics& { return _statistics; }
+    auto Reset() -> void;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Starts the hash of a call, every call hashes a different id first.
+    auto Call(uint32_t id) -> void;
+    auto Mix(uint64_t value) -> void;
+    auto Mix(const void* object) -> void { Mix(reinterpret_cast<uintptr_t>(object)); }
+    auto MixBytes(const void* data, uint32_t size) -> void;
+    template <typename T>
+    auto MixArray(const T* values, const uint32_t count) -> void {
+        for (uint32_t i = 0; i < count; ++i) Mix(values[i]);
+    }
+};
@@ -0,0 +1,424 @@
+﻿#include "BeOcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include <optional>
+#include <tuple>
+
+#include "BeLod.h"
+#include "BeThreadPool.h"
+
+namespace {
+    using BeInstructionSet = BeOcclusionBuffer::BeInstructionSet;
+    using BeTriangle = BeOcclusionBuffer::BeTriangle;
+    constexpr uint32_t Width = BeOcclusionBuffer::Width;
+    constexpr uint32_t Height = BeOcclusionBuffer::Height;
+
+    // clip space planes a polygon is cut against: the near plane, which is right for -1..1 depth and conservative
+    // for 0..1, and a guard band twice the screen, so screen coordinates stay small enough for float edge functions
+    constexpr float GuardBand = 2.0f;
+    constexpr glm::vec4 ClipPlanes[] = {
+        {0.0f, 0.0f, 1.0f, 1.0f},
+        {1.0f, 0.0f, 0.0f, GuardBand},
+        {-1.0f, 0.0f, 0.0f, GuardBand},
+        {0.0f, 1.0f, 0.0f, GuardBand},
+        {0.0f, -1.0f, 0.0f, GuardBand},
+    };
+    constexpr uint32_t MaxClippedVertices = 3 + std::size(ClipPlanes);
+
+    // pixel centres sit at x + 0.5, rows run top down
+    auto ToScreen(const glm::vec4& clip) -> glm::vec3 {
+        const float inverseW = 1.0f / clip.w;
+        return {
+            (clip.x * inverseW * 0.5f + 0.5f) * float(Width),
+            (0.5f - clip.y * inverseW * 0.5f) * float(Height),
+            inverseW,
+        };
+    }
+
+    // Sutherland-Hodgman against every clip plane, returns the vertex count of the remaining convex polygon.
+    auto ClipTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, std::array<glm::vec4, MaxClippedVertices>& polygon) -> uint32_t {
+        std::array<glm::vec4, MaxClippedVertices> scratch;
+        polygon[0] = a;
+        polygon[1] = b;
+        polygon[2] = c;
+        uint32_t count = 3;
+        for (const auto& plane : ClipPlanes) {
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < count; ++i) {
+                const glm::vec4& from = polygon[i];
+                const glm::vec4& to = polygon[(i + 1) % count];
+                const float fromDistance = glm::dot(plane, from);
+                const float toDistance = glm::dot(plane, to);
+                if (fromDistance >= 0.0f) scratch[kept++] = from;
+                if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+                    scratch[kept++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+            }
+            count = kept;
+            if (count < 3) return 0;
+            std::copy_n(scratch.begin(), count, polygon.begin());
+        }
+        return count;
+    }
+
+    auto MakeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c) -> std::optional<BeTriangle> {
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-6f) return std::nullopt;
+        // occluders are drawn from both sides, the winding only picks the edge signs
+        if (area < 0.0f) {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        BeTriangle triangle;
+        triangle.MinX = std::max(0, static_cast<int32_t>(std::ceil(std::min({a.x, b.x, c.x}) - 0.5f)));
+        triangle.MaxX = std::min(int32_t(Width) - 1, static_cast<int32_t>(std::floor(std::max({a.x, b.x, c.x}) - 0.5f)));
+        triangle.MinY = std::max(0, static_cast<int32_t>(std::ceil(std::min({a.y, b.y, c.y}) - 0.5f)));
+        triangle.MaxY = std::min(int32_t(Height) - 1, static_cast<int32_t>(std::floor(std::max({a.y, b.y, c.y}) - 0.5f)));
+        if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY) return std::nullopt;
+
+        // edge p -> q is positive on the side of the remaining vertex
+        const glm::vec3 corners[] = {a, b, c};
+        for (int edge = 0; edge < 3; ++edge) {
+            const glm::vec3& p = corners[edge];
+            const glm::vec3& q = corners[(edge + 1) % 3];
+            triangle.EdgeA[edge] = p.y - q.y;
+            triangle.EdgeB[edge] = q.x - p.x;
+            triangle.EdgeC[edge] = -(triangle.EdgeA[edge] * p.x + triangle.EdgeB[edge] * p.y);
+        }
+        const float depthA = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / area;
+        const float depthB = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / area;
+        triangle.Depth = {depthA, depthB, a.z - depthA * a.x - depthB * a.y};
+        return triangle;
+    }
+
+    // Every kernel evaluates a * px + (b * py + c) per pixel, the same operations in the same order, so they agree
+    // bit for bit.
+    auto RasterizeScalar(const BeTriangle& triangle, const int32_t firstRow, const int32_t lastRow, float* depth) -> void {
+        for (int32_t y = firstRow; y <= lastRow; ++y) {
+            const float py = float(y) + 0.5f;
+            const glm::vec3 rowEdge = triangle.EdgeB * py + triangle.EdgeC;
+            const float rowDepth = triangle.Depth.y * py + triangle.Depth.z;
+            float* row = depth + size_t(y) * Width;
+            for (int32_t x = triangle.MinX; x <= triangle.MaxX; ++x) {
+                const float px = float(x) + 0.5f;
+                if (triangle.EdgeA.x * px + rowEdge.x >= 0.0f &&
+                    triangle.EdgeA.y * px + rowEdge.y >= 0.0f &&
+                    triangle.EdgeA.z * px + rowEdge.z >= 0.0f)
+                    row[x] = std::max(row[x], triangle.Depth.x * px + rowDepth);
+            }
+        }
+    }
+
+    auto RasterizeSSE2(const BeTriangle& triangle, const int32_t firstRow, const int32_t lastRow, float* depth) -> void {
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 rangeMin = _mm_set1_ps(float(triangle.MinX) + 0.5f);
+        const __m128 rangeMax = _mm_set1_ps(float(triangle.MaxX) + 0.5f);
+        const __m128 edgeA0 = _mm_set1_ps(triangle.EdgeA.x);
+        const __m128 edgeA1 = _mm_set1_ps(triangle.EdgeA.y);
+        const __m128 edgeA2 = _mm_set1_ps(triangle.EdgeA.z);
+        const __m128 depthA = _mm_set1_ps(triangle.Depth.x);
+        const __m128 zero = _mm_setzero_ps();
+        const int32_t firstColumn = triangle.MinX & ~3;
+        for (int32_t y = firstRow; y <= lastRow; ++y) {
+            const float py = float(y) + 0.5f;
+            const __m128 rowEdge0 = _mm_set1_ps(triangle.EdgeB.x * py + triangle.EdgeC.x);
+            const __m128 rowEdge1 = _mm_set1_ps(triangle.EdgeB.y * py + triangle.EdgeC.y);
+            const __m128 rowEdge2 = _mm_set1_ps(triangle.EdgeB.z * py + triangle.EdgeC.z);
+            const __m128 rowDepth = _mm_set1_ps(triangle.Depth.y * py + triangle.Depth.z);
+            float* row = depth + size_t(y) * Width;
+            for (int32_t x = firstColumn; x <= triangle.MaxX; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(x)), laneOffsets);
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(px, rangeMin), _mm_cmple_ps(px, rangeMax));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), rowEdge0), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), rowEdge1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), rowEdge2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+                const __m128 previous = _mm_loadu_ps(row + x);
+                const __m128 nearest = _mm_max_ps(previous, _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth));
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+            }
+        }
+    }
+
+    BE_TARGET_AVX2 auto RasterizeAVX2(const BeTriangle& triangle, const int32_t firstRow, const int32_t lastRow, float* depth) -> void {
+        const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        const __m256 rangeMin = _mm256_set1_ps(float(triangle.MinX) + 0.5f);
+        const __m256 rangeMax = _mm256_set1_ps(float(triangle.MaxX) + 0.5f);
+        const __m256 edgeA0 = _mm256_set1_ps(triangle.EdgeA.x);
+        const __m256 edgeA1 = _mm256_set1_ps(triangle.EdgeA.y);
+        const __m256 edgeA2 = _mm256_set1_ps(triangle.EdgeA.z);
+        const __m256 depthA = _mm256_set1_ps(triangle.Depth.x);
+        const __m256 zero = _mm256_setzero_ps();
+        const int32_t firstColumn = triangle.MinX & ~7;
+        for (int32_t y = firstRow; y <= lastRow; ++y) {
+            const float py = float(y) + 0.5f;
+            const __m256 rowEdge0 = _mm256_set1_ps(triangle.EdgeB.x * py + triangle.EdgeC.x);
+            const __m256 rowEdge1 = _mm256_set1_ps(triangle.EdgeB.y * py + triangle.EdgeC.y);
+            const __m256 rowEdge2 = _mm256_set1_ps(triangle.EdgeB.z * py + triangle.EdgeC.z);
+            const __m256 rowDepth = _mm256_set1_ps(triangle.Depth.y * py + triangle.Depth.z);
+            float* row = depth + size_t(y) * Width;
+            for (int32_t x = firstColumn; x <= triangle.MaxX; x += 8) {
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(float(x)), laneOffsets);
+                __m256 inside = _mm256_and_ps(_mm256_cmp_ps(px, rangeMin, _CMP_GE_OQ), _mm256_cmp_ps(px, rangeMax, _CMP_LE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA0, px), rowEdge0), zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA1, px), rowEdge1), zero, _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA2, px), rowEdge2), zero, _CMP_GE_OQ));
+                if (_mm256_movemask_ps(inside) == 0) continue;
+                const __m256 previous = _mm256_loadu_ps(row + x);
+                const __m256 nearest = _mm256_max_ps(previous, _mm256_add_ps(_mm256_mul_ps(depthA, px), rowDepth));
+                _mm256_storeu_ps(row + x, _mm256_blendv_ps(previous, nearest, inside));
+            }
+        }
+    }
+
+    struct BeScreenBox {
+        int32_t MinX, MinY, MaxX, MaxY;   // every pixel the projected box overlaps, not only those it covers the centre of
+        float Nearest;                    // largest 1/w of the corners
+    };
+
+    // std::nullopt when the box crosses the near plane or is entirely off screen, occlusion has no say then.
+    auto ProjectBox(const glm::mat4& projectionView, const glm::vec3& center, const glm::vec3& extent) -> std::optional<BeScreenBox> {
+        glm::vec2 screenMin(std::numeric_limits<float>::max());
+        glm::vec2 screenMax(std::numeric_limits<float>::lowest());
+        float nearest = 0.0f;
+        // corners as the clip space centre plus or minus the clip space axes, no matrix product per corner
+        const glm::vec4 clipCenter = projectionView * glm::vec4(center, 1.0f);
+        const glm::vec4 axes[] = {projectionView[0] * extent.x, projectionView[1] * extent.y, projectionView[2] * extent.z};
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            const glm::vec4 clip = clipCenter +
+                (corner & 1 ? axes[0] : -axes[0]) +
+                (corner & 2 ? axes[1] : -axes[1]) +
+                (corner & 4 ? axes[2] : -axes[2]);
+            if (clip.z + clip.w < 0.0f || clip.w <= 0.0f) return std::nullopt;
+            const glm::vec3 screen = ToScreen(clip);
+            screenMin = glm::min(screenMin, glm::vec2(screen));
+            screenMax = glm::max(screenMax, glm::vec2(screen));
+            nearest = std::max(nearest, screen.z);
+        }
+        const BeScreenBox box = {
+            .MinX = static_cast<int32_t>(std::max(0.0f, std::floor(screenMin.x))),
+            .MinY = static_cast<int32_t>(std::max(0.0f, std::floor(screenMin.y))),
+            .MaxX = static_cast<int32_t>(std::min(float(Width), std::ceil(screenMax.x))) - 1,
+            .MaxY = static_cast<int32_t>(std::min(float(Height), std::ceil(screenMax.y))) - 1,
+            .Nearest = nearest,
+        };
+        if (box.MinX > box.MaxX || box.MinY > box.MaxY) return std::nullopt;
+        return box;
+    }
+}
+
+//static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeOcclusionBuffer::GenerateOccluder(BeModel& model) -> void {
+    model.OccluderVertices.clear();
+    model.OccluderIndices.clear();
+    if (model.Indices.empty()) return;
+
+    // every slice where its nodes place it, as a triangle soup welded by position; normals and UVs are all zero so
+    // no seam locks a vertex in place
+    const std::vector<glm::mat4> nodeWorlds = model.GetNodeWorlds();
+    std::vector<glm::vec3> placed;
+    for (size_t n = 0; n < model.Nodes.size(); ++n) {
+        for (const uint32_t s : std::span(model.NodeMeshes).subspan(model.Nodes[n].FirstMesh, model.Nodes[n].MeshCount)) {
+            const auto& slice = model.DrawSlices[s];
+            for (uint32_t i = slice.StartIndexLocation; i + 2 < slice.StartIndexLocation + slice.IndexCount; i += 3)
+                for (uint32_t corner = 0; corner < 3; ++corner)
+                    placed.push_back(glm::vec3(nodeWorlds[n] * glm::vec4(model.FullVertices[model.Indices[i + corner] + slice.BaseVertexLocation].Position, 1.0f)));
+        }
+    }
+    std::vector<uint32_t> order(placed.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto lessPosition = [&](const uint32_t left, const uint32_t right) {
+        const glm::vec3& a = placed[left];
+        const glm::vec3& b = placed[right];
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    };
+    std::ranges::sort(order, lessPosition);
+    std::vector<BeFullVertex> welded;
+    std::vector<uint32_t> weldedOf(placed.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || lessPosition(order[i - 1], order[i]))
+            welded.push_back({.Position = placed[order[i]], .Normal = glm::vec3(0.0f)});
+        weldedOf[order[i]] = static_cast<uint32_t>(welded.size() - 1);
+    }
+
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i + 2 < placed.size(); i += 3) {
+        const uint32_t a = weldedOf[i + 0];
+        const uint32_t b = weldedOf[i + 1];
+        const uint32_t c = weldedOf[i + 2];
+        if (a == b || b == c || c == a) continue;
+        indices.insert(indices.end(), {a, b, c});
+    }
+    if (indices.empty()) return;
+
+    const auto triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    const uint32_t targetTriangles = std::clamp(static_cast<uint32_t>(float(triangleCount) * OccluderRatio), 1u, MaxOccluderTriangles);
+    std::vector<uint32_t> simplified;
+    BeLod::Simplify(indices, welded, targetTriangles * 3, OccluderMaxRelativeError * model.Bounds.Radius, simplified);
+    if (simplified.empty() || simplified.size() / 3 > 4 * MaxOccluderTriangles) return;
+
+    std::vector<uint32_t> compacted(welded.size(), UINT32_MAX);
+    model.OccluderIndices.reserve(simplified.size());
+    for (const uint32_t index : simplified) {
+        if (compacted[index] == UINT32_MAX) {
+            compacted[index] = static_cast<uint32_t>(model.OccluderVertices.size());
+            model.OccluderVertices.push_back(welded[index].Position);
+        }
+        model.OccluderIndices.push_back(compacted[index]);
+    }
+}
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeOcclusionBuffer::BeOcclusionBuffer()
+    : _depth(size_t(Width) * Height, 0.0f) {
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeOcclusionBuffer::Begin(const glm::mat4& projectionView) -> void {
+    _projectionView = projectionView;
+    _occluders.clear();
+    std::ranges::fill(_depth, 0.0f);
+    _tileMin.fill(0.0f);
+    _tileMax.fill(0.0f);
+    _statistics = {};
+}
+
+auto BeOcclusionBuffer::AddOccluder(const std::span<const glm::vec3> vertices, const std::span<const uint32_t> indices, const glm::mat4& world) -> void {
+    _occluders.push_back({.Vertices = vertices, .Indices = indices, .World = world});
+    ++_statistics.Occluders;
+    _statistics.OccluderTriangles += static_cast<uint32_t>(indices.size() / 3);
+}
+
+auto BeOcclusionBuffer::Rasterize(const bool parallel) -> void {
+    Rasterize(parallel, BePixelKernels::GetInstructionSet());
+}
+
+auto BeOcclusionBuffer::Rasterize(const bool parallel, const BeInstructionSet instructionSet) -> void {
+    const auto occluderCount = static_cast<uint32_t>(_occluders.size());
+    _triangles.resize(std::max<size_t>(_triangles.size(), occluderCount));
+    constexpr uint32_t BandCount = Height / BandHeight;
+    auto rasterizeBand = [&](const uint32_t band) {
+        RasterizeBand(band, instructionSet);
+        UpdateTiles(band * BandHeight / TileSize, BandHeight / TileSize);
+    };
+    if (parallel) {
+        BeThreadPool::Shared().ParallelFor(occluderCount, [&](const uint32_t occluder) { SetupTriangles(occluder); });
+        BeThreadPool::Shared().ParallelFor(BandCount, rasterizeBand);
+    } else {
+        for (uint32_t occluder = 0; occluder < occluderCount; ++occluder) SetupTriangles(occluder);
+        for (uint32_t band = 0; band < BandCount; ++band) rasterizeBand(band);
+    }
+    _statistics.RasterizedTriangles = 0;
+    for (uint32_t occluder = 0; occluder < occluderCount; ++occluder)
+        _statistics.RasterizedTriangles += static_cast<uint32_t>(_triangles[occluder].size());
+}
+
+auto BeOcclusionBuffer::RasterizeReference() -> void {
+    const auto occluderCount = static_cast<uint32_t>(_occluders.size());
+    _triangles.resize(std::max<size_t>(_triangles.size(), occluderCount));
+    _statistics.RasterizedTriangles = 0;
+    for (uint32_t occluder = 0; occluder < occluderCount; ++occluder) {
+        SetupTriangles(occluder);
+        for (const auto& triangle : _triangles[occluder])
+            RasterizeScalar(triangle, triangle.MinY, triangle.MaxY, _depth.data());
+        _statistics.RasterizedTriangles += static_cast<uint32_t>(_triangles[occluder].size());
+    }
+    UpdateTiles(0, TilesY);
+}
+
+auto BeOcclusionBuffer::IsVisible(const glm::vec3& center, const glm::vec3& extent) -> bool {
+    const auto box = ProjectBox(_projectionView, center, extent);
+    if (!box) return true;
+    ++_statistics.TestedBoxes;
+
+    for (int32_t tileY = box->MinY / int32_t(TileSize); tileY <= box->MaxY / int32_t(TileSize); ++tileY) {
+        for (int32_t tileX = box->MinX / int32_t(TileSize); tileX <= box->MaxX / int32_t(TileSize); ++tileX) {
+            const uint32_t tile = tileY * TilesX + tileX;
+            if (_tileMin[tile] > box->Nearest) continue;   // every pixel holds something nearer
+            if (_tileMax[tile] <= box->Nearest) return true;
+            const int32_t firstY = std::max(box->MinY, tileY * int32_t(TileSize));
+            const int32_t lastY = std::min(box->MaxY, tileY * int32_t(TileSize) + int32_t(TileSize) - 1);
+            const int32_t firstX = std::max(box->MinX, tileX * int32_t(TileSize));
+            const int32_t lastX = std::min(box->MaxX, tileX * int32_t(TileSize) + int32_t(TileSize) - 1);
+            for (int32_t y = firstY; y <= lastY; ++y)
+                for (int32_t x = firstX; x <= lastX; ++x)
+                    if (_depth[size_t(y) * Width + x] <= box->Nearest) return true;
+        }
+    }
+    ++_statistics.OccludedBoxes;
+    return false;
+}
+
+auto BeOcclusionBuffer::IsVisibleReference(const glm::vec3& center, const glm::vec3& extent) const -> bool {
+    const auto box = ProjectBox(_projectionView, center, extent);
+    if (!box) return true;
+    for (int32_t y = box->MinY; y <= box->MaxY; ++y)
+        for (int32_t x = box->MinX; x <= box->MaxX; ++x)
+            if (_depth[size_t(y) * Width + x] <= box->Nearest) return true;
+    return false;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeOcclusionBuffer::SetupTriangles(const uint32_t occluderIndex) -> void {
+    const BeOccluder& occluder = _occluders[occluderIndex];
+    auto& triangles = _triangles[occluderIndex];
+    triangles.clear();
+    const glm::mat4 transform = _projectionView * occluder.World;
+    std::array<glm::vec4, MaxClippedVertices> polygon;
+    for (size_t i = 0; i + 2 < occluder.Indices.size(); i += 3) {
+        const glm::vec4 a = transform * glm::vec4(occluder.Vertices[occluder.Indices[i + 0]], 1.0f);
+        const glm::vec4 b = transform * glm::vec4(occluder.Vertices[occluder.Indices[i + 1]], 1.0f);
+        const glm::vec4 c = transform * glm::vec4(occluder.Vertices[occluder.Indices[i + 2]], 1.0f);
+        const uint32_t vertexCount = ClipTriangle(a, b, c, polygon);
+        if (vertexCount == 0) continue;
+        const glm::vec3 first = ToScreen(polygon[0]);
+        glm::vec3 previous = ToScreen(polygon[1]);
+        for (uint32_t v = 2; v < vertexCount; ++v) {
+            const glm::vec3 next = ToScreen(polygon[v]);
+            if (const auto triangle = MakeTriangle(first, previous, next))
+                triangles.push_back(*triangle);
+            previous = next;
+        }
+    }
+}
+
+auto BeOcclusionBuffer::RasterizeBand(const uint32_t band, const BeInstructionSet instructionSet) -> void {
+    const int32_t bandFirstRow = int32_t(band * BandHeight);
+    const int32_t bandLastRow = bandFirstRow + int32_t(BandHeight) - 1;
+    const auto rasterize =
+        std::min(instructionSet, BePixelKernels::GetSupportedInstructionSet()) == BeInstructionSet::AVX2 ? RasterizeAVX2 :
+        std::min(instructionSet, BePixelKernels::GetSupportedInstructionSet()) == BeInstructionSet::SSE2 ? RasterizeSSE2 :
+        RasterizeScalar;
+    for (uint32_t occluder = 0; occluder < _occluders.size(); ++occluder) {
+        for (const auto& triangle : _triangles[occluder]) {
+            const int32_t firstRow = std::max(triangle.MinY, bandFirstRow);
+            const int32_t lastRow = std::min(triangle.MaxY, bandLastRow);
+            if (firstRow <= lastRow)
+                rasterize(triangle, firstRow, lastRow, _depth.data());
+        }
+    }
+}
+
+auto BeOcclusionBuffer::UpdateTiles(const uint32_t firstTileRow, const uint32_t tileRowCount) -> void {
+    for (uint32_t tileY = firstTileRow; tileY < firstTileRow + tileRowCount; ++tileY) {
+        for (uint32_t tileX = 0; tileX < TilesX; ++tileX) {
+            float minimum = std::numeric_limits<float>::max();
+            float maximum = 0.0f;
+            for (uint32_t y = tileY * TileSize; y < (tileY + 1) * TileSize; ++y) {
+                const float* row = _depth.data() + size_t(y) * Width + tileX * TileSize;
+                for (uint32_t x = 0; x < TileSize; ++x) {
+                    minimum = std::min(minimum, row[x]);
+                    maximum = std::max(maximum, row[x]);
+                }
+            }
+            _tileMin[tileY * TilesX + tileX] = minimum;
+            _tileMax[tileY * TilesX + tileX] = maximum;
+        }
+    }
+}
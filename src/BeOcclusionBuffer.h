@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm.hpp>
+
+#include "BeModel.h"
+#include "BePixelKernels.h"
+
+// Low resolution depth buffer the CPU rasterizes selected occluders into, so object boxes hidden behind them can be
+// dropped before anything is drawn. Depth is stored as 1/w, which is linear across the screen and needs no depth
+// range convention: larger is nearer, 0 is empty. Triangles are set up per occluder and rasterized in bands of rows,
+// both on the shared thread pool, the inner loop covering 4 or 8 pixels per step on the BePixelKernels instruction
+// set. Every 8x8 tile keeps the min and max of its depths, so most box tests never touch single pixels.
+class BeOcclusionBuffer {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    using BeInstructionSet = BePixelKernels::BeInstructionSet;
+
+    static constexpr uint32_t Width = 256;
+    static constexpr uint32_t Height = 128;
+    static constexpr uint32_t TileSize = 8;
+    static constexpr uint32_t TilesX = Width / TileSize;
+    static constexpr uint32_t TilesY = Height / TileSize;
+    static constexpr uint32_t BandHeight = 16;   // rows one rasterization job owns
+
+    // occluder meshes keep this share of the model's triangles, at most MaxOccluderTriangles of them
+    static constexpr float OccluderRatio = 0.1f;
+    static constexpr uint32_t MaxOccluderTriangles = 512;
+    // simplification error an occluder may have, relative to the model's bounding radius; an occluder must not
+    // grow far past the surface it stands in for
+    static constexpr float OccluderMaxRelativeError = 0.01f;
+
+    // Edge functions and depth as planes a * x + b * y + c over pixel centres, all three edges >= 0 inside.
+    struct BeTriangle {
+        glm::vec3 EdgeA, EdgeB, EdgeC;
+        glm::vec3 Depth;
+        int32_t MinX, MinY, MaxX, MaxY;   // pixels whose centres the bounding box holds
+    };
+
+    struct BeStatistics {
+        uint32_t Occluders = 0;
+        uint32_t OccluderTriangles = 0;
+        uint32_t RasterizedTriangles = 0;   // after near plane clipping and dropping those between pixel centres
+        uint32_t TestedBoxes = 0;
+        uint32_t OccludedBoxes = 0;
+    };
+
+    // Welds the model's positions, placed by its nodes, and simplifies every slice together into model.OccluderVertices
+    // and model.OccluderIndices. Leaves them empty when the result would still be too detailed to be worth rasterizing.
+    // Reads model.Bounds, so it runs after ComputeBounds.
+    static auto GenerateOccluder(BeModel& model) -> void;
+
+private:
+    struct BeOccluder {
+        std::span<const glm::vec3> Vertices;
+        std::span<const uint32_t> Indices;
+        glm::mat4 World;
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    glm::mat4 _projectionView {1.0f};
+    std::vector<BeOccluder> _occluders;
+    std::vector<std::vector<BeTriangle>> _triangles;   // per occluder, reused between frames
+    std::vector<float> _depth;
+    std::array<float, TilesX * TilesY> _tileMin {};
+    std::array<float, TilesX * TilesY> _tileMax {};
+    BeStatistics _statistics;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeOcclusionBuffer();
+    ~BeOcclusionBuffer() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Clears the buffer and the occluder list for a new view.
+    auto Begin(const glm::mat4& projectionView) -> void;
+    // The mesh is read during Rasterize, it has to stay alive until then.
+    auto AddOccluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices, const glm::mat4& world) -> void;
+    auto Rasterize(bool parallel = true) -> void;
+    auto Rasterize(bool parallel, BeInstructionSet instructionSet) -> void;
+    // Single threaded and scalar, every triangle over its whole bounding box. The same arithmetic as Rasterize, so
+    // both fill identical buffers.
+    auto RasterizeReference() -> void;
+
+    // Whether any part of a world space box may be seen past the occluders. Boxes crossing the near plane are
+    // always visible.
+    [[nodiscard]] auto IsVisible(const glm::vec3& center, const glm::vec3& extent) -> bool;
+    // Every pixel under the box, without the tile min and max.
+    [[nodiscard]] auto IsVisibleReference(const glm::vec3& center, const glm::vec3& extent) const -> bool;
+
+    [[nodiscard]] auto GetDepth() const -> std::span<const float> { return _depth; }
+    [[nodiscard]] auto GetStatistics() const -> const BeStatistics& { return _statistics; }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto SetupTriangles(uint32_t occluderIndex) -> void;
+    auto RasterizeBand(uint32_t band, BeInstructionSet instructionSet) -> void;
+    auto UpdateTiles(uint32_t firstTileRow, uint32_t tileRowCount) -> void;
+};
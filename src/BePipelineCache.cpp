@@ -0,0 +1,90 @@
+﻿#include "BePipelineCache.h"
+
+#include <bit>
+#include <utility>
+
+#include "BeModelCache.h"
+#include "BeShader.h"
+#include "Utils.h"
+
+//static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BePipelineCache::MakeKey(const BePipelineDescriptor& descriptor) -> std::vector<uint32_t> {
+    std::vector<uint32_t> key;
+    auto add = [&key](const auto... values) { (key.push_back(static_cast<uint32_t>(values)), ...); };
+    auto addPointer = [&add](const void* pointer) {
+        const auto bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+        add(bits & 0xFFFFFFFF, bits >> 32);
+    };
+
+    const BeShader* vertexShader = descriptor.VertexShader;
+    const BeShader* pixelShader = descriptor.PixelShader;
+    addPointer(vertexShader ? vertexShader->ComputedInputLayout.Get() : nullptr);
+    addPointer(vertexShader ? vertexShader->VertexShader.Get() : nullptr);
+    addPointer(pixelShader ? pixelShader->PixelShader.Get() : nullptr);
+    add(descriptor.Topology, descriptor.StencilReference);
+
+    const D3D11_BLEND_DESC& blend = descriptor.Blend;
+    add(blend.AlphaToCoverageEnable, blend.IndependentBlendEnable);
+    for (uint32_t i = 0; i < (blend.IndependentBlendEnable ? 8u : 1u); ++i) {
+        const D3D11_RENDER_TARGET_BLEND_DESC& target = blend.RenderTarget[i];
+        add(target.BlendEnable, target.SrcBlend, target.DestBlend, target.BlendOp,
+            target.SrcBlendAlpha, target.DestBlendAlpha, target.BlendOpAlpha, target.RenderTargetWriteMask);
+    }
+
+    const D3D11_DEPTH_STENCIL_DESC& depth = descriptor.DepthStencil;
+    add(depth.DepthEnable, depth.DepthWriteMask, depth.DepthFunc, depth.StencilEnable);
+    if (depth.StencilEnable) {
+        add(depth.StencilReadMask, depth.StencilWriteMask);
+        for (const D3D11_DEPTH_STENCILOP_DESC& face : {depth.FrontFace, depth.BackFace})
+            add(face.StencilFailOp, face.StencilDepthFailOp, face.StencilPassOp, face.StencilFunc);
+    }
+
+    const D3D11_RASTERIZER_DESC& rasterizer = descriptor.Rasterizer;
+    add(rasterizer.FillMode, rasterizer.CullMode, rasterizer.FrontCounterClockwise, rasterizer.DepthBias,
+        std::bit_cast<uint32_t>(rasterizer.DepthBiasClamp), std::bit_cast<uint32_t>(rasterizer.SlopeScaledDepthBias),
+        rasterizer.DepthClipEnable, rasterizer.ScissorEnable, rasterizer.MultisampleEnable, rasterizer.AntialiasedLineEnable);
+    return key;
+}
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BePipelineCache::BePipelineCache(ComPtr<ID3D11Device> device) : _device(std::move(device)) {}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BePipelineCache::Get(const BePipelineDescriptor& descriptor) -> const BePipelineState* {
+    std::vector<uint32_t> key = MakeKey(descriptor);
+    const uint64_t hash = BeModelCache::HashBytes(reinterpret_cast<const uint8_t*>(key.data()), key.size() * sizeof(uint32_t));
+    auto& bucket = _pipelines[hash];
+    for (const BeEntry& entry : bucket)
+        if (entry.Key == key)
+            return entry.State.get();
+
+    // D3D11 hands out the same state object for equal descriptions, pipelines differing in their shaders share them
+    BeEntry entry {.Key = std::move(key)};
+    if (descriptor.VertexShader) {
+        entry.InputLayout = descriptor.VertexShader->ComputedInputLayout;
+        entry.VertexShader = descriptor.VertexShader->VertexShader;
+    }
+    if (descriptor.PixelShader)
+        entry.PixelShader = descriptor.PixelShader->PixelShader;
+    Utils::Check
+    << _device->CreateBlendState(&descriptor.Blend, entry.BlendState.GetAddressOf())
+    << _device->CreateDepthStencilState(&descriptor.DepthStencil, entry.DepthStencilState.GetAddressOf())
+    << _device->CreateRasterizerState(&descriptor.Rasterizer, entry.RasterizerState.GetAddressOf());
+
+    entry.State = std::make_unique<BePipelineState>(BePipelineState {
+        .InputLayout = entry.InputLayout.Get(),
+        .VertexShader = entry.VertexShader.Get(),
+        .PixelShader = entry.PixelShader.Get(),
+        .BlendState = entry.BlendState.Get(),
+        .DepthStencilState = entry.DepthStencilState.Get(),
+        .RasterizerState = entry.RasterizerState.Get(),
+        .Topology = static_cast<uint32_t>(descriptor.Topology),
+        .StencilReference = descriptor.StencilReference,
+        .Hash = hash,
+    });
+    ++_pipelineCount;
+    return bucket.emplace_back(std::move(entry)).State.get();
+}
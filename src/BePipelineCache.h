@@ -0,0 +1,110 @@
+﻿#pragma once
+#include <cstdint>
+#include <d3d11.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <wrl/client.h>
+
+#include "BePipelineState.h"
+
+class BeShader;
+using Microsoft::WRL::ComPtr;
+
+// Hash-conses pipeline states: a description is hashed over its shaders and every state field that takes effect,
+// equal descriptions get the pipeline made for the first one. Passes look their pipelines up once in Initialise.
+class BePipelineCache {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    // the states D3D11 uses when nothing is bound
+    static constexpr D3D11_BLEND_DESC DefaultBlend = {
+        .AlphaToCoverageEnable = false,
+        .IndependentBlendEnable = false,
+        .RenderTarget = {{
+            .BlendEnable = false,
+            .SrcBlend = D3D11_BLEND_ONE,
+            .DestBlend = D3D11_BLEND_ZERO,
+            .BlendOp = D3D11_BLEND_OP_ADD,
+            .SrcBlendAlpha = D3D11_BLEND_ONE,
+            .DestBlendAlpha = D3D11_BLEND_ZERO,
+            .BlendOpAlpha = D3D11_BLEND_OP_ADD,
+            .RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL,
+        }},
+    };
+    static constexpr D3D11_DEPTH_STENCIL_DESC DefaultDepthStencil = {
+        .DepthEnable = true,
+        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL,
+        .DepthFunc = D3D11_COMPARISON_LESS,
+        .StencilEnable = false,
+        .StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK,
+        .StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK,
+        .FrontFace = {D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS},
+        .BackFace = {D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS},
+    };
+    // fullscreen passes draw without a depth target
+    static constexpr D3D11_DEPTH_STENCIL_DESC DisabledDepthStencil = {
+        .DepthEnable = false,
+        .DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO,
+        .DepthFunc = D3D11_COMPARISON_LESS,
+        .StencilEnable = false,
+        .StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK,
+        .StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK,
+        .FrontFace = {D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS},
+        .BackFace = {D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS},
+    };
+    static constexpr D3D11_RASTERIZER_DESC DefaultRasterizer = {
+        .FillMode = D3D11_FILL_SOLID,
+        .CullMode = D3D11_CULL_BACK,
+        .FrontCounterClockwise = false,
+        .DepthBias = 0,
+        .DepthBiasClamp = 0.0f,
+        .SlopeScaledDepthBias = 0.0f,
+        .DepthClipEnable = true,
+        .ScissorEnable = false,
+        .MultisampleEnable = false,
+        .AntialiasedLineEnable = false,
+    };
+
+    struct BePipelineDescriptor {
+        const BeShader* VertexShader = nullptr;   // brings its input layout along
+        const BeShader* PixelShader = nullptr;
+        D3D11_BLEND_DESC Blend = DefaultBlend;
+        D3D11_DEPTH_STENCIL_DESC DepthStencil = DefaultDepthStencil;
+        D3D11_RASTERIZER_DESC Rasterizer = DefaultRasterizer;
+        D3D11_PRIMITIVE_TOPOLOGY Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        uint32_t StencilReference = 0;
+    };
+
+private:
+    struct BeEntry {
+        std::vector<uint32_t> Key;
+        std::unique_ptr<BePipelineState> State;
+        // hold the objects the state points to, shaders included
+        ComPtr<ID3D11InputLayout> InputLayout;
+        ComPtr<ID3D11VertexShader> VertexShader;
+        ComPtr<ID3D11PixelShader> PixelShader;
+        ComPtr<ID3D11BlendState> BlendState;
+        ComPtr<ID3D11DepthStencilState> DepthStencilState;
+        ComPtr<ID3D11RasterizerState> RasterizerState;
+    };
+
+    // The words a description is compared by: object pointers, then the fields of every state in declaration
+    // order, skipping blend targets 1-7 without independent blending and stencil fields without stencil.
+    [[nodiscard]] static auto MakeKey(const BePipelineDescriptor& descriptor) -> std::vector<uint32_t>;
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ComPtr<ID3D11Device> _device;
+    std::unordered_map<uint64_t, std::vector<BeEntry>> _pipelines;
+    uint32_t _pipelineCount = 0;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BePipelineCache(ComPtr<ID3D11Device> device);
+    ~BePipelineCache() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // The pipeline for the description, created on first use. Stays valid for the lifetime of the cache.
+    [[nodiscard]] auto Get(const BePipelineDescriptor& descriptor) -> const BePipelineState*;
+
+    [[nodiscard]] auto GetPipelineCount() const -> uint32_t { return _pipelineCount; }
+};
@@ -0,0 +1,19 @@
+﻿#pragma once
+#include <cstdint>
+
+#include "BeDeviceContext.h"
+
+// Everything a draw binds besides its resources, bound as one through BeStateTracker::SetPipeline. Pipelines come
+// from BePipelineCache, which makes one per distinct description and keeps its objects alive, so equal state is
+// always the same pointer and a pipeline never changes once handed out.
+struct BePipelineState {
+    ID3D11InputLayout* InputLayout = nullptr;
+    ID3D11VertexShader* VertexShader = nullptr;
+    ID3D11PixelShader* PixelShader = nullptr;
+    ID3D11BlendState* BlendState = nullptr;
+    ID3D11DepthStencilState* DepthStencilState = nullptr;
+    ID3D11RasterizerState* RasterizerState = nullptr;
+    uint32_t Topology = 0;
+    uint32_t StencilReference = 0;
+    uint64_t Hash = 0;
+};
@@ -0,0 +1,510 @@
+﻿#include "BePixelKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace {
+    using BeInstructionSet = BePixelKernels::BeInstructionSet;
+
+    struct BeKernelTable {
+        void (*SwizzleRow)(const uint8_t* src, uint8_t* dst, uint32_t width);
+        void (*ExpandRow)(const uint8_t* src, uint32_t channels, uint8_t* dst, uint32_t width);
+        void (*SwapRows)(uint8_t* a, uint8_t* b, size_t size);
+        void (*Premultiply)(uint8_t* pixels, size_t pixelCount);
+        void (*DownsampleRow)(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, uint32_t srcWidth, uint32_t dstWidth);
+    };
+
+    struct BeLinear12Tables {
+        uint16_t SRGBToLinear[256];
+        uint16_t UnormToLinear[256];
+        uint8_t LinearToSRGB[4096];
+        uint8_t LinearToUnorm[4096];
+    };
+
+    auto Linear12Tables() -> const BeLinear12Tables& {
+        static const BeLinear12Tables tables = [] {
+            BeLinear12Tables result{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                const float encoded = float(i) / 255.0f;
+                const float linear = encoded <= 0.04045f ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+                result.SRGBToLinear[i] = static_cast<uint16_t>(std::lround(linear * 4095.0f));
+                result.UnormToLinear[i] = static_cast<uint16_t>((i * 4095 + 127) / 255);
+            }
+            for (uint32_t i = 0; i < 4096; ++i) {
+                const float linear = float(i) / 4095.0f;
+                const float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+                result.LinearToSRGB[i] = static_cast<uint8_t>(std::lround(encoded * 255.0f));
+                result.LinearToUnorm[i] = static_cast<uint8_t>((i * 255 + 2047) / 4095);
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    //scalar/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    auto SwizzleRowScalar(const uint8_t* src, uint8_t* dst, const uint32_t width) -> void {
+        for (uint32_t x = 0; x < width; ++x) {
+            dst[4 * x + 0] = src[4 * x + 2];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = src[4 * x + 0];
+            dst[4 * x + 3] = src[4 * x + 3];
+        }
+    }
+
+    auto ExpandRowScalar(const uint8_t* src, const uint32_t channels, uint8_t* dst, const uint32_t width) -> void {
+        switch (channels) {
+            case 1:
+                for (uint32_t x = 0; x < width; ++x) {
+                    dst[4 * x + 0] = dst[4 * x + 1] = dst[4 * x + 2] = src[x];
+                    dst[4 * x + 3] = 255;
+                }
+                break;
+            case 2:
+                for (uint32_t x = 0; x < width; ++x) {
+                    dst[4 * x + 0] = dst[4 * x + 1] = dst[4 * x + 2] = src[2 * x];
+                    dst[4 * x + 3] = src[2 * x + 1];
+                }
+                break;
+            case 3:
+                for (uint32_t x = 0; x < width; ++x) {
+                    dst[4 * x + 0] = src[3 * x + 0];
+                    dst[4 * x + 1] = src[3 * x + 1];
+                    dst[4 * x + 2] = src[3 * x + 2];
+                    dst[4 * x + 3] = 255;
+                }
+                break;
+            default:
+                memcpy(dst, src, size_t(width) * 4);
+                break;
+        }
+    }
+
+    auto SwapRowsScalar(uint8_t* a, uint8_t* b, const size_t size) -> void {
+        std::swap_ranges(a, a + size, b);
+    }
+
+    auto PremultiplyScalar(uint8_t* pixels, const size_t pixelCount) -> void {
+        for (size_t i = 0; i < pixelCount; ++i) {
+            const uint32_t alpha = pixels[4 * i + 3];
+            for (size_t c = 0; c < 3; ++c) {
+                const uint32_t product = pixels[4 * i + c] * alpha + 128;
+                pixels[4 * i + c] = static_cast<uint8_t>((product + (product >> 8)) >> 8);
+            }
+        }
+    }
+
+    auto DownsampleRowScalar(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, const uint32_t srcWidth, const uint32_t dstWidth) -> void {
+        for (uint32_t x = 0; x < dstWidth; ++x) {
+            const uint32_t x0 = 2 * x;
+            const uint32_t x1 = std::min(2 * x + 1, srcWidth - 1);
+            for (uint32_t c = 0; c < 4; ++c)
+                dst[4 * x + c] = static_cast<uint16_t>((row0[4 * x0 + c] + row0[4 * x1 + c] + row1[4 * x0 + c] + row1[4 * x1 + c] + 2) >> 2);
+        }
+    }
+
+    //sse2///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    auto SwizzleRowSSE2(const uint8_t* src, uint8_t* dst, const uint32_t width) -> void {
+        // no byte shuffle in SSE2: swap R and B with shifts inside each 32 bit pixel
+        const __m128i redBlueMask = _mm_set1_epi32(0x00FF00FF);
+        uint32_t x = 0;
+        for (; x + 4 <= width; x += 4) {
+            const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+            const __m128i redBlue = _mm_and_si128(pixels, redBlueMask);
+            const __m128i greenAlpha = _mm_andnot_si128(redBlueMask, pixels);
+            const __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_or_si128(greenAlpha, swapped));
+        }
+        SwizzleRowScalar(src + 4 * x, dst + 4 * x, width - x);
+    }
+
+    auto ExpandRowSSE2(const uint8_t* src, const uint32_t channels, uint8_t* dst, const uint32_t width) -> void {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        uint32_t x = 0;
+        switch (channels) {
+            case 1: {
+                // grey bytes unpacked with themselves twice give GGGG, then alpha is forced to 255
+                for (; x + 16 <= width; x += 16) {
+                    const __m128i grey = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+                    const __m128i grey16Low = _mm_unpacklo_epi8(grey, grey);
+                    const __m128i grey16High = _mm_unpackhi_epi8(grey, grey);
+                    auto out = reinterpret_cast<__m128i*>(dst + 4 * x);
+                    _mm_storeu_si128(out + 0, _mm_or_si128(_mm_unpacklo_epi16(grey16Low, grey16Low), alpha));
+                    _mm_storeu_si128(out + 1, _mm_or_si128(_mm_unpackhi_epi16(grey16Low, grey16Low), alpha));
+                    _mm_storeu_si128(out + 2, _mm_or_si128(_mm_unpacklo_epi16(grey16High, grey16High), alpha));
+                    _mm_storeu_si128(out + 3, _mm_or_si128(_mm_unpackhi_epi16(grey16High, grey16High), alpha));
+                }
+                break;
+            }
+            case 2: {
+                // each 16 bit lane holds one GA pixel: GG from the masked grey, interleaved with GA gives GGGA
+                const __m128i greyMask = _mm_set1_epi16(0x00FF);
+                for (; x + 8 <= width; x += 8) {
+                    const __m128i greyAlpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x));
+                    const __m128i grey = _mm_and_si128(greyAlpha, greyMask);
+                    const __m128i greyGrey = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+                    auto out = reinterpret_cast<__m128i*>(dst + 4 * x);
+                    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(greyGrey, greyAlpha));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(greyGrey, greyAlpha));
+                }
+                break;
+            }
+            case 3: {
+                // no byte shuffle: byte shifts move each pixel to the bottom, the low dwords are gathered with
+                // unpacks and alpha overwrites the byte that belonged to the next pixel. Each load reads 16 bytes
+                // for 12 used ones, stop while a full load still fits in the row
+                for (; x + 6 <= width; x += 4) {
+                    const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x));
+                    const __m128i first = _mm_unpacklo_epi32(rgb, _mm_srli_si128(rgb, 3));
+                    const __m128i second = _mm_unpacklo_epi32(_mm_srli_si128(rgb, 6), _mm_srli_si128(rgb, 9));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_or_si128(_mm_unpacklo_epi64(first, second), alpha));
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        ExpandRowScalar(src + channels * x, channels, dst + 4 * x, width - x);
+    }
+
+    auto SwapRowsSSE2(uint8_t* a, uint8_t* b, const size_t size) -> void {
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            const __m128i rowA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            const __m128i rowB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), rowB);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), rowA);
+        }
+        SwapRowsScalar(a + i, b + i, size - i);
+    }
+
+    auto Divide255SSE2(const __m128i product) -> __m128i {
+        const __m128i rounded = _mm_add_epi16(product, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(rounded, _mm_srli_epi16(rounded, 8)), 8);
+    }
+
+    auto PremultiplySSE2(uint8_t* pixels, const size_t pixelCount) -> void {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        size_t i = 0;
+        for (; i + 4 <= pixelCount; i += 4) {
+            const auto address = reinterpret_cast<__m128i*>(pixels + 4 * i);
+            const __m128i source = _mm_loadu_si128(address);
+            const __m128i low = _mm_unpacklo_epi8(source, zero);
+            const __m128i high = _mm_unpackhi_epi8(source, zero);
+            const __m128i alphaLow = _mm_shufflehi_epi16(_mm_shufflelo_epi16(low, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i alphaHigh = _mm_shufflehi_epi16(_mm_shufflelo_epi16(high, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m128i product = _mm_packus_epi16(
+                Divide255SSE2(_mm_mullo_epi16(low, alphaLow)),
+                Divide255SSE2(_mm_mullo_epi16(high, alphaHigh)));
+            _mm_storeu_si128(address, _mm_or_si128(_mm_andnot_si128(alphaMask, product), _mm_and_si128(source, alphaMask)));
+        }
+        PremultiplyScalar(pixels + 4 * i, pixelCount - i);
+    }
+
+    auto DownsampleRowSSE2(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, const uint32_t srcWidth, const uint32_t dstWidth) -> void {
+        // a pixel is 64 bit, so each load holds a horizontal pair; 4 * 4095 + 2 still fits in 16 bit
+        uint32_t x = 0;
+        if (srcWidth >= 2) {
+            for (; x + 2 <= dstWidth; x += 2) {
+                const __m128i firstPair = _mm_add_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x)));
+                const __m128i secondPair = _mm_add_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 8)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 8)));
+                const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(firstPair, secondPair), _mm_unpackhi_epi64(firstPair, secondPair));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2));
+            }
+        }
+        DownsampleRowScalar(row0 + 8 * x, row1 + 8 * x, dst + 4 * x, srcWidth - 2 * x, dstWidth - x);
+    }
+
+    //avx2///////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    BE_TARGET_AVX2 auto SwizzleRowAVX2(const uint8_t* src, uint8_t* dst, const uint32_t width) -> void {
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        uint32_t x = 0;
+        for (; x + 8 <= width; x += 8) {
+            const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x), _mm256_shuffle_epi8(pixels, shuffle));
+        }
+        SwizzleRowSSE2(src + 4 * x, dst + 4 * x, width - x);
+    }
+
+    BE_TARGET_AVX2 auto ExpandRowAVX2(const uint8_t* src, const uint32_t channels, uint8_t* dst, const uint32_t width) -> void {
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        uint32_t x = 0;
+        switch (channels) {
+            case 2: {
+                const __m128i shuffle = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+                for (; x + 4 <= width; x += 4) {
+                    const __m128i greyAlpha = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 2 * x));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_shuffle_epi8(greyAlpha, shuffle));
+                }
+                break;
+            }
+            case 3: {
+                // each load reads 16 bytes for 12 used ones, stop while a full load still fits in the row
+                const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+                for (; x + 6 <= width; x += 4) {
+                    const __m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+                }
+                break;
+            }
+            default:
+                ExpandRowSSE2(src, channels, dst, width);
+                return;
+        }
+        ExpandRowScalar(src + channels * x, channels, dst + 4 * x, width - x);
+    }
+
+    BE_TARGET_AVX2 auto SwapRowsAVX2(uint8_t* a, uint8_t* b, const size_t size) -> void {
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            const __m256i rowA = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            const __m256i rowB = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), rowB);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + i), rowA);
+        }
+        SwapRowsSSE2(a + i, b + i, size - i);
+    }
+
+    BE_TARGET_AVX2 auto Divide255AVX2(const __m256i product) -> __m256i {
+        const __m256i rounded = _mm256_add_epi16(product, _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(rounded, _mm256_srli_epi16(rounded, 8)), 8);
+    }
+
+    BE_TARGET_AVX2 auto PremultiplyAVX2(uint8_t* pixels, const size_t pixelCount) -> void {
+        // unpack and pack both work per 128 bit lane, so the pixel order survives without a permute
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+        size_t i = 0;
+        for (; i + 8 <= pixelCount; i += 8) {
+            const auto address = reinterpret_cast<__m256i*>(pixels + 4 * i);
+            const __m256i source = _mm256_loadu_si256(address);
+            const __m256i low = _mm256_unpacklo_epi8(source, zero);
+            const __m256i high = _mm256_unpackhi_epi8(source, zero);
+            const __m256i alphaLow = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(low, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m256i alphaHigh = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(high, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            const __m256i product = _mm256_packus_epi16(
+                Divide255AVX2(_mm256_mullo_epi16(low, alphaLow)),
+                Divide255AVX2(_mm256_mullo_epi16(high, alphaHigh)));
+            _mm256_storeu_si256(address, _mm256_or_si256(_mm256_andnot_si256(alphaMask, product), _mm256_and_si256(source, alphaMask)));
+        }
+        PremultiplySSE2(pixels + 4 * i, pixelCount - i);
+    }
+
+    BE_TARGET_AVX2 auto DownsampleRowAVX2(const uint16_t* row0, const uint16_t* row1, uint16_t* dst, const uint32_t srcWidth, const uint32_t dstWidth) -> void {
+        // unpack works per lane, so the four results come out as 0 2 1 3 and get permuted back
+        uint32_t x = 0;
+        if (srcWidth >= 2) {
+            for (; x + 4 <= dstWidth; x += 4) {
+                const __m256i firstQuad = _mm256_add_epi16(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 8 * x)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 8 * x)));
+                const __m256i secondQuad = _mm256_add_epi16(
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 8 * x + 16)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 8 * x + 16)));
+                const __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(firstQuad, secondQuad), _mm256_unpackhi_epi64(firstQuad, secondQuad));
+                const __m256i average = _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x), _mm256_permute4x64_epi64(average, _MM_SHUFFLE(3, 1, 2, 0)));
+            }
+        }
+        DownsampleRowSSE2(row0 + 8 * x, row1 + 8 * x, dst + 4 * x, srcWidth - 2 * x, dstWidth - x);
+    }
+
+    //dispatch///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    constexpr BeKernelTable KernelTables[] = {
+        {SwizzleRowScalar, ExpandRowScalar, SwapRowsScalar, PremultiplyScalar, DownsampleRowScalar},
+        {SwizzleRowSSE2, ExpandRowSSE2, SwapRowsSSE2, PremultiplySSE2, DownsampleRowSSE2},
+        {SwizzleRowAVX2, ExpandRowAVX2, SwapRowsAVX2, PremultiplyAVX2, DownsampleRowAVX2},
+    };
+
+    // cpuid and the XCR0 register are the only compiler specific part of the dispatch
+    auto ReadCpuid(const uint32_t leaf, uint32_t (&registers)[4]) -> void {
+#if defined(_MSC_VER)
+        int info[4] = {};
+        __cpuidex(info, static_cast<int>(leaf), 0);
+        for (int i = 0; i < 4; ++i) registers[i] = static_cast<uint32_t>(info[i]);
+#else
+        __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+    }
+
+    auto ReadXCR0() -> uint64_t {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        uint32_t low = 0, high = 0;
+        __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+        return (uint64_t(high) << 32) | low;
+#endif
+    }
+
+    auto DetectInstructionSet() -> BeInstructionSet {
+        // SSE2 is part of x64, AVX2 also needs the OS to save the YMM registers
+        uint32_t info[4] = {};
+        ReadCpuid(0, info);
+        const uint32_t maxLeaf = info[0];
+
+        ReadCpuid(1, info);
+        const bool osxsave = (info[2] & (1u << 27)) != 0;
+        const bool avx = (info[2] & (1u << 28)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7) {
+            ReadCpuid(7, info);
+            avx2 = (info[1] & (1u << 5)) != 0;
+        }
+
+        if (avx2 && avx && osxsave && (ReadXCR0() & 0x6) == 0x6)
+            return BeInstructionSet::AVX2;
+        return BeInstructionSet::SSE2;
+    }
+
+    auto SupportedInstructionSet() -> BeInstructionSet {
+        static const BeInstructionSet supported = DetectInstructionSet();
+        return supported;
+    }
+
+    std::atomic<BeInstructionSet> activeInstructionSet = SupportedInstructionSet();
+
+    auto Kernels() -> const BeKernelTable& {
+        return KernelTables[static_cast<size_t>(activeInstructionSet.load(std::memory_order_relaxed))];
+    }
+}
+
+auto BePixelKernels::GetSupportedInstructionSet() -> BeInstructionSet {
+    return SupportedInstructionSet();
+}
+
+auto BePixelKernels::GetInstructionSet() -> BeInstructionSet {
+    return activeInstructionSet.load(std::memory_order_relaxed);
+}
+
+auto BePixelKernels::GetInstructionSetName(const BeInstructionSet instructionSet) -> const char* {
+    switch (instructionSet) {
+        case BeInstructionSet::Scalar: return "Scalar";
+        case BeInstructionSet::SSE2: return "SSE2";
+        case BeInstructionSet::AVX2: return "AVX2";
+    }
+    return "Unknown";
+}
+
+auto BePixelKernels::SetInstructionSet(const BeInstructionSet instructionSet) -> void {
+    activeInstructionSet.store(std::min(instructionSet, SupportedInstructionSet()), std::memory_order_relaxed);
+}
+
+auto BePixelKernels::SwizzleBGRAToRGBA(
+    const uint8_t* src,
+    uint8_t* dst,
+    const uint32_t width,
+    const uint32_t height,
+    const bool flipVertically)
+-> void {
+    const auto& kernels = Kernels();
+    const size_t rowSize = size_t(width) * 4;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t srcY = flipVertically ? height - 1 - y : y;
+        kernels.SwizzleRow(src + srcY * rowSize, dst + y * rowSize, width);
+    }
+}
+
+auto BePixelKernels::ExpandToRGBA(
+    const uint8_t* src,
+    const uint32_t channels,
+    uint8_t* dst,
+    const uint32_t width,
+    const uint32_t height,
+    const bool flipVertically)
+-> void {
+    const auto& kernels = Kernels();
+    const size_t srcRowSize = size_t(width) * channels;
+    const size_t dstRowSize = size_t(width) * 4;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t srcY = flipVertically ? height - 1 - y : y;
+        kernels.ExpandRow(src + srcY * srcRowSize, channels, dst + y * dstRowSize, width);
+    }
+}
+
+auto BePixelKernels::FlipVertically(uint8_t* pixels, const uint32_t width, const uint32_t height) -> void {
+    const auto& kernels = Kernels();
+    const size_t rowSize = size_t(width) * 4;
+    for (uint32_t y = 0; y < height / 2; ++y)
+        kernels.SwapRows(pixels + y * rowSize, pixels + (height - 1 - y) * rowSize, rowSize);
+}
+
+auto BePixelKernels::Premultiply(uint8_t* pixels, const size_t pixelCount) -> void {
+    Kernels().Premultiply(pixels, pixelCount);
+}
+
+auto BePixelKernels::DecodeToLinear12(const uint8_t* src, uint16_t* dst, const size_t pixelCount, const bool srgb) -> void {
+    // table lookups, the same on every instruction set
+    const auto& tables = Linear12Tables();
+    const uint16_t* colorTable = srgb ? tables.SRGBToLinear : tables.UnormToLinear;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        dst[4 * i + 0] = colorTable[src[4 * i + 0]];
+        dst[4 * i + 1] = colorTable[src[4 * i + 1]];
+        dst[4 * i + 2] = colorTable[src[4 * i + 2]];
+        dst[4 * i + 3] = tables.UnormToLinear[src[4 * i + 3]];
+    }
+}
+
+auto BePixelKernels::EncodeFromLinear12(
+    const uint16_t* src,
+    uint8_t* dst,
+    const size_t pixelCount,
+    const bool srgb,
+    const float alphaScale)
+-> void {
+    const auto& tables = Linear12Tables();
+    const uint8_t* colorTable = srgb ? tables.LinearToSRGB : tables.LinearToUnorm;
+    const bool scaleAlpha = alphaScale != 1.0f;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        dst[4 * i + 0] = colorTable[src[4 * i + 0]];
+        dst[4 * i + 1] = colorTable[src[4 * i + 1]];
+        dst[4 * i + 2] = colorTable[src[4 * i + 2]];
+        uint32_t alpha = src[4 * i + 3];
+        if (scaleAlpha)
+            alpha = std::min(4095u, static_cast<uint32_t>(float(alpha) * alphaScale + 0.5f));
+        dst[4 * i + 3] = tables.LinearToUnorm[alpha];
+    }
+}
+
+auto BePixelKernels::Downsample2x2(
+    const uint16_t* src,
+    const uint32_t srcWidth,
+    const uint32_t srcHeight,
+    uint16_t* dst,
+    const uint32_t rowBegin,
+    const uint32_t rowEnd)
+-> void {
+    const auto& kernels = Kernels();
+    const uint32_t dstWidth = std::max(1u, srcWidth / 2);
+    const size_t srcRowSize = size_t(srcWidth) * 4;
+    const size_t dstRowSize = size_t(dstWidth) * 4;
+    for (uint32_t y = rowBegin; y < rowEnd; ++y) {
+        const uint16_t* row0 = src + std::min(2 * y, srcHeight - 1) * srcRowSize;
+        const uint16_t* row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcRowSize;
+        kernels.DownsampleRow(row0, row1, dst + y * dstRowSize, srcWidth, dstWidth);
+    }
+}
+
+auto BePixelKernels::Linear12ToUnorm8(const uint16_t value) -> uint8_t {
+    return Linear12Tables().LinearToUnorm[std::min<uint16_t>(value, 4095)];
+}
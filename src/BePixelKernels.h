@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// AVX2 kernels sit next to their SSE2 fallbacks and only run after GetSupportedInstructionSet reported AVX2. MSVC
+// compiles the intrinsics anywhere, GCC and Clang need the instruction set enabled per function.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define BE_TARGET_AVX2
+#else
+#define BE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Pixel conversion kernels for the texture import path. Every kernel has a scalar, an SSE2 and an AVX2 version;
+// the widest one the CPU supports is picked at runtime on first use. All pixels are 8 bit per channel.
+namespace BePixelKernels {
+
+    enum class BeInstructionSet : uint8_t {
+        Scalar,
+        SSE2,
+        AVX2,
+    };
+
+    [[nodiscard]] auto GetSupportedInstructionSet() -> BeInstructionSet;
+    [[nodiscard]] auto GetInstructionSet() -> BeInstructionSet;
+    [[nodiscard]] auto GetInstructionSetName(BeInstructionSet instructionSet) -> const char*;
+    // Forces a narrower path, e.g. to compare them. Requests above what the CPU supports are clamped.
+    auto SetInstructionSet(BeInstructionSet instructionSet) -> void;
+
+    // BGRA -> RGBA into a separate buffer, optionally writing the rows bottom-up in the same pass.
+    auto SwizzleBGRAToRGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, bool flipVertically) -> void;
+    // 1 (grey), 2 (grey, alpha), 3 (RGB) or 4 channel pixels -> RGBA, optionally flipped in the same pass.
+    auto ExpandToRGBA(const uint8_t* src, uint32_t channels, uint8_t* dst, uint32_t width, uint32_t height, bool flipVertically) -> void;
+    // RGBA rows swapped in place, without a temporary row.
+    auto FlipVertically(uint8_t* pixels, uint32_t width, uint32_t height) -> void;
+    // RGB *= A / 255, rounded.
+    auto Premultiply(uint8_t* pixels, size_t pixelCount) -> void;
+
+    // Mip generation works on 12 bit linear pixels, four uint16 per pixel in 0..4095. With srgb the colour channels
+    // go through the sRGB curve so filtering happens in linear light, alpha is always stored linearly.
+    auto DecodeToLinear12(const uint8_t* src, uint16_t* dst, size_t pixelCount, bool srgb) -> void;
+    // alphaScale multiplies alpha before it is rounded back to 8 bit, see BeTexture::GenerateMips.
+    auto EncodeFromLinear12(const uint16_t* src, uint8_t* dst, size_t pixelCount, bool srgb, float alphaScale = 1.0f) -> void;
+    // 2x2 box filter into rows [rowBegin, rowEnd) of the next level, which is max(1, w / 2) x max(1, h / 2).
+    // Odd source sizes clamp the second tap to the last row or column.
+    auto Downsample2x2(const uint16_t* src, uint32_t srcWidth, uint32_t srcHeight, uint16_t* dst, uint32_t rowBegin, uint32_t rowEnd) -> void;
+    [[nodiscard]] auto Linear12ToUnorm8(uint16_t value) -> uint8_t;
+}
@@ -0,0 +1,212 @@
+﻿#include "BeRenderGraph.h"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+//static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeRenderGraph::GetBytesPerPixel(const BeFormat format) -> uint32_t {
+    switch (format) {
+    case BeFormat::RGBA32Float: return 16;
+    case BeFormat::RGBA16Float:
+    case BeFormat::RG32Float: return 8;
+    case BeFormat::RGBA8Unorm:
+    case BeFormat::RGBA8UnormSrgb:
+    case BeFormat::RGB10A2Unorm:
+    case BeFormat::R11G11B10Float:
+    case BeFormat::RG16Float:
+    case BeFormat::R32Float:
+    case BeFormat::Depth24Stencil8:
+    case BeFormat::Depth32: return 4;
+    case BeFormat::R16Float:
+    case BeFormat::R16Unorm:
+    case BeFormat::Depth16: return 2;
+    }
+    throw std::runtime_error(std::format("Render graph does not know the size of format {}", static_cast<uint32_t>(format)));
+}
+
+auto BeRenderGraph::IsDepthFormat(const BeFormat format) -> bool {
+    return format == BeFormat::Depth16 || format == BeFormat::Depth24Stencil8 || format == BeFormat::Depth32;
+}
+
+auto BeRenderGraph::GetByteSize(const BeResourceDescriptor& descriptor) -> uint64_t {
+    return uint64_t(descriptor.Width) * descriptor.Height * GetBytesPerPixel(descriptor.Format);
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeRenderGraph::AddResource(const std::string& name, const BeResourceDescriptor& descriptor) -> uint32_t {
+    if (_resourceIndices.contains(name))
+        throw std::runtime_error(std::format("Render graph resource {} is added twice", name));
+    const auto index = static_cast<uint32_t>(_resources.size());
+    _resources.push_back({.Name = name, .Descriptor = descriptor});
+    _resourceIndices.emplace(name, index);
+    return index;
+}
+
+auto BeRenderGraph::ImportResource(const std::string& name) -> uint32_t {
+    const uint32_t index = AddResource(name, {});
+    _resources[index].Imported = true;
+    return index;
+}
+
+auto BeRenderGraph::AddPass(const std::string& name, const BePassResources& resources) -> uint32_t {
+    BePass pass {.Name = name, .Reads = {}, .Writes = {}};
+    for (const auto& read : resources.Reads) pass.Reads.push_back(FindResource(read));
+    for (const auto& write : resources.Writes) pass.Writes.push_back(FindResource(write));
+    _passes.push_back(std::move(pass));
+    return static_cast<uint32_t>(_passes.size() - 1);
+}
+
+auto BeRenderGraph::Compile() -> void {
+    CullPasses();
+    OrderPasses();
+    AssignPhysicalResources();
+}
+
+auto BeRenderGraph::Clear() -> void {
+    _resources.clear();
+    _resourceIndices.clear();
+    _passes.clear();
+    _order.clear();
+    _physicalResources.clear();
+}
+
+auto BeRenderGraph::GetTransientBytes() const -> uint64_t {
+    uint64_t bytes = 0;
+    for (const auto& resource : _resources)
+        if (!resource.Imported) bytes += GetByteSize(resource.Descriptor);
+    return bytes;
+}
+
+auto BeRenderGraph::GetPhysicalBytes() const -> uint64_t {
+    uint64_t bytes = 0;
+    for (const auto& descriptor : _physicalResources)
+        bytes += GetByteSize(descriptor);
+    return bytes;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeRenderGraph::FindResource(const std::string& name) const -> uint32_t {
+    const auto found = _resourceIndices.find(name);
+    if (found == _resourceIndices.end())
+        throw std::runtime_error(std::format("Render graph has no resource {}", name));
+    return found->second;
+}
+
+auto BeRenderGraph::CullPasses() -> void {
+    // walk back from the passes writing imported resources through the writers of everything they read
+    std::vector<std::vector<uint32_t>> writers(_resources.size());
+    std::vector<uint32_t> stack;
+    for (uint32_t p = 0; p < _passes.size(); ++p) {
+        auto& pass = _passes[p];
+        for (const uint32_t write : pass.Writes) writers[write].push_back(p);
+        pass.Culled = std::ranges::none_of(pass.Writes, [&](const uint32_t write) { return _resources[write].Imported; });
+        if (!pass.Culled) stack.push_back(p);
+    }
+    while (!stack.empty()) {
+        const uint32_t p = stack.back();
+        stack.pop_back();
+        for (const uint32_t read : _passes[p].Reads) {
+            for (const uint32_t writer : writers[read]) {
+                if (!_passes[writer].Culled) continue;
+                _passes[writer].Culled = false;
+                stack.push_back(writer);
+            }
+        }
+    }
+}
+
+auto BeRenderGraph::OrderPasses() -> void {
+    std::vector<std::vector<uint32_t>> writers(_resources.size());
+    std::vector<std::vector<uint32_t>> readers(_resources.size());
+    for (uint32_t p = 0; p < _passes.size(); ++p) {
+        if (_passes[p].Culled) continue;
+        for (const uint32_t write : _passes[p].Writes) writers[write].push_back(p);
+        for (const uint32_t read : _passes[p].Reads) readers[read].push_back(p);
+    }
+
+    // writers chained in the order they were added, a pass that also reads what it writes counts as a writer
+    std::vector<std::vector<uint32_t>> successors(_passes.size());
+    std::vector<uint32_t> predecessorCounts(_passes.size(), 0);
+    auto addEdge = [&](const uint32_t from, const uint32_t to) {
+        successors[from].push_back(to);
+        ++predecessorCounts[to];
+    };
+    for (uint32_t r = 0; r < _resources.size(); ++r) {
+        for (uint32_t w = 1; w < writers[r].size(); ++w)
+            addEdge(writers[r][w - 1], writers[r][w]);
+        if (writers[r].empty()) continue;
+        for (const uint32_t reader : readers[r])
+            if (std::ranges::find(writers[r], reader) == writers[r].end())
+                addEdge(writers[r].back(), reader);
+    }
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+    uint32_t keptCount = 0;
+    for (uint32_t p = 0; p < _passes.size(); ++p) {
+        if (_passes[p].Culled) continue;
+        ++keptCount;
+        if (predecessorCounts[p] == 0) ready.push(p);
+    }
+    _order.clear();
+    while (!ready.empty()) {
+        const uint32_t p = ready.top();
+        ready.pop();
+        _order.push_back(p);
+        for (const uint32_t successor : successors[p])
+            if (--predecessorCounts[successor] == 0) ready.push(successor);
+    }
+    if (_order.size() != keptCount) {
+        std::string cycle;
+        for (uint32_t p = 0; p < _passes.size(); ++p)
+            if (!_passes[p].Culled && predecessorCounts[p] > 0) cycle += (cycle.empty() ? "" : ", ") + _passes[p].Name;
+        throw std::runtime_error(std::format("Render graph passes depend on each other in a cycle: {}", cycle));
+    }
+}
+
+auto BeRenderGraph::AssignPhysicalResources() -> void {
+    for (auto& resource : _resources) {
+        resource.FirstUse = UINT32_MAX;
+        resource.LastUse = 0;
+        resource.Physical = NoPhysical;
+    }
+    for (uint32_t position = 0; position < _order.size(); ++position) {
+        const BePass& pass = _passes[_order[position]];
+        for (const auto& accesses : {std::cref(pass.Reads), std::cref(pass.Writes)}) {
+            for (const uint32_t r : accesses.get()) {
+                _resources[r].FirstUse = std::min(_resources[r].FirstUse, position);
+                _resources[r].LastUse = std::max(_resources[r].LastUse, position);
+            }
+        }
+    }
+
+    // In order of first use, each transient resource moves into the texture whose last user finished longest ago
+    // among those with its descriptor, or gets a new one
+    std::vector<uint32_t> transients;
+    for (uint32_t r = 0; r < _resources.size(); ++r)
+        if (!_resources[r].Imported && _resources[r].FirstUse != UINT32_MAX) transients.push_back(r);
+    std::ranges::sort(transients, {}, [&](const uint32_t r) { return std::pair(_resources[r].FirstUse, r); });
+
+    _physicalResources.clear();
+    std::vector<uint32_t> physicalLastUses;
+    for (const uint32_t r : transients) {
+        auto& resource = _resources[r];
+        uint32_t best = NoPhysical;
+        for (uint32_t t = 0; t < _physicalResources.size(); ++t) {
+            if (physicalLastUses[t] >= resource.FirstUse || !(_physicalResources[t] == resource.Descriptor)) continue;
+            if (best == NoPhysical || physicalLastUses[t] < physicalLastUses[best]) best = t;
+        }
+        if (best == NoPhysical) {
+            best = static_cast<uint32_t>(_physicalResources.size());
+            _physicalResources.push_back(resource.Descriptor);
+            physicalLastUses.push_back(0);
+        }
+        resource.Physical = best;
+        physicalLastUses[best] = resource.LastUse;
+    }
+}
@@ -0,0 +1,111 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Orders render passes by the resources they read and write, drops the ones nothing visible depends on and lets
+// transient targets share one texture when their lifetimes do not overlap. Compiling yields the pass order and, per
+// transient resource, the physical texture it lives in; the renderer creates those textures from the graph's own
+// descriptors.
+// Imported resources live outside the graph (the back buffer, targets made up front): the graph never allocates or
+// aliases them, and passes writing one are always kept.
+class BeRenderGraph {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t NoPhysical = UINT32_MAX;
+
+    // Formats transient targets use. Depth formats are bound as depth stencil, the others as render targets, and
+    // every target is also read as a shader resource.
+    enum class BeFormat : uint8_t {
+        RGBA8Unorm,
+        RGBA8UnormSrgb,
+        RGB10A2Unorm,
+        R11G11B10Float,
+        RG16Float,
+        RGBA16Float,
+        R16Float,
+        R16Unorm,
+        R32Float,
+        RG32Float,
+        RGBA32Float,
+        Depth16,
+        Depth24Stencil8,
+        Depth32,
+    };
+
+    // Resources share a texture only when their descriptors are equal.
+    struct BeResourceDescriptor {
+        BeFormat Format = BeFormat::RGBA8Unorm;
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+
+        auto operator==(const BeResourceDescriptor&) const -> bool = default;
+    };
+
+    struct BePassResources {
+        std::vector<std::string> Reads;
+        std::vector<std::string> Writes;
+    };
+
+    struct BeResource {
+        std::string Name;
+        BeResourceDescriptor Descriptor;
+        bool Imported = false;
+        // positions in the pass order of the first and last pass using it, only while Physical is set
+        uint32_t FirstUse = UINT32_MAX;
+        uint32_t LastUse = 0;
+        uint32_t Physical = NoPhysical;   // none for imported resources and ones no kept pass uses
+    };
+
+    struct BePass {
+        std::string Name;
+        std::vector<uint32_t> Reads;
+        std::vector<uint32_t> Writes;
+        bool Culled = false;
+    };
+
+    [[nodiscard]] static auto GetBytesPerPixel(BeFormat format) -> uint32_t;
+    [[nodiscard]] static auto IsDepthFormat(BeFormat format) -> bool;
+    [[nodiscard]] static auto GetByteSize(const BeResourceDescriptor& descriptor) -> uint64_t;
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<BeResource> _resources;
+    std::unordered_map<std::string, uint32_t> _resourceIndices;
+    std::vector<BePass> _passes;
+    std::vector<uint32_t> _order;   // kept passes in execution order
+    std::vector<BeResourceDescriptor> _physicalResources;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeRenderGraph() = default;
+    ~BeRenderGraph() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Descriptors carry their final size. Names are unique across transient and imported resources.
+    auto AddResource(const std::string& name, const BeResourceDescriptor& descriptor) -> uint32_t;
+    auto ImportResource(const std::string& name) -> uint32_t;
+    // Throws for names that are not resources of the graph.
+    auto AddPass(const std::string& name, const BePassResources& resources) -> uint32_t;
+
+    // Every writer of a resource runs before its readers, writers of one resource in the order they were added, ties
+    // go to the pass added first. Throws when the passes depend on each other in a cycle.
+    auto Compile() -> void;
+    auto Clear() -> void;
+
+    [[nodiscard]] auto GetOrder() const -> const std::vector<uint32_t>& { return _order; }
+    [[nodiscard]] auto GetPasses() const -> const std::vector<BePass>& { return _passes; }
+    [[nodiscard]] auto GetResources() const -> const std::vector<BeResource>& { return _resources; }
+    [[nodiscard]] auto GetPhysicalResources() const -> const std::vector<BeResourceDescriptor>& { return _physicalResources; }
+    // transient resources as if each had its own texture, and the textures the compiled graph needs
+    [[nodiscard]] auto GetTransientBytes() const -> uint64_t;
+    [[nodiscard]] auto GetPhysicalBytes() const -> uint64_t;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    [[nodiscard]] auto FindResource(const std::string& name) const -> uint32_t;
+    auto CullPasses() -> void;
+    auto OrderPasses() -> void;
+    auto AssignPhysicalResources() -> void;
+};
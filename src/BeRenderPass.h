@@ -1,9 +1,14 @@
 ﻿#pragma once
 #include <wrl/client.h>
 
+#include "BeHandleRegistry.h"
+#include "BeRenderGraph.h"
+
 using Microsoft::WRL::ComPtr;
 
+class BeDeviceContext;
 class BeRenderer;
+class BeStateTracker;
 
 class BeRenderPass {
 protected:
@@ -16,6 +21,11 @@ public:
         _renderer = renderer;
     }
 
+    // the render resources the pass reads and writes, by name; the render graph orders and culls passes by them
+    virtual auto GetResources() const -> BeRenderGraph::BePassResources = 0;
+    // resolves the handles of the resources the pass uses, Render only goes through those
     virtual auto Initialise() -> void = 0;
-    virtual auto Render() -> void = 0;
+    // Records the pass into context, usually a command list recorded on a thread of its own while other passes record
+    // theirs. The viewport and the uniform buffer are bound, nothing else: every binding goes through stateTracker.
+    virtual auto Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void = 0;
 };
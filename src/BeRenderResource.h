@@ -14,6 +14,8 @@ public:
         uint32_t Width = 0;
         uint32_t Height = 0;
         uint32_t BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+        auto operator==(const BeResourceDescriptor&) const -> bool = default;
     };
     
     //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,12 +1,50 @@
 ﻿#include "BeRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+#include <typeinfo>
+
 #include "BeRenderPass.h"
 #include "BeShader.h"
+#include "BeThreadPool.h"
 #include "Utils.h"
 
+namespace {
+    // the texture a render graph target becomes, typeless for depth so it can be read as well
+    auto ToRenderResourceDescriptor(const BeRenderGraph::BeResourceDescriptor& descriptor) -> BeRenderResource::BeResourceDescriptor {
+        using BeFormat = BeRenderGraph::BeFormat;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        switch (descriptor.Format) {
+        case BeFormat::RGBA8Unorm: format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+        case BeFormat::RGBA8UnormSrgb: format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB; break;
+        case BeFormat::RGB10A2Unorm: format = DXGI_FORMAT_R10G10B10A2_UNORM; break;
+        case BeFormat::R11G11B10Float: format = DXGI_FORMAT_R11G11B10_FLOAT; break;
+        case BeFormat::RG16Float: format = DXGI_FORMAT_R16G16_FLOAT; break;
+        case BeFormat::RGBA16Float: format = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+        case BeFormat::R16Float: format = DXGI_FORMAT_R16_FLOAT; break;
+        case BeFormat::R16Unorm: format = DXGI_FORMAT_R16_UNORM; break;
+        case BeFormat::R32Float: format = DXGI_FORMAT_R32_FLOAT; break;
+        case BeFormat::RG32Float: format = DXGI_FORMAT_R32G32_FLOAT; break;
+        case BeFormat::RGBA32Float: format = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
+        case BeFormat::Depth16: format = DXGI_FORMAT_R16_TYPELESS; break;
+        case BeFormat::Depth24Stencil8: format = DXGI_FORMAT_R24G8_TYPELESS; break;
+        case BeFormat::Depth32: format = DXGI_FORMAT_R32_TYPELESS; break;
+        }
+        const uint32_t binding = BeRenderGraph::IsDepthFormat(descriptor.Format) ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET;
+        return {.Format = format, .Width = descriptor.Width, .Height = descriptor.Height, .BindFlags = binding | D3D11_BIND_SHADER_RESOURCE};
+    }
+}
+
 BeRenderer::BeRenderer(const HWND windowHandle, const uint32_t width, const uint32_t height) {
     _windowHandle = windowHandle;
     _width = width;
     _height = height;
+    _renderWidth = width;
+    _renderHeight = height;
 }
 
 auto BeRenderer::LaunchDevice() -> void {
@@ -30,6 +68,8 @@ auto BeRenderer::LaunchDevice() -> void {
         nullptr,
         &_context
     );
+    _deviceContext = std::make_unique<BeD3D11DeviceContext>(_context);
+    _pipelineCache = std::make_unique<BePipelineCache>(_device);
 
     
     // DXGI interfaces
@@ -77,12 +117,23 @@ auto BeRenderer::LaunchDevice() -> void {
     samplerDesc.MinLOD = 0;
     samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
     Utils::Check << _device->CreateSamplerState(&samplerDesc, &_pointSampler);
+    samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    Utils::Check << _device->CreateSamplerState(&samplerDesc, &_linearSampler);
+
+    const D3D11_QUERY_DESC disjointDesc = {.Query = D3D11_QUERY_TIMESTAMP_DISJOINT};
+    const D3D11_QUERY_DESC timestampDesc = {.Query = D3D11_QUERY_TIMESTAMP};
+    for (auto& timer : _frameTimers) {
+        Utils::Check
+        << _device->CreateQuery(&disjointDesc, &timer.Disjoint)
+        << _device->CreateQuery(&timestampDesc, &timer.Start)
+        << _device->CreateQuery(&timestampDesc, &timer.End);
+    }
 
     _fullscreenShader = std::make_unique<BeShader>(
         _device.Get(),
         "assets/shaders/fullscreen",
         BeShaderType::Vertex,
-        std::vector<BeVertexElementDescriptor>{}
+        BeVertexLayout{}
     );
 }
 
@@ -92,46 +143,116 @@ auto BeRenderer::AddRenderPass(BeRenderPass* renderPass) -> void {
 }
 
 auto BeRenderer::InitialisePasses() -> void {
-    for (const auto& pass : _passes)
+    // targets created up front and the back buffer are imported, passes writing them are what the graph keeps
+    _renderGraph.ImportResource(BackbufferName);
+    for (const auto& name : _createdResourceNames)
+        _renderGraph.ImportResource(name);
+    for (uint32_t i = 0; i < _passes.size(); ++i)
+        _renderGraph.AddPass(std::format("{} {}", i, typeid(*_passes[i]).name()), _passes[i]->GetResources());
+    _renderGraph.Compile();
+
+    const auto& physicalResources = _renderGraph.GetPhysicalResources();
+    std::vector<std::string> physicalNames(physicalResources.size());
+    for (const auto& resource : _renderGraph.GetResources())
+        if (resource.Physical != BeRenderGraph::NoPhysical)
+            physicalNames[resource.Physical] += (physicalNames[resource.Physical].empty() ? "" : "|") + resource.Name;
+    std::vector<BeRenderResource> textures;
+    for (uint32_t t = 0; t < physicalResources.size(); ++t) {
+        auto& texture = textures.emplace_back(physicalNames[t], ToRenderResourceDescriptor(physicalResources[t]));
+        texture.CreateGPUResources(_device);
+    }
+    // every declared name gets its own entry, sharing the views of its texture
+    uint32_t declaredCount = 0;
+    for (const auto& resource : _renderGraph.GetResources())
+        if (resource.Physical != BeRenderGraph::NoPhysical) {
+            _renderResources.Add(resource.Name, textures[resource.Physical]);
+            ++declaredCount;
+        }
+
+    _passOrder.clear();
+    _passesAtWindowSize.clear();
+    for (const uint32_t p : _renderGraph.GetOrder()) {
+        _passOrder.push_back(_passes[p]);
+        const auto writes = _passes[p]->GetResources().Writes;
+        _passesAtWindowSize.push_back(std::ranges::find(writes, BackbufferName) != writes.end());
+    }
+    _passRecordings.clear();
+    for (const auto& pass : _passOrder) {
         pass->Initialise();
+        _passRecordings.push_back(std::make_unique<BePassRecording>());
+    }
+
+    std::cout << std::format("Render graph: {} of {} passes kept, {} targets in {} textures, {:.1f} MB instead of {:.1f} MB\n",
+        _passOrder.size(), _passes.size(), declaredCount, textures.size(),
+        double(_renderGraph.GetPhysicalBytes()) / (1024.0 * 1024.0), double(_renderGraph.GetTransientBytes()) / (1024.0 * 1024.0));
 }
 
 auto BeRenderer::Render() -> void {
-    // Set viewport
-    D3D11_VIEWPORT viewport;
-    viewport.TopLeftX = 0;
-    viewport.TopLeftY = 0;
-    viewport.Width = static_cast<FLOAT>(_width);
-    viewport.Height = static_cast<FLOAT>(_height);
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    _context->RSSetViewports(1, &viewport);
+    const BeFrameTimer& timer = _frameTimers[_frameIndex % FrameTimerCount];
+    _context->Begin(timer.Disjoint.Get());
+    _context->End(timer.Start.Get());
 
+    const float renderScale = std::clamp(RenderScale, 0.01f, 1.0f);
+    _renderWidth = std::max(static_cast<uint32_t>(std::lround(float(_width) * renderScale)), 1u);
+    _renderHeight = std::max(static_cast<uint32_t>(std::lround(float(_height) * renderScale)), 1u);
+    UniformData.TargetSize = {float(_width), float(_height)};
+    UniformData.RenderScale = {float(_renderWidth) / float(_width), float(_renderHeight) / float(_height)};
     
     // Update uniform constant buffer
     const UniformBufferGPU uniformDataGpu(UniformData);
-    D3D11_MAPPED_SUBRESOURCE uniformMappedResource;
-    Utils::Check << _context->Map(_uniformBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &uniformMappedResource);
-    memcpy(uniformMappedResource.pData, &uniformDataGpu, sizeof(UniformBufferGPU));
-    _context->Unmap(_uniformBuffer.Get(), 0);
-    _context->VSSetConstantBuffers(0, 1, _uniformBuffer.GetAddressOf());
-    _context->PSSetConstantBuffers(0, 1, _uniformBuffer.GetAddressOf());
-
-    for (const auto& pass : _passes)
-        pass->Render();
-    
-    ID3D11Buffer* emptyBuffers[1] = { nullptr };
-    _context->VSSetConstantBuffers(1, 1, emptyBuffers);
-    _context->PSSetConstantBuffers(1, 1, emptyBuffers);
+    _deviceContext->UpdateBuffer(_uniformBuffer.Get(), 0, &uniformDataGpu, sizeof(UniformBufferGPU), true);
+
+    // Every pass records its list on the pool at once, then the lists are replayed in graph order. A list leaves
+    // nothing bound, so the flip model swap chain unbinding the back buffer in Present goes unnoticed.
+    BeThreadPool::Shared().ParallelFor(static_cast<uint32_t>(_passOrder.size()), [this](const uint32_t i) {
+        BePassRecording& recording = *_passRecordings[i];
+        recording.Commands.Reset();
+        recording.Tracker.Reset();
+        recording.Tracker.ResetStatistics();
+        if (_passesAtWindowSize[i]) recording.Commands.SetViewport(_width, _height);
+        else recording.Commands.SetViewport(_renderWidth, _renderHeight);
+        recording.Tracker.SetVSConstantBuffer(0, _uniformBuffer.Get());
+        recording.Tracker.SetPSConstantBuffer(0, _uniformBuffer.Get());
+        _passOrder[i]->Render(recording.Commands, recording.Tracker);
+    });
+    BindStatistics = {};
+    for (const auto& recording : _passRecordings) {
+        _deviceContext->ExecuteCommandList(recording->Commands);
+        BindStatistics.Requested += recording->Tracker.GetStatistics().Requested;
+        BindStatistics.Issued += recording->Tracker.GetStatistics().Issued;
+    }
+
+    _context->End(timer.End.Get());
+    _context->End(timer.Disjoint.Get());
+    ++_frameIndex;
+    ReadFrameTimer();
     
+    const auto presentStart = std::chrono::steady_clock::now();
     _swapchain->Present(1, 0);
+    const std::chrono::duration<float, std::milli> present = std::chrono::steady_clock::now() - presentStart;
+    PresentMilliseconds = present.count();
+}
+
+auto BeRenderer::PrintFrameStatistics() const -> void {
+    std::cout << std::format("Bindings: {} of {} requested binding calls reached the context, {} pipelines\n",
+        BindStatistics.Issued, BindStatistics.Requested, _pipelineCache->GetPipelineCount());
+    std::cout << std::format("Resolution: {}x{} of {}x{}, {:.2f} ms on the GPU\n",
+        _renderWidth, _renderHeight, _width, _height, GpuFrameMilliseconds);
+    uint32_t commandCount = 0;
+    size_t commandBytes = 0;
+    for (const auto& recording : _passRecordings) {
+        commandCount += recording->Commands.GetCommandCount();
+        commandBytes += recording->Commands.GetByteSize();
+    }
+    std::cout << std::format("Command lists: {} passes recorded {} commands, {:.1f} KB\n",
+        _passRecordings.size(), commandCount, double(commandBytes) / 1024.0);
 }
 
 auto BeRenderer::CreateRenderResource(
     const std::string& name,
     const bool useWindowSize,
     const BeRenderResource::BeResourceDescriptor& desc)
--> BeRenderResource* {
+-> BeHandle {
 
     BeRenderResource::BeResourceDescriptor descCopy = desc;
     if (useWindowSize) {
@@ -139,18 +260,54 @@ auto BeRenderer::CreateRenderResource(
         descCopy.Height = _height;
     }
     
-    const auto resource = std::make_unique<BeRenderResource>(name, descCopy);
-    resource->CreateGPUResources(_device);
-    BeRenderResource* resourcePtr = resource.get();
-    _renderResources.emplace(name, std::move(*resource));
-    return resourcePtr;
+    const BeHandle handle = _renderResources.Add(name, name, descCopy);
+    _renderResources.Get(handle)->CreateGPUResources(_device);
+    _createdResourceNames.push_back(name);
+    return handle;
+}
+
+auto BeRenderer::DeclareRenderResource(
+    const std::string& name,
+    const bool useWindowSize,
+    const BeRenderGraph::BeResourceDescriptor& desc)
+-> void {
+
+    BeRenderGraph::BeResourceDescriptor descCopy = desc;
+    if (useWindowSize) {
+        descCopy.Width = _width;
+        descCopy.Height = _height;
+    }
+    _renderGraph.AddResource(name, descCopy);
+}
+
+auto BeRenderer::FindRenderResource(const BeName name) const -> BeHandle {
+    const BeHandle handle = _renderResources.Find(name);
+    if (!handle.IsValid())
+        throw std::runtime_error(std::format("No render resource named {:016x}, declare it before InitialisePasses", name.Hash));
+    return handle;
 }
 
-auto BeRenderer::GetRenderResource(const std::string& name) -> BeRenderResource* {
-    return &_renderResources.at(name);
+auto BeRenderer::ReadFrameTimer() -> void {
+    GpuFrameMilliseconds = 0.0f;
+    if (_frameIndex < FrameTimerCount) return;
+
+    // the frame about to reuse its queries next, the oldest in flight; still pending means its time is lost
+    const BeFrameTimer& timer = _frameTimers[_frameIndex % FrameTimerCount];
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    uint64_t start, end;
+    if (_context->GetData(timer.Disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return;
+    if (_context->GetData(timer.Start.Get(), &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return;
+    if (_context->GetData(timer.End.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return;
+    if (disjoint.Disjoint || end < start) return;
+    GpuFrameMilliseconds = static_cast<float>(double(end - start) * 1000.0 / double(disjoint.Frequency));
 }
 
 auto BeRenderer::TerminateRenderer() -> void {
+    _renderResources.Clear();
+    _frameTimers = {};
+    _pipelineCache.reset();
+    _passRecordings.clear();
+    _deviceContext.reset();
     _backbufferTarget.Reset();
     _swapchain.Reset();
     _factory.Reset();
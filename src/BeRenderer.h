@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <array>
 #include <d3d11.h>
 #include <dxgi1_2.h>
 #include <vector>
@@ -9,8 +10,14 @@
 
 #include "BeModel.h"
 #include "BeBuffers.h"
+#include "BeCommandList.h"
+#include "BeD3D11DeviceContext.h"
+#include "BeHandleRegistry.h"
+#include "BePipelineCache.h"
+#include "BeRenderGraph.h"
 #include "BeRenderResource.h"
 #include "BeShader.h"
+#include "BeStateTracker.h"
 
 class BeRenderPass;
 class BeShader;
@@ -19,12 +26,27 @@ using Microsoft::WRL::ComPtr;
 
 class BeRenderer {
 
+public:
+    // the resource passes write to present, imported into the render graph
+    static inline const std::string BackbufferName = "Backbuffer";
+    // frames of GPU timestamps in flight, a frame's time is read back when its queries are about to be reused
+    static constexpr uint32_t FrameTimerCount = 3;
+
 public:
     explicit BeRenderer(HWND windowHandle, uint32_t width, uint32_t height);
     ~BeRenderer() = default;
 
 public:
     UniformData UniformData;
+    // binding calls the passes made in the last frame, and how many of them reached the context
+    BeStateTracker::BeBindStatistics BindStatistics;
+    // Share of the window size, in (0, 1], that passes before the ones writing the back buffer render at. Targets
+    // keep their size, only their top left part is rendered; the composer upscales it to the window.
+    float RenderScale = 1.0f;
+    // GPU time of the newest frame whose timestamps arrived during the last Render, 0 when none did
+    float GpuFrameMilliseconds = 0.0f;
+    // CPU time the last Render spent blocked in Present, waiting for vsync or a free back buffer
+    float PresentMilliseconds = 0.0f;
 
 private:
     // window
@@ -41,32 +63,83 @@ private:
     ComPtr<IDXGISwapChain1> _swapchain;
     ComPtr<ID3D11RenderTargetView> _backbufferTarget;
 
+    // passes record into command lists, replayed here in order; they never touch the context itself
+    std::unique_ptr<BeD3D11DeviceContext> _deviceContext;
+    std::unique_ptr<BePipelineCache> _pipelineCache;
+
     ComPtr<ID3D11Buffer> _uniformBuffer;
     ComPtr<ID3D11SamplerState> _pointSampler;
+    ComPtr<ID3D11SamplerState> _linearSampler;
     std::unique_ptr<BeShader> _fullscreenShader = nullptr;
     
-    std::unordered_map<std::string, BeRenderResource> _renderResources;
+    // targets created up front and, from InitialisePasses on, the declared ones; declared targets sharing a texture
+    // hold the same views
+    BeHandleRegistry<BeRenderResource> _renderResources;
+    std::vector<std::string> _createdResourceNames;
     std::vector<BeRenderPass*> _passes;
 
+    // declared targets and the passes, compiled in InitialisePasses
+    BeRenderGraph _renderGraph;
+    std::vector<BeRenderPass*> _passOrder;
+    std::vector<uint8_t> _passesAtWindowSize;   // per _passOrder entry, the ones writing the back buffer
+    // per _passOrder entry, the list the pass records into on a thread of the pool and the tracker in front of it
+    struct BePassRecording {
+        BeCommandList Commands;
+        BeStateTracker Tracker {Commands};
+    };
+    std::vector<std::unique_ptr<BePassRecording>> _passRecordings;
+
+    uint32_t _renderWidth;
+    uint32_t _renderHeight;
+    struct BeFrameTimer {
+        ComPtr<ID3D11Query> Disjoint;
+        ComPtr<ID3D11Query> Start;
+        ComPtr<ID3D11Query> End;
+    };
+    std::array<BeFrameTimer, FrameTimerCount> _frameTimers;
+    uint64_t _frameIndex = 0;
+
 public:
     [[nodiscard]] auto GetDevice() const -> ComPtr<ID3D11Device> { return _device; }
     [[nodiscard]] auto GetContext() const -> ComPtr<ID3D11DeviceContext> { return _context; }
     [[nodiscard]] auto GetPointSampler() const -> ComPtr<ID3D11SamplerState> { return _pointSampler; }
-    [[nodiscard]] auto GetFullscreenVertexShader() const -> ComPtr<ID3D11VertexShader> { return _fullscreenShader->VertexShader; }
+    [[nodiscard]] auto GetLinearSampler() const -> ComPtr<ID3D11SamplerState> { return _linearSampler; }
+    // bound to slot 0 of both stages before a pass renders, lists a pass records itself have to bind it again
+    [[nodiscard]] auto GetUniformBuffer() const -> ComPtr<ID3D11Buffer> { return _uniformBuffer; }
+    // pixels rendered this frame at the render scale, from the top left of every target
+    [[nodiscard]] auto GetRenderWidth() const -> uint32_t { return _renderWidth; }
+    [[nodiscard]] auto GetRenderHeight() const -> uint32_t { return _renderHeight; }
+    [[nodiscard]] auto GetFullscreenShader() const -> const BeShader* { return _fullscreenShader.get(); }
+    [[nodiscard]] auto GetPipelineCache() const -> BePipelineCache& { return *_pipelineCache; }
     [[nodiscard]] auto GetBackbufferTarget() const -> ComPtr<ID3D11RenderTargetView> { return _backbufferTarget; }
     
     auto LaunchDevice () -> void;
     auto AddRenderPass(BeRenderPass* renderPass) -> void;
+    // Compiles the render graph of the added passes, creates the declared targets and initialises the passes that
+    // are kept, in the order they will render.
     auto InitialisePasses() -> void;
     auto Render() -> void;
+    auto PrintFrameStatistics() const -> void;
 
     auto CreateRenderResource(
         const std::string& name,
         const bool useWindowSize,
         const BeRenderResource::BeResourceDescriptor& desc
-    ) -> BeRenderResource*;
-    auto GetRenderResource(const std::string& name) -> BeRenderResource*;
+    ) -> BeHandle;
+    // A render target the graph creates in InitialisePasses. It may share its texture with targets whose passes are
+    // all done before it is first written, its contents do not survive the frame.
+    auto DeclareRenderResource(
+        const std::string& name,
+        bool useWindowSize,
+        const BeRenderGraph::BeResourceDescriptor& desc
+    ) -> void;
+    // Passes resolve the targets they use once in Initialise, declared targets exist from then on. Throws for names
+    // that were neither created nor declared.
+    [[nodiscard]] auto FindRenderResource(BeName name) const -> BeHandle;
+    [[nodiscard]] auto GetRenderResource(const BeHandle handle) -> BeRenderResource* { return _renderResources.Get(handle); }
     
 private:
+    // Reads back the oldest frame's timestamps into GpuFrameMilliseconds without waiting for them.
+    auto ReadFrameTimer() -> void;
     void TerminateRenderer();
 };
@@ -0,0 +1,87 @@
+﻿#include "BeSceneGraph.h"
+
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include <gtc/matrix_transform.hpp>
+
+auto BeSceneGraph::ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> glm::mat4 {
+    return
+        glm::translate(glm::mat4(1.0f), position) *
+        glm::mat4_cast(rotation) *
+        glm::scale(glm::mat4(1.0f), scale);
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeSceneGraph::AddNode(const uint32_t parent, const glm::mat4& local) -> uint32_t {
+    const uint32_t node = GetNodeCount();
+    if (parent != NoParent && parent >= node)
+        throw std::runtime_error(std::format("Scene graph node {} added below {}, which does not exist yet", node, parent));
+    _parents.push_back(parent);
+    _locals.push_back(local);
+    _worlds.push_back(local);
+    _dirty.push_back(0);
+    MarkDirty(node);
+    return node;
+}
+
+auto BeSceneGraph::AddNode(const uint32_t parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> uint32_t {
+    return AddNode(parent, ComposeTransform(position, rotation, scale));
+}
+
+auto BeSceneGraph::SetLocal(const uint32_t node, const glm::mat4& local) -> void {
+    _locals[node] = local;
+    MarkDirty(node);
+}
+
+auto BeSceneGraph::SetLocal(const uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> void {
+    SetLocal(node, ComposeTransform(position, rotation, scale));
+}
+
+auto BeSceneGraph::Clear() -> void {
+    _parents.clear();
+    _locals.clear();
+    _worlds.clear();
+    _dirty.clear();
+    _changed.clear();
+    _firstDirty = 0;
+}
+
+auto BeSceneGraph::Update() -> void {
+    // a node is dirty when it moved or its parent was recomputed earlier in this pass; flags are cleared at the end,
+    // so they stay set for the children further on
+    _changed.clear();
+    const uint32_t nodeCount = GetNodeCount();
+    for (uint32_t i = _firstDirty; i < nodeCount; ++i) {
+        const uint32_t parent = _parents[i];
+        if (!_dirty[i]) {
+            if (parent == NoParent || !_dirty[parent]) continue;
+            _dirty[i] = 1;
+        }
+        _worlds[i] = parent == NoParent ? _locals[i] : _worlds[parent] * _locals[i];
+        _changed.push_back(i);
+    }
+    for (const uint32_t node : _changed)
+        _dirty[node] = 0;
+    _firstDirty = nodeCount;
+}
+
+auto BeSceneGraph::UpdateAll() -> void {
+    _changed.clear();
+    const uint32_t nodeCount = GetNodeCount();
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const uint32_t parent = _parents[i];
+        _worlds[i] = parent == NoParent ? _locals[i] : _worlds[parent] * _locals[i];
+        _changed.push_back(i);
+    }
+    std::ranges::fill(_dirty, 0);
+    _firstDirty = nodeCount;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeSceneGraph::MarkDirty(const uint32_t node) -> void {
+    _dirty[node] = 1;
+    _firstDirty = std::min(_firstDirty, node);
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+// Transform hierarchy in flat arrays, one entry per node. Parents always come before their children, so one pass in
+// index order sees every parent's world matrix finished before its children need it. Moving a node only marks it
+// dirty; Update recomputes the world matrices of dirty nodes and of everything below them, nothing else.
+class BeSceneGraph {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t NoParent = UINT32_MAX;
+
+    [[nodiscard]] static auto ComposeTransform(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> glm::mat4;
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<uint32_t> _parents;
+    std::vector<glm::mat4> _locals;
+    std::vector<glm::mat4> _worlds;
+    std::vector<uint8_t> _dirty;
+    std::vector<uint32_t> _changed;   // nodes the last Update recomputed
+    uint32_t _firstDirty = 0;         // nothing before it is dirty, the node count when nothing is
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeSceneGraph() = default;
+    ~BeSceneGraph() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // The parent has to exist already, new nodes start dirty.
+    auto AddNode(uint32_t parent, const glm::mat4& local) -> uint32_t;
+    auto AddNode(uint32_t parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> uint32_t;
+    auto SetLocal(uint32_t node, const glm::mat4& local) -> void;
+    auto SetLocal(uint32_t node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) -> void;
+    auto Clear() -> void;
+
+    // Recomputes the world matrices of dirty nodes and their descendants.
+    auto Update() -> void;
+    // Recomputes every world matrix, dirty or not.
+    auto UpdateAll() -> void;
+
+    [[nodiscard]] auto GetNodeCount() const -> uint32_t { return static_cast<uint32_t>(_parents.size()); }
+    [[nodiscard]] auto GetParent(const uint32_t node) const -> uint32_t { return _parents[node]; }
+    [[nodiscard]] auto GetLocal(const uint32_t node) const -> const glm::mat4& { return _locals[node]; }
+    // Valid for nodes that have been through an Update since they last moved.
+    [[nodiscard]] auto GetWorld(const uint32_t node) const -> const glm::mat4& { return _worlds[node]; }
+    [[nodiscard]] auto GetWorlds() const -> std::span<const glm::mat4> { return _worlds; }
+    // In index order, so parents before children.
+    [[nodiscard]] auto GetChangedNodes() const -> std::span<const uint32_t> { return _changed; }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto MarkDirty(uint32_t node) -> void;
+};
@@ -3,90 +3,164 @@
 #include <cassert>
 #include <d3dcompiler.h>
 #include <format>
+#include <future>
+#include <mutex>
 #include "Utils.h"
 #include "BeShaderIncludeHandler.hpp"
 
-BeShader::BeShader(
-    ID3D11Device* device,
-    const std::filesystem::path& filePathWithoutExtension,
-    const BeShaderType shaderType,
-    const std::vector<BeVertexElementDescriptor>& vertexLayout)
-    : VertexLayout(vertexLayout)
-    , ShaderType(shaderType) {
+static_assert(static_cast<uint32_t>(BeVertexFormat::R32G32B32A32Float) == DXGI_FORMAT_R32G32B32A32_FLOAT);
+static_assert(static_cast<uint32_t>(BeVertexFormat::R32G32B32Float) == DXGI_FORMAT_R32G32B32_FLOAT);
+static_assert(static_cast<uint32_t>(BeVertexFormat::R32G32Float) == DXGI_FORMAT_R32G32_FLOAT);
+static_assert(static_cast<uint32_t>(BeVertexFormat::R16G16Float) == DXGI_FORMAT_R16G16_FLOAT);
+static_assert(static_cast<uint32_t>(BeVertexFormat::R16G16Snorm) == DXGI_FORMAT_R16G16_SNORM);
+
+namespace {
+    std::mutex precompiledMutex;
+    std::unordered_map<std::string, std::shared_future<BeShaderBytecode>> precompiledShaders;
+
+    auto MakePrecompiledKey(const std::filesystem::path& filePathWithoutExtension, const BeShaderType shaderType) -> std::string {
+        return std::format("{}|{}", filePathWithoutExtension.generic_string(), static_cast<uint32_t>(shaderType));
+    }
+}
+
+auto BeShader::Precompile(const std::filesystem::path& filePathWithoutExtension, const BeShaderType shaderType) -> void {
+    std::promise<BeShaderBytecode> promise;
+    {
+        std::lock_guard lock(precompiledMutex);
+        const auto [it, inserted] = precompiledShaders.emplace(
+            MakePrecompiledKey(filePathWithoutExtension, shaderType),
+            promise.get_future().share());
+        if (!inserted) return;
+    }
+
+    try {
+        promise.set_value(Compile(filePathWithoutExtension, shaderType));
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
 
+auto BeShader::Compile(const std::filesystem::path& filePathWithoutExtension, const BeShaderType shaderType) -> BeShaderBytecode {
     BeShaderIncludeHandler includeHandler(
         filePathWithoutExtension.parent_path().string(),
         "src/shaders/"
     );
 
-    if (HasAny(ShaderType, BeShaderType::Pixel)) {
+    BeShaderBytecode bytecode;
+    if (HasAny(shaderType, BeShaderType::Pixel)) {
         std::filesystem::path psPath = filePathWithoutExtension;
         psPath += "Pixel.hlsl";
         assert(std::filesystem::exists(psPath));
 
-        LoadPixelShader(psPath, device, &includeHandler);
+        bytecode.Pixel = CompileStage(psPath, "ps_5_0", &includeHandler);
     }
 
-    if (HasAny(ShaderType, BeShaderType::Vertex)) {
+    if (HasAny(shaderType, BeShaderType::Vertex)) {
         std::filesystem::path vsPath = filePathWithoutExtension;
         vsPath += "Vertex.hlsl";
         assert(std::filesystem::exists(vsPath));
 
-        LoadVertexShader(vsPath, VertexLayout, device, &includeHandler);
+        bytecode.Vertex = CompileStage(vsPath, "vs_5_0", &includeHandler);
     }
+    return bytecode;
 }
 
-auto BeShader::Bind(ID3D11DeviceContext* context) const -> void {
-    context->IASetInputLayout(ComputedInputLayout.Get());
-    context->VSSetShader(VertexShader.Get(), nullptr, 0);
-    context->PSSetShader(PixelShader.Get(), nullptr, 0);
+BeShader::BeShader(
+    ID3D11Device* device,
+    const std::filesystem::path& filePathWithoutExtension,
+    const BeShaderType shaderType,
+    const BeVertexLayout& vertexLayout)
+    : VertexLayout(vertexLayout)
+    , ShaderType(shaderType) {
+
+    const BeShaderBytecode bytecode = AcquireBytecode(filePathWithoutExtension, ShaderType);
+
+    if (HasAny(ShaderType, BeShaderType::Pixel))
+        CreatePixelShader(bytecode.Pixel.Get(), device);
+
+    if (HasAny(ShaderType, BeShaderType::Vertex))
+        CreateVertexShader(bytecode.Vertex.Get(), VertexLayout, device);
 }
 
-auto BeShader::LoadVertexShader(
+auto BeShader::AcquireBytecode(const std::filesystem::path& filePathWithoutExtension, const BeShaderType shaderType) -> BeShaderBytecode {
+    std::shared_future<BeShaderBytecode> precompiled;
+    {
+        std::lock_guard lock(precompiledMutex);
+        const auto it = precompiledShaders.find(MakePrecompiledKey(filePathWithoutExtension, shaderType));
+        if (it != precompiledShaders.end())
+            precompiled = it->second;
+    }
+
+    if (precompiled.valid())
+        return precompiled.get();
+    return Compile(filePathWithoutExtension, shaderType);
+}
+
+auto BeShader::CompileStage(
     const std::filesystem::path& filePath,
-    const std::vector<BeVertexElementDescriptor>& vertexLayout,
-    ID3D11Device* device,
+    const char* target,
     BeShaderIncludeHandler* includeHandler)
-    -> void {
-    
-    ComPtr<ID3DBlob> vsBlob, errorBlob;
-    auto hr = D3DCompileFromFile(
+-> ComPtr<ID3DBlob> {
+
+    ComPtr<ID3DBlob> blob, errorBlob;
+    const auto result = D3DCompileFromFile(
         filePath.wstring().c_str(),
         nullptr,
         includeHandler,
         "main",
-        "vs_5_0",
+        target,
         0, 0,
-        &vsBlob,
+        &blob,
         &errorBlob);
-    if (FAILED(hr)) {
+    if (FAILED(result)) {
         if (errorBlob) {
             const std::string errorMsg(static_cast<const char*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
-            throw std::runtime_error("Vertex shader compilation error: " + errorMsg);
+            throw std::runtime_error(std::format("Shader compilation error ({}): {}", filePath.string(), errorMsg));
         } else {
-            Utils::ThrowIfFailed(hr);
+            Utils::ThrowIfFailed(result);
         }
     }
+    return blob;
+}
+
+auto BeShader::CreateVertexShader(
+    ID3DBlob* vsBlob,
+    const BeVertexLayout& vertexLayout,
+    ID3D11Device* device)
+    -> void {
 
-    BeShaderType typeCheck = BeShaderType::Vertex | BeShaderType::None;
-    
     Utils::Check << device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &VertexShader);
 
     //input layout
-    if (!vertexLayout.empty()) {
+    if (!vertexLayout.IsEmpty()) {
         std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayout;
-        inputLayout.reserve(vertexLayout.size());
+        inputLayout.reserve(vertexLayout.ElementCount);
 
-        for (const auto& descriptor : vertexLayout) {
+        for (const auto& element : vertexLayout) {
+            const auto& descriptor = GetVertexElementDescriptor(element.Semantic);
             D3D11_INPUT_ELEMENT_DESC elementDesc;
-            elementDesc.SemanticIndex = 0;
+            elementDesc.SemanticIndex = descriptor.SemanticIndex;
             elementDesc.InputSlot = 0;
-            elementDesc.AlignedByteOffset = BeVertexElementDescriptor::ElementOffsets.at(descriptor.Attribute);
+            elementDesc.AlignedByteOffset = element.Offset;
             elementDesc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
             elementDesc.InstanceDataStepRate = 0;
-            elementDesc.SemanticName = BeVertexElementDescriptor::SemanticNames.at(descriptor.Attribute);
-            elementDesc.Format = BeVertexElementDescriptor::ElementFormats.at(descriptor.Attribute);
-        
+            elementDesc.SemanticName = descriptor.SemanticName;
+            elementDesc.Format = static_cast<DXGI_FORMAT>(descriptor.Format);
+
+            inputLayout.push_back(elementDesc);
+        }
+
+        for (uint32_t row = 0; row < 4; ++row) {
+            D3D11_INPUT_ELEMENT_DESC elementDesc;
+            elementDesc.SemanticIndex = row;
+            elementDesc.InputSlot = InstanceStreamSlot;
+            elementDesc.AlignedByteOffset = row * 16;
+            elementDesc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+            elementDesc.InstanceDataStepRate = 1;
+            elementDesc.SemanticName = "INSTANCE_MODEL";
+            elementDesc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
             inputLayout.push_back(elementDesc);
         }
 
@@ -99,31 +173,9 @@ auto BeShader::LoadVertexShader(
     }
 }
 
-auto BeShader::LoadPixelShader(
-    const std::filesystem::path& filePath,
-    ID3D11Device* device,
-    BeShaderIncludeHandler* includeHandler)
+auto BeShader::CreatePixelShader(
+    ID3DBlob* psBlob,
+    ID3D11Device* device)
 -> void {
-    
-    ComPtr<ID3DBlob> psBlob, errorBlob;
-    const auto result = D3DCompileFromFile(
-        filePath.wstring().c_str(),
-        nullptr,
-        includeHandler,
-        "main",
-        "ps_5_0",
-        0, 0,
-        &psBlob,
-        &errorBlob);
-    if (FAILED(result)) {
-        if (errorBlob) {
-            std::string errorMsg(static_cast<const char*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
-            throw std::runtime_error("Vertex shader compilation error: " + errorMsg);
-        } else {
-            Utils::ThrowIfFailed(result);
-        }
-    }
-        
     Utils::Check << device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &PixelShader);
 }
-
@@ -0,0 +1,138 @@
+﻿#include "BeStateTracker.h"
+
+#include <algorithm>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeStateTracker::BeStateTracker(BeDeviceContext& context) : _context(&context) {}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeStateTracker::SetPipeline(const BePipelineState& pipeline) -> void {
+    _statistics.Requested += 7;
+    if (&pipeline == _pipeline) return;
+    _pipeline = &pipeline;
+
+    auto bind = [this](auto& bound, const auto value, auto&& issue) {
+        if (bound == value) return;
+        bound = value;
+        issue(value);
+        ++_statistics.Issued;
+    };
+    bind(_inputLayout, pipeline.InputLayout, [this](auto* layout) { _context->SetInputLayout(layout); });
+    bind(_topology, pipeline.Topology, [this](const uint32_t topology) { _context->SetPrimitiveTopology(topology); });
+    bind(_vertexShader, pipeline.VertexShader, [this](auto* shader) { _context->SetVertexShader(shader); });
+    bind(_pixelShader, pipeline.PixelShader, [this](auto* shader) { _context->SetPixelShader(shader); });
+    bind(_blendState, pipeline.BlendState, [this](auto* state) { _context->SetBlendState(state); });
+    bind(_rasterizerState, pipeline.RasterizerState, [this](auto* state) { _context->SetRasterizerState(state); });
+    if (_depthStencilState != pipeline.DepthStencilState || _stencilReference != pipeline.StencilReference) {
+        _depthStencilState = pipeline.DepthStencilState;
+        _stencilReference = pipeline.StencilReference;
+        _context->SetDepthStencilState(_depthStencilState, _stencilReference);
+        ++_statistics.Issued;
+    }
+}
+
+auto BeStateTracker::SetVertexBuffer(const uint32_t slot, ID3D11Buffer* buffer, const uint32_t stride, const uint32_t offset) -> void {
+    ++_statistics.Requested;
+    const BeVertexBufferBinding binding = {.Buffer = buffer, .Stride = stride, .Offset = offset};
+    if (Update(_vertexBuffers, slot, std::span(&binding, 1)).second == 0) return;
+    _context->SetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetIndexBuffer(ID3D11Buffer* buffer, const uint32_t format, const uint32_t offset) -> void {
+    ++_statistics.Requested;
+    if (_indexBuffer == buffer && _indexFormat == format && _indexOffset == offset) return;
+    _indexBuffer = buffer;
+    _indexFormat = format;
+    _indexOffset = offset;
+    _context->SetIndexBuffer(buffer, format, offset);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetVSConstantBuffer(const uint32_t slot, ID3D11Buffer* buffer) -> void {
+    ++_statistics.Requested;
+    if (Update(_vsConstantBuffers, slot, std::span(&buffer, 1)).second == 0) return;
+    _context->SetVSConstantBuffers(slot, 1, &buffer);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetPSConstantBuffer(const uint32_t slot, ID3D11Buffer* buffer) -> void {
+    ++_statistics.Requested;
+    if (Update(_psConstantBuffers, slot, std::span(&buffer, 1)).second == 0) return;
+    _context->SetPSConstantBuffers(slot, 1, &buffer);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetPSShaderResources(const uint32_t startSlot, const std::span<ID3D11ShaderResourceView* const> views) -> void {
+    ++_statistics.Requested;
+    const auto [first, count] = Update(_psShaderResources, startSlot, views);
+    if (count == 0) return;
+    _context->SetPSShaderResources(first, count, _psShaderResources.data() + first);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetPSSampler(const uint32_t slot, ID3D11SamplerState* sampler) -> void {
+    ++_statistics.Requested;
+    if (Update(_psSamplers, slot, std::span(&sampler, 1)).second == 0) return;
+    _context->SetPSSamplers(slot, 1, &sampler);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::SetRenderTargets(const std::span<ID3D11RenderTargetView* const> targets, ID3D11DepthStencilView* depthTarget) -> void {
+    ++_statistics.Requested;
+    if (targets.size() > RenderTargetSlots)
+        throw std::runtime_error(std::format("{} render targets are more than the {} D3D11 binds", targets.size(), RenderTargetSlots));
+    std::array<ID3D11RenderTargetView*, RenderTargetSlots> next {};
+    std::ranges::copy(targets, next.begin());
+    if (next == _renderTargets && depthTarget == _depthTarget) return;
+
+    const auto firstResource = std::ranges::find_if(_psShaderResources, [](const auto* view) { return view != nullptr; });
+    if (firstResource != _psShaderResources.end()) {
+        const auto lastResource = std::ranges::find_if(_psShaderResources | std::views::reverse, [](const auto* view) { return view != nullptr; });
+        const auto first = static_cast<uint32_t>(firstResource - _psShaderResources.begin());
+        const auto count = static_cast<uint32_t>(_psShaderResources.rend() - lastResource) - first;
+        const std::array<ID3D11ShaderResourceView*, ShaderResourceSlots> empty {};
+        _context->SetPSShaderResources(first, count, empty.data());
+        _psShaderResources = {};
+        ++_statistics.Issued;
+    }
+
+    _renderTargets = next;
+    _depthTarget = depthTarget;
+    _context->SetRenderTargets(static_cast<uint32_t>(targets.size()), targets.data(), depthTarget);
+    ++_statistics.Issued;
+}
+
+auto BeStateTracker::ExecuteCommandList(const BeCommandList& commands) -> void {
+    ++_statistics.Requested;
+    ++_statistics.Issued;
+    _context->ExecuteCommandList(commands);
+    Reset();
+}
+
+auto BeStateTracker::Reset() -> void {
+    const BeBindStatistics statistics = _statistics;
+    *this = BeStateTracker(*_context);
+    _statistics = statistics;
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T, size_t N>
+auto BeStateTracker::Update(std::array<T, N>& bound, const uint32_t startSlot, const std::type_identity_t<std::span<const T>> values) -> std::pair<uint32_t, uint32_t> {
+    if (startSlot + values.size() > N)
+        throw std::runtime_error(std::format("Slots {} to {} are past the {} the state tracker follows", startSlot, startSlot + values.size() - 1, N));
+    uint32_t first = UINT32_MAX, last = 0;
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        if (bound[startSlot + i] == values[i]) continue;
+        bound[startSlot + i] = values[i];
+        first = std::min(first, startSlot + i);
+        last = startSlot + i;
+    }
+    return first == UINT32_MAX ? std::pair(0u, 0u) : std::pair(first, last - first + 1);
+}
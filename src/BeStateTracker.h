@@ -0,0 +1,99 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "BeDeviceContext.h"
+#include "BePipelineState.h"
+
+// Sits in front of the device context and forwards a binding only when it changes what is bound, so passes bind
+// everything they need without unbinding behind themselves. It has to see every binding call, and assumes a context
+// with nothing bound when it is created or reset, which is also how command lists are recorded.
+// Changing render targets first unbinds the pixel shader resources, the previous targets are usually among them and
+// D3D11 would otherwise drop the new targets or the resources.
+class BeStateTracker {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t VertexBufferSlots = 16;
+    static constexpr uint32_t ConstantBufferSlots = 14;
+    static constexpr uint32_t ShaderResourceSlots = 16;
+    static constexpr uint32_t SamplerSlots = 16;
+    static constexpr uint32_t RenderTargetSlots = 8;
+
+    struct BeBindStatistics {
+        uint32_t Requested = 0;   // binding calls without the tracker, a pipeline counting one per state it holds
+        uint32_t Issued = 0;      // calls that reached the context
+    };
+
+private:
+    struct BeVertexBufferBinding {
+        ID3D11Buffer* Buffer = nullptr;
+        uint32_t Stride = 0;
+        uint32_t Offset = 0;
+        auto operator==(const BeVertexBufferBinding&) const -> bool = default;
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeDeviceContext* _context;
+    BeBindStatistics _statistics;
+
+    const BePipelineState* _pipeline = nullptr;
+    ID3D11InputLayout* _inputLayout = nullptr;
+    uint32_t _topology = 0;
+    ID3D11VertexShader* _vertexShader = nullptr;
+    ID3D11PixelShader* _pixelShader = nullptr;
+    ID3D11BlendState* _blendState = nullptr;
+    ID3D11DepthStencilState* _depthStencilState = nullptr;
+    uint32_t _stencilReference = 0;
+    ID3D11RasterizerState* _rasterizerState = nullptr;
+
+    std::array<BeVertexBufferBinding, VertexBufferSlots> _vertexBuffers {};
+    ID3D11Buffer* _indexBuffer = nullptr;
+    uint32_t _indexFormat = 0;
+    uint32_t _indexOffset = 0;
+    std::array<ID3D11Buffer*, ConstantBufferSlots> _vsConstantBuffers {};
+    std::array<ID3D11Buffer*, ConstantBufferSlots> _psConstantBuffers {};
+    std::array<ID3D11ShaderResourceView*, ShaderResourceSlots> _psShaderResources {};
+    std::array<ID3D11SamplerState*, SamplerSlots> _psSamplers {};
+    std::array<ID3D11RenderTargetView*, RenderTargetSlots> _renderTargets {};
+    uint32_t _renderTargetCount = 0;
+    ID3D11DepthStencilView* _depthTarget = nullptr;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeStateTracker(BeDeviceContext& context);
+    ~BeStateTracker() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Binds only the states that differ from the bound ones, nothing when the pipeline is the bound one.
+    auto SetPipeline(const BePipelineState& pipeline) -> void;
+    auto SetVertexBuffer(uint32_t slot, ID3D11Buffer* buffer, uint32_t stride, uint32_t offset) -> void;
+    auto SetIndexBuffer(ID3D11Buffer* buffer, uint32_t format, uint32_t offset = 0) -> void;
+    auto SetVSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer) -> void;
+    auto SetPSConstantBuffer(uint32_t slot, ID3D11Buffer* buffer) -> void;
+    // One call for the slots from the first to the last one that changes.
+    auto SetPSShaderResources(uint32_t startSlot, std::span<ID3D11ShaderResourceView* const> views) -> void;
+    auto SetPSSampler(uint32_t slot, ID3D11SamplerState* sampler) -> void;
+    auto SetRenderTargets(std::span<ID3D11RenderTargetView* const> targets, ID3D11DepthStencilView* depthTarget) -> void;
+    // Replays a recorded list on the context, which leaves nothing bound.
+    auto ExecuteCommandList(const BeCommandList& commands) -> void;
+    // Forgets every binding, for a context that has nothing bound again. Statistics stay.
+    auto Reset() -> void;
+
+    [[nodiscard]] auto GetStatistics() const -> const BeBindStatistics& { return _statistics; }
+    auto ResetStatistics() -> void { _statistics = {}; }
+    // counts what another tracker saw, one recording part of the same pass
+    auto AddStatistics(const BeBindStatistics& statistics) -> void {
+        _statistics.Requested += statistics.Requested;
+        _statistics.Issued += statistics.Issued;
+    }
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Writes values over bound from startSlot on and returns the changed range as {first slot, count}, count 0 when
+    // nothing changed. Throws when the range does not fit the tracked slots.
+    template <typename T, size_t N>
+    static auto Update(std::array<T, N>& bound, uint32_t startSlot, std::type_identity_t<std::span<const T>> values) -> std::pair<uint32_t, uint32_t>;
+};
@@ -0,0 +1,160 @@
+﻿#include "BeTaskGraph.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <stdexcept>
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeTaskGraph::BeTaskGraph(BeThreadPool& threadPool)
+    : _threadPool(threadPool) {
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeTaskGraph::AddTask(std::string name, std::function<void()> work, const std::vector<BeTaskId>& dependencies) -> BeTaskId {
+    return Add(std::move(name), std::move(work), dependencies, false);
+}
+
+auto BeTaskGraph::AddMainThreadTask(std::string name, std::function<void()> work, const std::vector<BeTaskId>& dependencies) -> BeTaskId {
+    return Add(std::move(name), std::move(work), dependencies, true);
+}
+
+auto BeTaskGraph::Run() -> void {
+    _runStart = std::chrono::steady_clock::now();
+    _completedTasks = 0;
+    _tasksInFlight = 0;
+    _error = nullptr;
+
+    {
+        std::lock_guard lock(_mutex);
+        for (auto& task : _tasks)
+            task.PendingDependencies = static_cast<uint32_t>(task.Dependencies.size());
+        for (BeTaskId id = 0; id < _tasks.size(); ++id)
+            if (_tasks[id].PendingDependencies == 0)
+                Schedule(id);
+    }
+
+    std::unique_lock lock(_mutex);
+    const auto totalTasks = static_cast<uint32_t>(_tasks.size());
+    while (_completedTasks < totalTasks && !(_error && _tasksInFlight == 0)) {
+        if (_mainThreadQueue.empty()) {
+            _condition.wait(lock);
+            continue;
+        }
+        const BeTaskId id = _mainThreadQueue.front();
+        _mainThreadQueue.pop_front();
+        lock.unlock();
+        Execute(id);
+        lock.lock();
+    }
+
+    const std::chrono::duration<double, std::milli> wallTime = std::chrono::steady_clock::now() - _runStart;
+    _wallTimeMs = wallTime.count();
+    if (_error)
+        std::rethrow_exception(_error);
+}
+
+auto BeTaskGraph::PrintReport(const std::string& title) const -> void {
+    // tasks only depend on earlier ones, so id order is a topological order
+    std::vector<double> pathEnd(_tasks.size(), 0.0);
+    std::vector<int32_t> pathPrevious(_tasks.size(), -1);
+    double serialTime = 0.0;
+    for (BeTaskId id = 0; id < _tasks.size(); ++id) {
+        const auto& task = _tasks[id];
+        const double duration = task.EndMs - task.StartMs;
+        serialTime += duration;
+        for (const BeTaskId dependency : task.Dependencies) {
+            if (pathEnd[dependency] > pathEnd[id]) {
+                pathEnd[id] = pathEnd[dependency];
+                pathPrevious[id] = static_cast<int32_t>(dependency);
+            }
+        }
+        pathEnd[id] += duration;
+    }
+
+    std::cout << "---- " << title << " ----\n";
+    std::cout << std::format("{:<52} {:>6} {:>10} {:>10}\n", "Task", "Thread", "Start (ms)", "Time (ms)");
+    for (const auto& task : _tasks) {
+        std::cout << std::format("{:<52} {:>6} {:>10.2f} {:>10.2f}\n",
+            task.Name, task.MainThread ? "main" : "worker", task.StartMs, task.EndMs - task.StartMs);
+    }
+
+    if (_tasks.empty()) return;
+    const auto last = std::ranges::max_element(pathEnd) - pathEnd.begin();
+    std::vector<BeTaskId> criticalPath;
+    for (auto id = static_cast<int32_t>(last); id >= 0; id = pathPrevious[id])
+        criticalPath.push_back(static_cast<BeTaskId>(id));
+
+    std::cout << "Critical path:\n";
+    for (auto it = criticalPath.rbegin(); it != criticalPath.rend(); ++it) {
+        const auto& task = _tasks[*it];
+        std::cout << std::format("  {:<50} {:>10.2f}\n", task.Name, task.EndMs - task.StartMs);
+    }
+    std::cout << std::format("Wall time {:.2f} ms, critical path {:.2f} ms, sequential {:.2f} ms ({:.1f}x saved) on {} workers\n",
+        _wallTimeMs, pathEnd[last], serialTime, serialTime / _wallTimeMs, _threadPool.GetThreadCount());
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeTaskGraph::Add(
+    std::string name,
+    std::function<void()> work,
+    const std::vector<BeTaskId>& dependencies,
+    const bool mainThread)
+-> BeTaskId {
+
+    const auto id = static_cast<BeTaskId>(_tasks.size());
+    for (const BeTaskId dependency : dependencies) {
+        if (dependency >= id)
+            throw std::invalid_argument("Task " + name + " depends on a task that is not in the graph yet");
+        _tasks[dependency].Dependents.push_back(id);
+    }
+
+    _tasks.push_back({
+        .Name = std::move(name),
+        .Work = std::move(work),
+        .Dependencies = dependencies,
+        .Dependents = {},
+        .MainThread = mainThread,
+    });
+    return id;
+}
+
+auto BeTaskGraph::Schedule(const BeTaskId id) -> void {
+    // called with _mutex held
+    ++_tasksInFlight;
+    if (_tasks[id].MainThread) {
+        _mainThreadQueue.push_back(id);
+        _condition.notify_all();
+        return;
+    }
+    _threadPool.Submit([this, id] { Execute(id); });
+}
+
+auto BeTaskGraph::Execute(const BeTaskId id) -> void {
+    auto& task = _tasks[id];
+    const auto start = std::chrono::steady_clock::now();
+    std::exception_ptr error = nullptr;
+    try {
+        task.Work();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    task.StartMs = std::chrono::duration<double, std::milli>(start - _runStart).count();
+    task.EndMs = std::chrono::duration<double, std::milli>(end - _runStart).count();
+
+    std::lock_guard lock(_mutex);
+    --_tasksInFlight;
+    ++_completedTasks;
+    if (error && !_error)
+        _error = error;
+    if (!_error) {
+        for (const BeTaskId dependent : task.Dependents)
+            if (--_tasks[dependent].PendingDependencies == 0)
+                Schedule(dependent);
+    }
+    _condition.notify_all();
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BeThreadPool.h"
+
+// One-shot dependency graph of tasks. Worker tasks run on the thread pool, main thread tasks (anything that
+// creates GPU objects) run serialized on the thread that calls Run. Every task is timed for the report.
+class BeTaskGraph {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    using BeTaskId = uint32_t;
+
+private:
+    struct BeTask {
+        std::string Name;
+        std::function<void()> Work;
+        std::vector<BeTaskId> Dependencies;
+        std::vector<BeTaskId> Dependents;
+        bool MainThread = false;
+        uint32_t PendingDependencies = 0;
+        double StartMs = 0.0;
+        double EndMs = 0.0;
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeThreadPool& _threadPool;
+    std::vector<BeTask> _tasks;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<BeTaskId> _mainThreadQueue;
+    uint32_t _completedTasks = 0;
+    uint32_t _tasksInFlight = 0;
+    std::exception_ptr _error = nullptr;
+    std::chrono::steady_clock::time_point _runStart;
+    double _wallTimeMs = 0.0;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeTaskGraph(BeThreadPool& threadPool = BeThreadPool::Shared());
+    ~BeTaskGraph() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    auto AddTask(std::string name, std::function<void()> work, const std::vector<BeTaskId>& dependencies = {}) -> BeTaskId;
+    auto AddMainThreadTask(std::string name, std::function<void()> work, const std::vector<BeTaskId>& dependencies = {}) -> BeTaskId;
+
+    // Blocks until every task finished. The first exception thrown by a task is rethrown once in-flight work drained.
+    auto Run() -> void;
+
+    // Per task timings, the critical path through the graph and how it compares to running everything in sequence.
+    auto PrintReport(const std::string& title) const -> void;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto Add(std::string name, std::function<void()> work, const std::vector<BeTaskId>& dependencies, bool mainThread) -> BeTaskId;
+    auto Schedule(BeTaskId id) -> void;
+    auto Execute(BeTaskId id) -> void;
+};
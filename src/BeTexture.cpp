@@ -1,8 +1,9 @@
 ﻿#include "BeTexture.h"
 
+#include "BePixelKernels.h"
+#include "BeTextureCompressor.h"
 #include "Utils.h"
 
-
 BeTexture::BeTexture(const glm::vec4& color) {
     Width = 1;
     Height = 1;
@@ -15,31 +16,53 @@ BeTexture::BeTexture(const glm::vec4& color) {
 }
 
 
-// ReSharper disable once CppMemberFunctionMayBeConst
-auto BeTexture::FlipVertically() -> void {
-    const uint32_t rowSize = Width * 4; // 4 bytes per pixel (RGBA8)
-    const auto tempRow = new uint8_t[rowSize];
+auto BeTexture::GetRowPitch(const uint32_t levelWidth) const -> uint32_t {
+    if (!IsBlockCompressed()) return 4 * levelWidth;
+    return (levelWidth + 3) / 4 * BeTextureCompressor::GetBlockSize(Format);
+}
+
+auto BeTexture::GetLevelSizeInBytes(const uint32_t levelWidth, const uint32_t levelHeight) const -> size_t {
+    const uint32_t rows = IsBlockCompressed() ? (levelHeight + 3) / 4 : levelHeight;
+    return size_t(GetRowPitch(levelWidth)) * rows;
+}
 
-    for (uint32_t y = 0; y < Height / 2; ++y) {
-        uint8_t* topRow = Pixels + y * rowSize;
-        uint8_t* bottomRow = Pixels + (Height - 1 - y) * rowSize;
+auto BeTexture::GetSizeInBytes() const -> size_t {
+    if (MipLevels.empty()) return GetLevelSizeInBytes(Width, Height);
+    const auto& last = MipLevels.back();
+    return last.Offset + GetLevelSizeInBytes(last.Width, last.Height);
+}
 
-        // Swap topRow and bottomRow
-        memcpy(tempRow, topRow, rowSize);
-        memcpy(topRow, bottomRow, rowSize);
-        memcpy(bottomRow, tempRow, rowSize);
+// ReSharper disable once CppMemberFunctionMayBeConst
+auto BeTexture::FlipVertically() -> void {
+    if (IsBlockCompressed()) throw std::runtime_error("Cannot flip a block compressed texture");
+    if (MipLevels.empty()) {
+        BePixelKernels::FlipVertically(Pixels, Width, Height);
+        return;
     }
+    for (const auto& level : MipLevels)
+        BePixelKernels::FlipVertically(Pixels + level.Offset, level.Width, level.Height);
+}
+
+auto BeTexture::GenerateMips(const BeMipSettings& settings) -> void {
+    if (!MipLevels.empty() || !Pixels) return;
+    if (IsBlockCompressed()) throw std::runtime_error("Cannot generate mips of a block compressed texture");
 
-    delete[] tempRow;
+    // lay out the whole chain first so Pixels grows only once
+    auto levels = BeMipChain::Layout(Width, Height);
+    const auto grown = static_cast<uint8_t*>(realloc(Pixels, BeMipChain::GetSizeInBytes(levels)));
+    if (!grown) throw std::runtime_error("Failed to allocate mip chain");
+    Pixels = grown;
+    MipLevels = std::move(levels);
+    BeMipChain::Generate(Pixels, MipLevels, settings);
 }
 
 auto BeTexture::CreateSRV(const ComPtr<ID3D11Device>& device) -> void {
     const D3D11_TEXTURE2D_DESC desc = {
         .Width = Width,
         .Height = Height,
-        .MipLevels = 1,
+        .MipLevels = GetMipCount(),
         .ArraySize = 1,
-        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .Format = Format,
         .SampleDesc = { .Count = 1 },
         .Usage = D3D11_USAGE_DEFAULT,
         .BindFlags = D3D11_BIND_SHADER_RESOURCE,
@@ -47,19 +70,20 @@ auto BeTexture::CreateSRV(const ComPtr<ID3D11Device>& device) -> void {
         .MiscFlags = 0, 
     };
 
-    const D3D11_SUBRESOURCE_DATA initData = {
-        .pSysMem = Pixels,
-        .SysMemPitch = 4 * Width
-    };
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    if (MipLevels.empty())
+        initData.push_back({ .pSysMem = Pixels, .SysMemPitch = GetRowPitch(Width) });
+    for (const auto& level : MipLevels)
+        initData.push_back({ .pSysMem = Pixels + level.Offset, .SysMemPitch = GetRowPitch(level.Width) });
             
     ComPtr<ID3D11Texture2D> d3dTexture = nullptr;
-    Utils::Check << device->CreateTexture2D(&desc, &initData, &d3dTexture);
+    Utils::Check << device->CreateTexture2D(&desc, initData.data(), &d3dTexture);
             
     // Create SRV
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDescriptor = {
-        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+        .Format = Format,
         .ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
-        .Texture2D = { .MostDetailedMip = 0, .MipLevels = 1 },
+        .Texture2D = { .MostDetailedMip = 0, .MipLevels = GetMipCount() },
     };
     Utils::Check << device->CreateShaderResourceView(d3dTexture.Get(), &srvDescriptor, SRV.GetAddressOf());
 }
@@ -1,21 +1,37 @@
 ﻿#pragma once
 #include <cstdint>
+#include <vector>
 #include <wrl/client.h>
 #include <d3d11.h>
 #include <glm.hpp>
 
+#include "BeMipChain.h"
+
 using Microsoft::WRL::ComPtr;
 
 struct BeTexture {
+    using BeMipLevel = ::BeMipLevel; // Offset counts from Pixels
+
     BeTexture () = default;
     explicit BeTexture (const glm::vec4& color);
     inline ~BeTexture() { free (Pixels); }
 
-    uint8_t* Pixels = nullptr; // RGBA8
+    uint8_t* Pixels = nullptr; // level 0 followed by the rest of the mip chain, RGBA8 texels or BC blocks
     uint32_t Width = 0;
     uint32_t Height = 0;
+    DXGI_FORMAT Format = DXGI_FORMAT_R8G8B8A8_UNORM; // BC1 or BC3 once BeTextureCompressor::Compress ran
+    std::vector<BeMipLevel> MipLevels; // level 0 included, empty until GenerateMips
     ComPtr<ID3D11ShaderResourceView> SRV = nullptr;
     
+    [[nodiscard]] auto GetMipCount() const -> uint32_t { return MipLevels.empty() ? 1 : static_cast<uint32_t>(MipLevels.size()); }
+    [[nodiscard]] auto IsBlockCompressed() const -> bool { return Format != DXGI_FORMAT_R8G8B8A8_UNORM; }
+    // bytes per row of texels, or per row of 4x4 blocks when block compressed
+    [[nodiscard]] auto GetRowPitch(uint32_t levelWidth) const -> uint32_t;
+    [[nodiscard]] auto GetLevelSizeInBytes(uint32_t levelWidth, uint32_t levelHeight) const -> size_t;
+    [[nodiscard]] auto GetSizeInBytes() const -> size_t;
+    // FlipVertically and GenerateMips work on RGBA8 only, so they have to run before compression.
     auto FlipVertically() -> void;
+    // Box filters the full chain down to 1x1 into the same allocation, see BeMipChain.
+    auto GenerateMips(const BeMipSettings& settings = {}) -> void;
     auto CreateSRV(const ComPtr<ID3D11Device>& device) -> void;
 };
@@ -0,0 +1,98 @@
+﻿#include "BeTextureCache.h"
+
+#include <format>
+#include <iostream>
+
+#include "BeTexture.h"
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeTextureCache::MakeKey(const BeTextureSource& source) -> std::string {
+    switch (source.Kind) {
+        case BeTextureSource::BeKind::File:
+            return "file:" + std::filesystem::absolute(source.Path).lexically_normal().generic_string();
+        case BeTextureSource::BeKind::EncodedMemory:
+            return std::format("encoded:{:016x}", BeModelCache::HashBytes(source.Data, source.Size));
+        case BeTextureSource::BeKind::DecodedMemory:
+            return std::format("decoded:{}x{}:{:016x}", source.Width, source.Height,
+                BeModelCache::HashBytes(source.Data, size_t(source.Width) * source.Height * 4));
+    }
+    throw std::runtime_error("Unknown texture source");
+}
+
+auto BeTextureCache::Acquire(
+    const std::string& key,
+    const std::function<std::shared_ptr<BeTexture>()>& decode)
+-> std::shared_ptr<BeTexture> {
+
+    std::promise<std::shared_ptr<BeTexture>> promise;
+    {
+        std::unique_lock lock(_mutex);
+        auto& entry = _entries[key];
+        if (auto texture = entry.Texture.lock()) {
+            ++_statistics.Hits;
+            _statistics.BytesSaved += texture->GetSizeInBytes();
+            return texture;
+        }
+        if (entry.Pending.valid()) {
+            const auto pending = entry.Pending;
+            lock.unlock();
+            auto texture = pending.get();
+            lock.lock();
+            ++_statistics.Hits;
+            _statistics.BytesSaved += texture->GetSizeInBytes();
+            return texture;
+        }
+        ++_statistics.Misses;
+        entry.Pending = promise.get_future().share();
+    }
+
+    std::shared_ptr<BeTexture> texture;
+    try {
+        texture = decode();
+    } catch (...) {
+        {
+            std::lock_guard lock(_mutex);
+            _entries.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        auto& entry = _entries[key];
+        entry.Texture = texture;
+        entry.Pending = {};
+    }
+    promise.set_value(texture);
+    return texture;
+}
+
+auto BeTextureCache::EvictExpired() -> uint32_t {
+    std::lock_guard lock(_mutex);
+    const auto evicted = static_cast<uint32_t>(std::erase_if(_entries, [](const auto& pair) {
+        return !pair.second.Pending.valid() && pair.second.Texture.expired();
+    }));
+    _statistics.Evictions += evicted;
+    return evicted;
+}
+
+auto BeTextureCache::GetStatistics() const -> BeStatistics {
+    std::lock_guard lock(_mutex);
+    return _statistics;
+}
+
+auto BeTextureCache::PrintStatistics() const -> void {
+    std::lock_guard lock(_mutex);
+    const uint64_t requests = _statistics.Hits + _statistics.Misses;
+    std::cout << std::format(
+        "Texture cache: {} requests, {} hits, {} misses ({:.1f}% hit rate), {} entries, {} evicted, {:.2f} MB saved\n",
+        requests,
+        _statistics.Hits,
+        _statistics.Misses,
+        requests ? 100.0 * double(_statistics.Hits) / double(requests) : 0.0,
+        _entries.size(),
+        _statistics.Evictions,
+        double(_statistics.BytesSaved) / (1024.0 * 1024.0));
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "BeModelCache.h"
+
+struct BeTexture;
+
+// Deduplicates decoded textures across meshes, models and importers. File textures are keyed by their resolved
+// path, embedded ones by a hash of their bytes. Entries only hold weak references, so a texture nobody uses any
+// more can be evicted. Safe to use from several import threads at once.
+class BeTextureCache {
+public:
+    struct BeStatistics {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+        uint64_t BytesSaved = 0;   // decoded bytes hits did not have to allocate again
+    };
+
+private:
+    struct BeEntry {
+        std::weak_ptr<BeTexture> Texture;
+        std::shared_future<std::shared_ptr<BeTexture>> Pending;   // valid while the first request decodes
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string, BeEntry> _entries;
+    BeStatistics _statistics;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    BeTextureCache() = default;
+    ~BeTextureCache() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    [[nodiscard]] static auto MakeKey(const BeTextureSource& source) -> std::string;
+
+    // Returns the cached texture for the key or runs decode once, even when several threads ask at the same time.
+    [[nodiscard]] auto Acquire(const std::string& key, const std::function<std::shared_ptr<BeTexture>()>& decode) -> std::shared_ptr<BeTexture>;
+
+    // Drops the entries whose textures are no longer referenced anywhere.
+    auto EvictExpired() -> uint32_t;
+
+    [[nodiscard]] auto GetStatistics() const -> BeStatistics;
+    auto PrintStatistics() const -> void;
+};
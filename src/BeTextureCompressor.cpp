@@ -0,0 +1,55 @@
+﻿#include "BeTextureCompressor.h"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+#include "BeTexture.h"
+
+namespace {
+    auto ToDxgiFormat(const BeBlockFormat format, const DXGI_FORMAT uncompressed) -> DXGI_FORMAT {
+        switch (format) {
+            case BeBlockFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+            case BeBlockFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+            default: return uncompressed;
+        }
+    }
+}
+
+auto BeTextureCompressor::ChooseFormat(const BeTexture& texture) -> DXGI_FORMAT {
+    return ToDxgiFormat(BeBlockCompression::ChooseFormat(texture.Pixels, texture.Width, texture.Height), texture.Format);
+}
+
+auto BeTextureCompressor::Compress(BeTexture& texture, const bool parallel) -> DXGI_FORMAT {
+    if (texture.Format != DXGI_FORMAT_R8G8B8A8_UNORM || !texture.Pixels) return texture.Format;
+
+    const BeBlockFormat format = BeBlockCompression::ChooseFormat(texture.Pixels, texture.Width, texture.Height);
+    if (format == BeBlockFormat::None) return texture.Format;
+
+    std::vector<BeTexture::BeMipLevel> levels = texture.MipLevels;
+    if (levels.empty())
+        levels.push_back({.Width = texture.Width, .Height = texture.Height, .Offset = 0});
+
+    std::vector<BeTexture::BeMipLevel> blockLevels = BeBlockCompression::Layout(levels, format);
+    const auto blocks = static_cast<uint8_t*>(malloc(BeBlockCompression::GetSizeInBytes(blockLevels, format)));
+    if (!blocks) throw std::runtime_error("Failed to allocate compressed texture");
+    BeBlockCompression::Encode(texture.Pixels, levels, format, blocks, blockLevels, parallel);
+
+    free(texture.Pixels);
+    texture.Pixels = blocks; // free with free()
+    texture.Format = ToDxgiFormat(format, texture.Format);
+    texture.MipLevels = std::move(blockLevels);
+    return texture.Format;
+}
+
+auto BeTextureCompressor::GetBlockSize(const DXGI_FORMAT format) -> uint32_t {
+    return BeBlockCompression::GetBlockSize(ToBlockFormat(format));
+}
+
+auto BeTextureCompressor::ToBlockFormat(const DXGI_FORMAT format) -> BeBlockFormat {
+    switch (format) {
+        case DXGI_FORMAT_BC1_UNORM: return BeBlockFormat::BC1;
+        case DXGI_FORMAT_BC3_UNORM: return BeBlockFormat::BC3;
+        default: return BeBlockFormat::None;
+    }
+}
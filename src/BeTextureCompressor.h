@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <cstdint>
+#include <dxgiformat.h>
+
+#include "BeBlockCompression.h"
+
+struct BeTexture;
+
+// Block compression of BeTexture, BC1 for opaque textures and BC3 otherwise. The encoding itself lives in
+// BeBlockCompression, this maps it onto the texture's allocation and DXGI format.
+namespace BeTextureCompressor {
+
+    // BC1 when alpha is 255 everywhere in level 0, BC3 otherwise, the texture's own format when the size is not a
+    // multiple of 4.
+    [[nodiscard]] auto ChooseFormat(const BeTexture& texture) -> DXGI_FORMAT;
+
+    // Replaces the RGBA8 chain of the texture with blocks of the chosen format, block rows spread across the shared
+    // thread pool. Textures whose size is not a multiple of 4 stay uncompressed, as D3D11 requires it for BC formats.
+    // Returns the format the texture ends up in.
+    auto Compress(BeTexture& texture, bool parallel = true) -> DXGI_FORMAT;
+
+    [[nodiscard]] auto GetBlockSize(DXGI_FORMAT format) -> uint32_t;
+    [[nodiscard]] auto ToBlockFormat(DXGI_FORMAT format) -> BeBlockFormat;
+}
@@ -0,0 +1,189 @@
+﻿#include "BeTextureResidency.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+BeTextureResidency::BeTextureResidency(const size_t budgetBytes) : BudgetBytes(budgetBytes) {}
+
+auto BeTextureResidency::Register(const std::shared_ptr<void>& texture, const std::span<const BeLevel> levels) -> void {
+    if (!texture || levels.empty()) return;
+    if (const auto found = _lookup.find(texture.get()); found != _lookup.end()) {
+        if (!_entries[found->second].Texture.expired()) return;
+        // a new texture at the address of one that died before Update noticed
+        Remove(found->second);
+    }
+
+    _lookup.emplace(texture.get(), static_cast<uint32_t>(_entries.size()));
+    auto& entry = _entries.emplace_back();
+    entry.Texture = texture;
+    entry.Key = texture.get();
+    entry.MipCount = static_cast<uint32_t>(levels.size());
+    entry.BytesFromMip.assign(entry.MipCount + 1, 0);
+    entry.Streamable.assign(entry.MipCount, true);
+    for (uint32_t mip = entry.MipCount; mip-- > 0;) {
+        entry.BytesFromMip[mip] = entry.BytesFromMip[mip + 1] + levels[mip].Bytes;
+        entry.Streamable[mip] = mip == 0 || levels[mip].Streamable;
+    }
+    _chainBytes += entry.BytesFromMip[0];
+
+    // coarsest level within StartSize that can top a GPU texture, level 0 always can
+    uint32_t start = 0;
+    for (uint32_t mip = 0; mip < entry.MipCount; ++mip) {
+        if (!entry.Streamable[mip]) continue;
+        start = mip;
+        if (levels[mip].Width <= StartSize && levels[mip].Height <= StartSize) break;
+    }
+    entry.StartMip = start;
+    entry.ResidentMip = entry.MipCount;   // nothing resident yet
+    entry.RequestedMip = start;
+    entry.LastUsedFrame = 0;
+    SetResidentMip(entry, start);
+}
+
+auto BeTextureResidency::Request(const void* texture, uint32_t mip) -> void {
+    const auto found = _lookup.find(texture);
+    if (found == _lookup.end()) return;
+    auto& entry = _entries[found->second];
+    // a texture that died before Update dropped it, the pointer may already belong to an unregistered one
+    if (entry.Texture.expired()) return;
+    mip = std::min(mip, entry.StartMip);
+    while (mip > 0 && !entry.Streamable[mip]) --mip;
+
+    ++_statistics.Requests;
+    if (entry.ResidentMip <= mip) ++_statistics.SatisfiedRequests;
+    if (entry.LastUsedFrame != _frame) {
+        entry.LastUsedFrame = _frame;
+        entry.RequestedMip = mip;
+    } else {
+        entry.RequestedMip = std::min(entry.RequestedMip, mip);
+    }
+}
+
+auto BeTextureResidency::Update() -> void {
+    // textures nobody holds any more give their memory back first
+    for (size_t i = _entries.size(); i-- > 0;)
+        if (_entries[i].Texture.expired()) Remove(static_cast<uint32_t>(i));
+
+    // Textures below what this frame asked for stream in, the coarsest relative to their request first. Memory
+    // comes from the least recently used textures holding more than they need: unused ones fall back to their start
+    // level, ones drawn this frame at a coarser level than resident go last.
+    std::vector<uint32_t> streamIn;
+    std::vector<uint32_t> evictable;
+    for (uint32_t i = 0; i < _entries.size(); ++i) {
+        const auto& entry = _entries[i];
+        const bool used = entry.LastUsedFrame == _frame;
+        const uint32_t needed = used ? entry.RequestedMip : entry.StartMip;
+        if (entry.ResidentMip > needed) streamIn.push_back(i);
+        else if (entry.ResidentMip < needed) evictable.push_back(i);
+    }
+    std::ranges::sort(streamIn, [this](const uint32_t a, const uint32_t b) {
+        const auto& entryA = _entries[a];
+        const auto& entryB = _entries[b];
+        const uint32_t missingA = entryA.ResidentMip - entryA.RequestedMip;
+        const uint32_t missingB = entryB.ResidentMip - entryB.RequestedMip;
+        if (missingA != missingB) return missingA > missingB;
+        return entryA.BytesFromMip[entryA.RequestedMip] < entryB.BytesFromMip[entryB.RequestedMip];
+    });
+    std::ranges::sort(evictable, [this](const uint32_t a, const uint32_t b) {
+        return _entries[a].LastUsedFrame < _entries[b].LastUsedFrame;
+    });
+
+    auto getEvictionMip = [this](const BeEntry& entry) {
+        return entry.LastUsedFrame == _frame ? entry.RequestedMip : entry.StartMip;
+    };
+    size_t reclaimableBytes = 0;
+    for (const uint32_t index : evictable)
+        reclaimableBytes += _entries[index].ResidentBytes - _entries[index].BytesFromMip[getEvictionMip(_entries[index])];
+    size_t nextEviction = 0;
+    auto evictNext = [&]() {
+        auto& entry = _entries[evictable[nextEviction++]];
+        reclaimableBytes -= entry.ResidentBytes - entry.BytesFromMip[getEvictionMip(entry)];
+        SetResidentMip(entry, getEvictionMip(entry));
+        ++_statistics.Evictions;
+    };
+
+    size_t uploadedBytes = 0;
+    for (const uint32_t index : streamIn) {
+        auto& entry = _entries[index];
+        // the requested level when it fits, otherwise the finest one that does
+        for (uint32_t mip = entry.RequestedMip; mip < entry.ResidentMip; ++mip) {
+            if (!entry.Streamable[mip]) continue;
+            const size_t extraBytes = entry.BytesFromMip[mip] - entry.ResidentBytes;
+            // nothing is evicted for a level that would not fit anyway
+            if (uploadedBytes + extraBytes > MaxUploadBytesPerFrame) continue;
+            if (_residentBytes - reclaimableBytes + extraBytes > BudgetBytes) continue;
+            while (_residentBytes + extraBytes > BudgetBytes)
+                evictNext();
+            uploadedBytes += extraBytes;
+            SetResidentMip(entry, mip);
+            break;
+        }
+    }
+    // a budget lowered at runtime
+    while (_residentBytes > BudgetBytes && nextEviction < evictable.size())
+        evictNext();
+
+    _statistics.PeakResidentBytes = std::max(_statistics.PeakResidentBytes, _residentBytes);
+    assert(ValidateAccounting());
+    ++_frame;
+}
+
+auto BeTextureResidency::GetResidentMip(const void* texture) const -> uint32_t {
+    const auto found = _lookup.find(texture);
+    return found == _lookup.end() ? 0 : _entries[found->second].ResidentMip;
+}
+
+auto BeTextureResidency::GetStatistics() const -> BeStatistics {
+    BeStatistics statistics = _statistics;
+    statistics.Textures = static_cast<uint32_t>(_entries.size());
+    statistics.ResidentBytes = _residentBytes;
+    statistics.ChainBytes = _chainBytes;
+    return statistics;
+}
+
+auto BeTextureResidency::ValidateAccounting() const -> bool {
+    size_t total = 0;
+    size_t chainTotal = 0;
+    for (const auto& entry : _entries) {
+        if (entry.ResidentMip > entry.StartMip) return false;
+        if (entry.ResidentBytes != entry.BytesFromMip[entry.ResidentMip]) return false;
+        if (!entry.Streamable[entry.ResidentMip]) return false;
+        total += entry.ResidentBytes;
+        chainTotal += entry.BytesFromMip[0];
+    }
+    return total == _residentBytes && chainTotal == _chainBytes && _lookup.size() == _entries.size();
+}
+
+auto BeTextureResidency::Remove(const uint32_t index) -> void {
+    _residentBytes -= _entries[index].ResidentBytes;
+    _chainBytes -= _entries[index].BytesFromMip[0];
+    _lookup.erase(_entries[index].Key);
+    if (index + 1 != _entries.size()) {
+        _entries[index] = std::move(_entries.back());
+        _lookup[_entries[index].Key] = index;
+    }
+    _entries.pop_back();
+}
+
+auto BeTextureResidency::SetResidentMip(BeEntry& entry, const uint32_t mip) -> void {
+    if (mip == entry.ResidentMip) return;
+    const size_t bytes = entry.BytesFromMip[mip];
+    if (bytes > entry.ResidentBytes) _statistics.StreamedInBytes += bytes - entry.ResidentBytes;
+    else _statistics.StreamedOutBytes += entry.ResidentBytes - bytes;
+    _residentBytes = _residentBytes - entry.ResidentBytes + bytes;
+    entry.ResidentBytes = bytes;
+    entry.ResidentMip = mip;
+    if (Upload)
+        if (const auto texture = entry.Texture.lock())
+            Upload(texture.get(), mip);
+}
+
+auto BeTextureResidency::ComputeRequiredMip(const uint32_t size, const uint32_t mipCount, const float uvPerUnit, const float pixelsPerUnit) -> uint32_t {
+    const uint32_t lastMip = mipCount - 1;
+    if (pixelsPerUnit <= 0.0f) return lastMip;
+    // texels of level 0 under one screen pixel, each level halves it
+    const float texelsPerPixel = float(size) * uvPerUnit / pixelsPerUnit;
+    if (!(texelsPerPixel > 1.0f)) return 0;
+    return std::min(static_cast<uint32_t>(std::floor(std::log2(texelsPerPixel))), lastMip);
+}
@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// The residency policy of BeTextureStreamer without any graphics API: registered textures keep a coarse start level
+// resident and stream finer levels in as they are requested, within a byte budget, least recently used textures give
+// theirs back when it runs out. Textures are opaque here, a level change reaches the owner through Upload.
+class BeTextureResidency {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    // textures start with the levels no larger than this resident
+    static constexpr uint32_t StartSize = 64;
+
+    struct BeLevel {
+        uint32_t Width = 1;
+        uint32_t Height = 1;
+        size_t Bytes = 0;
+        bool Streamable = true;   // can top a GPU texture, block compressed levels need multiples of 4
+    };
+
+    struct BeStatistics {
+        uint32_t Textures = 0;
+        size_t ResidentBytes = 0;
+        size_t PeakResidentBytes = 0;
+        size_t ChainBytes = 0;            // every level of the registered textures, the CPU copy streaming reads from
+        uint64_t StreamedInBytes = 0;
+        uint64_t StreamedOutBytes = 0;
+        uint64_t Evictions = 0;
+        uint64_t Requests = 0;
+        uint64_t SatisfiedRequests = 0;   // requests whose level was already resident
+    };
+
+    // The texture as registered and the finest level that is resident from now on.
+    using BeUploadCallback = std::function<void(void* texture, uint32_t mip)>;
+
+    // Finest level worth sampling of a texture whose largest side is size texels, when one model space unit covers
+    // pixelsPerUnit pixels and uvPerUnit UV units.
+    [[nodiscard]] static auto ComputeRequiredMip(uint32_t size, uint32_t mipCount, float uvPerUnit, float pixelsPerUnit) -> uint32_t;
+
+private:
+    struct BeEntry {
+        std::weak_ptr<void> Texture;
+        const void* Key = nullptr;      // lookup key, still valid to erase once the texture expired
+        uint32_t MipCount = 1;
+        uint32_t StartMip = 0;          // coarsest resident level the texture never drops below
+        uint32_t ResidentMip = 0;       // finest level resident, every coarser one is resident too
+        uint32_t RequestedMip = 0;      // finest level asked for in the current frame
+        uint64_t LastUsedFrame = 0;
+        size_t ResidentBytes = 0;
+        std::vector<size_t> BytesFromMip;   // bytes of the chain from each level down, plus 0 past the end
+        std::vector<bool> Streamable;
+    };
+
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<BeEntry> _entries;
+    std::unordered_map<const void*, uint32_t> _lookup;
+    size_t _residentBytes = 0;
+    size_t _chainBytes = 0;
+    uint64_t _frame = 1;
+    BeStatistics _statistics;
+
+public:
+    size_t BudgetBytes;
+    // bounds the upload stall of a single frame
+    size_t MaxUploadBytesPerFrame = 32ull << 20;
+    BeUploadCallback Upload;
+
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeTextureResidency(size_t budgetBytes = 256ull << 20);
+    ~BeTextureResidency() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Makes the start levels resident. Textures registered twice keep their state, an expired texture at the same
+    // address is dropped first.
+    auto Register(const std::shared_ptr<void>& texture, std::span<const BeLevel> levels) -> void;
+    // Asks for a level for this frame, several requests keep the finest.
+    auto Request(const void* texture, uint32_t mip) -> void;
+    // Drops expired textures, applies the frame's requests within the budget and starts the next frame.
+    auto Update() -> void;
+
+    [[nodiscard]] auto GetResidentMip(const void* texture) const -> uint32_t;
+    [[nodiscard]] auto GetStatistics() const -> BeStatistics;
+    // Resident and chain bytes match the sums over the entries and every entry sits between level 0 and its start level.
+    [[nodiscard]] auto ValidateAccounting() const -> bool;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto Remove(uint32_t index) -> void;
+    auto SetResidentMip(BeEntry& entry, uint32_t mip) -> void;
+};
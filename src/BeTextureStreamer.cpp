@@ -0,0 +1,121 @@
+﻿#include "BeTextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <iostream>
+
+#include "BeTexture.h"
+#include "Utils.h"
+
+namespace {
+    auto GetLevelSize(const BeTexture& texture, const uint32_t mip) -> glm::uvec2 {
+        if (texture.MipLevels.empty()) return {texture.Width, texture.Height};
+        return {texture.MipLevels[mip].Width, texture.MipLevels[mip].Height};
+    }
+
+    auto GetLevelOffset(const BeTexture& texture, const uint32_t mip) -> size_t {
+        return texture.MipLevels.empty() ? 0 : texture.MipLevels[mip].Offset;
+    }
+}
+
+BeTextureStreamer::BeTextureStreamer(const ComPtr<ID3D11Device>& device, const size_t budgetBytes)
+    : _device(device), _residency(budgetBytes) {
+    if (_device)
+        _residency.Upload = [this](void* texture, const uint32_t mip) { Upload(*static_cast<BeTexture*>(texture), mip); };
+}
+
+auto BeTextureStreamer::Register(const std::shared_ptr<BeTexture>& texture) -> void {
+    if (!texture) return;
+    std::vector<BeTextureResidency::BeLevel> levels(texture->GetMipCount());
+    for (uint32_t mip = 0; mip < levels.size(); ++mip) {
+        const glm::uvec2 size = GetLevelSize(*texture, mip);
+        levels[mip] = {
+            .Width = size.x,
+            .Height = size.y,
+            .Bytes = texture->GetLevelSizeInBytes(size.x, size.y),
+            .Streamable = !texture->IsBlockCompressed() || (size.x % 4 == 0 && size.y % 4 == 0),
+        };
+    }
+    _residency.Register(texture, levels);
+}
+
+auto BeTextureStreamer::RegisterModel(const BeModel& model) -> void {
+    for (const auto& slice : model.DrawSlices) {
+        Register(slice.Material.DiffuseTexture);
+        Register(slice.Material.SpecularTexture);
+    }
+}
+
+auto BeTextureStreamer::PrintStatistics() const -> void {
+    const BeStatistics statistics = GetStatistics();
+    std::cout << std::format(
+        "Texture streaming: {} textures, {:.1f} / {:.1f} MB resident (peak {:.1f} MB), {:.1f} MB on the CPU, {:.1f} MB in, {:.1f} MB out, {} evictions, {:.1f}% of requests resident\n",
+        statistics.Textures,
+        double(statistics.ResidentBytes) / (1024.0 * 1024.0),
+        double(_residency.BudgetBytes) / (1024.0 * 1024.0),
+        double(statistics.PeakResidentBytes) / (1024.0 * 1024.0),
+        double(statistics.ChainBytes) / (1024.0 * 1024.0),
+        double(statistics.StreamedInBytes) / (1024.0 * 1024.0),
+        double(statistics.StreamedOutBytes) / (1024.0 * 1024.0),
+        statistics.Evictions,
+        statistics.Requests > 0 ? 100.0 * double(statistics.SatisfiedRequests) / double(statistics.Requests) : 100.0);
+}
+
+auto BeTextureStreamer::Upload(BeTexture& texture, const uint32_t mip) const -> void {
+    // D3D11 has no partially resident textures, so the levels from mip down get a texture of their own and the
+    // view is swapped. Draws already recorded keep the old one alive.
+    const uint32_t mipCount = texture.GetMipCount() - mip;
+    const glm::uvec2 size = GetLevelSize(texture, mip);
+    const D3D11_TEXTURE2D_DESC desc = {
+        .Width = size.x,
+        .Height = size.y,
+        .MipLevels = mipCount,
+        .ArraySize = 1,
+        .Format = texture.Format,
+        .SampleDesc = { .Count = 1 },
+        .Usage = D3D11_USAGE_IMMUTABLE,
+        .BindFlags = D3D11_BIND_SHADER_RESOURCE,
+        .CPUAccessFlags = 0,
+        .MiscFlags = 0,
+    };
+
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    for (uint32_t level = mip; level < texture.GetMipCount(); ++level) {
+        initData.push_back({
+            .pSysMem = texture.Pixels + GetLevelOffset(texture, level),
+            .SysMemPitch = texture.GetRowPitch(GetLevelSize(texture, level).x),
+        });
+    }
+
+    ComPtr<ID3D11Texture2D> d3dTexture = nullptr;
+    Utils::Check << _device->CreateTexture2D(&desc, initData.data(), &d3dTexture);
+
+    const D3D11_SHADER_RESOURCE_VIEW_DESC srvDescriptor = {
+        .Format = texture.Format,
+        .ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D,
+        .Texture2D = { .MostDetailedMip = 0, .MipLevels = mipCount },
+    };
+    ComPtr<ID3D11ShaderResourceView> srv = nullptr;
+    Utils::Check << _device->CreateShaderResourceView(d3dTexture.Get(), &srvDescriptor, srv.GetAddressOf());
+    texture.SRV = srv;
+}
+
+auto BeTextureStreamer::ComputeRequiredMip(const BeTexture& texture, const float uvPerUnit, const float pixelsPerUnit) -> uint32_t {
+    return BeTextureResidency::ComputeRequiredMip(std::max(texture.Width, texture.Height), texture.GetMipCount(), uvPerUnit, pixelsPerUnit);
+}
+
+auto BeTextureStreamer::ComputeUVDensity(const BeModel& model, const BeModel::BeDrawSlice& slice) -> float {
+    double uvArea = 0.0;
+    double surfaceArea = 0.0;
+    for (uint32_t i = 0; i + 2 < slice.IndexCount; i += 3) {
+        const auto& v0 = model.FullVertices[slice.BaseVertexLocation + model.Indices[slice.StartIndexLocation + i + 0]];
+        const auto& v1 = model.FullVertices[slice.BaseVertexLocation + model.Indices[slice.StartIndexLocation + i + 1]];
+        const auto& v2 = model.FullVertices[slice.BaseVertexLocation + model.Indices[slice.StartIndexLocation + i + 2]];
+        const glm::vec2 uv1 = v1.UV0 - v0.UV0;
+        const glm::vec2 uv2 = v2.UV0 - v0.UV0;
+        uvArea += std::abs(uv1.x * uv2.y - uv1.y * uv2.x) * 0.5;
+        surfaceArea += glm::length(glm::cross(v1.Position - v0.Position, v2.Position - v0.Position)) * 0.5;
+    }
+    return surfaceArea > 0.0 ? static_cast<float>(std::sqrt(uvArea / surfaceArea)) : 0.0f;
+}
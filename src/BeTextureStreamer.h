@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <cstdint>
+#include <memory>
+#include <wrl/client.h>
+#include <d3d11.h>
+
+#include "BeModel.h"
+#include "BeTextureResidency.h"
+
+struct BeTexture;
+using Microsoft::WRL::ComPtr;
+
+// Keeps registered textures on the GPU from a coarse start level down to the finest level recently requested,
+// within a byte budget. Renderers request a level for every texture they draw, Update then streams finer levels
+// in, least recently used textures give theirs back when the budget runs out. The policy lives in
+// BeTextureResidency, this class describes BeTexture mip chains to it and uploads the levels it picks. The CPU mip
+// chain in BeTexture::Pixels is the streaming source and stays allocated: textures are decoded, filtered and block
+// compressed at import with no cooked copy on disk, so a released level could only come back by redoing all of that.
+// The statistics report these bytes as ChainBytes.
+class BeTextureStreamer {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    static constexpr uint32_t StartSize = BeTextureResidency::StartSize;
+    using BeStatistics = BeTextureResidency::BeStatistics;
+
+    // Finest level worth sampling when one model space unit covers pixelsPerUnit pixels and uvPerUnit UV units.
+    [[nodiscard]] static auto ComputeRequiredMip(const BeTexture& texture, float uvPerUnit, float pixelsPerUnit) -> uint32_t;
+    // Average UV units per model space unit over a slice, from the ratio of UV area to surface area.
+    [[nodiscard]] static auto ComputeUVDensity(const BeModel& model, const BeModel::BeDrawSlice& slice) -> float;
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    ComPtr<ID3D11Device> _device;
+    BeTextureResidency _residency;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Without a device only the residency bookkeeping runs.
+    explicit BeTextureStreamer(const ComPtr<ID3D11Device>& device = nullptr, size_t budgetBytes = 256ull << 20);
+    ~BeTextureStreamer() = default;
+    // the residency's upload callback points back here
+    BeTextureStreamer(const BeTextureStreamer&) = delete;
+    BeTextureStreamer& operator=(const BeTextureStreamer&) = delete;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // Makes the start levels resident. Textures registered twice keep their state.
+    auto Register(const std::shared_ptr<BeTexture>& texture) -> void;
+    auto RegisterModel(const BeModel& model) -> void;
+    // Forwarded to the residency, see BeTextureResidency::Request.
+    auto Request(const BeTexture* texture, uint32_t mip) -> void { _residency.Request(texture, mip); }
+    // Applies the frame's requests within the budget and starts the next frame.
+    auto Update() -> void { _residency.Update(); }
+
+    [[nodiscard]] auto GetResidency() -> BeTextureResidency& { return _residency; }
+    [[nodiscard]] auto GetResidentMip(const BeTexture* texture) const -> uint32_t { return _residency.GetResidentMip(texture); }
+    [[nodiscard]] auto GetStatistics() const -> BeStatistics { return _residency.GetStatistics(); }
+    auto PrintStatistics() const -> void;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto Upload(BeTexture& texture, uint32_t mip) const -> void;
+};
@@ -0,0 +1,104 @@
+﻿#include "BeThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+//static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeThreadPool::Shared() -> BeThreadPool& {
+    // leave one core to the thread that waits on the pool
+    static BeThreadPool pool(std::max(1u, std::thread::hardware_concurrency() - 1));
+    return pool;
+}
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeThreadPool::BeThreadPool(const uint32_t threadCount) {
+    _workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        _workers.emplace_back([this] { WorkerLoop(); });
+}
+
+BeThreadPool::~BeThreadPool() {
+    {
+        std::lock_guard lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+    for (auto& worker : _workers)
+        worker.join();
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeThreadPool::Submit(std::function<void()> job) -> void {
+    {
+        std::lock_guard lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _condition.notify_one();
+}
+
+auto BeThreadPool::ParallelFor(const uint32_t count, const std::function<void(uint32_t)>& body) -> void {
+    if (count == 0) return;
+    if (count == 1) {
+        body(0);
+        return;
+    }
+
+    struct BeSharedState {
+        std::atomic<uint32_t> Next = 0;
+        std::atomic<uint32_t> Finished = 0;
+        std::mutex Mutex;
+        std::condition_variable Condition;
+        std::exception_ptr Error = nullptr;
+    };
+    const auto state = std::make_shared<BeSharedState>();
+
+    // helpers that start after the range is drained return straight away, hence the shared state
+    auto drain = [state, count, &body] {
+        uint32_t done = 0;
+        for (uint32_t i = state->Next++; i < count; i = state->Next++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard lock(state->Mutex);
+                if (!state->Error) state->Error = std::current_exception();
+            }
+            ++done;
+        }
+        if (done == 0) return;
+        if (state->Finished.fetch_add(done) + done == count) {
+            std::lock_guard lock(state->Mutex);
+            state->Condition.notify_all();
+        }
+    };
+
+    const uint32_t helpers = std::min(count - 1, GetThreadCount());
+    for (uint32_t i = 0; i < helpers; ++i)
+        Submit(drain);
+    drain();
+
+    std::unique_lock lock(state->Mutex);
+    state->Condition.wait(lock, [&] { return state->Finished.load() == count; });
+    if (state->Error)
+        std::rethrow_exception(state->Error);
+}
+
+//private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeThreadPool::WorkerLoop() -> void {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(_mutex);
+            _condition.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_stopping && _jobs.empty()) return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
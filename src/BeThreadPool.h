@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BeThreadPool {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    // Process-wide pool sized to the machine, shared by startup, importing and per-frame work.
+    static auto Shared() -> BeThreadPool&;
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopping = false;
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeThreadPool(uint32_t threadCount);
+    ~BeThreadPool();
+    BeThreadPool(const BeThreadPool&) = delete;
+    BeThreadPool& operator=(const BeThreadPool&) = delete;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    [[nodiscard]] auto GetThreadCount() const -> uint32_t { return static_cast<uint32_t>(_workers.size()); }
+
+    auto Submit(std::function<void()> job) -> void;
+
+    // Runs body(i) for every i in [0, count). The calling thread takes part, so it is safe to call from a job.
+    auto ParallelFor(uint32_t count, const std::function<void(uint32_t)>& body) -> void;
+
+private:
+    //private logic/////////////////////////////////////////////////////////////////////////////////////////////////////
+    auto WorkerLoop() -> void;
+};
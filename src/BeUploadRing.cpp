@@ -0,0 +1,29 @@
+﻿#include "BeUploadRing.h"
+
+#include <format>
+#include <stdexcept>
+
+//initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+
+BeUploadRing::BeUploadRing(const uint32_t capacity) {
+    Reset(capacity);
+}
+
+//public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+
+auto BeUploadRing::Allocate(const uint32_t size, const uint32_t alignment) -> BeAllocation {
+    if (size > _capacity)
+        throw std::runtime_error(std::format("Upload of {} bytes does not fit a ring of {} bytes", size, _capacity));
+    const uint64_t start = (uint64_t(_head) + alignment - 1) & ~uint64_t(alignment - 1);
+    if (start + size > _capacity) {
+        _head = size;
+        return {.Offset = 0, .Wrapped = true};
+    }
+    _head = static_cast<uint32_t>(start + size);
+    return {.Offset = static_cast<uint32_t>(start), .Wrapped = false};
+}
+
+auto BeUploadRing::Reset(const uint32_t capacity) -> void {
+    _capacity = capacity;
+    _head = capacity;
+}
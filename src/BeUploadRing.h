@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <cstdint>
+
+// Hands out byte ranges of a dynamic GPU buffer the CPU refills every frame, front to back, starting over at the
+// beginning when a range no longer fits. A range behind the previous one is mapped with WRITE_NO_OVERWRITE, nothing
+// the GPU may still read is touched; a range that wrapped is mapped with WRITE_DISCARD, which hands the buffer fresh
+// memory. Sized for a few frames, the driver renames the buffer once every few frames instead of every frame.
+class BeUploadRing {
+    //static part///////////////////////////////////////////////////////////////////////////////////////////////////////
+public:
+    struct BeAllocation {
+        uint32_t Offset;
+        bool Wrapped;   // map with WRITE_DISCARD, everything handed out before is gone
+    };
+
+private:
+    //fields////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    uint32_t _capacity = 0;
+    uint32_t _head = 0;   // the capacity until the first allocation, so that one discards
+
+public:
+    //initialisation////////////////////////////////////////////////////////////////////////////////////////////////////
+    explicit BeUploadRing(uint32_t capacity = 0);
+    ~BeUploadRing() = default;
+
+    //public interface//////////////////////////////////////////////////////////////////////////////////////////////////
+    // size bytes at a multiple of alignment, a power of two. Throws when size exceeds the capacity.
+    [[nodiscard]] auto Allocate(uint32_t size, uint32_t alignment = 16) -> BeAllocation;
+    // Forgets every allocation, the next one wraps.
+    auto Reset(uint32_t capacity) -> void;
+
+    [[nodiscard]] auto GetCapacity() const -> uint32_t { return _capacity; }
+};
@@ -0,0 +1,113 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+
+enum class BeVertexSemantic : uint8_t {
+    Position,
+    Normal,
+    NormalOctahedral,   // unit normal folded onto an octahedron, two snorm16
+    Color3,
+    Color4,
+    TexCoord0,
+    TexCoord0Half,      // two half floats
+    TexCoord1,
+    TexCoord2,
+    _Count
+};
+
+// DXGI_FORMAT values of the element formats, so layouts stay free of D3D headers. BeShader.cpp checks them against
+// dxgiformat.h.
+enum class BeVertexFormat : uint32_t {
+    R32G32B32A32Float = 2,
+    R32G32B32Float = 6,
+    R32G32Float = 16,
+    R16G16Float = 34,
+    R16G16Snorm = 37,
+};
+
+struct BeVertexElementDescriptor {
+    BeVertexSemantic Semantic;
+    const char* SemanticName;
+    uint32_t SemanticIndex;
+    BeVertexFormat Format;
+    uint32_t Size;
+};
+
+inline constexpr std::array<BeVertexElementDescriptor, static_cast<size_t>(BeVertexSemantic::_Count)> VertexElementDescriptors = {{
+    {BeVertexSemantic::Position,         "POSITION", 0, BeVertexFormat::R32G32B32Float,    12},
+    {BeVertexSemantic::Normal,           "NORMAL",   0, BeVertexFormat::R32G32B32Float,    12},
+    {BeVertexSemantic::NormalOctahedral, "NORMAL",   0, BeVertexFormat::R16G16Snorm,        4},
+    {BeVertexSemantic::Color3,           "COLOR",    0, BeVertexFormat::R32G32B32Float,    12},
+    {BeVertexSemantic::Color4,           "COLOR",    0, BeVertexFormat::R32G32B32A32Float, 16},
+    {BeVertexSemantic::TexCoord0,        "TEXCOORD", 0, BeVertexFormat::R32G32Float,        8},
+    {BeVertexSemantic::TexCoord0Half,    "TEXCOORD", 0, BeVertexFormat::R16G16Float,        4},
+    {BeVertexSemantic::TexCoord1,        "TEXCOORD", 1, BeVertexFormat::R32G32Float,        8},
+    {BeVertexSemantic::TexCoord2,        "TEXCOORD", 2, BeVertexFormat::R32G32Float,        8},
+}};
+
+constexpr auto GetVertexElementDescriptor(const BeVertexSemantic semantic) -> const BeVertexElementDescriptor& {
+    return VertexElementDescriptors[static_cast<size_t>(semantic)];
+}
+
+static_assert([] {
+    for (size_t i = 0; i < VertexElementDescriptors.size(); ++i)
+        if (static_cast<size_t>(VertexElementDescriptors[i].Semantic) != i) return false;
+    return true;
+}(), "VertexElementDescriptors must be in BeVertexSemantic order");
+
+// Tightly packed vertex layout with offsets worked out when the layout is constructed, so a constexpr layout is
+// fully resolved at compile time. Shaders declare the layout they read and the geometry pass packs to it.
+struct BeVertexLayout {
+    static constexpr uint32_t MaxElements = 8;
+
+    struct BeElement {
+        BeVertexSemantic Semantic = BeVertexSemantic::Position;
+        uint32_t Offset = 0;
+
+        constexpr auto operator==(const BeElement&) const -> bool = default;
+    };
+
+    std::array<BeElement, MaxElements> Elements {};
+    uint32_t ElementCount = 0;
+    uint32_t Stride = 0;
+
+    constexpr BeVertexLayout() = default;
+    constexpr BeVertexLayout(const std::initializer_list<BeVertexSemantic> semantics) {
+        for (const auto semantic : semantics) {
+            if (ElementCount == MaxElements) throw std::length_error("Too many vertex elements");
+            Elements[ElementCount++] = {.Semantic = semantic, .Offset = Stride};
+            Stride += GetVertexElementDescriptor(semantic).Size;
+        }
+    }
+
+    [[nodiscard]] constexpr auto IsEmpty() const -> bool { return ElementCount == 0; }
+    [[nodiscard]] constexpr auto begin() const { return Elements.begin(); }
+    [[nodiscard]] constexpr auto end() const { return Elements.begin() + ElementCount; }
+
+    constexpr auto operator==(const BeVertexLayout&) const -> bool = default;
+};
+
+// Object shaders read their world matrix per instance from a second stream, as the four float4 INSTANCE_MODEL rows.
+inline constexpr uint32_t InstanceStreamSlot = 1;
+inline constexpr uint32_t InstanceStride = 64;
+
+// what the standard shader reads
+inline constexpr BeVertexLayout StandardVertexLayout {
+    BeVertexSemantic::Position,
+    BeVertexSemantic::NormalOctahedral,
+    BeVertexSemantic::TexCoord0Half,
+};
+// BeFullVertex as it sits in memory
+inline constexpr BeVertexLayout FullVertexLayout {
+    BeVertexSemantic::Position,
+    BeVertexSemantic::Normal,
+    BeVertexSemantic::Color4,
+    BeVertexSemantic::TexCoord0,
+    BeVertexSemantic::TexCoord1,
+    BeVertexSemantic::TexCoord2,
+};
+
+static_assert(StandardVertexLayout.Stride == 20);
+static_assert(FullVertexLayout.Stride == 64);
@@ -0,0 +1,211 @@
+﻿#include "BeVertexPacking.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <iostream>
+
+namespace {
+    auto SignNotZero(const float value) -> float {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    auto ToSnorm16(const float value) -> int16_t {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+}
+
+auto BeVertexPacking::EncodeOctahedral(const glm::vec3& normal) -> std::array<int16_t, 2> {
+    const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum == 0.0f) return {0, 0};
+
+    glm::vec2 folded = glm::vec2(normal.x, normal.y) / sum;
+    if (normal.z < 0.0f) {
+        // lower hemisphere folds over the diagonals onto the outer triangles of the square
+        folded = {
+            (1.0f - std::abs(folded.y)) * SignNotZero(folded.x),
+            (1.0f - std::abs(folded.x)) * SignNotZero(folded.y),
+        };
+    }
+    return {ToSnorm16(folded.x), ToSnorm16(folded.y)};
+}
+
+auto BeVertexPacking::DecodeOctahedral(const std::array<int16_t, 2>& encoded) -> glm::vec3 {
+    // snorm conversion as the input assembler does it, -32768 clamps to -1
+    const glm::vec2 folded = {
+        std::max(float(encoded[0]) / 32767.0f, -1.0f),
+        std::max(float(encoded[1]) / 32767.0f, -1.0f),
+    };
+    glm::vec3 normal = {folded.x, folded.y, 1.0f - std::abs(folded.x) - std::abs(folded.y)};
+    const float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+    return glm::normalize(normal);
+}
+
+auto BeVertexPacking::FloatToHalf(const float value) -> uint16_t {
+    const auto bits = std::bit_cast<uint32_t>(value);
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t exponentBits = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponentBits == 0xFF)
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0)); // infinity or NaN
+    const int32_t exponent = int32_t(exponentBits) - 127 + 15;
+    if (exponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00); // overflows to infinity
+
+    if (exponent <= 0) {
+        // subnormal half, or zero when even that is too small
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+auto BeVertexPacking::HalfToFloat(const uint16_t value) -> float {
+    const uint32_t sign = uint32_t(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1F;
+    const uint32_t mantissa = value & 0x3FF;
+
+    if (exponent == 0) {
+        const float magnitude = std::ldexp(float(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31)
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    return std::bit_cast<float>(sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+}
+
+auto BeVertexPacking::PackVertices(
+    const std::span<const BeFullVertex> vertices,
+    const BeVertexLayout& layout,
+    uint8_t* destination)
+-> void {
+    for (const auto& vertex : vertices) {
+        for (const auto& element : layout) {
+            uint8_t* target = destination + element.Offset;
+            switch (element.Semantic) {
+                case BeVertexSemantic::Position:
+                    memcpy(target, &vertex.Position, 12);
+                    break;
+                case BeVertexSemantic::Normal:
+                    memcpy(target, &vertex.Normal, 12);
+                    break;
+                case BeVertexSemantic::NormalOctahedral: {
+                    const auto encoded = EncodeOctahedral(vertex.Normal);
+                    memcpy(target, encoded.data(), 4);
+                    break;
+                }
+                case BeVertexSemantic::Color3:
+                    memcpy(target, &vertex.Color, 12);
+                    break;
+                case BeVertexSemantic::Color4:
+                    memcpy(target, &vertex.Color, 16);
+                    break;
+                case BeVertexSemantic::TexCoord0:
+                    memcpy(target, &vertex.UV0, 8);
+                    break;
+                case BeVertexSemantic::TexCoord0Half: {
+                    const uint16_t encoded[2] = {FloatToHalf(vertex.UV0.x), FloatToHalf(vertex.UV0.y)};
+                    memcpy(target, encoded, 4);
+                    break;
+                }
+                case BeVertexSemantic::TexCoord1:
+                    memcpy(target, &vertex.UV1, 8);
+                    break;
+                case BeVertexSemantic::TexCoord2:
+                    memcpy(target, &vertex.UV2, 8);
+                    break;
+                case BeVertexSemantic::_Count:
+                    break;
+            }
+        }
+        destination += layout.Stride;
+    }
+}
+
+auto BeVertexPacking::PackVertices(const std::span<const BeFullVertex> vertices, const BeVertexLayout& layout) -> std::vector<uint8_t> {
+    std::vector<uint8_t> packed(vertices.size() * layout.Stride);
+    PackVertices(vertices, layout, packed.data());
+    return packed;
+}
+
+auto BeVertexPacking::UnpackVertex(const uint8_t* source, const BeVertexLayout& layout) -> BeFullVertex {
+    BeFullVertex vertex {};
+    for (const auto& element : layout) {
+        const uint8_t* data = source + element.Offset;
+        switch (element.Semantic) {
+            case BeVertexSemantic::Position:
+                memcpy(&vertex.Position, data, 12);
+                break;
+            case BeVertexSemantic::Normal:
+                memcpy(&vertex.Normal, data, 12);
+                break;
+            case BeVertexSemantic::NormalOctahedral: {
+                std::array<int16_t, 2> encoded;
+                memcpy(encoded.data(), data, 4);
+                vertex.Normal = DecodeOctahedral(encoded);
+                break;
+            }
+            case BeVertexSemantic::Color3:
+                memcpy(&vertex.Color, data, 12);
+                break;
+            case BeVertexSemantic::Color4:
+                memcpy(&vertex.Color, data, 16);
+                break;
+            case BeVertexSemantic::TexCoord0:
+                memcpy(&vertex.UV0, data, 8);
+                break;
+            case BeVertexSemantic::TexCoord0Half: {
+                uint16_t encoded[2];
+                memcpy(encoded, data, 4);
+                vertex.UV0 = {HalfToFloat(encoded[0]), HalfToFloat(encoded[1])};
+                break;
+            }
+            case BeVertexSemantic::TexCoord1:
+                memcpy(&vertex.UV1, data, 8);
+                break;
+            case BeVertexSemantic::TexCoord2:
+                memcpy(&vertex.UV2, data, 8);
+                break;
+            case BeVertexSemantic::_Count:
+                break;
+        }
+    }
+    return vertex;
+}
+
+auto BeVertexPacking::Measure(const std::span<const BeFullVertex> vertices, const BeVertexLayout& layout) -> BeStatistics {
+    BeStatistics statistics {
+        .VertexCount = static_cast<uint32_t>(vertices.size()),
+        .PackedStride = layout.Stride,
+    };
+    std::vector<uint8_t> packed(layout.Stride);
+    for (const auto& vertex : vertices) {
+        PackVertices({&vertex, 1}, layout, packed.data());
+        const BeFullVertex unpacked = UnpackVertex(packed.data(), layout);
+
+        const float normalLength = glm::length(vertex.Normal);
+        if (normalLength > 0.0f) {
+            const float cosine = std::clamp(glm::dot(vertex.Normal / normalLength, unpacked.Normal), -1.0f, 1.0f);
+            statistics.MaxNormalErrorDegrees = std::max(statistics.MaxNormalErrorDegrees, glm::degrees(std::acos(cosine)));
+        }
+        const glm::vec2 texCoordError = glm::abs(vertex.UV0 - unpacked.UV0);
+        statistics.MaxTexCoordError = std::max({statistics.MaxTexCoordError, texCoordError.x, texCoordError.y});
+    }
+    return statistics;
+}
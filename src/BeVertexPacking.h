@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm.hpp>
+
+#include "BeModel.h"
+#include "BeVertexLayout.h"
+
+// Converts BeFullVertex data to and from the packed layouts shaders declare.
+namespace BeVertexPacking {
+
+    struct BeStatistics {
+        uint32_t VertexCount = 0;
+        uint32_t PackedStride = 0;
+        float MaxNormalErrorDegrees = 0.0f;   // angle between the source normal and the decoded one
+        float MaxTexCoordError = 0.0f;        // largest absolute UV0 difference after decoding
+    };
+
+    // Octahedral mapping of a unit vector to two snorm16, matching DecodeOctahedral in BeFunctions.hlsli.
+    [[nodiscard]] auto EncodeOctahedral(const glm::vec3& normal) -> std::array<int16_t, 2>;
+    [[nodiscard]] auto DecodeOctahedral(const std::array<int16_t, 2>& encoded) -> glm::vec3;
+
+    // IEEE 754 binary16, rounded to nearest even.
+    [[nodiscard]] auto FloatToHalf(float value) -> uint16_t;
+    [[nodiscard]] auto HalfToFloat(uint16_t value) -> float;
+
+    // Writes layout.Stride bytes per vertex.
+    auto PackVertices(std::span<const BeFullVertex> vertices, const BeVertexLayout& layout, uint8_t* destination) -> void;
+    [[nodiscard]] auto PackVertices(std::span<const BeFullVertex> vertices, const BeVertexLayout& layout) -> std::vector<uint8_t>;
+    // Attributes the layout does not carry keep their BeFullVertex defaults.
+    [[nodiscard]] auto UnpackVertex(const uint8_t* source, const BeVertexLayout& layout) -> BeFullVertex;
+
+    // Round trips every vertex through the layout and measures what the quantisation costs.
+    [[nodiscard]] auto Measure(std::span<const BeFullVertex> vertices, const BeVertexLayout& layout) -> BeStatistics;
+}
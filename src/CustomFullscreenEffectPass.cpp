@@ -1,47 +1,57 @@
 ﻿#include "CustomFullscreenEffectPass.h"
 
+#include "BePipelineCache.h"
 #include "BeRenderer.h"
 #include "BeShader.h"
 
 CustomFullscreenEffectPass::CustomFullscreenEffectPass() = default;
 CustomFullscreenEffectPass::~CustomFullscreenEffectPass() = default;
 
-auto CustomFullscreenEffectPass::Initialise() -> void {}
+auto CustomFullscreenEffectPass::GetResources() const -> BeRenderGraph::BePassResources {
+    return {.Reads = InputTextureNames, .Writes = OutputTextureNames};
+}
 
-auto CustomFullscreenEffectPass::Render() -> void {
-    const auto context = _renderer->GetContext();
+auto CustomFullscreenEffectPass::Initialise() -> void {
+    _inputTextures.clear();
+    for (const auto& inputTextureName : InputTextureNames)
+        _inputTextures.push_back(_renderer->FindRenderResource(inputTextureName));
+    _outputTextures.clear();
+    for (const auto& outputTextureName : OutputTextureNames)
+        _outputTextures.push_back(_renderer->FindRenderResource(outputTextureName));
+
+    _pipeline = _renderer->GetPipelineCache().Get({
+        .VertexShader = _renderer->GetFullscreenShader(),
+        .PixelShader = Shader,
+        .DepthStencil = BePipelineCache::DisabledDepthStencil,
+        .Topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP,
+    });
+}
 
-    // Set input resources
-    std::vector<ID3D11ShaderResourceView*> inputResources;
-    for (const auto& inputTextureName : InputTextureNames) {
-        const auto resource = _renderer->GetRenderResource(inputTextureName);
-        inputResources.push_back(resource->SRV.Get());
+auto CustomFullscreenEffectPass::Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void {
+    if (Bypassed) {
+        const auto input = _renderer->GetRenderResource(_inputTextures.front());
+        const auto output = _renderer->GetRenderResource(_outputTextures.front());
+        context.CopyTextureRegion(output->Texture.Get(), input->Texture.Get(), _renderer->GetRenderWidth(), _renderer->GetRenderHeight());
+        return;
     }
-    context->PSSetShaderResources(0, inputResources.size(), inputResources.data());
 
-    // Set output render targets
+    // Set output render targets, before the inputs: the targets of the previous pass are unbound with its inputs
     std::vector<ID3D11RenderTargetView*> renderTargets;
-    for (const auto& outputTextureName : OutputTextureNames) {
-        const auto resource = _renderer->GetRenderResource(outputTextureName);
+    for (const BeHandle outputTexture : _outputTextures) {
+        const auto resource = _renderer->GetRenderResource(outputTexture);
         renderTargets.push_back(resource->RTV.Get());
     }
-    context->OMSetRenderTargets(renderTargets.size(), renderTargets.data(), nullptr);
-
-    
-    context->PSSetSamplers(0, 1, _renderer->GetPointSampler().GetAddressOf());
-    
-    context->VSSetShader(_renderer->GetFullscreenVertexShader().Get(), nullptr, 0);
-    context->PSSetShader(Shader->PixelShader.Get(), nullptr, 0);
-
-    context->IASetInputLayout(nullptr);
-    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-    context->Draw(4, 0);
+    stateTracker.SetRenderTargets(renderTargets, nullptr);
 
+    // Set input resources
+    std::vector<ID3D11ShaderResourceView*> inputResources;
+    for (const BeHandle inputTexture : _inputTextures) {
+        const auto resource = _renderer->GetRenderResource(inputTexture);
+        inputResources.push_back(resource->SRV.Get());
+    }
+    stateTracker.SetPSShaderResources(0, inputResources);
 
-    const std::vector<ID3D11ShaderResourceView*> emptyResources(InputTextureNames.size(), nullptr);
-    context->PSSetShaderResources(0, emptyResources.size(), emptyResources.data());
-    const std::vector<ID3D11RenderTargetView*> emptyTargets(OutputTextureNames.size(), nullptr);
-    context->OMSetRenderTargets(emptyTargets.size(), emptyTargets.data(), nullptr);
-    ID3D11SamplerState* emptySamplers[] = { nullptr };
-    context->PSSetSamplers(0, 1, emptySamplers);
+    stateTracker.SetPSSampler(0, _renderer->GetPointSampler().Get());
+    stateTracker.SetPipeline(*_pipeline);
+    context.Draw(4, 0);
 }
@@ -6,17 +6,27 @@
 #include "BeRenderPass.h"
 
 class BeShader;
+struct BePipelineState;
 
 class CustomFullscreenEffectPass final : public BeRenderPass {
 public:
     std::vector<std::string> InputTextureNames;
     std::vector<std::string> OutputTextureNames;
     BeShader* Shader;
+    // Copies the rendered part of the first input into the first output instead of drawing, a quality knob. Both
+    // have to share size and format.
+    bool Bypassed = false;
+
+private:
+    const BePipelineState* _pipeline = nullptr;
+    std::vector<BeHandle> _inputTextures;
+    std::vector<BeHandle> _outputTextures;
     
 public:
     explicit CustomFullscreenEffectPass();
     ~CustomFullscreenEffectPass() override;
     
+    auto GetResources() const -> BeRenderGraph::BePassResources override;
     auto Initialise() -> void override;
-    auto Render() -> void override;
+    auto Render(BeDeviceContext& context, BeStateTracker& stateTracker) -> void override;
 };
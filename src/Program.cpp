@@ -7,6 +7,7 @@
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cassert>
 
@@ -17,9 +18,12 @@
 #include "BeRenderer.h"
 #include "BeCamera.h"
 #include "BeComposerPass.h"
+#include "BeFrameGovernor.h"
 #include "BeGeometryPass.h"
 #include "BeLightingPass.h"
 #include "BeShader.h"
+#include "BeTaskGraph.h"
+#include "BeTextureStreamer.h"
 #include "CustomFullscreenEffectPass.h"
 
 
@@ -50,27 +54,64 @@ auto Program::run() -> int {
     
     // engine
     BeRenderer renderer(hwnd, width, height);
-    renderer.LaunchDevice();
-    const auto device = renderer.GetDevice();
+    std::unique_ptr<BeShader> standardShader;
+    std::unique_ptr<BeTextureStreamer> textureStreamer;
+    std::shared_ptr<BeModel> witchItems, cube, macintosh, pagoda, disks, anvil;
+
+    // startup graph: imports and shader compiles run on workers, GPU objects are created on this thread
+    BeTaskGraph startup;
+    const auto launchDevice = startup.AddMainThreadTask("Launch device", [&renderer] { renderer.LaunchDevice(); });
+
+    std::vector<BeTaskGraph::BeTaskId> shaderCompiles;
+    const std::pair<const char*, BeShaderType> shaders[] = {
+        {"assets/shaders/fullscreen", BeShaderType::Vertex},
+        {"assets/shaders/standard", BeShaderType::Vertex | BeShaderType::Pixel},
+        {"assets/shaders/directionalLight", BeShaderType::Pixel},
+        {"assets/shaders/pointLight", BeShaderType::Pixel},
+        {"assets/shaders/poorBloom", BeShaderType::Pixel},
+        {"assets/shaders/composer", BeShaderType::Pixel},
+    };
+    for (const auto& [path, type] : shaders)
+        shaderCompiles.push_back(startup.AddTask(std::string("Compile ") + path, [path, type] { BeShader::Precompile(path, type); }));
+
+    startup.AddMainThreadTask("Create standard shader", [&renderer, &standardShader] {
+        standardShader = std::make_unique<BeShader>(
+            renderer.GetDevice().Get(),
+            "assets/shaders/standard",
+            BeShaderType::Vertex | BeShaderType::Pixel,
+            StandardVertexLayout
+        );
+    }, {launchDevice, shaderCompiles[1]});
+
+    // textures go up at a low mip and stream finer levels in as the geometry pass asks for them
+    const auto createTextureStreamer = startup.AddMainThreadTask("Create texture streamer", [&renderer, &textureStreamer] {
+        textureStreamer = std::make_unique<BeTextureStreamer>(renderer.GetDevice());
+    }, {launchDevice});
+
+    // one importer per model, Assimp::Importer is not thread safe; decoded textures are shared between them
+    const auto textureCache = std::make_shared<BeTextureCache>();
+    std::vector<std::unique_ptr<BeAssetImporter>> importerPool;
+    auto loadModel = [&](std::shared_ptr<BeModel>& target, const std::filesystem::path& path) {
+        BeAssetImporter* importer = importerPool.emplace_back(std::make_unique<BeAssetImporter>(nullptr, textureCache)).get();
+        const auto import = startup.AddTask("Import " + path.string(), [importer, &target, path] {
+            target = importer->ImportModel(path);
+        });
+        return startup.AddMainThreadTask("Upload " + path.string(), [&textureStreamer, &target] {
+            textureStreamer->RegisterModel(*target);
+        }, {createTextureStreamer, import});
+    };
+    loadModel(witchItems, "assets/witch_items.glb");
+    loadModel(cube, "assets/cube.glb");
+    loadModel(macintosh, "assets/model.fbx");
+    loadModel(pagoda, "assets/pagoda.glb");
+    loadModel(disks, "assets/floppy-disks.glb");
+    loadModel(anvil, "assets/anvil/anvil.fbx");
 
-    BeShader standardShader(
-        device.Get(),
-        "assets/shaders/standard",
-        BeShaderType::Vertex | BeShaderType::Pixel,
-        {
-            {.Name = "Position", .Attribute = BeVertexElementDescriptor::BeVertexSemantic::Position},
-            {.Name = "Normal", .Attribute = BeVertexElementDescriptor::BeVertexSemantic::Normal},
-            {.Name = "UV", .Attribute = BeVertexElementDescriptor::BeVertexSemantic::TexCoord0},
-        }
-    );
+    startup.Run();
+    startup.PrintReport("Startup");
+    textureCache->PrintStatistics();
 
-    BeAssetImporter importer(device);
-    auto witchItems = importer.LoadModel("assets/witch_items.glb");
-    auto cube = importer.LoadModel("assets/cube.glb");
-    auto macintosh = importer.LoadModel("assets/model.fbx");
-    auto pagoda = importer.LoadModel("assets/pagoda.glb");
-    auto disks = importer.LoadModel("assets/floppy-disks.glb");
-    auto anvil = importer.LoadModel("assets/anvil/anvil.fbx");
+    const auto device = renderer.GetDevice();
     anvil->DrawSlices[0].Material.SpecularColor = glm::vec4(1.0f);
     anvil->DrawSlices[0].Material.SuperSpecularColor = glm::vec4(1.0f) * 3.f;
     anvil->DrawSlices[0].Material.SuperShininess = 512.f;
@@ -81,28 +122,28 @@ auto Program::run() -> int {
             .Name = "Macintosh",
             .Position = {0, 0, -7},
             .Model = macintosh.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Plane",
             .Position = {50, -2, -50},
             .Scale = glm::vec3(100.f, 0.1f, 100.f),
             .Model = cube.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Pagoda",
             .Position = {0, 0, 8},
             .Scale = glm::vec3(0.2f),
             .Model = pagoda.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Witch Items",
             .Position = {-3, 0, 5},
             .Scale = glm::vec3(3.f),
             .Model = witchItems.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Anvil",
@@ -110,7 +151,7 @@ auto Program::run() -> int {
             .Rotation = glm::quat(glm::vec3(0, glm::radians(90.f), 0)),
             .Scale = glm::vec3(0.2f),
             .Model = anvil.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Anvil1",
@@ -118,7 +159,7 @@ auto Program::run() -> int {
             .Rotation = glm::quat(glm::vec3(0, glm::radians(-90.f), 0)),
             .Scale = glm::vec3(0.2f),
             .Model = anvil.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Anvil2",
@@ -126,14 +167,14 @@ auto Program::run() -> int {
             .Rotation = glm::quat(glm::vec3(0, glm::radians(-90.f), 0)),
             .Scale = glm::vec3(1.0f),
             .Model = anvil.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
         {
             .Name = "Disks",
             .Position = {7.5f, 1, -4},
             .Rotation = glm::quat(glm::vec3(0, glm::radians(150.f), 0)),
             .Model = disks.get(),
-            .Shader = &standardShader,
+            .Shader = standardShader.get(),
         },
     };
 
@@ -141,37 +182,20 @@ auto Program::run() -> int {
     renderer.UniformData.NearFarPlane = {0.1f, 100.0f};
     renderer.UniformData.AmbientColor = glm::vec3(0.1f);
 
-    renderer.CreateRenderResource("DepthStencil", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R24G8_TYPELESS,
-        .BindFlags = D3D11_BIND_DEPTH_STENCIL | D3D11_BIND_SHADER_RESOURCE,
-    });
-    renderer.CreateRenderResource("GBuffer0", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
-        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
-    });
-    renderer.CreateRenderResource("GBuffer1", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R16G16B16A16_FLOAT,
-        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
-    });
-    renderer.CreateRenderResource("GBuffer2", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R8G8B8A8_UNORM,
-        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
-    });
-    renderer.CreateRenderResource("Lighting", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R11G11B10_FLOAT,
-        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
-    });
+    renderer.DeclareRenderResource("DepthStencil", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::Depth24Stencil8});
+    renderer.DeclareRenderResource("GBuffer0", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::RGBA8Unorm});
+    renderer.DeclareRenderResource("GBuffer1", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::RGBA16Float});
+    renderer.DeclareRenderResource("GBuffer2", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::RGBA8Unorm});
+    renderer.DeclareRenderResource("Lighting", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::R11G11B10Float});
 
     // Blur effect resource
-    renderer.CreateRenderResource("PPOutput", true, BeRenderResource::BeResourceDescriptor {
-        .Format = DXGI_FORMAT_R11G11B10_FLOAT,
-        .BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE,
-    });
+    renderer.DeclareRenderResource("PPOutput", true, BeRenderGraph::BeResourceDescriptor {.Format = BeRenderGraph::BeFormat::R11G11B10Float});
 
     // geometry pass
     auto geometryPass = new BeGeometryPass();
     renderer.AddRenderPass(geometryPass);
     geometryPass->SetObjects(objects);
+    geometryPass->TextureStreamer = textureStreamer.get();
     geometryPass->OutputDepthTextureName = "DepthStencil";
     geometryPass->OutputTexture0Name = "GBuffer0";
     geometryPass->OutputTexture1Name = "GBuffer1";
@@ -200,7 +224,7 @@ auto Program::run() -> int {
         device.Get(),
         "assets/shaders/poorBloom",
         BeShaderType::Pixel,
-        std::vector<BeVertexElementDescriptor>{}
+        BeVertexLayout{}
     );
     auto effectPass = new CustomFullscreenEffectPass();
     renderer.AddRenderPass(effectPass);
@@ -223,6 +247,10 @@ auto Program::run() -> int {
 
     
     renderer.InitialisePasses();
+
+    // lowers the render scale, then drops the bloom, then half the point lights to stay within a 60 Hz frame
+    BeFrameGovernor governor(BeFrameGovernor::BeSettings {.QualityLevels = 2});
+    const auto pointLightCount = static_cast<uint32_t>(lightingPass->PointLights.size());
     
     BeInput input(window);
     BeCamera cam;
@@ -232,6 +260,7 @@ auto Program::run() -> int {
     cam.FarPlane = 100.0f;
 
     double lastTime = glfwGetTime();
+    float gpuMilliseconds = 0.0f;
     
     // Main loop
     while (!glfwWindowShouldClose(window)) {
@@ -277,9 +306,17 @@ auto Program::run() -> int {
         // Update camera matrices
         cam.updateMatrices();
 
+        // Apply the quality the governor picked from earlier frames
+        const BeFrameGovernor::BeQuality& quality = governor.GetQuality();
+        renderer.RenderScale = quality.RenderScale;
+        effectPass->Bypassed = quality.Level >= 1;
+        lightingPass->MaxPointLights = quality.Level >= 2 ? pointLightCount / 2 : pointLightCount;
+
         // Apply camera to renderer
         renderer.UniformData.ProjectionView = cam.getProjectionMatrix() * cam.getViewMatrix();
         renderer.UniformData.CameraPosition = cam.Position;
+        renderer.UniformData.VerticalFov = glm::radians(cam.Fov);
+        renderer.UniformData.ViewportHeight = cam.Height * quality.RenderScale;
 
         {
             static float angle = 0.0f;
@@ -295,6 +332,17 @@ auto Program::run() -> int {
         }
         
         renderer.Render();
+        textureStreamer->Update();
+
+        // The governor sees whichever side limits the frame: the CPU work of this frame without the vsync wait in
+        // Present, or the newest GPU time, kept from an earlier frame while no new timestamp arrived
+        const float cpuMilliseconds = static_cast<float>((glfwGetTime() - now) * 1000.0) - renderer.PresentMilliseconds;
+        if (renderer.GpuFrameMilliseconds > 0.0f) gpuMilliseconds = renderer.GpuFrameMilliseconds;
+        governor.Update(std::max(cpuMilliseconds, gpuMilliseconds));
+        if (input.getKeyDown(GLFW_KEY_F1)) {
+            geometryPass->PrintFrameStatistics();
+            renderer.PrintFrameStatistics();
+        }
     }
     
     return 0;
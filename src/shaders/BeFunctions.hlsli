@@ -60,3 +60,12 @@ float LinearizeDepth(float depth01, float nearZ, float farZ)
     float ndc = depth01 * 2.0 - 1.0;
     return (2.0 * nearZ * farZ) / (farZ + nearZ - ndc * (farZ - nearZ));
 }
+
+// inverse of BeVertexPacking::EncodeOctahedral, input is the snorm pair the input assembler already scaled to [-1, 1]
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 normal = float3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.xy += (normal.xy >= 0.0) ? -t : t;
+    return normalize(normal);
+}
@@ -1,7 +1,5 @@
 
 cbuffer MaterialBuffer: register(b1) {
-    row_major float4x4 _Model;
-    
     float3 _DiffuseColor;
     float3 _SpecularColor0;
     float _Shininess0;
@@ -7,6 +7,10 @@ cbuffer UniformBuffer: register(b0) {
     float3 _CameraPosition;
     
     float3 _AmbientColor;
+    // xy = render target size in pixels, zw = 1 / xy
+    float4 _TargetSize;
+    // xy = share of the targets rendered this frame, from the top left; fullscreen UVs already include it
+    float4 _RenderScale;
     //float3 _DirectionalLightVector;
     //float3 _DirectionalLightColor;
     //float _DirectionalLightPower;
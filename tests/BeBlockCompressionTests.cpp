@@ -0,0 +1,142 @@
+﻿#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "BeBlockCompression.h"
+#include "BeMipChain.h"
+#include "BeTest.h"
+
+namespace {
+    // largest difference of any channel between the source texels and the decoded block
+    auto MaxChannelError(const uint8_t* texels, const uint8_t* decoded, const uint32_t firstChannel, const uint32_t lastChannel) -> int {
+        int error = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+            for (uint32_t c = firstChannel; c <= lastChannel; ++c)
+                error = std::max(error, std::abs(int(texels[4 * i + c]) - int(decoded[4 * i + c])));
+        return error;
+    }
+
+    auto MakeGradient(const uint32_t width, const uint32_t height, const bool withAlpha) -> std::vector<uint8_t> {
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                uint8_t* pixel = pixels.data() + 4 * (size_t(y) * width + x);
+                pixel[0] = static_cast<uint8_t>(x * 255 / std::max(1u, width - 1));
+                pixel[1] = static_cast<uint8_t>(y * 255 / std::max(1u, height - 1));
+                pixel[2] = static_cast<uint8_t>(128 + (x + y) % 16);
+                pixel[3] = withAlpha ? static_cast<uint8_t>((x + y) * 255 / std::max(1u, width + height - 2)) : 255;
+            }
+        }
+        return pixels;
+    }
+}
+
+BE_TEST(BlockCompression, SolidBlocksRoundTripWithinEndpointPrecision) {
+    // a single colour rounds to the nearest 565 endpoint: red and blue step by about 8, green by about 4
+    const uint8_t colors[][4] = {{0, 0, 0, 255}, {255, 255, 255, 255}, {200, 100, 50, 255}, {13, 77, 201, 90}, {128, 128, 128, 0}};
+    for (const auto& color : colors) {
+        uint8_t texels[64];
+        for (uint32_t i = 0; i < 16; ++i)
+            std::copy(color, color + 4, texels + 4 * i);
+
+        uint8_t block[16];
+        uint8_t decoded[64];
+        BeBlockCompression::EncodeBC3Block(texels, block);
+        BeBlockCompression::DecodeBC3Block(block, decoded);
+        BE_CHECK(MaxChannelError(texels, decoded, 0, 2) <= 4);
+        BE_CHECK_EQ(MaxChannelError(texels, decoded, 3, 3), 0);
+
+        if (color[3] != 255) continue;
+        BeBlockCompression::EncodeBC1Block(texels, block);
+        BeBlockCompression::DecodeBC1Block(block, decoded);
+        BE_CHECK(MaxChannelError(texels, decoded, 0, 2) <= 4);
+        BE_CHECK_EQ(MaxChannelError(texels, decoded, 3, 3), 0);
+    }
+}
+
+BE_TEST(BlockCompression, GradientBlocksRoundTripWithinPaletteSpacing) {
+    // 16 values 8 apart on four palette entries 40 apart are up to 20 off, about 11 on average, so about 27 dB is the
+    // best a block can do
+    uint8_t texels[64];
+    for (uint32_t i = 0; i < 16; ++i) {
+        texels[4 * i + 0] = static_cast<uint8_t>(64 + 8 * i);
+        texels[4 * i + 1] = static_cast<uint8_t>(32 + 4 * i);
+        texels[4 * i + 2] = static_cast<uint8_t>(192 - 8 * i);
+        texels[4 * i + 3] = static_cast<uint8_t>(255 - 12 * i);
+    }
+
+    uint8_t block[16];
+    uint8_t decoded[64];
+    BeBlockCompression::EncodeBC1Block(texels, block);
+    BE_CHECK(BeBlockCompression::MeasureQuality(texels, 4, 4, block, BeBlockFormat::BC1).ColorPSNR > 27.0);
+
+    // alpha has eight values about 26 apart over its 180 wide range, each texel lands within half of that
+    BeBlockCompression::EncodeBC3Block(texels, block);
+    BE_CHECK(BeBlockCompression::MeasureQuality(texels, 4, 4, block, BeBlockFormat::BC3).ColorPSNR > 27.0);
+    BeBlockCompression::DecodeBC3Block(block, decoded);
+    BE_CHECK(MaxChannelError(texels, decoded, 3, 3) <= 13);
+
+    // a smooth image changes little inside each block
+    const auto pixels = MakeGradient(64, 64, true);
+    const std::vector<BeMipLevel> levels = {{.Width = 64, .Height = 64, .Offset = 0}};
+    const auto blockLevels = BeBlockCompression::Layout(levels, BeBlockFormat::BC3);
+    std::vector<uint8_t> blocks(BeBlockCompression::GetSizeInBytes(blockLevels, BeBlockFormat::BC3));
+    BeBlockCompression::Encode(pixels.data(), levels, BeBlockFormat::BC3, blocks.data(), blockLevels, false);
+    const BeBlockQuality quality = BeBlockCompression::MeasureQuality(pixels.data(), 64, 64, blocks.data(), BeBlockFormat::BC3);
+    BE_CHECK(quality.ColorPSNR > 35.0);
+    BE_CHECK(quality.AlphaPSNR > 45.0);
+}
+
+BE_TEST(BlockCompression, ChoosesBC3OnlyWhenAlphaIsPresent) {
+    auto pixels = MakeGradient(16, 8, false);
+    BE_CHECK(BeBlockCompression::ChooseFormat(pixels.data(), 16, 8) == BeBlockFormat::BC1);
+
+    // a single translucent texel anywhere in level 0 is enough
+    pixels[4 * (16 * 7 + 15) + 3] = 254;
+    BE_CHECK(BeBlockCompression::ChooseFormat(pixels.data(), 16, 8) == BeBlockFormat::BC3);
+
+    BE_CHECK(BeBlockCompression::ChooseFormat(MakeGradient(8, 8, true).data(), 8, 8) == BeBlockFormat::BC3);
+    BE_CHECK_EQ(BeBlockCompression::GetBlockSize(BeBlockFormat::BC1), 8u);
+    BE_CHECK_EQ(BeBlockCompression::GetBlockSize(BeBlockFormat::BC3), 16u);
+}
+
+BE_TEST(BlockCompression, SizesNotMultipleOfFourStayUncompressed) {
+    const std::pair<uint32_t, uint32_t> sizes[] = {{1, 1}, {2, 4}, {4, 6}, {6, 4}, {13, 16}, {640, 482}};
+    for (const auto& [width, height] : sizes) {
+        const auto pixels = MakeGradient(width, height, false);
+        BE_CHECK(BeBlockCompression::ChooseFormat(pixels.data(), width, height) == BeBlockFormat::None);
+        BE_CHECK_EQ(BeBlockCompression::GetBlockSize(BeBlockFormat::None), 0u);
+    }
+    const auto pixels = MakeGradient(640, 480, false);
+    BE_CHECK(BeBlockCompression::ChooseFormat(pixels.data(), 640, 480) == BeBlockFormat::BC1);
+}
+
+BE_TEST(BlockCompression, ChainLevelsBelowFourTexelsTakeAWholeBlock) {
+    const auto levels = BeMipChain::Layout(8, 8);   // 8, 4, 2, 1
+    const auto blockLevels = BeBlockCompression::Layout(levels, BeBlockFormat::BC1);
+    BE_CHECK_EQ(blockLevels.size(), levels.size());
+    const size_t offsets[] = {0, 32, 40, 48};
+    for (size_t i = 0; i < blockLevels.size(); ++i) {
+        BE_CHECK_EQ(blockLevels[i].Width, levels[i].Width);
+        BE_CHECK_EQ(blockLevels[i].Offset, offsets[i]);
+    }
+    BE_CHECK_EQ(BeBlockCompression::GetSizeInBytes(blockLevels, BeBlockFormat::BC1), size_t(56));
+    BE_CHECK_EQ(BeBlockCompression::GetSizeInBytes(BeBlockCompression::Layout(levels, BeBlockFormat::BC3), BeBlockFormat::BC3), size_t(112));
+}
+
+BE_TEST(BlockCompression, PoolMatchesSingleThreaded) {
+    const auto levels = BeMipChain::Layout(256, 128);
+    std::vector<uint8_t> chain(BeMipChain::GetSizeInBytes(levels));
+    const auto level0 = MakeGradient(256, 128, true);
+    std::ranges::copy(level0, chain.begin());
+    BeMipChain::Generate(chain.data(), levels);
+
+    const auto blockLevels = BeBlockCompression::Layout(levels, BeBlockFormat::BC3);
+    std::vector<uint8_t> single(BeBlockCompression::GetSizeInBytes(blockLevels, BeBlockFormat::BC3));
+    std::vector<uint8_t> pooled(single.size());
+    BeBlockCompression::Encode(chain.data(), levels, BeBlockFormat::BC3, single.data(), blockLevels, false);
+    BeBlockCompression::Encode(chain.data(), levels, BeBlockFormat::BC3, pooled.data(), blockLevels, true);
+    BE_CHECK(single == pooled);
+}
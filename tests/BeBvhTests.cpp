@@ -0,0 +1,221 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeBvh.h"
+#include "BeTest.h"
+
+namespace {
+    // boxes of 0.2 to 2 units at a density of one per 64 cubic units
+    auto MakeBoxes(const uint32_t objectCount, std::mt19937& random) -> std::vector<BeBvh::BeBox> {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const float side = 4.0f * std::cbrt(float(objectCount));
+        std::vector<BeBvh::BeBox> boxes(objectCount);
+        for (auto& box : boxes) {
+            const glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 extent = glm::vec3(0.1f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.9f;
+            box = {center - extent, center + extent};
+        }
+        return boxes;
+    }
+
+    auto Contains(const glm::vec3& outerMin, const glm::vec3& outerMax, const BeBvh::BeBox& inner) -> bool {
+        return glm::all(glm::lessThanEqual(outerMin, inner.Min)) && glm::all(glm::greaterThanEqual(outerMax, inner.Max));
+    }
+
+    // Every node reached once from the root, every object in exactly one leaf, every bound holding its children or
+    // the current boxes of its objects.
+    auto CheckTree(const BeBvh& bvh, const std::vector<BeBvh::BeBox>& boxes) -> void {
+        const auto nodes = bvh.GetNodes();
+        const auto leafObjects = bvh.GetLeafObjects();
+        BE_CHECK_EQ(leafObjects.size(), boxes.size());
+        if (boxes.empty()) return;
+
+        std::vector<uint32_t> reached(nodes.size(), 0);
+        std::vector<uint32_t> leafSlots(leafObjects.size(), 0);
+        std::vector<uint32_t> objects(boxes.size(), 0);
+        std::vector<uint32_t> stack = {0};
+        uint32_t failures = 0;
+        while (!stack.empty()) {
+            const uint32_t nodeIndex = stack.back();
+            stack.pop_back();
+            if (nodeIndex >= nodes.size() || reached[nodeIndex]++ > 0) {
+                ++failures;
+                continue;
+            }
+            const auto& node = nodes[nodeIndex];
+            if (node.ItemCount == 0) {
+                if (node.First <= nodeIndex || node.First + 1 >= nodes.size()) {
+                    ++failures;
+                    continue;
+                }
+                for (const uint32_t child : {node.First, node.First + 1}) {
+                    if (!Contains(node.Min, node.Max, {nodes[child].Min, nodes[child].Max})) ++failures;
+                    stack.push_back(child);
+                }
+                continue;
+            }
+            if (node.ItemCount > BeBvh::MaxLeafSize || node.First + node.ItemCount > leafObjects.size()) {
+                ++failures;
+                continue;
+            }
+            for (uint32_t i = node.First; i < node.First + node.ItemCount; ++i) {
+                ++leafSlots[i];
+                ++objects[leafObjects[i]];
+                if (!Contains(node.Min, node.Max, boxes[leafObjects[i]])) ++failures;
+            }
+        }
+        BE_CHECK_EQ(failures, 0u);
+        BE_CHECK(std::ranges::all_of(reached, [](const uint32_t count) { return count == 1; }));
+        BE_CHECK(std::ranges::all_of(leafSlots, [](const uint32_t count) { return count == 1; }));
+        BE_CHECK(std::ranges::all_of(objects, [](const uint32_t count) { return count == 1; }));
+    }
+
+    auto Touches(const BeBvh::BeBox& box, const BeCulling::BePlanes& planes) -> bool {
+        const glm::vec3 center = (box.Min + box.Max) * 0.5f;
+        const glm::vec3 extent = (box.Max - box.Min) * 0.5f;
+        for (const auto& plane : planes)
+            if (glm::dot(glm::vec3(plane), center) + plane.w + glm::dot(glm::abs(glm::vec3(plane)), extent) < 0.0f) return false;
+        return true;
+    }
+
+    auto Touches(const BeBvh::BeBox& box, const glm::vec3& center, const float radius) -> bool {
+        const glm::vec3 offset = glm::clamp(center, box.Min, box.Max) - center;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // the brute force reference for ray queries
+    auto IntersectRay(const BeBvh::BeBox& box, const glm::vec3& origin, const glm::vec3& direction) -> float {
+        const glm::vec3 inverseDirection = 1.0f / direction;
+        const glm::vec3 t0 = (box.Min - origin) * inverseDirection;
+        const glm::vec3 t1 = (box.Max - origin) * inverseDirection;
+        const glm::vec3 near = glm::min(t0, t1);
+        const glm::vec3 far = glm::max(t0, t1);
+        const float enter = std::max({near.x, near.y, near.z, 0.0f});
+        const float exit = std::min({far.x, far.y, far.z});
+        return enter <= exit ? enter : -1.0f;
+    }
+
+    auto Sorted(std::vector<uint32_t> objects) -> std::vector<uint32_t> {
+        std::ranges::sort(objects);
+        return objects;
+    }
+
+    // frustum, sphere and ray queries against testing every box
+    auto CheckQueries(const BeBvh& bvh, const std::vector<BeBvh::BeBox>& boxes, std::mt19937& random) -> void {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        const float side = 4.0f * std::cbrt(float(boxes.size()));
+        constexpr uint32_t QueryCount = 16;
+        uint32_t mismatches = 0;
+        std::vector<uint32_t> found;
+
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 eye = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const auto planes = BeCulling::ExtractPlanes(
+                glm::perspectiveFovLH(glm::radians(60.0f), 16.0f, 9.0f, 0.1f, side * 0.25f) *
+                glm::lookAtLH(eye, target, glm::vec3(0.0f, 1.0f, 0.0f)));
+            found.clear();
+            bvh.QueryFrustum(planes, found);
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < boxes.size(); ++i)
+                if (Touches(boxes[i], planes)) expected.push_back(i);
+            mismatches += Sorted(found) != expected;
+        }
+
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const float radius = side * 0.05f * unit(random);
+            found.clear();
+            bvh.QuerySphere(center, radius, found);
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < boxes.size(); ++i)
+                if (Touches(boxes[i], center, radius)) expected.push_back(i);
+            mismatches += Sorted(found) != expected;
+        }
+
+        for (uint32_t q = 0; q < QueryCount; ++q) {
+            const glm::vec3 origin = glm::vec3(unit(random), unit(random), unit(random)) * side;
+            const glm::vec3 direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) - 0.5f);
+            const auto hit = bvh.Raycast(origin, direction);
+            BeBvh::BeRayHit expected;
+            for (uint32_t i = 0; i < boxes.size(); ++i) {
+                const float distance = IntersectRay(boxes[i], origin, direction);
+                if (distance >= 0.0f && (distance < expected.Distance || (distance == expected.Distance && i < expected.Object)))
+                    expected = {i, distance};
+            }
+            // ties between boxes the ray enters at the same distance may go either way
+            if (hit.Object != expected.Object && hit.Distance != expected.Distance) ++mismatches;
+        }
+        BE_CHECK_EQ(mismatches, 0u);
+    }
+}
+
+BE_TEST(Bvh, BuildsValidTreeAndMatchesBruteForce) {
+    std::mt19937 random(3);
+    for (const uint32_t objectCount : {1u, 3u, 100u, 10000u}) {
+        const auto boxes = MakeBoxes(objectCount, random);
+        BeBvh bvh;
+        bvh.Build(boxes, false);
+        CheckTree(bvh, boxes);
+        CheckQueries(bvh, boxes, random);
+    }
+}
+
+BE_TEST(Bvh, ParallelBuildMatchesSerial) {
+    // large enough for subtrees and binning passes to go to the pool
+    std::mt19937 random(5);
+    const auto boxes = MakeBoxes(70000, random);
+    BeBvh serial, parallel;
+    serial.Build(boxes, false);
+    parallel.Build(boxes, true);
+    CheckTree(parallel, boxes);
+    BE_CHECK_EQ(parallel.GetObjectCount(), serial.GetObjectCount());
+    BE_CHECK_NEAR(parallel.ComputeCost(), serial.ComputeCost(), serial.ComputeCost() * 0.01);
+    CheckQueries(parallel, boxes, random);
+}
+
+BE_TEST(Bvh, RefitKeepsQueriesExact) {
+    std::mt19937 random(7);
+    auto boxes = MakeBoxes(20000, random);
+    BeBvh bvh;
+    bvh.Build(boxes);
+    const uint32_t nodeCount = bvh.GetNodeCount();
+    const float builtCost = bvh.ComputeCost();
+
+    // everything drifts by up to half a unit, the topology stays and the tree is only a little worse
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (auto& box : boxes) {
+        const glm::vec3 offset = glm::vec3(unit(random), unit(random), unit(random)) - 0.5f;
+        box.Min += offset;
+        box.Max += offset;
+    }
+    BE_CHECK(!bvh.Update(boxes));
+    BE_CHECK_EQ(bvh.GetNodeCount(), nodeCount);
+    BE_CHECK(bvh.ComputeCost() < builtCost * BeBvh::MaxCostGrowth);
+    CheckTree(bvh, boxes);
+    CheckQueries(bvh, boxes, random);
+
+    // scattering every object across the scene makes refitting too costly, Update rebuilds
+    std::ranges::shuffle(boxes, random);
+    BE_CHECK(bvh.Update(boxes));
+    CheckTree(bvh, boxes);
+    CheckQueries(bvh, boxes, random);
+
+    // a different object count always rebuilds
+    boxes.resize(boxes.size() / 2);
+    BE_CHECK(bvh.Update(boxes));
+    CheckTree(bvh, boxes);
+}
+
+BE_TEST(Bvh, EmptyTreeFindsNothing) {
+    BeBvh bvh;
+    bvh.Build({});
+    std::vector<uint32_t> found;
+    bvh.QuerySphere(glm::vec3(0.0f), 10.0f, found);
+    BE_CHECK(found.empty());
+    BE_CHECK_EQ(bvh.Raycast(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f)).Object, UINT32_MAX);
+    BE_CHECK_EQ(bvh.GetObjectCount(), 0u);
+}
@@ -0,0 +1,179 @@
+﻿#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BeCommandList.h"
+#include "BeNullDeviceContext.h"
+#include "BeRecordingContext.h"
+#include "BeTest.h"
+#include "BeThreadPool.h"
+
+namespace {
+    // count calls of every kind but ExecuteCommandList, with objects from small pools and random uploads
+    auto ApplyRandomCalls(BeDeviceContext& context, const uint32_t seed, const uint32_t count) -> void {
+        std::mt19937 random(seed);
+        auto pick = [&random](const uint32_t range) { return static_cast<uint32_t>(random() % range); };
+        std::array<uint32_t, 4> numbers {};
+        std::array<uint8_t, 300> bytes {};
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t slot = pick(4);
+            const uint32_t slotCount = 1 + pick(4);
+            switch (pick(22)) {
+            case 0: context.SetInputLayout(MakeToken<ID3D11InputLayout>(pick(3))); break;
+            case 1: context.SetPrimitiveTopology(4 + pick(2)); break;
+            case 2: {
+                std::array<ID3D11Buffer*, 4> buffers {};
+                std::array<uint32_t, 4> offsets {};
+                for (uint32_t s = 0; s < slotCount; ++s) {
+                    buffers[s] = MakeToken<ID3D11Buffer>(pick(4));
+                    numbers[s] = 16 * pick(4);
+                    offsets[s] = 64 * pick(16);
+                }
+                context.SetVertexBuffers(slot, slotCount, buffers.data(), numbers.data(), offsets.data());
+                break;
+            }
+            case 3: context.SetIndexBuffer(MakeToken<ID3D11Buffer>(pick(3)), 42 + pick(2) * 15, 4 * pick(8)); break;
+            case 4: context.SetVertexShader(MakeToken<ID3D11VertexShader>(pick(3))); break;
+            case 5: context.SetPixelShader(MakeToken<ID3D11PixelShader>(pick(3))); break;
+            case 6:
+            case 7: {
+                std::array<ID3D11Buffer*, 4> buffers {};
+                for (uint32_t s = 0; s < slotCount; ++s) buffers[s] = MakeToken<ID3D11Buffer>(pick(6));
+                if (i % 2 == 0) context.SetVSConstantBuffers(slot, slotCount, buffers.data());
+                else context.SetPSConstantBuffers(slot, slotCount, buffers.data());
+                break;
+            }
+            case 8: {
+                std::array<ID3D11ShaderResourceView*, 4> views {};
+                for (uint32_t s = 0; s < slotCount; ++s) views[s] = MakeToken<ID3D11ShaderResourceView>(pick(8));
+                context.SetPSShaderResources(slot, slotCount, views.data());
+                break;
+            }
+            case 9: {
+                std::array<ID3D11SamplerState*, 4> samplers {};
+                for (uint32_t s = 0; s < slotCount; ++s) samplers[s] = MakeToken<ID3D11SamplerState>(pick(3));
+                context.SetPSSamplers(slot, slotCount, samplers.data());
+                break;
+            }
+            case 10: context.SetRasterizerState(MakeToken<ID3D11RasterizerState>(pick(2))); break;
+            case 11: context.SetBlendState(MakeToken<ID3D11BlendState>(pick(2))); break;
+            case 12: context.SetDepthStencilState(MakeToken<ID3D11DepthStencilState>(pick(2)), pick(3)); break;
+            case 13: {
+                std::array<ID3D11RenderTargetView*, 4> targets {};
+                for (uint32_t s = 0; s < slotCount; ++s) targets[s] = MakeToken<ID3D11RenderTargetView>(pick(5));
+                context.SetRenderTargets(slotCount, targets.data(), MakeToken<ID3D11DepthStencilView>(pick(2)));
+                break;
+            }
+            case 14: context.SetViewport(1 + pick(1920), 1 + pick(1080)); break;
+            case 15: context.ClearState(); break;
+            case 16: {
+                const std::array<float, 4> color = {float(pick(4)) / 4.0f, 0.5f, 0.25f, 1.0f};
+                context.ClearRenderTargetView(MakeToken<ID3D11RenderTargetView>(pick(5)), color.data());
+                break;
+            }
+            case 17: context.ClearDepthStencilView(MakeToken<ID3D11DepthStencilView>(pick(2)), 1 + pick(3), float(pick(2)), uint8_t(pick(256))); break;
+            case 18: {
+                const uint32_t size = pick(uint32_t(bytes.size()) + 1);
+                for (uint32_t b = 0; b < size; ++b) bytes[b] = uint8_t(random());
+                context.UpdateBuffer(MakeToken<ID3D11Buffer>(pick(3)), 16 * pick(64), bytes.data(), size, pick(4) == 0);
+                break;
+            }
+            case 19: context.CopyTextureRegion(MakeToken<ID3D11Texture2D>(pick(3)), MakeToken<ID3D11Texture2D>(pick(3)), 1 + pick(1920), 1 + pick(1080)); break;
+            case 20: context.Draw(3 + pick(4), pick(8)); break;
+            case 21: context.DrawIndexedInstanced(3 * (1 + pick(1000)), 1 + pick(4), pick(50000), int32_t(pick(2000)) - 1000, pick(100)); break;
+            }
+        }
+    }
+
+    // what a direct replay of the calls looks like: cleared before and after, as a list replays
+    auto ApplyBracketed(BeDeviceContext& context, const uint32_t seed, const uint32_t count) -> void {
+        context.ClearState();
+        ApplyRandomCalls(context, seed, count);
+        context.ClearState();
+    }
+}
+
+BE_TEST(CommandList, ReplayMatchesStraightCalls) {
+    // random call sequences applied straight and recorded then replayed hash alike, and a list that is reset records
+    // as a new one
+    BeNullDeviceContext direct;
+    BeNullDeviceContext replayed;
+    BeCommandList list;
+    for (uint32_t round = 0; round < 40; ++round) {
+        const uint32_t count = 1 + round * 37 % 500;
+        direct.Reset();
+        replayed.Reset();
+        ApplyBracketed(direct, round, count);
+        list.Reset();
+        ApplyRandomCalls(list, round + 1000, 50);
+        list.Reset();
+        ApplyRandomCalls(list, round, count);
+        BE_CHECK_EQ(list.GetCommandCount(), count);
+        replayed.ExecuteCommandList(list);
+        BE_CHECK_EQ(replayed.GetHash(), direct.GetHash());
+        BE_CHECK_EQ(replayed.GetStatistics().Calls, direct.GetStatistics().Calls);
+    }
+}
+
+BE_TEST(CommandList, ListsRecordedInParallelReplayInOrder) {
+    constexpr uint32_t ListCount = 64;
+    std::vector<std::unique_ptr<BeCommandList>> lists;
+    for (uint32_t i = 0; i < ListCount; ++i) lists.push_back(std::make_unique<BeCommandList>());
+    BeThreadPool pool(3);
+    pool.ParallelFor(ListCount, [&lists](const uint32_t i) {
+        ApplyRandomCalls(*lists[i], 7 * i, 100 + i * 13 % 300);
+    });
+    BeNullDeviceContext direct;
+    BeNullDeviceContext replayed;
+    for (uint32_t i = 0; i < ListCount; ++i) {
+        ApplyBracketed(direct, 7 * i, 100 + i * 13 % 300);
+        replayed.ExecuteCommandList(*lists[i]);
+    }
+    BE_CHECK_EQ(replayed.GetHash(), direct.GetHash());
+    BE_CHECK_EQ(replayed.GetStatistics().Draws, direct.GetStatistics().Draws);
+}
+
+BE_TEST(CommandList, NestedListsReplayInPlace) {
+    // a list executing others between calls of its own replays like those lists replayed one after the other
+    BeCommandList first;
+    BeCommandList second;
+    ApplyRandomCalls(first, 7, 120);
+    ApplyRandomCalls(second, 8, 120);
+    BeCommandList outer;
+    ApplyRandomCalls(outer, 501, 80);
+    outer.ExecuteCommandList(first);
+    outer.ExecuteCommandList(second);
+    ApplyRandomCalls(outer, 502, 80);
+
+    BeNullDeviceContext direct;
+    direct.ClearState();
+    ApplyRandomCalls(direct, 501, 80);
+    first.Replay(direct);
+    second.Replay(direct);
+    ApplyRandomCalls(direct, 502, 80);
+    direct.ClearState();
+    BeNullDeviceContext replayed;
+    replayed.ExecuteCommandList(outer);
+    BE_CHECK_EQ(replayed.GetHash(), direct.GetHash());
+}
+
+BE_TEST(CommandList, RecordingCopiesUploads) {
+    // the bytes of an upload may change as soon as UpdateBuffer returns
+    std::array<uint8_t, 40> bytes {};
+    for (uint32_t i = 0; i < bytes.size(); ++i) bytes[i] = uint8_t(i);
+    BeNullDeviceContext direct;
+    direct.ClearState();
+    direct.UpdateBuffer(MakeToken<ID3D11Buffer>(1), 0, bytes.data(), uint32_t(bytes.size()), true);
+    direct.ClearState();
+
+    BeCommandList list;
+    list.UpdateBuffer(MakeToken<ID3D11Buffer>(1), 0, bytes.data(), uint32_t(bytes.size()), true);
+    bytes.fill(0xff);
+    BeNullDeviceContext replayed;
+    replayed.ExecuteCommandList(list);
+    BE_CHECK_EQ(replayed.GetHash(), direct.GetHash());
+    BE_CHECK_EQ(list.GetCommandCount(), 1u);
+    BE_CHECK(list.GetByteSize() >= bytes.size());
+}
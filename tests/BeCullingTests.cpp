@@ -0,0 +1,119 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+#include <gtc/quaternion.hpp>
+
+#include "BeCulling.h"
+#include "BeTest.h"
+
+namespace {
+    using BeInstructionSet = BeCulling::BeInstructionSet;
+
+    auto MakeProjectionView() -> glm::mat4 {
+        return glm::perspectiveFovLH(glm::radians(60.0f), 1920.0f, 1080.0f, 0.1f, 1000.0f) *
+            glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // boxes around the camera, many of them crossing a plane
+    auto MakeBoxes(const uint32_t count, const uint32_t seed) -> BeCulling::BeBoxes {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        BeCulling::BeBoxes boxes;
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * 200.0f - 100.0f;
+            boxes.Add(center, glm::vec3(unit(random), unit(random), unit(random)) * 10.0f);
+        }
+        return boxes;
+    }
+
+    // The box against each plane on its own: outside when even its corner furthest along the normal is behind it.
+    auto IsVisibleReference(const BeCulling::BePlanes& planes, const glm::vec3& center, const glm::vec3& extent) -> bool {
+        for (const auto& plane : planes) {
+            const glm::vec3 normal = glm::vec3(plane);
+            const glm::vec3 corner = center + glm::vec3(
+                normal.x >= 0.0f ? extent.x : -extent.x,
+                normal.y >= 0.0f ? extent.y : -extent.y,
+                normal.z >= 0.0f ? extent.z : -extent.z);
+            if (glm::dot(normal, corner) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+}
+
+BE_TEST(Culling, EveryInstructionSetMatchesReference) {
+    const BeCulling::BePlanes planes = BeCulling::ExtractPlanes(MakeProjectionView());
+    // counts around the 4 and 8 box steps, so every tail length goes through the scalar remainder
+    for (const uint32_t count : {0u, 1u, 3u, 4u, 5u, 7u, 8u, 9u, 15u, 17u, 31u, 5000u}) {
+        const BeCulling::BeBoxes boxes = MakeBoxes(count, count + 1);
+        std::vector<uint8_t> expected(count);
+        uint32_t expectedCount = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 center = {boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]};
+            const glm::vec3 extent = {boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]};
+            expected[i] = IsVisibleReference(planes, center, extent) ? 1 : 0;
+            expectedCount += expected[i];
+        }
+        if (count == 5000) {
+            BE_CHECK(expectedCount > 0);
+            BE_CHECK(expectedCount < count);
+        }
+
+        for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+             instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+            std::vector<uint8_t> visible = {7, 7, 7};
+            const uint32_t visibleCount = BeCulling::Cull(boxes, planes, visible, instructionSet);
+            BE_CHECK_EQ(visibleCount, expectedCount);
+            BE_CHECK(visible == expected);
+        }
+    }
+}
+
+BE_TEST(Culling, BoxesAroundTheCamera) {
+    const BeCulling::BePlanes planes = BeCulling::ExtractPlanes(MakeProjectionView());
+    BeCulling::BeBoxes boxes;
+    boxes.Add(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(1.0f));      // straight ahead
+    boxes.Add(glm::vec3(0.0f, 0.0f, -10.0f), glm::vec3(1.0f));     // behind
+    boxes.Add(glm::vec3(0.0f, 0.0f, 2000.0f), glm::vec3(1.0f));    // past the far plane
+    boxes.Add(glm::vec3(100.0f, 0.0f, 10.0f), glm::vec3(1.0f));    // far to the right
+    boxes.Add(glm::vec3(0.0f), glm::vec3(0.5f));                   // around the eye
+    std::vector<uint8_t> visible;
+    BE_CHECK_EQ(BeCulling::Cull(boxes, planes, visible), 2u);
+    BE_CHECK(visible == std::vector<uint8_t>({1, 0, 0, 0, 1}));
+}
+
+BE_TEST(Culling, TransformedBoundsHoldTheCorners) {
+    const BeBounds bounds = {.Min = glm::vec3(-1.0f, 0.0f, -0.5f), .Max = glm::vec3(1.0f, 2.0f, 0.5f), .Center = glm::vec3(0.0f, 1.0f, 0.0f), .Radius = 1.5f};
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    BeCulling::BeBoxes boxes;
+    for (uint32_t i = 0; i < 64; ++i) {
+        const glm::vec3 position = glm::vec3(unit(random), unit(random), unit(random)) * 100.0f - 50.0f;
+        const glm::quat rotation = glm::normalize(glm::quat(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f));
+        const glm::mat4 transform = glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) *
+            glm::scale(glm::mat4(1.0f), glm::vec3(0.5f + 2.5f * unit(random)));
+        boxes.Add(bounds, transform);
+
+        // the tightest box around the eight transformed corners
+        glm::vec3 low(1e30f), high(-1e30f);
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            const glm::vec3 local = {
+                corner & 1 ? bounds.Max.x : bounds.Min.x,
+                corner & 2 ? bounds.Max.y : bounds.Min.y,
+                corner & 4 ? bounds.Max.z : bounds.Min.z};
+            const glm::vec3 world = glm::vec3(transform * glm::vec4(local, 1.0f));
+            low = glm::min(low, world);
+            high = glm::max(high, world);
+        }
+        const glm::vec3 center = {boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]};
+        const glm::vec3 extent = {boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]};
+        const float tolerance = 1e-4f * (1.0f + glm::length(position));
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            BE_CHECK_NEAR(center[axis] - extent[axis], low[axis], tolerance);
+            BE_CHECK_NEAR(center[axis] + extent[axis], high[axis], tolerance);
+        }
+    }
+    BE_CHECK_EQ(boxes.Count, 64u);
+}
@@ -0,0 +1,117 @@
+﻿#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "BeDrawList.h"
+#include "BeTest.h"
+
+namespace {
+    using BeDraw = BeDrawList::BeDraw;
+
+    // Batch is the insertion index, so equal keys show whether their order survived.
+    auto MakeDraws(const uint32_t count, const uint32_t keySpread, const uint32_t seed) -> std::vector<BeDraw> {
+        std::mt19937 random(seed);
+        std::vector<BeDraw> draws(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint32_t material = random() % keySpread;
+            const uint32_t textureSet = material % 300;
+            const uint32_t shader = textureSet % 6;
+            const uint32_t depth = random() % keySpread;
+            draws[i] = {.Key = BeDrawList::MakeKey(shader, textureSet, material, depth), .Batch = i, .Slice = 0, .FirstRange = i, .RangeCount = 1};
+        }
+        return draws;
+    }
+
+    auto SameOrder(const std::vector<BeDraw>& a, const std::vector<BeDraw>& b) -> bool {
+        return std::ranges::equal(a, b, [](const BeDraw& x, const BeDraw& y) { return x.Key == y.Key && x.Batch == y.Batch; });
+    }
+}
+
+BE_TEST(DrawList, KeyFieldsRoundTrip) {
+    constexpr uint64_t key = BeDrawList::MakeKey(200, 40000, 1234, 0xABCDEF);
+    static_assert(BeDrawList::GetShader(key) == 200);
+    static_assert(BeDrawList::GetTextureSet(key) == 40000);
+    static_assert(BeDrawList::GetMaterial(key) == 1234);
+    // ids wider than their field are cut to it instead of spilling into the next one
+    static_assert(BeDrawList::GetShader(BeDrawList::MakeKey(256 + 3, 0, 0, 0)) == 3);
+    static_assert(BeDrawList::GetTextureSet(BeDrawList::MakeKey(0, 0, 0, 1u << 24)) == 0);
+    // shader outranks texture set outranks material outranks depth
+    static_assert(BeDrawList::MakeKey(1, 0, 0, 0) > BeDrawList::MakeKey(0, 65535, 65535, 0xFFFFFF));
+    static_assert(BeDrawList::MakeKey(0, 1, 0, 0) > BeDrawList::MakeKey(0, 0, 65535, 0xFFFFFF));
+    static_assert(BeDrawList::MakeKey(0, 0, 1, 0) > BeDrawList::MakeKey(0, 0, 0, 0xFFFFFF));
+    BE_CHECK_EQ(key & 0xFFFFFF, 0xABCDEFu);
+}
+
+BE_TEST(DrawList, QuantizeDepthIsMonotonic) {
+    BE_CHECK_EQ(BeDrawList::QuantizeDepth(0.0f, 100.0f), 0u);
+    BE_CHECK_EQ(BeDrawList::QuantizeDepth(-5.0f, 100.0f), 0u);
+    BE_CHECK_EQ(BeDrawList::QuantizeDepth(100.0f, 100.0f), (1u << BeDrawList::DepthBits) - 1);
+    BE_CHECK_EQ(BeDrawList::QuantizeDepth(500.0f, 100.0f), (1u << BeDrawList::DepthBits) - 1);
+    uint32_t previous = 0;
+    uint32_t decreasing = 0;
+    for (float distance = 0.0f; distance <= 100.0f; distance += 0.37f) {
+        const uint32_t depth = BeDrawList::QuantizeDepth(distance, 100.0f);
+        decreasing += depth < previous;
+        previous = depth;
+    }
+    BE_CHECK_EQ(decreasing, 0u);
+}
+
+BE_TEST(DrawList, SortMatchesStableSort) {
+    std::vector<BeDraw> scratch;
+    // a narrow spread gives long runs of equal keys, a wide one keys differing in every byte
+    for (const uint32_t count : {0u, 1u, 2u, 17u, 1000u, 50000u}) {
+        for (const uint32_t keySpread : {3u, 900u, 1u << 16}) {
+            const std::vector<BeDraw> unsorted = MakeDraws(count, keySpread, count + keySpread);
+            std::vector<BeDraw> sorted = unsorted;
+            BeDrawList::Sort(sorted, scratch);
+            std::vector<BeDraw> reference = unsorted;
+            std::ranges::stable_sort(reference, {}, &BeDraw::Key);
+            BE_CHECK(SameOrder(sorted, reference));
+        }
+    }
+
+    // every key the same skips every pass
+    std::vector<BeDraw> same(100, BeDraw {.Key = BeDrawList::MakeKey(1, 2, 3, 4), .Batch = 0, .Slice = 0, .FirstRange = 0, .RangeCount = 1});
+    for (uint32_t i = 0; i < same.size(); ++i)
+        same[i].Batch = i;
+    const std::vector<BeDraw> original = same;
+    BeDrawList::Sort(same, scratch);
+    BE_CHECK(SameOrder(same, original));
+}
+
+BE_TEST(DrawList, CountStateChanges) {
+    const std::vector<BeDraw> draws = {
+        {.Key = BeDrawList::MakeKey(0, 0, 0, 5), .Batch = 0, .Slice = 0, .FirstRange = 0, .RangeCount = 1},
+        {.Key = BeDrawList::MakeKey(0, 0, 0, 9), .Batch = 1, .Slice = 0, .FirstRange = 1, .RangeCount = 2},
+        {.Key = BeDrawList::MakeKey(0, 0, 1, 1), .Batch = 2, .Slice = 0, .FirstRange = 3, .RangeCount = 1},
+        {.Key = BeDrawList::MakeKey(0, 1, 1, 1), .Batch = 3, .Slice = 0, .FirstRange = 4, .RangeCount = 1},
+        {.Key = BeDrawList::MakeKey(1, 1, 1, 1), .Batch = 4, .Slice = 0, .FirstRange = 5, .RangeCount = 1},
+    };
+    const BeDrawList::BeStateChanges skipped = BeDrawList::CountStateChanges(draws, true);
+    BE_CHECK_EQ(skipped.Shaders, 2u);
+    BE_CHECK_EQ(skipped.TextureSets, 2u);
+    BE_CHECK_EQ(skipped.Materials, 2u);
+    BE_CHECK_EQ(skipped.Draws, 6u);
+    BE_CHECK_EQ(skipped.GetBindCount(), 6u);
+
+    const BeDrawList::BeStateChanges everyDraw = BeDrawList::CountStateChanges(draws, false);
+    BE_CHECK_EQ(everyDraw.Shaders, 2u);
+    BE_CHECK_EQ(everyDraw.TextureSets, 5u);
+    BE_CHECK_EQ(everyDraw.Materials, 5u);
+    BE_CHECK_EQ(BeDrawList::CountStateChanges({}, true).GetBindCount(), 0u);
+}
+
+BE_TEST(DrawList, SortingSavesBinds) {
+    std::vector<BeDraw> draws = MakeDraws(20000, 900, 23);
+    const BeDrawList::BeStateChanges before = BeDrawList::CountStateChanges(draws, true);
+    std::vector<BeDraw> scratch;
+    BeDrawList::Sort(draws, scratch);
+    const BeDrawList::BeStateChanges after = BeDrawList::CountStateChanges(draws, true);
+    BE_CHECK_EQ(after.Draws, before.Draws);
+    // at most one bind of each distinct id once equal ids are adjacent
+    BE_CHECK(after.Shaders <= 6);
+    BE_CHECK(after.TextureSets <= 300);
+    BE_CHECK(after.Materials <= 900);
+    BE_CHECK(after.GetBindCount() < before.GetBindCount());
+}
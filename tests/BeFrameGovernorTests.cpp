@@ -0,0 +1,74 @@
+﻿#include <vector>
+
+#include "BeFrameGovernor.h"
+#include "BeFrameTraces.h"
+#include "BeTest.h"
+
+namespace {
+    constexpr uint32_t FrameCount = 3000;
+
+    auto RunGoverned(const uint32_t trace) -> BeTraceResult {
+        return RunTrace(GetTraces()[trace], GetTraceSettings(), FrameCount, true);
+    }
+}
+
+BE_TEST(FrameGovernor, LightLoadKeepsFullQuality) {
+    const BeTraceResult light = RunGoverned(0);
+    BE_CHECK_EQ(light.Changes, 0u);
+    BE_CHECK(light.FinalQuality == BeFrameGovernor::BeQuality {});
+    BE_CHECK_EQ(light.FramesOverBudget, 0u);
+}
+
+BE_TEST(FrameGovernor, SingleSpikesChangeNothing) {
+    BE_CHECK_EQ(RunGoverned(1).Changes, 0u);
+}
+
+BE_TEST(FrameGovernor, HeavyLoadSettlesInBudget) {
+    const BeFrameGovernor::BeSettings settings = GetTraceSettings();
+    const BeTraceResult heavy = RunGoverned(2);
+    BE_CHECK_EQ(heavy.LateChanges, 0u);
+    BE_CHECK(heavy.LateMeanMilliseconds <= settings.TargetMilliseconds);
+    BE_CHECK_EQ(heavy.FinalQuality.Level, 0u);
+    BE_CHECK(heavy.FinalQuality.RenderScale < settings.MaxRenderScale);
+    const BeTraceResult fixed = RunTrace(GetTraces()[2], settings, FrameCount, false);
+    BE_CHECK(heavy.FramesOverBudget < fixed.FramesOverBudget / 10);
+}
+
+BE_TEST(FrameGovernor, OverloadDropsEveryLevel) {
+    const BeFrameGovernor::BeSettings settings = GetTraceSettings();
+    const BeTraceResult overload = RunGoverned(3);
+    BE_CHECK_EQ(overload.FinalQuality.Level, settings.QualityLevels);
+    BE_CHECK_NEAR(overload.FinalQuality.RenderScale, settings.MinRenderScale, 1e-4f);
+}
+
+BE_TEST(FrameGovernor, FailedStepUpsBackOff) {
+    // one level too many is fast and one too few slow: six steps down, then step ups waiting 90, 180, 360... frames
+    const BeTraceResult levelBound = RunGoverned(4);
+    BE_CHECK(levelBound.Changes <= 18u);
+    BE_CHECK(levelBound.LateChanges <= 2u);
+}
+
+BE_TEST(FrameGovernor, QualityComesBackWhenTheLoadGoes) {
+    BE_CHECK(RunGoverned(5).FinalQuality == BeFrameGovernor::BeQuality {});
+}
+
+BE_TEST(FrameGovernor, StepsFollowTheSettings) {
+    // constant slow frames: a step down every SlowFrames after the settle frames, scale first and then levels
+    BeFrameGovernor::BeSettings settings = GetTraceSettings();
+    settings.Smoothing = 1.0f;
+    BeFrameGovernor governor(settings);
+    std::vector<uint32_t> changeFrames;
+    for (uint32_t frame = 0; frame < 60; ++frame)
+        if (governor.Update(100.0f)) changeFrames.push_back(frame);
+    BE_CHECK_EQ(changeFrames.size(), size_t(7));
+    BE_CHECK_EQ(changeFrames[0], settings.SlowFrames - 1);
+    BE_CHECK_EQ(changeFrames[1] - changeFrames[0], settings.SettleFrames + settings.SlowFrames);
+    BE_CHECK_EQ(governor.GetQuality().Level, settings.QualityLevels);
+    BE_CHECK_NEAR(governor.GetQuality().RenderScale, settings.MinRenderScale, 1e-4f);
+    BE_CHECK_EQ(governor.GetChangeCount(), 7u);
+
+    governor.Reset();
+    BE_CHECK(governor.GetQuality() == BeFrameGovernor::BeQuality {});
+    BE_CHECK_EQ(governor.GetChangeCount(), 0u);
+    BE_CHECK_EQ(governor.GetSmoothedMilliseconds(), 0.0f);
+}
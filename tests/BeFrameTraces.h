@@ -0,0 +1,88 @@
+﻿#pragma once
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BeFrameGovernor.h"
+
+// What a frame costs at a quality: a part that does not depend on resolution, a part that scales with the pixel
+// count and what every dropped quality level saves.
+struct BeLoad {
+    float FixedMilliseconds;
+    float PixelMilliseconds;
+    float LevelMilliseconds;
+};
+
+struct BeTrace {
+    std::string Name;
+    BeLoad Load;
+    BeLoad LaterLoad;   // from the middle of the trace on
+    uint32_t SpikePeriod = 0;   // every so many frames one takes 45 ms
+};
+
+struct BeTraceResult {
+    uint32_t FramesOverBudget = 0;
+    uint32_t LateChanges = 0;   // in the second half of the trace
+    double MeanRenderScale = 0.0;
+    double LateMeanMilliseconds = 0.0;
+    BeFrameGovernor::BeQuality FinalQuality;
+    uint32_t Changes = 0;
+};
+
+inline auto GetFrameMilliseconds(const BeLoad& load, const BeFrameGovernor::BeQuality& quality) -> float {
+    const float pixels = quality.RenderScale * quality.RenderScale;
+    return std::max(load.FixedMilliseconds + load.PixelMilliseconds * pixels - load.LevelMilliseconds * float(quality.Level), 0.5f);
+}
+
+// Measured times reach the governor two frames late, as GPU timestamps do; governed = false renders every frame
+// at full quality.
+inline auto RunTrace(const BeTrace& trace, const BeFrameGovernor::BeSettings& settings, const uint32_t frameCount, const bool governed) -> BeTraceResult {
+    constexpr uint32_t Latency = 2;
+    std::mt19937 random(43);
+    std::uniform_real_distribution noise(0.97f, 1.03f);
+    BeFrameGovernor governor(settings);
+    std::deque<float> inFlight;
+    BeTraceResult result;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        const bool late = frame >= frameCount / 2;
+        const BeFrameGovernor::BeQuality quality = governed ? governor.GetQuality() : BeFrameGovernor::BeQuality{};
+        float milliseconds = GetFrameMilliseconds(late ? trace.LaterLoad : trace.Load, quality) * noise(random);
+        if (trace.SpikePeriod != 0 && frame % trace.SpikePeriod == trace.SpikePeriod - 1)
+            milliseconds = 45.0f;
+
+        result.FramesOverBudget += milliseconds > settings.TargetMilliseconds;
+        result.MeanRenderScale += quality.RenderScale / frameCount;
+        if (late) result.LateMeanMilliseconds += milliseconds / (frameCount - frameCount / 2);
+
+        inFlight.push_back(milliseconds);
+        if (inFlight.size() > Latency) {
+            const bool changed = governor.Update(inFlight.front());
+            result.LateChanges += changed && late;
+            inFlight.pop_front();
+        }
+    }
+    result.FinalQuality = governed ? governor.GetQuality() : BeFrameGovernor::BeQuality{};
+    result.Changes = governor.GetChangeCount();
+    return result;
+}
+
+inline auto GetTraces() -> std::vector<BeTrace> {
+    const BeLoad light {3.0f, 8.0f, 0.0f};
+    const BeLoad heavy {3.0f, 20.0f, 0.0f};
+    const BeLoad overload {14.0f, 20.0f, 2.0f};
+    const BeLoad levelBound {14.5f, 8.0f, 5.0f};
+    return {
+        {.Name = "light", .Load = light, .LaterLoad = light},
+        {.Name = "light with spikes", .Load = light, .LaterLoad = light, .SpikePeriod = 97},
+        {.Name = "heavy", .Load = heavy, .LaterLoad = heavy},
+        {.Name = "overload", .Load = overload, .LaterLoad = overload},
+        {.Name = "level bound", .Load = levelBound, .LaterLoad = levelBound},
+        {.Name = "heavy then light", .Load = heavy, .LaterLoad = light},
+    };
+}
+
+inline auto GetTraceSettings() -> BeFrameGovernor::BeSettings {
+    return {.QualityLevels = 2};
+}
@@ -0,0 +1,104 @@
+﻿#include <algorithm>
+#include <format>
+#include <ranges>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "BeHandleRegistry.h"
+#include "BeTest.h"
+
+// the FNV-1a 64 test vectors, checked by the compiler
+static_assert(BeName("").Hash == 0xcbf29ce484222325ull);
+static_assert(BeName("a").Hash == 0xaf63dc4c8601ec8cull);
+static_assert(BeName("foobar").Hash == 0x85944171f73967e8ull);
+
+BE_TEST(HandleRegistry, RuntimeNamesHashLikeLiterals) {
+    BE_CHECK(BeName(std::string("foobar")) == BeName("foobar"));
+    BE_CHECK(BeName(std::string_view("RenderTarget")) == BeName("RenderTarget"));
+    BE_CHECK(BeName("GBuffer0") != BeName("GBuffer1"));
+}
+
+BE_TEST(HandleRegistry, RandomAddsAndRemovesMatchAMap) {
+    // handles resolve to their own entry at the address it was created at, stale handles and removed names resolve to
+    // nothing, taken names throw
+    struct BeEntry {
+        std::string Name;
+        BeHandle Handle;
+        const std::string* Address;
+    };
+    std::mt19937 random(37);
+    BeHandleRegistry<std::string> registry;
+    std::unordered_map<std::string, BeEntry> expected;
+    std::vector<BeHandle> staleHandles;
+    uint32_t duplicatesAccepted = 0, badAdds = 0, badRemoves = 0, wrongCounts = 0, wrongValues = 0, staleResolved = 0;
+    for (uint32_t i = 0; i < 20000; ++i) {
+        const std::string name = std::format("Target{}", random() % 64);
+        const auto found = expected.find(name);
+        if (random() % 3 != 0) {
+            if (found != expected.end()) {
+                try {
+                    (void)registry.Add(name, "duplicate");
+                    ++duplicatesAccepted;
+                } catch (const std::runtime_error&) {
+                }
+                continue;
+            }
+            const BeHandle handle = registry.Add(name, name + " value");
+            badAdds += !handle.IsValid() || registry.Find(name) != handle;
+            expected.emplace(name, BeEntry {.Name = name, .Handle = handle, .Address = registry.Get(handle)});
+        } else if (found != expected.end()) {
+            badRemoves += !registry.Remove(found->second.Handle) || registry.Remove(found->second.Handle);
+            staleHandles.push_back(found->second.Handle);
+            expected.erase(found);
+            badRemoves += registry.Find(name).IsValid();
+        }
+
+        wrongCounts += registry.GetCount() != expected.size();
+        for (const auto& entry : expected | std::views::values) {
+            const std::string* value = registry.Get(entry.Handle);
+            wrongValues += value != entry.Address || *value != entry.Name + " value";
+        }
+        staleResolved += static_cast<uint32_t>(std::ranges::count_if(staleHandles, [&](const BeHandle handle) {
+            return registry.Get(handle) != nullptr;
+        }));
+    }
+    BE_CHECK_EQ(duplicatesAccepted, 0u);
+    BE_CHECK_EQ(badAdds, 0u);
+    BE_CHECK_EQ(badRemoves, 0u);
+    BE_CHECK_EQ(wrongCounts, 0u);
+    BE_CHECK_EQ(wrongValues, 0u);
+    BE_CHECK_EQ(staleResolved, 0u);
+
+    registry.Clear();
+    BE_CHECK_EQ(registry.GetCount(), 0u);
+    for (const auto& entry : expected | std::views::values) {
+        BE_CHECK(registry.Get(entry.Handle) == nullptr);
+        BE_CHECK(!registry.Find(entry.Name).IsValid());
+    }
+}
+
+BE_TEST(HandleRegistry, ReusedSlotsDoNotResolveOldHandles) {
+    BeHandleRegistry<uint32_t> registry;
+    const BeHandle first = registry.Add("Lighting", 1u);
+    BE_CHECK(registry.Remove(first));
+    const BeHandle second = registry.Add("Bloom", 2u);
+    BE_CHECK_EQ(second.Index, first.Index);
+    BE_CHECK(second.Generation != first.Generation);
+    BE_CHECK(registry.Get(first) == nullptr);
+    BE_CHECK_EQ(*registry.Get(second), 2u);
+    BE_CHECK(!registry.Find("Lighting").IsValid());
+    BE_CHECK(registry.Find("Bloom") == second);
+}
+
+BE_TEST(HandleRegistry, InvalidHandlesResolveToNothing) {
+    BeHandleRegistry<uint32_t> registry;
+    BE_CHECK(registry.Get(BeHandle {}) == nullptr);
+    BE_CHECK(!registry.Find("Missing").IsValid());
+    BE_CHECK(!registry.Remove(BeHandle {}));
+    const BeHandle handle = registry.Add("Backbuffer", 7u);
+    BE_CHECK(registry.Get(BeHandle {.Index = handle.Index, .Generation = 0}) == nullptr);
+    BE_CHECK(registry.Get(BeHandle {.Index = handle.Index + 1, .Generation = handle.Generation}) == nullptr);
+}
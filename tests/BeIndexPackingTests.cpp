@@ -0,0 +1,116 @@
+﻿#include <algorithm>
+#include <vector>
+
+#include "BeIndexPacking.h"
+#include "BeModel.h"
+#include "BeTest.h"
+
+#if defined(_WIN32)
+#include <filesystem>
+#include "BeAssetImporter.h"
+#endif
+
+namespace {
+    // every index range the geometry pass draws from the model: full detail slices, LOD slices and meshlets
+    auto CollectRanges(const BeModel& model) -> std::vector<std::pair<uint32_t, uint32_t>> {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (const auto& slice : model.DrawSlices)
+            ranges.emplace_back(slice.StartIndexLocation, slice.IndexCount);
+        for (const auto& level : model.Lods)
+            for (const auto& slice : level.Slices)
+                ranges.emplace_back(slice.StartIndexLocation, slice.IndexCount);
+        for (const auto& meshlet : model.Meshlets)
+            ranges.emplace_back(meshlet.StartIndexLocation, meshlet.TriangleCount * 3);
+        return ranges;
+    }
+
+    // packs the models in order as the geometry pass does and reads every range back against the 32 bit source
+    auto CheckModels(const std::vector<const BeModel*>& models) -> void {
+        BeIndexPacking::BeIndexBuffers buffers;
+        std::vector<BeIndexPacking::BePlacement> placements;
+        for (const BeModel* model : models)
+            placements.push_back(BeIndexPacking::Append(model->Indices, buffers));
+
+        for (size_t m = 0; m < models.size(); ++m) {
+            const BeModel& model = *models[m];
+            BE_CHECK_EQ(placements[m].IsShort, BeIndexPacking::FitsInShort(model.Indices));
+            for (const auto& [start, count] : CollectRanges(model)) {
+                BE_CHECK(size_t(start) + count <= model.Indices.size());
+                uint32_t mismatches = 0;
+                for (uint32_t i = start; i < start + count; ++i)
+                    if (BeIndexPacking::Read(buffers, placements[m], i) != model.Indices[i]) ++mismatches;
+                BE_CHECK_EQ(mismatches, 0u);
+            }
+        }
+    }
+
+    auto MakeModel(const uint32_t vertexCount, const uint32_t sliceCount, const uint32_t seed) -> BeModel {
+        BeModel model;
+        uint32_t state = seed;
+        for (uint32_t s = 0; s < sliceCount; ++s) {
+            const auto start = static_cast<uint32_t>(model.Indices.size());
+            for (uint32_t i = 0; i < 3 * 200; ++i) {
+                state = state * 1664525u + 1013904223u;
+                model.Indices.push_back(state % vertexCount);
+            }
+            auto& slice = model.DrawSlices.emplace_back();
+            slice.IndexCount = 3 * 200;
+            slice.StartIndexLocation = start;
+            slice.BaseVertexLocation = 0;
+        }
+        auto& level = model.Lods.emplace_back();
+        level.Error = 1.0f;
+        for (const auto& slice : model.DrawSlices)
+            level.Slices.push_back({.IndexCount = slice.IndexCount / 2, .StartIndexLocation = slice.StartIndexLocation + 3});
+        return model;
+    }
+}
+
+BE_TEST(IndexPacking, ChoosesNarrowestWidth) {
+    BE_CHECK(BeIndexPacking::FitsInShort(std::vector<uint32_t>{}));
+    BE_CHECK(BeIndexPacking::FitsInShort(std::vector<uint32_t>{0, 1, UINT16_MAX}));
+    BE_CHECK(!BeIndexPacking::FitsInShort(std::vector<uint32_t>{0, UINT16_MAX + 1u, 2}));
+
+    BeIndexPacking::BeIndexBuffers buffers;
+    const auto first = BeIndexPacking::Append(std::vector<uint32_t>{0, 1, 2}, buffers);
+    const auto wide = BeIndexPacking::Append(std::vector<uint32_t>{70000, 1, 2}, buffers);
+    const auto second = BeIndexPacking::Append(std::vector<uint32_t>{3, 4, UINT16_MAX}, buffers);
+    BE_CHECK(first.IsShort && second.IsShort && !wide.IsShort);
+    BE_CHECK_EQ(first.FirstIndex, 0u);
+    BE_CHECK_EQ(second.FirstIndex, 3u);
+    BE_CHECK_EQ(wide.FirstIndex, 0u);
+    BE_CHECK_EQ(buffers.Short.size(), size_t(6));
+    BE_CHECK_EQ(buffers.Wide.size(), size_t(3));
+    BE_CHECK_EQ(BeIndexPacking::Read(buffers, second, 2), uint32_t(UINT16_MAX));
+    BE_CHECK_EQ(BeIndexPacking::Read(buffers, wide, 0), 70000u);
+}
+
+BE_TEST(IndexPacking, SliceRangesMatchWideIndices) {
+    // a mix of models on both sides of the 16 bit limit, sharing the buffers in upload order
+    const BeModel small = MakeModel(300, 3, 1);
+    const BeModel limit = MakeModel(UINT16_MAX + 1u, 2, 2);
+    const BeModel large = MakeModel(200000, 4, 3);
+    const BeModel tail = MakeModel(5000, 5, 4);
+    BE_CHECK(BeIndexPacking::FitsInShort(limit.Indices));
+    BE_CHECK(!BeIndexPacking::FitsInShort(large.Indices));
+    CheckModels({&small, &limit, &large, &tail, &small});
+}
+
+#if defined(_WIN32)
+// The same comparison for every model under assets, imported with its LODs and meshlets.
+BE_TEST(IndexPacking, AssetSliceRangesMatchWideIndices) {
+    BeAssetImporter importer;
+    std::vector<std::shared_ptr<BeModel>> models;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator("assets")) {
+        if (!entry.is_regular_file()) continue;
+        const auto extension = entry.path().extension();
+        if (extension != ".glb" && extension != ".gltf" && extension != ".fbx") continue;
+        models.push_back(importer.ImportModel(entry.path()));
+    }
+    BE_CHECK(!models.empty());
+
+    std::vector<const BeModel*> order;
+    for (const auto& model : models) order.push_back(model.get());
+    CheckModels(order);
+}
+#endif
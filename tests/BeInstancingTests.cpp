@@ -0,0 +1,109 @@
+﻿#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "BeInstancing.h"
+#include "BeTest.h"
+
+namespace {
+    auto MakeWorld(const float x, const float z) -> glm::mat4 {
+        glm::mat4 world {1.0f};
+        world[3] = glm::vec4(x, 0.0f, z, 1.0f);
+        return world;
+    }
+
+    // Every instance in exactly one batch of its key, with its matrix and object at its place in the instance data.
+    auto CheckBuild(const std::vector<BeInstancing::BeInstance>& instances) -> void {
+        std::vector<glm::mat4> instanceData;
+        std::vector<uint32_t> instanceObjects;
+        std::vector<BeInstancing::BeBatch> batches;
+        BeInstancing::Build(instances, instanceData, instanceObjects, batches);
+
+        BE_CHECK_EQ(instanceData.size(), instances.size());
+        BE_CHECK_EQ(instanceObjects.size(), instances.size());
+        std::unordered_map<uint64_t, const BeInstancing::BeBatch*> batchOfKey;
+        uint32_t expectedFirst = 0;
+        for (const auto& batch : batches) {
+            BE_CHECK_EQ(batch.FirstInstance, expectedFirst);
+            BE_CHECK(batch.InstanceCount > 0);
+            BE_CHECK(batchOfKey.emplace(batch.Key, &batch).second);   // one batch per key
+            expectedFirst += batch.InstanceCount;
+        }
+        BE_CHECK_EQ(size_t(expectedFirst), instances.size());
+
+        std::unordered_map<uint64_t, uint32_t> seen;
+        for (const auto& instance : instances) {
+            const auto found = batchOfKey.find(instance.Key);
+            if (found == batchOfKey.end()) {
+                BE_CHECK(found != batchOfKey.end());
+                continue;
+            }
+            const auto& batch = *found->second;
+            const uint32_t place = seen[instance.Key]++;
+            // the first object of a batch stands in for it, the others follow in their original order
+            if (place == 0) BE_CHECK_EQ(batch.Object, instance.Object);
+            if (place >= batch.InstanceCount) {
+                BE_CHECK(place < batch.InstanceCount);
+                continue;
+            }
+            BE_CHECK(instanceData[batch.FirstInstance + place] == instance.World);
+            BE_CHECK_EQ(instanceObjects[batch.FirstInstance + place], instance.Object);
+        }
+    }
+}
+
+BE_TEST(Instancing, GroupsByKeyInOrderOfFirstAppearance) {
+    const std::vector<BeInstancing::BeInstance> instances = {
+        {.Key = BeInstancing::MakeKey(1, 0), .Object = 0, .World = MakeWorld(0, 0)},
+        {.Key = BeInstancing::MakeKey(0, 0), .Object = 1, .World = MakeWorld(1, 0)},
+        {.Key = BeInstancing::MakeKey(1, 0), .Object = 2, .World = MakeWorld(2, 0)},
+        {.Key = BeInstancing::MakeKey(1, 1), .Object = 3, .World = MakeWorld(3, 0)},
+        {.Key = BeInstancing::MakeKey(0, 0), .Object = 4, .World = MakeWorld(4, 0)},
+        {.Key = BeInstancing::MakeKey(1, 0), .Object = 5, .World = MakeWorld(5, 0)},
+    };
+    std::vector<glm::mat4> instanceData;
+    std::vector<uint32_t> instanceObjects;
+    std::vector<BeInstancing::BeBatch> batches;
+    BeInstancing::Build(instances, instanceData, instanceObjects, batches);
+
+    BE_CHECK_EQ(batches.size(), size_t(3));
+    BE_CHECK_EQ(batches[0].Key, BeInstancing::MakeKey(1, 0));
+    BE_CHECK_EQ(batches[0].InstanceCount, 3u);
+    BE_CHECK_EQ(batches[1].Key, BeInstancing::MakeKey(0, 0));
+    BE_CHECK_EQ(batches[1].FirstInstance, 3u);
+    BE_CHECK_EQ(batches[2].Object, 3u);
+    BE_CHECK(instanceObjects == (std::vector<uint32_t>{0, 2, 5, 1, 4, 3}));
+    BE_CHECK(instanceData[4] == MakeWorld(4, 0));
+    CheckBuild(instances);
+}
+
+BE_TEST(Instancing, KeysSeparateGroupAndLod) {
+    BE_CHECK(BeInstancing::MakeKey(1, 0) != BeInstancing::MakeKey(0, 1));
+    BE_CHECK_EQ(BeInstancing::MakeKey(3, 2) >> 32, uint64_t(3));
+    BE_CHECK_EQ(BeInstancing::MakeKey(3, 2) & 0xFFFFFFFF, uint64_t(2));
+}
+
+BE_TEST(Instancing, RandomFieldsBuildValidBatches) {
+    // the benchmark's field at a few sizes, including none at all and a single object
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-200.0f, 200.0f);
+    for (const uint32_t count : {0u, 1u, 37u, 5000u}) {
+        std::vector<BeInstancing::BeInstance> instances;
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto model = static_cast<uint32_t>(random() % 4);
+            const float x = coordinate(random), z = coordinate(random);
+            instances.push_back({.Key = BeInstancing::MakeKey(model, static_cast<uint32_t>(random() % 4)), .Object = i, .World = MakeWorld(x, z)});
+        }
+        CheckBuild(instances);
+    }
+
+    // a second build reuses the output vectors
+    std::vector<glm::mat4> instanceData(3);
+    std::vector<uint32_t> instanceObjects(3);
+    std::vector<BeInstancing::BeBatch> batches(2);
+    const std::vector<BeInstancing::BeInstance> single = {{.Key = 7, .Object = 9, .World = MakeWorld(1, 1)}};
+    BeInstancing::Build(single, instanceData, instanceObjects, batches);
+    BE_CHECK_EQ(batches.size(), size_t(1));
+    BE_CHECK_EQ(instanceData.size(), size_t(1));
+    BE_CHECK_EQ(instanceObjects[0], 9u);
+}
@@ -0,0 +1,156 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+#include <gtc/constants.hpp>
+
+#include "BeLod.h"
+#include "BeModel.h"
+#include "BeTest.h"
+
+namespace {
+    // A unit sphere as one slice, welded everywhere but the pole rows, which are left out.
+    auto MakeSphere(const uint32_t rings, const uint32_t segments) -> BeModel {
+        BeModel model;
+        for (uint32_t ring = 0; ring <= rings; ++ring) {
+            for (uint32_t segment = 0; segment < segments; ++segment) {
+                const float theta = glm::pi<float>() * float(ring) / float(rings);
+                const float phi = glm::two_pi<float>() * float(segment) / float(segments);
+                const glm::vec3 normal {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                model.FullVertices.push_back({.Position = normal, .Normal = normal});
+            }
+        }
+        // the poles as single vertices, so the surface is closed
+        const auto top = static_cast<uint32_t>(model.FullVertices.size());
+        model.FullVertices.push_back({.Position = {0.0f, 1.0f, 0.0f}, .Normal = {0.0f, 1.0f, 0.0f}});
+        model.FullVertices.push_back({.Position = {0.0f, -1.0f, 0.0f}, .Normal = {0.0f, -1.0f, 0.0f}});
+        auto vertex = [&](const uint32_t ring, const uint32_t segment) {
+            return ring == 0 ? top : ring == rings ? top + 1 : ring * segments + segment % segments;
+        };
+        for (uint32_t ring = 0; ring < rings; ++ring) {
+            for (uint32_t segment = 0; segment < segments; ++segment) {
+                if (ring != 0)
+                    model.Indices.insert(model.Indices.end(), {vertex(ring, segment), vertex(ring, segment + 1), vertex(ring + 1, segment)});
+                if (ring + 1 != rings)
+                    model.Indices.insert(model.Indices.end(), {vertex(ring, segment + 1), vertex(ring + 1, segment + 1), vertex(ring + 1, segment)});
+            }
+        }
+        auto& slice = model.DrawSlices.emplace_back();
+        slice.IndexCount = static_cast<uint32_t>(model.Indices.size());
+        slice.StartIndexLocation = 0;
+        slice.BaseVertexLocation = 0;
+        return model;
+    }
+
+    auto Height(const uint32_t x, const uint32_t y) -> float {
+        return 0.3f * std::sin(float(x) * 0.4f) * std::cos(float(y) * 0.3f);
+    }
+}
+
+BE_TEST(Lod, SimplifyReachesTargetCounts) {
+    const BeModel model = MakeSphere(48, 96);
+    std::vector<uint32_t> simplified;
+    const auto triangles = static_cast<uint32_t>(model.Indices.size() / 3);
+    for (const float ratio : BeLod::LevelRatios) {
+        const uint32_t target = uint32_t(float(triangles) * ratio) * 3;
+        (void)BeLod::Simplify(model.Indices, model.FullVertices, target, std::numeric_limits<float>::max(), simplified);
+        // one collapse removes two triangles, the last pass may overshoot by a few
+        BE_CHECK(simplified.size() <= target);
+        BE_CHECK(float(simplified.size()) >= float(target) * 0.95f);
+    }
+}
+
+BE_TEST(Lod, BordersAndSeamsStayInPlace) {
+    // a bumpy open grid with a UV seam down the middle: the outline and both sides of the seam are locked
+    constexpr uint32_t Size = 32;
+    constexpr uint32_t Seam = Size / 2;
+    std::vector<BeFullVertex> vertices;
+    for (uint32_t y = 0; y <= Size; ++y)
+        for (uint32_t x = 0; x <= Size; ++x)
+            vertices.push_back({.Position = {float(x), float(y), Height(x, y)}, .Normal = {0.0f, 0.0f, 1.0f}, .UV0 = {float(x) / Size, float(y) / Size}});
+    const auto seamStart = static_cast<uint32_t>(vertices.size());
+    for (uint32_t y = 0; y <= Size; ++y)
+        vertices.push_back({.Position = {float(Seam), float(y), Height(Seam, y)}, .Normal = {0.0f, 0.0f, 1.0f}, .UV0 = {1.0f, float(y) / Size}});
+    // left of the seam uses the grid's own seam column, right of it the copies
+    auto vertex = [&](const uint32_t x, const uint32_t y, const bool right) {
+        return right && x == Seam ? seamStart + y : y * (Size + 1) + x;
+    };
+    std::vector<uint32_t> indices;
+    for (uint32_t y = 0; y < Size; ++y) {
+        for (uint32_t x = 0; x < Size; ++x) {
+            const bool right = x >= Seam;
+            indices.insert(indices.end(), {vertex(x, y, right), vertex(x + 1, y, right), vertex(x, y + 1, right)});
+            indices.insert(indices.end(), {vertex(x + 1, y, right), vertex(x + 1, y + 1, right), vertex(x, y + 1, right)});
+        }
+    }
+    std::vector<uint32_t> locked;
+    for (uint32_t y = 0; y <= Size; ++y) {
+        for (uint32_t x = 0; x <= Size; ++x)
+            if (x == 0 || y == 0 || x == Size || y == Size || x == Seam) locked.push_back(vertex(x, y, false));
+        locked.push_back(seamStart + y);
+    }
+
+    std::vector<uint32_t> simplified;
+    (void)BeLod::Simplify(indices, vertices, uint32_t(indices.size() / 4), std::numeric_limits<float>::max(), simplified);
+    BE_CHECK(simplified.size() < indices.size() / 2);
+    // collapses land on existing vertices, so a locked vertex keeps its position as long as it is still referenced
+    uint32_t lost = 0;
+    for (const uint32_t v : locked)
+        lost += std::ranges::find(simplified, v) == simplified.end();
+    BE_CHECK_EQ(lost, 0u);
+    // and no triangle may reach across the seam
+    uint32_t crossing = 0;
+    for (size_t t = 0; t < simplified.size(); t += 3) {
+        bool left = false, right = false;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            const uint32_t v = simplified[t + corner];
+            if (v >= seamStart) right = true;
+            else if (v % (Size + 1) < Seam) left = true;
+            else if (v % (Size + 1) > Seam) right = true;
+        }
+        crossing += left && right;
+    }
+    BE_CHECK_EQ(crossing, 0u);
+}
+
+BE_TEST(Lod, LevelsShrinkWhileTheErrorGrows) {
+    // a sphere this fine reaches every ratio well before the error limit of 5% of its radius
+    BeModel model = MakeSphere(48, 96);
+    BeLod::Generate(model);
+    BE_CHECK_EQ(model.Lods.size(), std::size(BeLod::LevelRatios));
+    const float full = float(BeLod::GetTriangleCount(model, 0));
+    for (uint32_t level = 1; level <= model.Lods.size(); ++level) {
+        BE_CHECK(BeLod::GetError(model, level) > BeLod::GetError(model, level - 1));
+        BE_CHECK(float(BeLod::GetTriangleCount(model, level)) <= full * BeLod::LevelRatios[level - 1]);
+        BE_CHECK(float(BeLod::GetTriangleCount(model, level)) >= full * BeLod::LevelRatios[level - 1] * 0.95f);
+    }
+    BE_CHECK(BeLod::GetError(model, uint32_t(model.Lods.size())) <= BeLod::MaxRelativeError * std::sqrt(3.0f));
+}
+
+BE_TEST(Lod, SelectionHoldsInsideTheHysteresisBand) {
+    // levels of 0.01, 0.02 and 0.04 units against a 1 pixel threshold: level 1 is taken below 75 pixels per unit and
+    // left above 125
+    BeModel model;
+    for (const float error : {0.01f, 0.02f, 0.04f})
+        model.Lods.push_back({.Error = error, .Slices = {}});
+    BE_CHECK_EQ(BeLod::SelectLevel(model, 200.0f, 1.0f, 0), 0u);
+    BE_CHECK_EQ(BeLod::SelectLevel(model, 70.0f, 1.0f, 0), 1u);
+    BE_CHECK_EQ(BeLod::SelectLevel(model, 10.0f, 1.0f, 0), 3u);
+    BE_CHECK_EQ(BeLod::SelectLevel(model, 200.0f, 1.0f, 3), 0u);
+
+    // a camera wobbling inside the band keeps whichever level it came in with
+    uint32_t switches = 0;
+    for (const uint32_t start : {0u, 1u}) {
+        uint32_t level = start;
+        for (uint32_t frame = 0; frame < 200; ++frame) {
+            const float pixelsPerUnit = 100.0f + 20.0f * std::sin(float(frame) * 0.7f);
+            const uint32_t next = BeLod::SelectLevel(model, pixelsPerUnit, 1.0f, level);
+            switches += next != level;
+            level = next;
+        }
+    }
+    BE_CHECK_EQ(switches, 0u);
+    BE_CHECK_NEAR(BeLod::GetPixelsPerUnit(glm::half_pi<float>(), 1000.0f, 1.0f), 500.0f, 1e-2f);
+}
@@ -0,0 +1,204 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <span>
+#include <vector>
+#include <gtc/constants.hpp>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeLod.h"
+#include "BeMeshlets.h"
+#include "BeModel.h"
+#include "BeTest.h"
+
+namespace {
+    using BeTriangle = std::array<uint32_t, 3>;
+
+    // A unit sphere around center as one slice, triangles wound so cross(p1 - p0, p2 - p0) points outward.
+    auto AddSphere(BeModel& model, const glm::vec3& center, const uint32_t rings, const uint32_t segments) -> void {
+        const auto baseVertex = static_cast<int32_t>(model.FullVertices.size());
+        const auto startIndex = static_cast<uint32_t>(model.Indices.size());
+        for (uint32_t ring = 0; ring <= rings; ++ring) {
+            for (uint32_t segment = 0; segment <= segments; ++segment) {
+                const float theta = glm::pi<float>() * float(ring) / float(rings);
+                const float phi = glm::two_pi<float>() * float(segment) / float(segments);
+                const glm::vec3 normal {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                model.FullVertices.push_back({.Position = center + normal, .Normal = normal});
+            }
+        }
+        auto vertex = [&](const uint32_t ring, const uint32_t segment) { return ring * (segments + 1) + segment; };
+        auto position = [&](const uint32_t index) { return model.FullVertices[baseVertex + index].Position; };
+        auto addTriangle = [&](const BeTriangle& triangle) {
+            const glm::vec3 normal = glm::cross(position(triangle[1]) - position(triangle[0]), position(triangle[2]) - position(triangle[0]));
+            if (glm::length(normal) < 1e-6f) return;   // the pole rows collapse to a point
+            model.Indices.insert(model.Indices.end(), triangle.begin(), triangle.end());
+        };
+        for (uint32_t ring = 0; ring < rings; ++ring) {
+            for (uint32_t segment = 0; segment < segments; ++segment) {
+                addTriangle({vertex(ring, segment), vertex(ring, segment + 1), vertex(ring + 1, segment)});
+                addTriangle({vertex(ring, segment + 1), vertex(ring + 1, segment + 1), vertex(ring + 1, segment)});
+            }
+        }
+        auto& slice = model.DrawSlices.emplace_back();
+        slice.IndexCount = static_cast<uint32_t>(model.Indices.size()) - startIndex;
+        slice.StartIndexLocation = startIndex;
+        slice.BaseVertexLocation = baseVertex;
+    }
+
+    auto MakeSpheres() -> BeModel {
+        BeModel model;
+        AddSphere(model, {0.0f, 0.0f, 0.0f}, 48, 96);
+        AddSphere(model, {3.0f, 0.0f, 0.0f}, 16, 32);
+        return model;
+    }
+
+    // the triangles of an index range, sorted, each rotated to start at its smallest index so the winding is kept
+    auto CollectTriangles(const BeModel& model, const uint32_t startIndex, const uint32_t indexCount) -> std::vector<BeTriangle> {
+        std::vector<BeTriangle> triangles;
+        for (uint32_t i = 0; i < indexCount; i += 3) {
+            BeTriangle triangle {model.Indices[startIndex + i], model.Indices[startIndex + i + 1], model.Indices[startIndex + i + 2]};
+            std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+            triangles.push_back(triangle);
+        }
+        std::ranges::sort(triangles);
+        return triangles;
+    }
+
+    auto GetAllSlices(const BeModel& model) -> std::vector<BeModel::BeLodSlice> {
+        std::vector<BeModel::BeLodSlice> slices;
+        for (const auto& slice : model.DrawSlices)
+            slices.push_back({slice.IndexCount, slice.StartIndexLocation, slice.FirstMeshlet, slice.MeshletCount});
+        for (const auto& level : model.Lods)
+            slices.insert(slices.end(), level.Slices.begin(), level.Slices.end());
+        return slices;
+    }
+
+    // views from outside, from close up and from between the spheres, every one looking at the origin
+    auto GetViews() -> std::vector<BeMeshlets::BeCullView> {
+        const glm::mat4 projection = glm::perspectiveFovLH(glm::radians(60.0f), 1920.0f, 1080.0f, 0.05f, 100.0f);
+        std::vector<BeMeshlets::BeCullView> views;
+        for (uint32_t step = 0; step < 16; ++step) {
+            const float angle = glm::two_pi<float>() * float(step) / 16.0f;
+            for (const float distance : {1.3f, 2.0f, 6.0f}) {
+                const glm::vec3 eye = glm::vec3(std::cos(angle), 0.3f, std::sin(angle)) * distance;
+                const glm::mat4 view = glm::lookAtLH(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                views.push_back(BeMeshlets::MakeCullView(projection * view, glm::mat4(1.0f), eye));
+            }
+        }
+        return views;
+    }
+}
+
+BE_TEST(Meshlets, EveryTriangleInExactlyOneMeshlet) {
+    BeModel model = MakeSpheres();
+    BeLod::Generate(model);
+    BE_CHECK(!model.Lods.empty());
+    std::vector<std::vector<BeTriangle>> before;
+    for (const auto& slice : GetAllSlices(model))
+        before.push_back(CollectTriangles(model, slice.StartIndexLocation, slice.IndexCount));
+    BeMeshlets::Build(model);
+
+    const auto slices = GetAllSlices(model);
+    for (size_t s = 0; s < slices.size(); ++s) {
+        const auto& slice = slices[s];
+        BE_CHECK(slice.MeshletCount > 0);
+        BE_CHECK(uint64_t(slice.FirstMeshlet) + slice.MeshletCount <= model.Meshlets.size());
+        // meshlets tile the slice's index range in order, so together they draw every triangle once
+        uint32_t next = slice.StartIndexLocation;
+        uint32_t gaps = 0;
+        for (uint32_t m = slice.FirstMeshlet; m < slice.FirstMeshlet + slice.MeshletCount; ++m) {
+            gaps += model.Meshlets[m].StartIndexLocation != next;
+            next = model.Meshlets[m].StartIndexLocation + model.Meshlets[m].TriangleCount * 3;
+        }
+        BE_CHECK_EQ(gaps, 0u);
+        BE_CHECK_EQ(next, slice.StartIndexLocation + slice.IndexCount);
+        BE_CHECK(CollectTriangles(model, slice.StartIndexLocation, slice.IndexCount) == before[s]);
+    }
+}
+
+BE_TEST(Meshlets, MeshletsStayWithinLimits) {
+    BeModel model = MakeSpheres();
+    BeMeshlets::Build(model);
+    uint32_t overLimit = 0, wrongVertexCounts = 0, empty = 0;
+    std::vector<uint32_t> vertices;
+    for (const auto& meshlet : model.Meshlets) {
+        empty += meshlet.TriangleCount == 0;
+        overLimit += meshlet.TriangleCount > BeMeshlets::MaxTriangles || meshlet.VertexCount > BeMeshlets::MaxVertices;
+        vertices.assign(model.Indices.begin() + meshlet.StartIndexLocation, model.Indices.begin() + meshlet.StartIndexLocation + meshlet.TriangleCount * 3);
+        std::ranges::sort(vertices);
+        wrongVertexCounts += std::ranges::distance(vertices.begin(), std::ranges::unique(vertices).begin()) != meshlet.VertexCount;
+    }
+    BE_CHECK_EQ(empty, 0u);
+    BE_CHECK_EQ(overLimit, 0u);
+    BE_CHECK_EQ(wrongVertexCounts, 0u);
+}
+
+BE_TEST(Meshlets, CullingAgreesWithPerTriangleTests) {
+    // a meshlet may only be culled when every one of its triangles would be: each backfacing, or each with all its
+    // corners outside one frustum plane
+    BeModel model = MakeSpheres();
+    BeMeshlets::Build(model);
+    uint32_t wronglyBackfacing = 0, wronglyOutside = 0;
+    uint64_t coneCulled = 0, frustumCulled = 0, backfacingTriangles = 0, outsideTriangles = 0;
+    for (const auto& view : GetViews()) {
+        for (const auto& slice : model.DrawSlices) {
+            for (uint32_t m = slice.FirstMeshlet; m < slice.FirstMeshlet + slice.MeshletCount; ++m) {
+                const BeMeshlet& meshlet = model.Meshlets[m];
+                const BeMeshlets::BeVisibility visibility = BeMeshlets::Classify(meshlet, view);
+                for (uint32_t t = 0; t < meshlet.TriangleCount; ++t) {
+                    std::array<glm::vec3, 3> corners;
+                    for (uint32_t corner = 0; corner < 3; ++corner)
+                        corners[corner] = model.FullVertices[slice.BaseVertexLocation + model.Indices[meshlet.StartIndexLocation + t * 3 + corner]].Position;
+                    const glm::vec3 normal = glm::normalize(glm::cross(corners[1] - corners[0], corners[2] - corners[0]));
+                    const bool backfacing = glm::dot(view.Eye - corners[0], normal) <= 1e-4f;
+                    const bool outside = std::ranges::any_of(view.Planes, [&](const glm::vec4& plane) {
+                        return std::ranges::all_of(corners, [&](const glm::vec3& p) { return glm::dot(glm::vec3(plane), p) + plane.w < 1e-4f; });
+                    });
+                    backfacingTriangles += backfacing;
+                    outsideTriangles += outside;
+                    wronglyBackfacing += visibility == BeMeshlets::BeVisibility::Backfacing && !backfacing;
+                    wronglyOutside += visibility == BeMeshlets::BeVisibility::OutsideFrustum && !outside;
+                    coneCulled += visibility == BeMeshlets::BeVisibility::Backfacing;
+                    frustumCulled += visibility == BeMeshlets::BeVisibility::OutsideFrustum;
+                }
+            }
+        }
+    }
+    BE_CHECK_EQ(wronglyBackfacing, 0u);
+    BE_CHECK_EQ(wronglyOutside, 0u);
+    // conservative, but still a good share of what per triangle tests remove; the close views cut through meshlets,
+    // which keeps the frustum share lower
+    BE_CHECK(coneCulled * 3 > backfacingTriangles);
+    BE_CHECK(frustumCulled * 4 > outsideTriangles);
+}
+
+BE_TEST(Meshlets, CullMergesAdjacentVisibleRanges) {
+    BeModel model = MakeSpheres();
+    BeMeshlets::Build(model);
+    const auto& slice = model.DrawSlices[0];
+    const std::span meshlets = std::span(model.Meshlets).subspan(slice.FirstMeshlet, slice.MeshletCount);
+    uint32_t mismatches = 0, merged = 0;
+    for (const auto& view : GetViews()) {
+        // one range per run of visible meshlets
+        std::vector<BeMeshlets::BeIndexRange> expected;
+        uint32_t expectedCulled = 0;
+        bool previousVisible = false;
+        for (const auto& meshlet : meshlets) {
+            const bool visible = BeMeshlets::IsVisible(meshlet, view);
+            if (!visible) expectedCulled += meshlet.TriangleCount;
+            else if (previousVisible) expected.back().IndexCount += meshlet.TriangleCount * 3;
+            else expected.push_back({meshlet.StartIndexLocation, meshlet.TriangleCount * 3});
+            merged += visible && previousVisible;
+            previousVisible = visible;
+        }
+        std::vector<BeMeshlets::BeIndexRange> ranges {{0, 3}};
+        const uint32_t culled = BeMeshlets::Cull(meshlets, view, ranges);
+        mismatches += culled != expectedCulled || ranges.size() != expected.size() + 1;
+        for (size_t r = 0; r < expected.size() && r + 1 < ranges.size(); ++r)
+            mismatches += ranges[r + 1].StartIndexLocation != expected[r].StartIndexLocation || ranges[r + 1].IndexCount != expected[r].IndexCount;
+        // appended after what was there, never merged into it
+        mismatches += ranges[0].StartIndexLocation != 0 || ranges[0].IndexCount != 3;
+    }
+    BE_CHECK_EQ(mismatches, 0u);
+    BE_CHECK(merged > 0);
+}
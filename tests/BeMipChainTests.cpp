@@ -0,0 +1,177 @@
+﻿#include <algorithm>
+#include <bit>
+#include <utility>
+#include <vector>
+
+#include "BeMipChain.h"
+#include "BePixelKernels.h"
+#include "BeTest.h"
+
+namespace {
+    auto MakeChain(const uint32_t width, const uint32_t height, const std::vector<uint8_t>& level0) -> std::vector<uint8_t> {
+        std::vector<uint8_t> chain(BeMipChain::GetSizeInBytes(BeMipChain::Layout(width, height)));
+        std::ranges::copy(level0, chain.begin());
+        return chain;
+    }
+
+    auto MeasureCoverage(const uint8_t* pixels, const BeMipLevel& level, const uint8_t threshold) -> double {
+        const size_t pixelCount = size_t(level.Width) * level.Height;
+        size_t covered = 0;
+        for (size_t i = 0; i < pixelCount; ++i)
+            if (pixels[level.Offset + 4 * i + 3] >= threshold) ++covered;
+        return double(covered) / double(pixelCount);
+    }
+}
+
+BE_TEST(MipChain, LayoutHalvesDownToOneTexel) {
+    const std::pair<uint32_t, uint32_t> sizes[] = {{1, 1}, {2, 2}, {256, 256}, {256, 64}, {13, 5}, {1, 7}, {640, 480}, {1000, 3}};
+    for (const auto& [width, height] : sizes) {
+        const auto levels = BeMipChain::Layout(width, height);
+        BE_CHECK_EQ(levels.front().Width, width);
+        BE_CHECK_EQ(levels.front().Height, height);
+        BE_CHECK_EQ(levels.size(), size_t(std::bit_width(std::max(width, height))));
+        BE_CHECK_EQ(levels.back().Width, 1u);
+        BE_CHECK_EQ(levels.back().Height, 1u);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (i > 0) {
+                BE_CHECK_EQ(levels[i].Width, std::max(1u, levels[i - 1].Width / 2));
+                BE_CHECK_EQ(levels[i].Height, std::max(1u, levels[i - 1].Height / 2));
+            }
+            BE_CHECK_EQ(levels[i].Offset, offset);
+            offset += size_t(levels[i].Width) * levels[i].Height * 4;
+        }
+        BE_CHECK_EQ(BeMipChain::GetSizeInBytes(levels), offset);
+    }
+
+    const auto levels = BeMipChain::Layout(13, 5);
+    BE_CHECK_EQ(levels.size(), 4u);
+    BE_CHECK(levels[1].Width == 6 && levels[1].Height == 2);
+    BE_CHECK(levels[2].Width == 3 && levels[2].Height == 1);
+    BE_CHECK_EQ(BeMipChain::GetSizeInBytes(levels), size_t(4 * (65 + 12 + 3 + 1)));
+}
+
+BE_TEST(MipChain, BoxFilterAveragesInLinearLight) {
+    // black and white texels average to half the light, which sRGB encodes as 188 rather than 128
+    const std::vector<uint8_t> checker = {
+        0, 0, 0, 255,       255, 255, 255, 255,
+        255, 255, 255, 255, 0, 0, 0, 255,
+    };
+    const auto levels = BeMipChain::Layout(2, 2);
+
+    auto srgb = MakeChain(2, 2, checker);
+    BeMipChain::Generate(srgb.data(), levels, {.SRGB = true, .Parallel = false});
+    const uint8_t* texel = srgb.data() + levels[1].Offset;
+    BE_CHECK_EQ(int(texel[0]), 188);
+    BE_CHECK_EQ(int(texel[1]), 188);
+    BE_CHECK_EQ(int(texel[2]), 188);
+    BE_CHECK_EQ(int(texel[3]), 255);
+
+    auto linear = MakeChain(2, 2, checker);
+    BeMipChain::Generate(linear.data(), levels, {.SRGB = false, .Parallel = false});
+    texel = linear.data() + levels[1].Offset;
+    BE_CHECK_EQ(int(texel[0]), 128);
+    BE_CHECK_EQ(int(texel[3]), 255);
+
+    // alpha is linear in both modes
+    const std::vector<uint8_t> halfAlpha = {
+        255, 0, 0, 0,   255, 0, 0, 255,
+        255, 0, 0, 255, 255, 0, 0, 0,
+    };
+    auto alpha = MakeChain(2, 2, halfAlpha);
+    BeMipChain::Generate(alpha.data(), levels, {.SRGB = true, .Parallel = false});
+    texel = alpha.data() + levels[1].Offset;
+    BE_CHECK_EQ(int(texel[0]), 255);
+    BE_CHECK_EQ(int(texel[1]), 0);
+    BE_CHECK_EQ(int(texel[3]), 128);
+}
+
+BE_TEST(MipChain, UniformColourSurvivesEveryLevel) {
+    constexpr uint32_t width = 12;
+    constexpr uint32_t height = 7;
+    const auto levels = BeMipChain::Layout(width, height);
+    for (const uint8_t value : {uint8_t(0), uint8_t(37), uint8_t(128), uint8_t(200), uint8_t(255)}) {
+        std::vector<uint8_t> level0(size_t(width) * height * 4);
+        for (size_t i = 0; i < level0.size(); i += 4) {
+            level0[i] = value;
+            level0[i + 1] = uint8_t(255 - value);
+            level0[i + 2] = value;
+            level0[i + 3] = value;
+        }
+        auto chain = MakeChain(width, height, level0);
+        BeMipChain::Generate(chain.data(), levels, {.SRGB = true, .Parallel = false});
+        for (size_t i = 0; i < chain.size(); i += 4) {
+            BE_CHECK_EQ(int(chain[i]), int(value));
+            BE_CHECK_EQ(int(chain[i + 1]), 255 - int(value));
+            BE_CHECK_EQ(int(chain[i + 3]), int(value));
+        }
+    }
+}
+
+BE_TEST(MipChain, AlphaCoverageIsPreserved) {
+    // foliage-like cutout: thresholded, blurred noise, which plain box filtering erodes level after level
+    constexpr uint32_t size = 128;
+    std::vector<float> noise(size_t(size) * size);
+    uint32_t state = 1;
+    for (auto& value : noise) {
+        state = state * 1664525u + 1013904223u;
+        value = float(state >> 8) / 16777216.0f;
+    }
+    std::vector<uint8_t> level0(size_t(size) * size * 4, 255);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            float sum = 0.0f;
+            for (uint32_t dy = 0; dy < 5; ++dy)
+                for (uint32_t dx = 0; dx < 5; ++dx)
+                    sum += noise[size_t((y + dy + size - 2) % size) * size + (x + dx + size - 2) % size];
+            level0[(size_t(y) * size + x) * 4 + 3] = sum / 25.0f > 0.55f ? 255 : 0;
+        }
+    }
+
+    const auto levels = BeMipChain::Layout(size, size);
+    auto preserved = MakeChain(size, size, level0);
+    BeMipChain::Generate(preserved.data(), levels, {.SRGB = true, .AlphaCutoff = 0.5f, .Parallel = false});
+    auto plain = MakeChain(size, size, level0);
+    BeMipChain::Generate(plain.data(), levels, {.SRGB = true, .Parallel = false});
+
+    const double target = MeasureCoverage(preserved.data(), levels[0], 128);
+    BE_CHECK(target > 0.1 && target < 0.3);
+    for (size_t i = 1; i < levels.size(); ++i) {
+        const size_t pixelCount = size_t(levels[i].Width) * levels[i].Height;
+        if (pixelCount < 64) break; // too few texels to hold the fraction
+        BE_CHECK_NEAR(MeasureCoverage(preserved.data(), levels[i], 128), target, 0.05);
+    }
+    // without the correction the cutout thins out
+    BE_CHECK(MeasureCoverage(plain.data(), levels[3], 128) < 0.5 * target);
+}
+
+BE_TEST(MipChain, EveryInstructionSetAndThreadingMatchesScalar) {
+    constexpr uint32_t width = 301;
+    constexpr uint32_t height = 157;
+    std::vector<uint8_t> level0(size_t(width) * height * 4);
+    uint32_t state = 12345;
+    for (auto& channel : level0) {
+        state = state * 1664525u + 1013904223u;
+        channel = static_cast<uint8_t>(state >> 24);
+    }
+    const auto levels = BeMipChain::Layout(width, height);
+    constexpr BeMipSettings settings {.SRGB = true, .AlphaCutoff = 0.5f};
+
+    const auto previous = BePixelKernels::GetInstructionSet();
+    BePixelKernels::SetInstructionSet(BePixelKernels::BeInstructionSet::Scalar);
+    auto reference = MakeChain(width, height, level0);
+    BeMipChain::Generate(reference.data(), levels, {.SRGB = settings.SRGB, .AlphaCutoff = settings.AlphaCutoff, .Parallel = false});
+
+    for (auto instructionSet = BePixelKernels::BeInstructionSet::Scalar;
+         instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+         instructionSet = static_cast<BePixelKernels::BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+        BePixelKernels::SetInstructionSet(instructionSet);
+        for (const bool parallel : {false, true}) {
+            auto chain = MakeChain(width, height, level0);
+            BeMipChain::Generate(chain.data(), levels, {.SRGB = settings.SRGB, .AlphaCutoff = settings.AlphaCutoff, .Parallel = parallel});
+            BE_CHECK(chain == reference);
+        }
+    }
+    BePixelKernels::SetInstructionSet(previous);
+}
@@ -0,0 +1,125 @@
+﻿#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include <gtc/matrix_transform.hpp>
+
+#include "BeOcclusionBuffer.h"
+#include "BeTest.h"
+
+namespace {
+    using BeInstructionSet = BeOcclusionBuffer::BeInstructionSet;
+    using BeBox = std::pair<glm::vec3, glm::vec3>;
+
+    const std::vector<glm::vec3> CubeVertices = {
+        {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1}, {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1},
+    };
+    const std::vector<uint32_t> CubeIndices = {
+        0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 7, 6, 3, 6, 2, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5,
+    };
+    const std::vector<glm::vec3> QuadVertices = {{-1, 0, -1}, {1, 0, -1}, {1, 0, 1}, {-1, 0, 1}};
+    const std::vector<uint32_t> QuadIndices = {0, 2, 1, 0, 3, 2};
+
+    // A camera looking down +z over a ground plane, walls and a field of small boxes, some of them behind the walls.
+    struct BeScene {
+        glm::mat4 ProjectionView;
+        glm::mat4 Ground;
+        std::vector<glm::mat4> Walls;
+        std::vector<BeBox> Boxes;
+
+        BeScene(const uint32_t occluderCount, const uint32_t objectCount) {
+            std::mt19937 random(17);
+            std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+            for (uint32_t i = 0; i < occluderCount; ++i) {
+                const glm::vec3 position = {unit(random) * 160.0f - 80.0f, 0.0f, 10.0f + unit(random) * 90.0f};
+                const glm::vec3 scale = {2.0f + unit(random) * 6.0f, 1.0f + unit(random) * 5.0f, 0.5f};
+                Walls.push_back(glm::translate(glm::mat4(1.0f), position + glm::vec3(0.0f, scale.y, 0.0f)) *
+                    glm::rotate(glm::mat4(1.0f), (unit(random) - 0.5f) * 1.0f, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                    glm::scale(glm::mat4(1.0f), scale));
+            }
+            Ground = glm::scale(glm::mat4(1.0f), glm::vec3(400.0f, 1.0f, 400.0f));
+            for (uint32_t i = 0; i < objectCount; ++i) {
+                const glm::vec3 extent = glm::vec3(0.2f) + glm::vec3(unit(random), unit(random), unit(random)) * 0.8f;
+                const glm::vec3 center = {unit(random) * 240.0f - 120.0f, extent.y + unit(random) * 2.0f, 2.0f + unit(random) * 200.0f};
+                Boxes.emplace_back(center, extent);
+            }
+            ProjectionView =
+                glm::perspectiveFovLH(glm::radians(60.0f), float(BeOcclusionBuffer::Width), float(BeOcclusionBuffer::Height), 0.1f, 1000.0f) *
+                glm::lookAtLH(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.5f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+
+        auto AddOccluders(BeOcclusionBuffer& buffer) const -> void {
+            buffer.Begin(ProjectionView);
+            buffer.AddOccluder(QuadVertices, QuadIndices, Ground);
+            for (const auto& wall : Walls)
+                buffer.AddOccluder(CubeVertices, CubeIndices, wall);
+        }
+    };
+}
+
+BE_TEST(OcclusionBuffer, RasterizeMatchesReference) {
+    const BeScene scene(32, 0);
+    BeOcclusionBuffer buffer;
+    scene.AddOccluders(buffer);
+    buffer.RasterizeReference();
+    const std::vector<float> reference(buffer.GetDepth().begin(), buffer.GetDepth().end());
+    BE_CHECK_EQ(reference.size(), size_t(BeOcclusionBuffer::Width) * BeOcclusionBuffer::Height);
+    BE_CHECK(std::ranges::count(reference, 0.0f) < std::ssize(reference));
+    BE_CHECK(buffer.GetStatistics().RasterizedTriangles > 0);
+
+    for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+         instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+        for (const bool parallel : {false, true}) {
+            scene.AddOccluders(buffer);
+            buffer.Rasterize(parallel, instructionSet);
+            uint32_t mismatches = 0;
+            for (size_t i = 0; i < reference.size(); ++i)
+                mismatches += buffer.GetDepth()[i] != reference[i];
+            BE_CHECK_EQ(mismatches, 0u);
+        }
+    }
+}
+
+BE_TEST(OcclusionBuffer, BoxTestsMatchReference) {
+    const BeScene scene(32, 4000);
+    BeOcclusionBuffer buffer;
+    scene.AddOccluders(buffer);
+    buffer.Rasterize();
+
+    uint32_t mismatches = 0;
+    uint32_t occluded = 0;
+    for (const auto& [center, extent] : scene.Boxes) {
+        const bool visible = buffer.IsVisible(center, extent);
+        mismatches += visible != buffer.IsVisibleReference(center, extent);
+        occluded += !visible;
+    }
+    BE_CHECK_EQ(mismatches, 0u);
+    BE_CHECK(occluded > 0);
+    BE_CHECK(occluded < scene.Boxes.size());
+    // boxes off screen or across the near plane are visible without a test
+    BE_CHECK(buffer.GetStatistics().TestedBoxes <= scene.Boxes.size());
+    BE_CHECK_EQ(buffer.GetStatistics().OccludedBoxes, occluded);
+}
+
+BE_TEST(OcclusionBuffer, WallHidesWhatIsBehindIt) {
+    const glm::mat4 projectionView =
+        glm::perspectiveFovLH(glm::radians(60.0f), float(BeOcclusionBuffer::Width), float(BeOcclusionBuffer::Height), 0.1f, 1000.0f) *
+        glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 wall = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 10.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 3.0f, 0.5f));
+
+    BeOcclusionBuffer buffer;
+    buffer.Begin(projectionView);
+    buffer.Rasterize();
+    // nothing drawn hides nothing
+    BE_CHECK(buffer.IsVisible(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(1.0f)));
+
+    buffer.Begin(projectionView);
+    buffer.AddOccluder(CubeVertices, CubeIndices, wall);
+    buffer.Rasterize();
+    BE_CHECK(!buffer.IsVisible(glm::vec3(0.0f, 0.0f, 20.0f), glm::vec3(1.0f)));
+    BE_CHECK(buffer.IsVisible(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(1.0f)));
+    // crossing the near plane
+    BE_CHECK(buffer.IsVisible(glm::vec3(0.0f), glm::vec3(1.0f)));
+    // beside the wall
+    BE_CHECK(buffer.IsVisible(glm::vec3(20.0f, 0.0f, 30.0f), glm::vec3(1.0f)));
+}
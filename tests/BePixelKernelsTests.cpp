@@ -0,0 +1,206 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "BePixelKernels.h"
+#include "BeTest.h"
+
+namespace {
+    using BeInstructionSet = BePixelKernels::BeInstructionSet;
+
+    // widths around the 4 and 8 pixel steps, so every tail length goes through the scalar remainder
+    constexpr uint32_t Widths[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 67};
+
+    // Runs check once per instruction set the CPU supports, with that set active, and restores the previous one.
+    auto ForEachInstructionSet(const std::function<void(BeInstructionSet)>& check) -> void {
+        const BeInstructionSet previous = BePixelKernels::GetInstructionSet();
+        for (auto instructionSet = BeInstructionSet::Scalar; instructionSet <= BePixelKernels::GetSupportedInstructionSet();
+             instructionSet = static_cast<BeInstructionSet>(static_cast<uint8_t>(instructionSet) + 1)) {
+            BePixelKernels::SetInstructionSet(instructionSet);
+            check(instructionSet);
+        }
+        BePixelKernels::SetInstructionSet(previous);
+    }
+
+    auto MakeBytes(const size_t count, const uint32_t seed) -> std::vector<uint8_t> {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<uint32_t> byte(0, 255);
+        std::vector<uint8_t> bytes(count);
+        for (auto& value : bytes)
+            value = static_cast<uint8_t>(byte(random));
+        return bytes;
+    }
+}
+
+BE_TEST(PixelKernels, SwizzleMatchesReference) {
+    ForEachInstructionSet([](const BeInstructionSet) {
+        for (const uint32_t width : Widths) {
+            for (const uint32_t height : {1u, 2u, 3u}) {
+                const std::vector<uint8_t> source = MakeBytes(size_t(width) * height * 4, width * 7 + height);
+                for (const bool flip : {false, true}) {
+                    std::vector<uint8_t> result(source.size());
+                    BePixelKernels::SwizzleBGRAToRGBA(source.data(), result.data(), width, height, flip);
+                    uint32_t mismatches = 0;
+                    for (uint32_t y = 0; y < height; ++y) {
+                        const uint8_t* src = source.data() + size_t(flip ? height - 1 - y : y) * width * 4;
+                        const uint8_t* dst = result.data() + size_t(y) * width * 4;
+                        for (uint32_t x = 0; x < width; ++x) {
+                            mismatches += dst[4 * x + 0] != src[4 * x + 2] || dst[4 * x + 1] != src[4 * x + 1] ||
+                                dst[4 * x + 2] != src[4 * x + 0] || dst[4 * x + 3] != src[4 * x + 3];
+                        }
+                    }
+                    BE_CHECK_EQ(mismatches, 0u);
+                }
+            }
+        }
+    });
+}
+
+BE_TEST(PixelKernels, ExpandMatchesReference) {
+    ForEachInstructionSet([](const BeInstructionSet) {
+        for (const uint32_t channels : {1u, 2u, 3u, 4u}) {
+            for (const uint32_t width : Widths) {
+                const uint32_t height = 3;
+                const std::vector<uint8_t> source = MakeBytes(size_t(width) * height * channels, width * 5 + channels);
+                for (const bool flip : {false, true}) {
+                    std::vector<uint8_t> result(size_t(width) * height * 4);
+                    BePixelKernels::ExpandToRGBA(source.data(), channels, result.data(), width, height, flip);
+                    uint32_t mismatches = 0;
+                    for (uint32_t y = 0; y < height; ++y) {
+                        const uint8_t* src = source.data() + size_t(flip ? height - 1 - y : y) * width * channels;
+                        const uint8_t* dst = result.data() + size_t(y) * width * 4;
+                        for (uint32_t x = 0; x < width; ++x) {
+                            const uint8_t* pixel = src + size_t(x) * channels;
+                            uint8_t expected[4];
+                            switch (channels) {
+                                case 1: expected[0] = expected[1] = expected[2] = pixel[0]; expected[3] = 255; break;
+                                case 2: expected[0] = expected[1] = expected[2] = pixel[0]; expected[3] = pixel[1]; break;
+                                case 3: expected[0] = pixel[0]; expected[1] = pixel[1]; expected[2] = pixel[2]; expected[3] = 255; break;
+                                default: expected[0] = pixel[0]; expected[1] = pixel[1]; expected[2] = pixel[2]; expected[3] = pixel[3]; break;
+                            }
+                            for (uint32_t c = 0; c < 4; ++c)
+                                mismatches += dst[4 * x + c] != expected[c];
+                        }
+                    }
+                    BE_CHECK_EQ(mismatches, 0u);
+                }
+            }
+        }
+    });
+}
+
+BE_TEST(PixelKernels, FlipVerticallyMatchesReference) {
+    ForEachInstructionSet([](const BeInstructionSet) {
+        for (const uint32_t width : Widths) {
+            for (const uint32_t height : {1u, 2u, 5u, 6u}) {
+                const std::vector<uint8_t> source = MakeBytes(size_t(width) * height * 4, width * 3 + height);
+                std::vector<uint8_t> result = source;
+                BePixelKernels::FlipVertically(result.data(), width, height);
+                uint32_t mismatches = 0;
+                const size_t rowSize = size_t(width) * 4;
+                for (uint32_t y = 0; y < height; ++y) {
+                    for (size_t i = 0; i < rowSize; ++i)
+                        mismatches += result[y * rowSize + i] != source[(height - 1 - y) * rowSize + i];
+                }
+                BE_CHECK_EQ(mismatches, 0u);
+            }
+        }
+    });
+}
+
+BE_TEST(PixelKernels, PremultiplyRoundsEveryPair) {
+    ForEachInstructionSet([](const BeInstructionSet) {
+        // every colour against every alpha, colour in r and b and its complement in g
+        std::vector<uint8_t> pixels(256 * 256 * 4);
+        for (uint32_t alpha = 0; alpha < 256; ++alpha) {
+            for (uint32_t color = 0; color < 256; ++color) {
+                uint8_t* pixel = pixels.data() + (alpha * 256 + color) * 4;
+                pixel[0] = static_cast<uint8_t>(color);
+                pixel[1] = static_cast<uint8_t>(255 - color);
+                pixel[2] = static_cast<uint8_t>(color);
+                pixel[3] = static_cast<uint8_t>(alpha);
+            }
+        }
+        BePixelKernels::Premultiply(pixels.data(), 256 * 256);
+        uint32_t mismatches = 0;
+        for (uint32_t alpha = 0; alpha < 256; ++alpha) {
+            for (uint32_t color = 0; color < 256; ++color) {
+                const uint8_t* pixel = pixels.data() + (alpha * 256 + color) * 4;
+                const auto expected = [&](const uint32_t value) { return static_cast<uint8_t>(std::lround(value * alpha / 255.0)); };
+                mismatches += pixel[0] != expected(color) || pixel[1] != expected(255 - color) ||
+                    pixel[2] != expected(color) || pixel[3] != alpha;
+            }
+        }
+        BE_CHECK_EQ(mismatches, 0u);
+
+        // short runs leave the pixels after them alone
+        for (const uint32_t count : Widths) {
+            std::vector<uint8_t> run = MakeBytes((count + 1) * 4, count);
+            const std::vector<uint8_t> original = run;
+            BePixelKernels::Premultiply(run.data(), count);
+            for (uint32_t c = 0; c < 4; ++c)
+                BE_CHECK_EQ(run[count * 4 + c], original[count * 4 + c]);
+        }
+    });
+}
+
+BE_TEST(PixelKernels, DownsampleMatchesReference) {
+    const std::pair<uint32_t, uint32_t> sizes[] = {{1, 1}, {2, 2}, {3, 5}, {7, 3}, {16, 2}, {17, 4}, {33, 9}, {67, 4}, {64, 64}};
+    ForEachInstructionSet([&](const BeInstructionSet) {
+        for (const auto& [srcWidth, srcHeight] : sizes) {
+            std::mt19937 random(srcWidth * 31 + srcHeight);
+            std::uniform_int_distribution<uint32_t> value(0, 4095);
+            std::vector<uint16_t> source(size_t(srcWidth) * srcHeight * 4);
+            for (auto& channel : source)
+                channel = static_cast<uint16_t>(value(random));
+
+            const uint32_t dstWidth = std::max(1u, srcWidth / 2);
+            const uint32_t dstHeight = std::max(1u, srcHeight / 2);
+            std::vector<uint16_t> result(size_t(dstWidth) * dstHeight * 4);
+            // in two row ranges, as the mip jobs split it
+            BePixelKernels::Downsample2x2(source.data(), srcWidth, srcHeight, result.data(), 0, dstHeight / 2);
+            BePixelKernels::Downsample2x2(source.data(), srcWidth, srcHeight, result.data(), dstHeight / 2, dstHeight);
+
+            uint32_t mismatches = 0;
+            const auto at = [&](const uint32_t x, const uint32_t y, const uint32_t c) {
+                return uint32_t(source[(size_t(std::min(y, srcHeight - 1)) * srcWidth + std::min(x, srcWidth - 1)) * 4 + c]);
+            };
+            for (uint32_t y = 0; y < dstHeight; ++y) {
+                for (uint32_t x = 0; x < dstWidth; ++x) {
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        const uint32_t sum = at(2 * x, 2 * y, c) + at(2 * x + 1, 2 * y, c) + at(2 * x, 2 * y + 1, c) + at(2 * x + 1, 2 * y + 1, c);
+                        mismatches += result[(size_t(y) * dstWidth + x) * 4 + c] != (sum + 2) >> 2;
+                    }
+                }
+            }
+            BE_CHECK_EQ(mismatches, 0u);
+        }
+    });
+}
+
+BE_TEST(PixelKernels, Linear12RoundTrip) {
+    std::vector<uint8_t> source(256 * 4);
+    for (uint32_t i = 0; i < 256; ++i)
+        source[4 * i + 0] = source[4 * i + 1] = source[4 * i + 2] = source[4 * i + 3] = static_cast<uint8_t>(i);
+    for (const bool srgb : {false, true}) {
+        std::vector<uint16_t> linear(source.size());
+        BePixelKernels::DecodeToLinear12(source.data(), linear.data(), 256, srgb);
+        BE_CHECK_EQ(linear[0], 0);
+        BE_CHECK_EQ(linear[255 * 4], 4095);
+        uint32_t notIncreasing = 0;
+        for (uint32_t i = 1; i < 256; ++i)
+            notIncreasing += linear[4 * i] <= linear[4 * (i - 1)];
+        BE_CHECK_EQ(notIncreasing, 0u);
+
+        std::vector<uint8_t> result(source.size());
+        BePixelKernels::EncodeFromLinear12(linear.data(), result.data(), 256, srgb);
+        BE_CHECK(result == source);
+    }
+    BE_CHECK_EQ(BePixelKernels::Linear12ToUnorm8(0), 0);
+    BE_CHECK_EQ(BePixelKernels::Linear12ToUnorm8(4095), 255);
+    BE_CHECK_EQ(BePixelKernels::Linear12ToUnorm8(60000), 255);
+}
@@ -0,0 +1,121 @@
+﻿#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#include "BeCommandList.h"
+#include "BeDeviceContext.h"
+#include "BeStateTracker.h"
+
+// everything a context has bound, the way D3D11 keeps it: render targets past the bound count are empty
+struct BeBoundState {
+    ID3D11InputLayout* InputLayout = nullptr;
+    uint32_t Topology = 0;
+    std::array<ID3D11Buffer*, BeStateTracker::VertexBufferSlots> VertexBuffers {};
+    std::array<uint32_t, BeStateTracker::VertexBufferSlots> VertexStrides {};
+    std::array<uint32_t, BeStateTracker::VertexBufferSlots> VertexOffsets {};
+    ID3D11Buffer* IndexBuffer = nullptr;
+    uint32_t IndexFormat = 0;
+    uint32_t IndexOffset = 0;
+    ID3D11VertexShader* VertexShader = nullptr;
+    ID3D11PixelShader* PixelShader = nullptr;
+    std::array<ID3D11Buffer*, BeStateTracker::ConstantBufferSlots> VSConstantBuffers {};
+    std::array<ID3D11Buffer*, BeStateTracker::ConstantBufferSlots> PSConstantBuffers {};
+    std::array<ID3D11ShaderResourceView*, BeStateTracker::ShaderResourceSlots> PSShaderResources {};
+    std::array<ID3D11SamplerState*, BeStateTracker::SamplerSlots> PSSamplers {};
+    ID3D11RasterizerState* RasterizerState = nullptr;
+    ID3D11BlendState* BlendState = nullptr;
+    ID3D11DepthStencilState* DepthStencilState = nullptr;
+    uint32_t StencilReference = 0;
+    std::array<ID3D11RenderTargetView*, BeStateTracker::RenderTargetSlots> RenderTargets {};
+    ID3D11DepthStencilView* DepthTarget = nullptr;
+
+    auto operator==(const BeBoundState&) const -> bool = default;
+};
+
+// Applies calls to a BeBoundState and counts them, and the ones that left it as it was.
+class BeRecordingContext final : public BeDeviceContext {
+public:
+    BeBoundState State;
+    uint32_t Calls = 0;
+    uint32_t UnchangedCalls = 0;
+
+    auto SetInputLayout(ID3D11InputLayout* layout) -> void override {
+        Record([&] { State.InputLayout = layout; });
+    }
+    auto SetPrimitiveTopology(const uint32_t topology) -> void override {
+        Record([&] { State.Topology = topology; });
+    }
+    auto SetVertexBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers, const uint32_t* strides, const uint32_t* offsets) -> void override {
+        Record([&] {
+            std::copy_n(buffers, count, State.VertexBuffers.begin() + startSlot);
+            std::copy_n(strides, count, State.VertexStrides.begin() + startSlot);
+            std::copy_n(offsets, count, State.VertexOffsets.begin() + startSlot);
+        });
+    }
+    auto SetIndexBuffer(ID3D11Buffer* buffer, const uint32_t format, const uint32_t offset) -> void override {
+        Record([&] { State.IndexBuffer = buffer; State.IndexFormat = format; State.IndexOffset = offset; });
+    }
+    auto SetVertexShader(ID3D11VertexShader* shader) -> void override {
+        Record([&] { State.VertexShader = shader; });
+    }
+    auto SetPixelShader(ID3D11PixelShader* shader) -> void override {
+        Record([&] { State.PixelShader = shader; });
+    }
+    auto SetVSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void override {
+        Record([&] { std::copy_n(buffers, count, State.VSConstantBuffers.begin() + startSlot); });
+    }
+    auto SetPSConstantBuffers(const uint32_t startSlot, const uint32_t count, ID3D11Buffer* const* buffers) -> void override {
+        Record([&] { std::copy_n(buffers, count, State.PSConstantBuffers.begin() + startSlot); });
+    }
+    auto SetPSShaderResources(const uint32_t startSlot, const uint32_t count, ID3D11ShaderResourceView* const* views) -> void override {
+        Record([&] { std::copy_n(views, count, State.PSShaderResources.begin() + startSlot); });
+    }
+    auto SetPSSamplers(const uint32_t startSlot, const uint32_t count, ID3D11SamplerState* const* samplers) -> void override {
+        Record([&] { std::copy_n(samplers, count, State.PSSamplers.begin() + startSlot); });
+    }
+    auto SetRasterizerState(ID3D11RasterizerState* state) -> void override {
+        Record([&] { State.RasterizerState = state; });
+    }
+    auto SetBlendState(ID3D11BlendState* state) -> void override {
+        Record([&] { State.BlendState = state; });
+    }
+    auto SetDepthStencilState(ID3D11DepthStencilState* state, const uint32_t stencilReference) -> void override {
+        Record([&] { State.DepthStencilState = state; State.StencilReference = stencilReference; });
+    }
+    auto SetRenderTargets(const uint32_t count, ID3D11RenderTargetView* const* targets, ID3D11DepthStencilView* depthTarget) -> void override {
+        Record([&] {
+            State.RenderTargets = {};
+            std::copy_n(targets, count, State.RenderTargets.begin());
+            State.DepthTarget = depthTarget;
+        });
+    }
+    auto ClearState() -> void override {
+        Record([&] { State = {}; });
+    }
+    auto ExecuteCommandList(const BeCommandList& commands) -> void override {
+        commands.Replay(*this);
+    }
+    // nothing below changes a binding
+    auto SetViewport(uint32_t, uint32_t) -> void override {}
+    auto ClearRenderTargetView(ID3D11RenderTargetView*, const float*) -> void override {}
+    auto ClearDepthStencilView(ID3D11DepthStencilView*, uint32_t, float, uint8_t) -> void override {}
+    auto UpdateBuffer(ID3D11Buffer*, uint32_t, const void*, uint32_t, bool) -> void override {}
+    auto CopyTextureRegion(ID3D11Texture2D*, ID3D11Texture2D*, uint32_t, uint32_t) -> void override {}
+    auto Draw(uint32_t, uint32_t) -> void override {}
+    auto DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) -> void override {}
+
+private:
+    auto Record(auto&& apply) -> void {
+        const BeBoundState before = State;
+        apply();
+        ++Calls;
+        UnchangedCalls += State == before;
+    }
+};
+
+// stands in for a D3D11 object, never dereferenced; 0 is nullptr
+template <typename T>
+inline auto MakeToken(const uint32_t index) -> T* {
+    return reinterpret_cast<T*>(static_cast<uintptr_t>(index) * 64);
+}
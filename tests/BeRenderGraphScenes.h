@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <algorithm>
+#include <format>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BeRenderGraph.h"
+
+// the renderer as Program sets it up, with a chain of effectCount fullscreen effects between lighting and composer
+inline auto AddRendererGraph(BeRenderGraph& graph, const uint32_t width, const uint32_t height, const uint32_t effectCount, std::mt19937* shuffle) -> void {
+    using BeFormat = BeRenderGraph::BeFormat;
+    auto target = [&](const BeFormat format) {
+        return BeRenderGraph::BeResourceDescriptor {.Format = format, .Width = width, .Height = height};
+    };
+    graph.AddResource("DepthStencil", target(BeFormat::Depth24Stencil8));
+    graph.AddResource("GBuffer0", target(BeFormat::RGBA8Unorm));
+    graph.AddResource("GBuffer1", target(BeFormat::RGBA16Float));
+    graph.AddResource("GBuffer2", target(BeFormat::RGBA8Unorm));
+    graph.AddResource("Lighting", target(BeFormat::R11G11B10Float));
+    for (uint32_t i = 0; i < effectCount; ++i)
+        graph.AddResource(std::format("PPOutput{}", i), target(BeFormat::R11G11B10Float));
+    graph.ImportResource("Backbuffer");
+
+    std::vector<std::pair<std::string, BeRenderGraph::BePassResources>> passes;
+    passes.push_back({"Geometry", {.Reads = {}, .Writes = {"DepthStencil", "GBuffer0", "GBuffer1", "GBuffer2"}}});
+    passes.push_back({"Lighting", {.Reads = {"DepthStencil", "GBuffer0", "GBuffer1", "GBuffer2"}, .Writes = {"Lighting"}}});
+    std::string lastOutput = "Lighting";
+    for (uint32_t i = 0; i < effectCount; ++i) {
+        std::string output = std::format("PPOutput{}", i);
+        passes.push_back({std::format("Effect{}", i), {.Reads = {lastOutput}, .Writes = {output}}});
+        lastOutput = std::move(output);
+    }
+    passes.push_back({"Composer", {.Reads = {"DepthStencil", "GBuffer0", "GBuffer1", "GBuffer2", lastOutput}, .Writes = {"Backbuffer"}}});
+    if (shuffle) std::ranges::shuffle(passes, *shuffle);
+    for (const auto& [name, resources] : passes)
+        graph.AddPass(name, resources);
+}
@@ -0,0 +1,204 @@
+﻿#include <algorithm>
+#include <format>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BeRenderGraph.h"
+#include "BeRenderGraphScenes.h"
+#include "BeTest.h"
+
+namespace {
+    auto PositionOf(const BeRenderGraph& graph, const std::string& name) -> uint32_t {
+        const auto& order = graph.GetOrder();
+        for (uint32_t i = 0; i < order.size(); ++i)
+            if (graph.GetPasses()[order[i]].Name == name) return i;
+        return UINT32_MAX;
+    }
+
+    auto PhysicalOf(const BeRenderGraph& graph, const std::string& name) -> uint32_t {
+        for (const auto& resource : graph.GetResources())
+            if (resource.Name == name) return resource.Physical;
+        return UINT32_MAX - 1;
+    }
+
+    // resources sharing a texture have equal descriptors and lifetimes that do not overlap, used ones all have one
+    auto CheckAliasing(const BeRenderGraph& graph) -> bool {
+        const auto& resources = graph.GetResources();
+        for (uint32_t a = 0; a < resources.size(); ++a) {
+            const auto& resource = resources[a];
+            const bool used = resource.FirstUse != UINT32_MAX;
+            if (resource.Imported ? resource.Physical != BeRenderGraph::NoPhysical : used != (resource.Physical != BeRenderGraph::NoPhysical))
+                return false;
+            if (used && !resource.Imported && !(graph.GetPhysicalResources()[resource.Physical] == resource.Descriptor))
+                return false;
+            for (uint32_t b = a + 1; b < resources.size(); ++b) {
+                const auto& other = resources[b];
+                if (resource.Physical == BeRenderGraph::NoPhysical || resource.Physical != other.Physical) continue;
+                if (resource.FirstUse <= other.LastUse && other.FirstUse <= resource.LastUse) return false;
+            }
+        }
+        return graph.GetPhysicalBytes() <= graph.GetTransientBytes();
+    }
+
+    auto Throws(auto&& call) -> bool {
+        try {
+            call();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    }
+}
+
+BE_TEST(RenderGraph, RendererGraphInAnyOrder) {
+    // lighting and the single effect output overlap in the effect pass, nothing aliases
+    std::mt19937 random(43);
+    for (uint32_t i = 0; i < 10; ++i) {
+        BeRenderGraph graph;
+        AddRendererGraph(graph, 64, 32, 1, &random);
+        graph.Compile();
+        BE_CHECK_EQ(graph.GetOrder().size(), size_t(4));
+        BE_CHECK_EQ(PositionOf(graph, "Geometry"), 0u);
+        BE_CHECK_EQ(PositionOf(graph, "Lighting"), 1u);
+        BE_CHECK_EQ(PositionOf(graph, "Effect0"), 2u);
+        BE_CHECK_EQ(PositionOf(graph, "Composer"), 3u);
+        BE_CHECK_EQ(graph.GetPhysicalResources().size(), size_t(6));
+        BE_CHECK(CheckAliasing(graph));
+    }
+}
+
+BE_TEST(RenderGraph, ChainPingPongsAndUnusedPassesAreCulled) {
+    std::mt19937 random(44);
+    BeRenderGraph graph;
+    AddRendererGraph(graph, 64, 32, 3, &random);
+    graph.AddResource("DebugView", {.Width = 64, .Height = 32});
+    graph.AddPass("Debug", {.Reads = {"GBuffer1"}, .Writes = {"DebugView"}});
+    graph.Compile();
+    BE_CHECK_EQ(graph.GetOrder().size(), size_t(6));
+    BE_CHECK(graph.GetPasses().back().Culled);
+    BE_CHECK_EQ(PhysicalOf(graph, "DebugView"), BeRenderGraph::NoPhysical);
+    BE_CHECK_EQ(PhysicalOf(graph, "PPOutput1"), PhysicalOf(graph, "Lighting"));
+    BE_CHECK_EQ(PhysicalOf(graph, "PPOutput2"), PhysicalOf(graph, "PPOutput0"));
+    BE_CHECK_EQ(graph.GetPhysicalResources().size(), size_t(6));
+    BE_CHECK(CheckAliasing(graph));
+    BE_CHECK(graph.GetPhysicalBytes() < graph.GetTransientBytes());
+}
+
+BE_TEST(RenderGraph, DifferentDescriptorsNeverAlias) {
+    // two targets in a chain that would alias if they matched
+    BeRenderGraph graph;
+    graph.AddResource("A", {.Format = BeRenderGraph::BeFormat::RGBA8Unorm, .Width = 16, .Height = 16});
+    graph.AddResource("B", {.Format = BeRenderGraph::BeFormat::RGBA16Float, .Width = 16, .Height = 16});
+    graph.AddResource("C", {.Format = BeRenderGraph::BeFormat::RGBA8Unorm, .Width = 16, .Height = 16});
+    graph.AddResource("D", {.Format = BeRenderGraph::BeFormat::RGBA8Unorm, .Width = 16, .Height = 8});
+    graph.ImportResource("Output");
+    graph.AddPass("First", {.Reads = {}, .Writes = {"A"}});
+    graph.AddPass("Second", {.Reads = {"A"}, .Writes = {"B"}});
+    graph.AddPass("Third", {.Reads = {"B"}, .Writes = {"C"}});
+    graph.AddPass("Fourth", {.Reads = {"C"}, .Writes = {"D"}});
+    graph.AddPass("Last", {.Reads = {"D"}, .Writes = {"Output"}});
+    graph.Compile();
+    BE_CHECK_EQ(PhysicalOf(graph, "C"), PhysicalOf(graph, "A"));
+    BE_CHECK(PhysicalOf(graph, "B") != PhysicalOf(graph, "A"));
+    BE_CHECK(PhysicalOf(graph, "D") != PhysicalOf(graph, "B"));
+    BE_CHECK(PhysicalOf(graph, "D") != PhysicalOf(graph, "A"));
+    BE_CHECK_EQ(graph.GetPhysicalResources().size(), size_t(3));
+    BE_CHECK(CheckAliasing(graph));
+    BE_CHECK_EQ(graph.GetTransientBytes(), uint64_t(16 * 16 * 4 + 16 * 16 * 8 + 16 * 16 * 4 + 16 * 8 * 4));
+}
+
+BE_TEST(RenderGraph, CyclesAndUnknownNamesThrow) {
+    BeRenderGraph graph;
+    graph.AddResource("X", {.Width = 4, .Height = 4});
+    graph.AddResource("Y", {.Width = 4, .Height = 4});
+    graph.ImportResource("Backbuffer");
+    graph.AddPass("A", {.Reads = {"X"}, .Writes = {"Y"}});
+    graph.AddPass("B", {.Reads = {"Y"}, .Writes = {"X"}});
+    graph.AddPass("C", {.Reads = {"Y"}, .Writes = {"Backbuffer"}});
+    BE_CHECK(Throws([&] { graph.Compile(); }));
+    BE_CHECK(Throws([&] { graph.AddPass("D", {.Reads = {"Z"}, .Writes = {}}); }));
+    BE_CHECK(Throws([&] { graph.AddResource("X", {}); }));
+    BE_CHECK(Throws([&] { graph.ImportResource("Backbuffer"); }));
+}
+
+BE_TEST(RenderGraph, RandomGraphs) {
+    // every resource has one pass that writes it and is read only by passes after that one in a hidden order, some
+    // passes write an imported output of their own; passes are added shuffled
+    std::mt19937 random(43);
+    uint32_t misplaced = 0, wronglyCulled = 0, badAliasing = 0;
+    for (uint32_t iteration = 0; iteration < 500; ++iteration) {
+        const uint32_t passCount = 2 + random() % 20;
+        std::vector<BeRenderGraph::BePassResources> passes(passCount);
+        std::vector<uint32_t> owners;
+        BeRenderGraph graph;
+        for (uint32_t p = 0; p < passCount; ++p) {
+            for (uint32_t w = 0, writes = 1 + random() % 2; w < writes; ++w) {
+                const auto name = std::format("R{}", owners.size());
+                const auto format = random() % 2 ? BeRenderGraph::BeFormat::RGBA8Unorm : BeRenderGraph::BeFormat::R11G11B10Float;
+                graph.AddResource(name, {.Format = format, .Width = 8, .Height = 8});
+                passes[p].Writes.push_back(name);
+                owners.push_back(p);
+            }
+            if (random() % 4 == 0) {
+                const auto output = std::format("Output{}", p);
+                graph.ImportResource(output);
+                passes[p].Writes.push_back(output);
+            }
+            for (uint32_t r = 0, reads = random() % 3; r < reads; ++r) {
+                const uint32_t resource = random() % owners.size();
+                if (owners[resource] < p) passes[p].Reads.push_back(std::format("R{}", resource));
+            }
+        }
+        std::vector<uint32_t> addOrder(passCount);
+        std::iota(addOrder.begin(), addOrder.end(), 0u);
+        std::ranges::shuffle(addOrder, random);
+        for (const uint32_t p : addOrder)
+            graph.AddPass(std::format("P{}", p), passes[p]);
+        graph.Compile();
+
+        // kept: writes the output, or a resource a kept pass reads; found by iterating to a fixed point
+        std::vector<uint8_t> kept(passCount, 0);
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (uint32_t p = 0; p < passCount; ++p) {
+                if (kept[p]) continue;
+                const bool needed = std::ranges::any_of(passes[p].Writes, [&](const std::string& write) {
+                    if (write.starts_with("Output")) return true;
+                    for (uint32_t q = 0; q < passCount; ++q)
+                        if (kept[q] && std::ranges::find(passes[q].Reads, write) != passes[q].Reads.end()) return true;
+                    return false;
+                });
+                if (needed) kept[p] = 1, changed = true;
+            }
+        }
+        for (uint32_t p = 0; p < passCount; ++p) {
+            const uint32_t position = PositionOf(graph, std::format("P{}", p));
+            wronglyCulled += (position != UINT32_MAX) != (kept[p] != 0);
+            if (!kept[p]) continue;
+            for (const auto& read : passes[p].Reads) {
+                const uint32_t writer = owners[std::stoul(read.substr(1))];
+                misplaced += PositionOf(graph, std::format("P{}", writer)) >= position;
+            }
+        }
+        badAliasing += !CheckAliasing(graph);
+    }
+    BE_CHECK_EQ(wronglyCulled, 0u);
+    BE_CHECK_EQ(misplaced, 0u);
+    BE_CHECK_EQ(badAliasing, 0u);
+}
+
+BE_TEST(RenderGraph, FormatSizes) {
+    using BeFormat = BeRenderGraph::BeFormat;
+    BE_CHECK_EQ(BeRenderGraph::GetBytesPerPixel(BeFormat::RGBA32Float), 16u);
+    BE_CHECK_EQ(BeRenderGraph::GetBytesPerPixel(BeFormat::RGBA16Float), 8u);
+    BE_CHECK_EQ(BeRenderGraph::GetBytesPerPixel(BeFormat::R11G11B10Float), 4u);
+    BE_CHECK_EQ(BeRenderGraph::GetBytesPerPixel(BeFormat::Depth24Stencil8), 4u);
+    BE_CHECK_EQ(BeRenderGraph::GetBytesPerPixel(BeFormat::Depth16), 2u);
+    BE_CHECK(BeRenderGraph::IsDepthFormat(BeFormat::Depth32));
+    BE_CHECK(!BeRenderGraph::IsDepthFormat(BeFormat::R32Float));
+    BE_CHECK_EQ(BeRenderGraph::GetByteSize({.Format = BeFormat::RGBA16Float, .Width = 1920, .Height = 1080}), uint64_t(1920) * 1080 * 8);
+    BE_CHECK(Throws([] { (void)BeRenderGraph::GetBytesPerPixel(static_cast<BeFormat>(200)); }));
+}
@@ -0,0 +1,83 @@
+﻿#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "BeSceneGraph.h"
+#include "BeTest.h"
+
+namespace {
+    // trees of up to 12 nodes, each node below a random earlier node of its tree
+    auto MakeForest(const uint32_t nodeCount, std::mt19937& random) -> BeSceneGraph {
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        BeSceneGraph graph;
+        uint32_t treeRoot = 0;
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            if (i - treeRoot >= 1 + random() % 12) treeRoot = i;
+            const uint32_t parent = i == treeRoot ? BeSceneGraph::NoParent : treeRoot + random() % (i - treeRoot);
+            graph.AddNode(parent, glm::vec3(unit(random), unit(random), unit(random)) * 4.0f - 2.0f,
+                glm::quat(glm::vec3(unit(random), unit(random), unit(random)) * 6.28f), glm::vec3(0.5f + unit(random)));
+        }
+        return graph;
+    }
+}
+
+BE_TEST(SceneGraph, UpdateMatchesFullRecompute) {
+    std::mt19937 random(19);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    BeSceneGraph graph = MakeForest(2000, random);
+    graph.Update();
+    uint32_t mismatches = 0;
+    for (uint32_t frame = 0; frame < 50; ++frame) {
+        for (uint32_t i = 0, moves = random() % 40; i < moves; ++i)
+            graph.SetLocal(random() % graph.GetNodeCount(), glm::vec3(unit(random)), glm::quat(glm::vec3(unit(random))), glm::vec3(1.0f));
+        graph.Update();
+        // the same arithmetic either way, so the matrices match exactly
+        BeSceneGraph reference = graph;
+        reference.UpdateAll();
+        mismatches += !std::ranges::equal(graph.GetWorlds(), reference.GetWorlds());
+    }
+    BE_CHECK_EQ(mismatches, 0u);
+}
+
+BE_TEST(SceneGraph, ChangedNodesAreTheDirtiedSubtrees) {
+    std::mt19937 random(23);
+    BeSceneGraph graph = MakeForest(1000, random);
+    graph.Update();
+    BE_CHECK_EQ(graph.GetChangedNodes().size(), size_t(1000));
+    graph.Update();
+    BE_CHECK(graph.GetChangedNodes().empty());
+
+    uint32_t wrongLists = 0;
+    for (uint32_t frame = 0; frame < 50; ++frame) {
+        std::vector<uint8_t> inSubtree(graph.GetNodeCount(), 0);
+        for (uint32_t i = 0, moves = 1 + random() % 10; i < moves; ++i) {
+            const uint32_t node = random() % graph.GetNodeCount();
+            graph.SetLocal(node, graph.GetLocal(node));
+            inSubtree[node] = 1;
+        }
+        // parents come first, so one pass in index order reaches every descendant
+        std::vector<uint32_t> expected;
+        for (uint32_t node = 0; node < graph.GetNodeCount(); ++node) {
+            const uint32_t parent = graph.GetParent(node);
+            if (parent != BeSceneGraph::NoParent && inSubtree[parent]) inSubtree[node] = 1;
+            if (inSubtree[node]) expected.push_back(node);
+        }
+        graph.Update();
+        wrongLists += !std::ranges::equal(graph.GetChangedNodes(), expected);
+    }
+    BE_CHECK_EQ(wrongLists, 0u);
+}
+
+BE_TEST(SceneGraph, InvalidParentThrows) {
+    BeSceneGraph graph;
+    const uint32_t root = graph.AddNode(BeSceneGraph::NoParent, glm::mat4(1.0f));
+    bool threw = false;
+    try {
+        graph.AddNode(root + 1, glm::mat4(1.0f));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    BE_CHECK(threw);
+    BE_CHECK_EQ(graph.GetNodeCount(), 1u);
+}
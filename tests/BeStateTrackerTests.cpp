@@ -0,0 +1,247 @@
+﻿#include <algorithm>
+#include <array>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "BeCommandList.h"
+#include "BePipelineState.h"
+#include "BeRecordingContext.h"
+#include "BeStateTracker.h"
+#include "BeTest.h"
+
+// The tracker and an unfiltered context driven with random bindings from small pools: both have to end up with the
+// same state after every call, and no call the tracker issues may leave the state as it was.
+BE_TEST(StateTracker, RandomBindingsMatchUnfilteredContext) {
+    std::mt19937 random(37);
+    auto pick = [&random](const uint32_t count) { return static_cast<uint32_t>(random() % count); };
+
+    // few distinct objects so that most bindings repeat what is bound
+    std::vector<BePipelineState> pipelines(8);
+    for (auto& pipeline : pipelines) {
+        pipeline = {
+            .InputLayout = MakeToken<ID3D11InputLayout>(pick(3)),
+            .VertexShader = MakeToken<ID3D11VertexShader>(pick(3)),
+            .PixelShader = MakeToken<ID3D11PixelShader>(pick(4)),
+            .BlendState = MakeToken<ID3D11BlendState>(pick(2)),
+            .DepthStencilState = MakeToken<ID3D11DepthStencilState>(pick(2)),
+            .RasterizerState = MakeToken<ID3D11RasterizerState>(pick(2)),
+            .Topology = 4 + pick(2),
+            .StencilReference = pick(2),
+        };
+    }
+
+    BeRecordingContext tracked;
+    BeRecordingContext reference;
+    BeStateTracker tracker(tracked);
+    for (uint32_t i = 0; i < 20000; ++i) {
+        switch (pick(8)) {
+        case 0: {
+            const BePipelineState& pipeline = pipelines[pick(static_cast<uint32_t>(pipelines.size()))];
+            tracker.SetPipeline(pipeline);
+            reference.SetInputLayout(pipeline.InputLayout);
+            reference.SetPrimitiveTopology(pipeline.Topology);
+            reference.SetVertexShader(pipeline.VertexShader);
+            reference.SetPixelShader(pipeline.PixelShader);
+            reference.SetBlendState(pipeline.BlendState);
+            reference.SetDepthStencilState(pipeline.DepthStencilState, pipeline.StencilReference);
+            reference.SetRasterizerState(pipeline.RasterizerState);
+            break;
+        }
+        case 1: {
+            const uint32_t slot = pick(3), stride = 16 * (1 + pick(2)), offset = 64 * pick(2);
+            ID3D11Buffer* buffer = MakeToken<ID3D11Buffer>(pick(3));
+            tracker.SetVertexBuffer(slot, buffer, stride, offset);
+            reference.SetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+            break;
+        }
+        case 2: {
+            const uint32_t format = 42 + pick(2), offset = 0;
+            ID3D11Buffer* buffer = MakeToken<ID3D11Buffer>(pick(3));
+            tracker.SetIndexBuffer(buffer, format, offset);
+            reference.SetIndexBuffer(buffer, format, offset);
+            break;
+        }
+        case 3:
+        case 4: {
+            const uint32_t slot = pick(3);
+            ID3D11Buffer* buffer = MakeToken<ID3D11Buffer>(pick(4));
+            if (i % 2) {
+                tracker.SetVSConstantBuffer(slot, buffer);
+                reference.SetVSConstantBuffers(slot, 1, &buffer);
+            } else {
+                tracker.SetPSConstantBuffer(slot, buffer);
+                reference.SetPSConstantBuffers(slot, 1, &buffer);
+            }
+            break;
+        }
+        case 5: {
+            std::vector<ID3D11ShaderResourceView*> views(1 + pick(5));
+            for (auto& view : views) view = MakeToken<ID3D11ShaderResourceView>(pick(4));
+            const uint32_t startSlot = pick(5);
+            tracker.SetPSShaderResources(startSlot, views);
+            reference.SetPSShaderResources(startSlot, static_cast<uint32_t>(views.size()), views.data());
+            break;
+        }
+        case 6: {
+            const uint32_t slot = pick(2);
+            ID3D11SamplerState* sampler = MakeToken<ID3D11SamplerState>(pick(3));
+            tracker.SetPSSampler(slot, sampler);
+            reference.SetPSSamplers(slot, 1, &sampler);
+            break;
+        }
+        case 7: {
+            std::vector<ID3D11RenderTargetView*> targets(1 + pick(3));
+            for (auto& target : targets) target = MakeToken<ID3D11RenderTargetView>(pick(3));
+            ID3D11DepthStencilView* depthTarget = MakeToken<ID3D11DepthStencilView>(pick(2));
+            // what the tracker promises: resources unbound whenever the targets change
+            BeBoundState next = reference.State;
+            next.RenderTargets = {};
+            std::ranges::copy(targets, next.RenderTargets.begin());
+            next.DepthTarget = depthTarget;
+            if (next.RenderTargets != reference.State.RenderTargets || next.DepthTarget != reference.State.DepthTarget)
+                reference.State.PSShaderResources = {};
+            tracker.SetRenderTargets(targets, depthTarget);
+            reference.SetRenderTargets(static_cast<uint32_t>(targets.size()), targets.data(), depthTarget);
+            break;
+        }
+        }
+        // stop at the first call that went wrong, the ones after it would only repeat the report
+        if (tracked.State != reference.State || tracked.UnchangedCalls != 0 || tracked.Calls != tracker.GetStatistics().Issued) {
+            BE_CHECK(tracked.State == reference.State);
+            BE_CHECK_EQ(tracked.UnchangedCalls, 0u);
+            BE_CHECK_EQ(tracked.Calls, tracker.GetStatistics().Issued);
+            break;
+        }
+    }
+    BE_CHECK(tracker.GetStatistics().Issued < tracker.GetStatistics().Requested);
+}
+
+BE_TEST(StateTracker, PipelineBindsOnlyChangedStates) {
+    const BePipelineState first = {
+        .InputLayout = MakeToken<ID3D11InputLayout>(1),
+        .VertexShader = MakeToken<ID3D11VertexShader>(1),
+        .PixelShader = MakeToken<ID3D11PixelShader>(1),
+        .BlendState = MakeToken<ID3D11BlendState>(1),
+        .DepthStencilState = MakeToken<ID3D11DepthStencilState>(1),
+        .RasterizerState = MakeToken<ID3D11RasterizerState>(1),
+        .Topology = 4,
+    };
+    BePipelineState second = first;
+    second.PixelShader = MakeToken<ID3D11PixelShader>(2);
+    second.StencilReference = 1;
+
+    BeRecordingContext context;
+    BeStateTracker tracker(context);
+    tracker.SetPipeline(first);
+    BE_CHECK_EQ(context.Calls, 7u);
+    tracker.SetPipeline(first);
+    BE_CHECK_EQ(context.Calls, 7u);
+    // the pixel shader, and the depth stencil state for its reference
+    tracker.SetPipeline(second);
+    BE_CHECK_EQ(context.Calls, 9u);
+    BE_CHECK(context.State.PixelShader == second.PixelShader);
+    BE_CHECK_EQ(context.State.StencilReference, 1u);
+    BE_CHECK_EQ(tracker.GetStatistics().Requested, 21u);
+    BE_CHECK_EQ(tracker.GetStatistics().Issued, 9u);
+
+    // a pipeline of nothing but nullptr against a fresh context binds only its topology
+    BeRecordingContext fresh;
+    BeStateTracker freshTracker(fresh);
+    freshTracker.SetPipeline(BePipelineState {.Topology = 5});
+    BE_CHECK_EQ(fresh.Calls, 1u);
+}
+
+BE_TEST(StateTracker, ResourceRangesAreMerged) {
+    BeRecordingContext context;
+    BeStateTracker tracker(context);
+    const std::array<ID3D11ShaderResourceView*, 4> views = {
+        MakeToken<ID3D11ShaderResourceView>(1), MakeToken<ID3D11ShaderResourceView>(2),
+        MakeToken<ID3D11ShaderResourceView>(3), MakeToken<ID3D11ShaderResourceView>(4)};
+    tracker.SetPSShaderResources(2, views);
+    BE_CHECK_EQ(context.Calls, 1u);
+    tracker.SetPSShaderResources(2, views);
+    BE_CHECK_EQ(context.Calls, 1u);
+
+    // only the middle two change, one call for them
+    std::array<ID3D11ShaderResourceView*, 4> changed = views;
+    changed[1] = MakeToken<ID3D11ShaderResourceView>(7);
+    changed[2] = nullptr;
+    tracker.SetPSShaderResources(2, changed);
+    BE_CHECK_EQ(context.Calls, 2u);
+    BE_CHECK(std::ranges::equal(std::span(context.State.PSShaderResources).subspan(2, 4), changed));
+    BE_CHECK_EQ(context.UnchangedCalls, 0u);
+}
+
+BE_TEST(StateTracker, RenderTargetsUnbindResources) {
+    BeRecordingContext context;
+    BeStateTracker tracker(context);
+    ID3D11RenderTargetView* target = MakeToken<ID3D11RenderTargetView>(1);
+    ID3D11RenderTargetView* other = MakeToken<ID3D11RenderTargetView>(2);
+    ID3D11ShaderResourceView* view = MakeToken<ID3D11ShaderResourceView>(1);
+
+    tracker.SetRenderTargets(std::span(&target, 1), nullptr);
+    tracker.SetPSShaderResources(3, std::span(&view, 1));
+    const uint32_t calls = context.Calls;
+    // the same targets leave the resources bound
+    tracker.SetRenderTargets(std::span(&target, 1), nullptr);
+    BE_CHECK_EQ(context.Calls, calls);
+    BE_CHECK(context.State.PSShaderResources[3] == view);
+
+    // new targets unbind them first, in one call
+    tracker.SetRenderTargets(std::span(&other, 1), nullptr);
+    BE_CHECK_EQ(context.Calls, calls + 2);
+    BE_CHECK(context.State.PSShaderResources[3] == nullptr);
+    BE_CHECK(context.State.RenderTargets[0] == other);
+
+    // and the resource binds again afterwards
+    tracker.SetPSShaderResources(3, std::span(&view, 1));
+    BE_CHECK_EQ(context.Calls, calls + 3);
+    BE_CHECK_EQ(context.UnchangedCalls, 0u);
+}
+
+BE_TEST(StateTracker, ResetAndCommandListsForgetBindings) {
+    BeRecordingContext context;
+    BeStateTracker tracker(context);
+    ID3D11Buffer* buffer = MakeToken<ID3D11Buffer>(1);
+    tracker.SetVSConstantBuffer(0, buffer);
+    tracker.SetVSConstantBuffer(0, buffer);
+    BE_CHECK_EQ(context.Calls, 1u);
+
+    // the context was cleared behind the tracker's back
+    context.ClearState();
+    tracker.Reset();
+    tracker.SetVSConstantBuffer(0, buffer);
+    BE_CHECK_EQ(context.Calls, 3u);
+    BE_CHECK(context.State.VSConstantBuffers[0] == buffer);
+    BE_CHECK_EQ(tracker.GetStatistics().Requested, 3u);
+
+    // executing a list counts as one call, after which everything binds again
+    BeCommandList commands;
+    commands.Draw(3, 0);
+    tracker.ExecuteCommandList(commands);
+    const uint32_t issued = tracker.GetStatistics().Issued;
+    tracker.SetVSConstantBuffer(0, buffer);
+    BE_CHECK_EQ(tracker.GetStatistics().Issued, issued + 1);
+}
+
+BE_TEST(StateTracker, SlotsPastTheTrackedOnesThrow) {
+    BeRecordingContext context;
+    BeStateTracker tracker(context);
+    auto throws = [](auto&& call) {
+        try {
+            call();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    BE_CHECK(throws([&] { tracker.SetPSSampler(BeStateTracker::SamplerSlots, nullptr); }));
+    BE_CHECK(throws([&] { tracker.SetVSConstantBuffer(BeStateTracker::ConstantBufferSlots, nullptr); }));
+    const std::array<ID3D11ShaderResourceView*, 2> views {};
+    BE_CHECK(throws([&] { tracker.SetPSShaderResources(BeStateTracker::ShaderResourceSlots - 1, views); }));
+    const std::array<ID3D11RenderTargetView*, BeStateTracker::RenderTargetSlots + 1> targets {};
+    BE_CHECK(throws([&] { tracker.SetRenderTargets(targets, nullptr); }));
+    BE_CHECK_EQ(context.Calls, 0u);
+}
@@ -0,0 +1,77 @@
+﻿#pragma once
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+// Tests register themselves through BE_TEST(Suite, Name). A failed check reports itself and the test carries on, the
+// runner executes the suites named in its arguments, or all of them, and exits non zero when any check failed.
+struct BeTestCase {
+    std::string_view Suite;
+    std::string_view Name;
+    auto (*Run)() -> void;
+
+    static auto GetRegistry() -> std::vector<BeTestCase>& {
+        static std::vector<BeTestCase> registry;
+        return registry;
+    }
+
+    // failed checks of the test that is running
+    static auto GetFailureCount() -> uint32_t& {
+        static uint32_t failureCount = 0;
+        return failureCount;
+    }
+
+    template <typename T>
+    static auto Describe(const T& value) -> void {
+        if constexpr (requires { std::cerr << value; })
+            std::cerr << value;
+        else
+            std::cerr << "?";
+    }
+
+    static auto ReportFailure(const char* file, const int line, const std::string_view check) -> void {
+        ++GetFailureCount();
+        std::cerr << file << "(" << line << "): check failed: " << check << "\n";
+    }
+
+    template <typename A, typename B>
+    static auto ReportMismatch(const char* file, const int line, const std::string_view check, const A& a, const B& b) -> void {
+        ReportFailure(file, line, check);
+        std::cerr << "    ";
+        Describe(a);
+        std::cerr << " vs ";
+        Describe(b);
+        std::cerr << "\n";
+    }
+};
+
+struct BeTestRegistration {
+    BeTestRegistration(const std::string_view suite, const std::string_view name, auto (*run)() -> void) {
+        BeTestCase::GetRegistry().push_back({suite, name, run});
+    }
+};
+
+#define BE_TEST(Suite, Name) \
+    static auto Suite##_##Name##Test() -> void; \
+    static const BeTestRegistration Suite##_##Name##Registration {#Suite, #Name, &Suite##_##Name##Test}; \
+    static auto Suite##_##Name##Test() -> void
+
+#define BE_CHECK(condition) \
+    do { if (!(condition)) BeTestCase::ReportFailure(__FILE__, __LINE__, #condition); } while (false)
+
+#define BE_CHECK_EQ(a, b) \
+    do { \
+        const auto beCheckA = (a); \
+        const auto beCheckB = (b); \
+        if (!(beCheckA == beCheckB)) BeTestCase::ReportMismatch(__FILE__, __LINE__, #a " == " #b, beCheckA, beCheckB); \
+    } while (false)
+
+#define BE_CHECK_NEAR(a, b, tolerance) \
+    do { \
+        const double beCheckA = (a); \
+        const double beCheckB = (b); \
+        if (!(std::abs(beCheckA - beCheckB) <= (tolerance))) \
+            BeTestCase::ReportMismatch(__FILE__, __LINE__, #a " ~= " #b, beCheckA, beCheckB); \
+    } while (false)
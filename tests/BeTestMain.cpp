@@ -0,0 +1,34 @@
+﻿#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include "BeTest.h"
+
+auto main(const int argc, char** argv) -> int {
+    const std::vector<std::string_view> suites(argv + 1, argv + argc);
+    auto& registry = BeTestCase::GetRegistry();
+    std::ranges::stable_sort(registry, {}, &BeTestCase::Suite);
+
+    uint32_t runCount = 0;
+    uint32_t failedCount = 0;
+    for (const auto& test : registry) {
+        if (!suites.empty() && std::ranges::find(suites, test.Suite) == suites.end()) continue;
+
+        ++runCount;
+        BeTestCase::GetFailureCount() = 0;
+        try {
+            test.Run();
+        } catch (const std::exception& exception) {
+            BeTestCase::ReportFailure(__FILE__, __LINE__, exception.what());
+        }
+        const bool passed = BeTestCase::GetFailureCount() == 0;
+        if (!passed) ++failedCount;
+        std::cout << (passed ? "[ passed ] " : "[ FAILED ] ") << test.Suite << "." << test.Name << "\n";
+    }
+
+    std::cout << runCount - failedCount << " of " << runCount << " tests passed\n";
+    // a suite name that matches nothing is a typo in the caller, not a pass
+    return runCount > 0 && failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,244 @@
+﻿#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "BeTest.h"
+#include "BeTextureResidency.h"
+
+namespace {
+    // 4 bytes per texel, or 8 bytes per 4x4 block when block compressed
+    auto MakeLevels(uint32_t width, uint32_t height, const bool blockCompressed = false) -> std::vector<BeTextureResidency::BeLevel> {
+        std::vector<BeTextureResidency::BeLevel> levels;
+        while (true) {
+            const size_t bytes = blockCompressed ? size_t((width + 3) / 4) * ((height + 3) / 4) * 8 : size_t(width) * height * 4;
+            levels.push_back({width, height, bytes, !blockCompressed || (width % 4 == 0 && height % 4 == 0)});
+            if (width == 1 && height == 1) break;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        return levels;
+    }
+
+    auto GetBytesFrom(const std::vector<BeTextureResidency::BeLevel>& levels, const uint32_t mip) -> size_t {
+        size_t bytes = 0;
+        for (size_t i = mip; i < levels.size(); ++i) bytes += levels[i].Bytes;
+        return bytes;
+    }
+
+    struct BeUploadLog {
+        std::vector<std::pair<void*, uint32_t>> Uploads;
+        auto Attach(BeTextureResidency& residency) -> void {
+            residency.Upload = [this](void* texture, const uint32_t mip) { Uploads.emplace_back(texture, mip); };
+        }
+    };
+}
+
+BE_TEST(TextureResidency, RegisterMakesStartLevelsResident) {
+    BeTextureResidency residency(1ull << 30);
+    BeUploadLog log;
+    log.Attach(residency);
+    const auto levels = MakeLevels(1024, 512);
+    const auto texture = std::make_shared<int>();
+    residency.Register(texture, levels);
+
+    // 64x32 is the first level within StartSize
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 4u);
+    BE_CHECK_EQ(residency.GetStatistics().ResidentBytes, GetBytesFrom(levels, 4));
+    BE_CHECK_EQ(log.Uploads.size(), size_t(1));
+    BE_CHECK(log.Uploads[0] == std::make_pair(static_cast<void*>(texture.get()), 4u));
+
+    // registering again keeps the state and uploads nothing
+    residency.Register(texture, levels);
+    BE_CHECK_EQ(residency.GetStatistics().Textures, 1u);
+    BE_CHECK_EQ(log.Uploads.size(), size_t(1));
+    BE_CHECK(residency.ValidateAccounting());
+}
+
+BE_TEST(TextureResidency, RequestsStreamInAndUnusedFallBack) {
+    BeTextureResidency residency(1ull << 30);
+    BeUploadLog log;
+    log.Attach(residency);
+    const auto levels = MakeLevels(256, 256);
+    const auto texture = std::make_shared<int>();
+    residency.Register(texture, levels);
+
+    residency.Request(texture.get(), 3);
+    residency.Request(texture.get(), 1);   // the finest of a frame's requests wins
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 1u);
+    BE_CHECK(log.Uploads.back() == std::make_pair(static_cast<void*>(texture.get()), 1u));
+
+    // with budget to spare nothing is evicted, an unrequested texture keeps its levels
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 1u);
+
+    // requests coarser than the start level never drop below it
+    residency.Request(texture.get(), 8);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 1u);
+    BE_CHECK_EQ(residency.GetStatistics().Requests, 3u);
+    BE_CHECK_EQ(residency.GetStatistics().SatisfiedRequests, 2u);   // level 3 and the clamped level 8 were resident
+    BE_CHECK(residency.ValidateAccounting());
+}
+
+BE_TEST(TextureResidency, EvictsLeastRecentlyUsedWithinBudget) {
+    const auto levels = MakeLevels(256, 256);
+    // start levels of three textures plus one of them at full detail
+    const size_t startBytes = GetBytesFrom(levels, 2);
+    BeTextureResidency residency(3 * startBytes + GetBytesFrom(levels, 0) - startBytes);
+    const auto a = std::make_shared<int>();
+    const auto b = std::make_shared<int>();
+    const auto c = std::make_shared<int>();
+    for (const auto& texture : {a, b, c}) residency.Register(texture, levels);
+
+    residency.Request(a.get(), 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(a.get()), 0u);
+
+    // b only fits once a falls back to its start level
+    residency.Request(c.get(), 2);
+    residency.Request(b.get(), 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(b.get()), 0u);
+    BE_CHECK_EQ(residency.GetResidentMip(a.get()), 2u);
+    BE_CHECK_EQ(residency.GetStatistics().Evictions, 1u);
+    BE_CHECK(residency.GetStatistics().ResidentBytes <= residency.BudgetBytes);
+
+    // a texture drawn this frame is not evicted for another one, the request waits instead
+    residency.Request(b.get(), 0);
+    residency.Request(a.get(), 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(b.get()), 0u);
+    BE_CHECK(residency.GetResidentMip(a.get()) > 0u);
+    BE_CHECK(residency.ValidateAccounting());
+}
+
+BE_TEST(TextureResidency, UploadsStayWithinFrameLimit) {
+    BeTextureResidency residency(1ull << 30);
+    const auto levels = MakeLevels(1024, 1024);
+    residency.MaxUploadBytesPerFrame = GetBytesFrom(levels, 2) - GetBytesFrom(levels, 4);
+    const auto texture = std::make_shared<int>();
+    residency.Register(texture, levels);
+
+    // level 0 does not fit into one frame, the finest level that does is taken and the rest follows
+    residency.Request(texture.get(), 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 2u);
+    BE_CHECK_EQ(residency.GetStatistics().StreamedInBytes, GetBytesFrom(levels, 2));
+}
+
+BE_TEST(TextureResidency, BlockCompressedLevelsStopAtStreamableSizes) {
+    BeTextureResidency residency(1ull << 30);
+    // levels of 100, 50, 25, 12, 6, 3 and 1 texels, only 100 and 12 are multiples of 4
+    const auto levels = MakeLevels(100, 100, true);
+    const auto texture = std::make_shared<int>();
+    residency.Register(texture, levels);
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 3u);
+
+    // a request for level 1 has to take level 0 with it
+    const auto small = std::make_shared<int>();
+    residency.Register(small, MakeLevels(48, 48, true));
+    residency.Request(texture.get(), 1);
+    residency.Request(small.get(), 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(texture.get()), 0u);
+    BE_CHECK_EQ(residency.GetResidentMip(small.get()), 0u);
+    BE_CHECK(residency.ValidateAccounting());
+}
+
+BE_TEST(TextureResidency, ExpiredTexturesAreDropped) {
+    BeTextureResidency residency(1ull << 30);
+    BeUploadLog log;
+    log.Attach(residency);
+    const auto levels = MakeLevels(512, 512);
+    const auto other = MakeLevels(128, 128);
+
+    // two owners of the same address, as when a texture dies and the allocator hands its memory to the next one
+    int storage = 0;
+    auto first = std::shared_ptr<void>(std::make_shared<int>(), &storage);
+    residency.Register(first, levels);
+    residency.Request(&storage, 0);
+    residency.Update();
+    BE_CHECK_EQ(residency.GetResidentMip(&storage), 0u);
+    first.reset();
+
+    // a request through the stale pointer is not counted against anything
+    const uint64_t requests = residency.GetStatistics().Requests;
+    residency.Request(&storage, 0);
+    BE_CHECK_EQ(residency.GetStatistics().Requests, requests);
+
+    // the new texture starts from scratch instead of inheriting the dead one's levels
+    auto second = std::shared_ptr<void>(std::make_shared<int>(), &storage);
+    residency.Register(second, other);
+    BE_CHECK_EQ(residency.GetResidentMip(&storage), 1u);
+    BE_CHECK_EQ(residency.GetStatistics().Textures, 1u);
+    BE_CHECK_EQ(residency.GetStatistics().ResidentBytes, GetBytesFrom(other, 1));
+    BE_CHECK_EQ(residency.GetStatistics().ChainBytes, GetBytesFrom(other, 0));
+    BE_CHECK(log.Uploads.back() == std::make_pair(static_cast<void*>(&storage), 1u));
+    BE_CHECK(residency.ValidateAccounting());
+
+    // Update gives back the memory of textures nobody re-registered
+    const auto third = std::make_shared<int>();
+    residency.Register(third, levels);
+    second.reset();
+    residency.Update();
+    BE_CHECK_EQ(residency.GetStatistics().Textures, 1u);
+    BE_CHECK_EQ(residency.GetStatistics().ResidentBytes, GetBytesFrom(levels, 3));
+    BE_CHECK_EQ(residency.GetStatistics().ChainBytes, GetBytesFrom(levels, 0));
+    BE_CHECK(residency.ValidateAccounting());
+}
+
+BE_TEST(TextureResidency, AccountingHoldsUnderWanderingWorkingSet) {
+    // the benchmark's scenario at a smaller scale: textures along a line, a camera sweeping over them
+    constexpr uint32_t textureCount = 512;
+    constexpr size_t budgetBytes = 8ull << 20;
+    std::mt19937 random(7);
+    std::vector<std::shared_ptr<int>> textures;
+    std::vector<std::vector<BeTextureResidency::BeLevel>> textureLevels;
+    std::vector<float> positions;
+    BeTextureResidency residency(budgetBytes);
+    residency.MaxUploadBytesPerFrame = 4ull << 20;
+    for (uint32_t i = 0; i < textureCount; ++i) {
+        const uint32_t size = 128u << (random() % 4);
+        textures.push_back(std::make_shared<int>());
+        textureLevels.push_back(MakeLevels(size, size >> (random() % 2), random() % 2 == 0));
+        positions.push_back(float(random() % (2 * textureCount)));
+        residency.Register(textures.back(), textureLevels.back());
+    }
+    const size_t startBytes = residency.GetStatistics().ResidentBytes;
+
+    uint32_t failures = 0;
+    for (uint32_t frame = 0; frame < 200; ++frame) {
+        const float phase = float(frame) / 200.0f;
+        const float camera = float(2 * textureCount) * (phase < 0.5f ? 2.0f * phase : 2.0f - 2.0f * phase);
+        for (uint32_t i = 0; i < textureCount; ++i) {
+            if (!textures[i]) continue;
+            const float distance = std::abs(positions[i] - camera);
+            if (distance > 32.0f) continue;
+            const auto& levels = textureLevels[i];
+            residency.Request(textures[i].get(), BeTextureResidency::ComputeRequiredMip(
+                std::max(levels[0].Width, levels[0].Height), static_cast<uint32_t>(levels.size()), 1.0f, 1024.0f / std::max(distance, 1.0f)));
+        }
+        if (frame % 50 == 10) textures[frame].reset();
+        const uint64_t streamedBefore = residency.GetStatistics().StreamedInBytes;
+        residency.Update();
+        const auto statistics = residency.GetStatistics();
+        if (!residency.ValidateAccounting()) ++failures;
+        if (statistics.ResidentBytes > std::max(budgetBytes, startBytes)) ++failures;
+        if (statistics.StreamedInBytes - streamedBefore > residency.MaxUploadBytesPerFrame) ++failures;
+    }
+    BE_CHECK_EQ(failures, 0u);
+    BE_CHECK(residency.GetStatistics().Evictions > 0);
+    BE_CHECK_EQ(residency.GetStatistics().Textures, textureCount - 4);
+}
+
+BE_TEST(TextureResidency, RequiredMipFollowsTexelDensity) {
+    // one texel per pixel wants level 0, every halving of the screen size one level coarser
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 1.0f, 1024.0f), 0u);
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 1.0f, 2048.0f), 0u);
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 1.0f, 256.0f), 2u);
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 4.0f, 1024.0f), 2u);
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 1.0f, 0.001f), 10u);
+    BE_CHECK_EQ(BeTextureResidency::ComputeRequiredMip(1024, 11, 1.0f, 0.0f), 10u);
+}
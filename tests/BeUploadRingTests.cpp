@@ -0,0 +1,94 @@
+﻿#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "BeTest.h"
+#include "BeUploadRing.h"
+
+BE_TEST(UploadRing, RandomRunsStayAlignedAndClear) {
+    std::mt19937 random(29);
+    for (const uint32_t capacity : {64u, 1000u, 4096u, 65536u}) {
+        BeUploadRing ring(capacity);
+        // ranges handed out since the last wrap, and where the next one would start without wrapping
+        std::vector<std::pair<uint32_t, uint32_t>> live;
+        uint64_t expectedHead = capacity;
+        uint32_t wrongWraps = 0, misplaced = 0, overlapping = 0;
+        for (uint32_t i = 0; i < 10000; ++i) {
+            const uint32_t alignment = 1u << (random() % 9);
+            const uint32_t size = 1 + random() % std::max(capacity / 3, 1u);
+            const uint64_t alignedHead = (expectedHead + alignment - 1) & ~uint64_t(alignment - 1);
+            const bool mustWrap = alignedHead + size > capacity;
+
+            const BeUploadRing::BeAllocation allocation = ring.Allocate(size, alignment);
+            wrongWraps += allocation.Wrapped != mustWrap;
+            misplaced += allocation.Offset % alignment != 0 || uint64_t(allocation.Offset) + size > capacity ||
+                (allocation.Wrapped && allocation.Offset != 0);
+            if (allocation.Wrapped)
+                live.clear();
+            const uint32_t end = allocation.Offset + size;
+            overlapping += std::ranges::any_of(live, [&](const auto& range) { return allocation.Offset < range.second && range.first < end; });
+            live.emplace_back(allocation.Offset, end);
+            expectedHead = end;
+        }
+        BE_CHECK_EQ(wrongWraps, 0u);
+        BE_CHECK_EQ(misplaced, 0u);
+        BE_CHECK_EQ(overlapping, 0u);
+    }
+}
+
+BE_TEST(UploadRing, FirstAllocationAndResetWrap) {
+    BeUploadRing ring(256);
+    BE_CHECK_EQ(ring.GetCapacity(), 256u);
+    const auto first = ring.Allocate(16);
+    BE_CHECK(first.Wrapped);
+    BE_CHECK_EQ(first.Offset, 0u);
+    const auto second = ring.Allocate(16);
+    BE_CHECK(!second.Wrapped);
+    BE_CHECK_EQ(second.Offset, 16u);
+
+    ring.Reset(512);
+    BE_CHECK_EQ(ring.GetCapacity(), 512u);
+    BE_CHECK(ring.Allocate(16).Wrapped);
+}
+
+BE_TEST(UploadRing, FillsExactlyBeforeWrapping) {
+    BeUploadRing ring(256);
+    (void)ring.Allocate(64);
+    // a range ending on the capacity still fits
+    const auto last = ring.Allocate(192, 64);
+    BE_CHECK(!last.Wrapped);
+    BE_CHECK_EQ(last.Offset, 64u);
+    const auto next = ring.Allocate(1, 1);
+    BE_CHECK(next.Wrapped);
+    BE_CHECK_EQ(next.Offset, 0u);
+
+    // alignment padding counts towards the fit
+    const auto padded = ring.Allocate(100, 128);
+    BE_CHECK(!padded.Wrapped);
+    BE_CHECK_EQ(padded.Offset, 128u);
+    BE_CHECK(ring.Allocate(100, 128).Wrapped);
+}
+
+BE_TEST(UploadRing, OversizedAllocationThrows) {
+    BeUploadRing ring(1000);
+    bool threw = false;
+    try {
+        (void)ring.Allocate(1001);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    BE_CHECK(threw);
+    BE_CHECK(ring.Allocate(1000).Wrapped);
+
+    // an empty ring fits nothing
+    BeUploadRing empty;
+    threw = false;
+    try {
+        (void)empty.Allocate(1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    BE_CHECK(threw);
+}
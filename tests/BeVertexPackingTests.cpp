@@ -0,0 +1,151 @@
+﻿#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <vector>
+
+#include "BeTest.h"
+#include "BeVertexPacking.h"
+
+namespace {
+    // evenly spread over the sphere, plus the axes and the folds of the octahedron where the mapping is least even
+    auto MakeUnitVectors() -> std::vector<glm::vec3> {
+        std::vector<glm::vec3> vectors;
+        constexpr uint32_t count = 20000;
+        const float goldenAngle = std::numbers::pi_v<float> * (3.0f - std::sqrt(5.0f));
+        for (uint32_t i = 0; i < count; ++i) {
+            const float z = 1.0f - 2.0f * (float(i) + 0.5f) / float(count);
+            const float radius = std::sqrt(1.0f - z * z);
+            vectors.emplace_back(radius * std::cos(goldenAngle * float(i)), radius * std::sin(goldenAngle * float(i)), z);
+        }
+        for (const float sign : {-1.0f, 1.0f}) {
+            vectors.emplace_back(sign, 0.0f, 0.0f);
+            vectors.emplace_back(0.0f, sign, 0.0f);
+            vectors.emplace_back(0.0f, 0.0f, sign);
+            vectors.push_back(glm::normalize(glm::vec3(sign, sign, -1.0f)));
+            vectors.push_back(glm::normalize(glm::vec3(sign, -sign, 1e-4f)));
+            vectors.push_back(glm::normalize(glm::vec3(1e-4f, sign, -1.0f)));
+        }
+        return vectors;
+    }
+
+    auto AngleDegrees(const glm::vec3& a, const glm::vec3& b) -> double {
+        const glm::dvec3 da = glm::normalize(glm::dvec3(a));
+        const glm::dvec3 db = glm::normalize(glm::dvec3(b));
+        // atan2 of cross and dot stays accurate for tiny angles, where acos of the dot does not
+        return glm::degrees(std::atan2(glm::length(glm::cross(da, db)), glm::dot(da, db)));
+    }
+}
+
+BE_TEST(VertexPacking, OctahedralRoundTripStaysWithinBound) {
+    // 16 bit per axis spaces codes 2 / 32767 apart on the folded square, a bit over 0.005 degrees at worst
+    double maxError = 0.0;
+    for (const auto& normal : MakeUnitVectors()) {
+        const glm::vec3 decoded = BeVertexPacking::DecodeOctahedral(BeVertexPacking::EncodeOctahedral(normal));
+        BE_CHECK_NEAR(glm::length(decoded), 1.0, 1e-6);
+        maxError = std::max(maxError, AngleDegrees(normal, decoded));
+    }
+    BE_CHECK(maxError < 0.01);
+
+    // unnormalised input only changes the length, which decoding drops
+    const glm::vec3 direction = glm::normalize(glm::vec3(0.3f, -0.8f, -0.5f));
+    const glm::vec3 decoded = BeVertexPacking::DecodeOctahedral(BeVertexPacking::EncodeOctahedral(direction * 7.5f));
+    BE_CHECK(AngleDegrees(direction, decoded) < 0.01);
+    BE_CHECK(BeVertexPacking::EncodeOctahedral(glm::vec3(0.0f)) == (std::array<int16_t, 2>{0, 0}));
+}
+
+BE_TEST(VertexPacking, OctahedralDecodeMatchesEncode) {
+    // every code on a coarse grid decodes to a direction that encodes back to a neighbouring code
+    for (int32_t x = -32767; x <= 32767; x += 1021) {
+        for (int32_t y = -32767; y <= 32767; y += 1021) {
+            const std::array<int16_t, 2> code = {static_cast<int16_t>(x), static_cast<int16_t>(y)};
+            const auto reencoded = BeVertexPacking::EncodeOctahedral(BeVertexPacking::DecodeOctahedral(code));
+            const glm::vec3 a = BeVertexPacking::DecodeOctahedral(code);
+            const glm::vec3 b = BeVertexPacking::DecodeOctahedral(reencoded);
+            BE_CHECK(AngleDegrees(a, b) < 0.01);
+        }
+    }
+}
+
+BE_TEST(VertexPacking, HalfConversionKnownValues) {
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(0.0f), uint16_t(0x0000));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(-0.0f), uint16_t(0x8000));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(1.0f), uint16_t(0x3C00));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(-2.0f), uint16_t(0xC000));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(0.5f), uint16_t(0x3800));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(0.1f), uint16_t(0x2E66));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(65504.0f), uint16_t(0x7BFF));       // largest finite half
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(65520.0f), uint16_t(0x7C00));       // rounds up to infinity
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(std::ldexp(1.0f, -14)), uint16_t(0x0400)); // smallest normal
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(std::ldexp(1.0f, -24)), uint16_t(0x0001)); // smallest subnormal
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(std::ldexp(1.0f, -26)), uint16_t(0x0000));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(INFINITY), uint16_t(0x7C00));
+    BE_CHECK(std::isnan(BeVertexPacking::HalfToFloat(BeVertexPacking::FloatToHalf(NAN))));
+    // ties go to the even mantissa
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(1.0f + std::ldexp(1.0f, -11)), uint16_t(0x3C00));
+    BE_CHECK_EQ(BeVertexPacking::FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)), uint16_t(0x3C02));
+}
+
+BE_TEST(VertexPacking, HalfRoundTripIsExactAndWithinBound) {
+    // every half survives the trip through float unchanged
+    for (uint32_t bits = 0; bits <= 0xFFFF; ++bits) {
+        const auto half = static_cast<uint16_t>(bits);
+        const float value = BeVertexPacking::HalfToFloat(half);
+        if (std::isnan(value)) continue;
+        BE_CHECK_EQ(BeVertexPacking::FloatToHalf(value), half);
+    }
+
+    // floats in the UV range come back within half a unit in the last place: 2^-11 relative, 2^-25 for subnormals
+    uint32_t state = 7;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1664525u + 1013904223u;
+        const float value = (float(state >> 8) / 16777216.0f - 0.5f) * 16.0f;
+        const float decoded = BeVertexPacking::HalfToFloat(BeVertexPacking::FloatToHalf(value));
+        const double bound = std::max(std::abs(double(value)) * std::ldexp(1.0, -11), std::ldexp(1.0, -25));
+        BE_CHECK(std::abs(double(decoded) - double(value)) <= bound);
+    }
+}
+
+BE_TEST(VertexPacking, LayoutsRoundTrip) {
+    std::vector<BeFullVertex> vertices;
+    for (const auto& normal : MakeUnitVectors()) {
+        const auto i = static_cast<float>(vertices.size());
+        vertices.push_back({
+            .Position = normal * 3.0f + glm::vec3(i, -i, 0.5f),
+            .Normal = normal,
+            .Color = {normal * 0.5f + 0.5f, 1.0f},
+            .UV0 = {normal.x * 4.0f, normal.y * 0.25f},
+            .UV1 = {i, 1.0f},
+            .UV2 = {2.0f, i},
+        });
+    }
+
+    // the full layout is BeFullVertex byte for byte
+    const auto full = BeVertexPacking::PackVertices(vertices, FullVertexLayout);
+    BE_CHECK_EQ(full.size(), vertices.size() * sizeof(BeFullVertex));
+    BE_CHECK(memcmp(full.data(), vertices.data(), full.size()) == 0);
+    const BeFullVertex unpackedFull = BeVertexPacking::UnpackVertex(full.data() + 5 * sizeof(BeFullVertex), FullVertexLayout);
+    BE_CHECK(memcmp(&unpackedFull, &vertices[5], sizeof(BeFullVertex)) == 0);
+
+    // the standard layout keeps position exactly and quantises normal and UV0 within their bounds
+    const auto standard = BeVertexPacking::PackVertices(vertices, StandardVertexLayout);
+    BE_CHECK_EQ(standard.size(), vertices.size() * 20);
+    for (size_t i = 0; i < vertices.size(); i += 97) {
+        const BeFullVertex unpacked = BeVertexPacking::UnpackVertex(standard.data() + i * StandardVertexLayout.Stride, StandardVertexLayout);
+        BE_CHECK(unpacked.Position == vertices[i].Position);
+        BE_CHECK(AngleDegrees(unpacked.Normal, vertices[i].Normal) < 0.01);
+        BE_CHECK(unpacked.UV1 == glm::vec2(0.0f)); // not in the layout, keeps its default
+    }
+    const auto statistics = BeVertexPacking::Measure(vertices, StandardVertexLayout);
+    BE_CHECK_EQ(statistics.VertexCount, uint32_t(vertices.size()));
+    BE_CHECK_EQ(statistics.PackedStride, 20u);
+    BE_CHECK(statistics.MaxNormalErrorDegrees < 0.05f); // float acos inside Measure, coarser than the test above
+    BE_CHECK(statistics.MaxTexCoordError <= 4.0f * std::ldexp(1.0f, -11));
+
+    // a single element layout packs to just that element
+    constexpr BeVertexLayout positionOnly {BeVertexSemantic::Position};
+    const auto positions = BeVertexPacking::PackVertices(vertices, positionOnly);
+    BE_CHECK_EQ(positions.size(), vertices.size() * 12);
+    BE_CHECK(BeVertexPacking::UnpackVertex(positions.data() + 12, positionOnly).Position == vertices[1].Position);
+}